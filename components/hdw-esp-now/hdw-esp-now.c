@@ -7,7 +7,9 @@
 #include <esp_wifi.h>
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_heap_caps.h>
 #include <esp_private/wifi.h>
+#include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 
 #include "hdw-esp-now.h"
@@ -71,21 +73,6 @@ typedef enum
     CM_SERIAL,
 } connectionMode_t;
 
-//==============================================================================
-// Enums
-//==============================================================================
-
-/**
- * @brief A packet received over ESP-NOW
- */
-typedef struct
-{
-    int8_t rssi;       ///< The received signal strength indicator for the packet
-    uint8_t mac[6];    ///< The MAC address of the sender
-    uint8_t len;       ///< The length of the received bytes
-    uint8_t data[255]; ///< The received bytes
-} espNowPacket_t;
-
 //==============================================================================
 // Variables
 //==============================================================================
@@ -97,6 +84,7 @@ static uint8_t myMac[6] = {0};
 
 static hostEspNowRecvCb_t hostEspNowRecvCb = NULL;
 static hostEspNowSendCb_t hostEspNowSendCb = NULL;
+static hostEspNowRecvBatchCb_t hostEspNowRecvBatchCb = NULL;
 
 static QueueHandle_t esp_now_queue = NULL;
 
@@ -114,6 +102,20 @@ static int16_t rBufHead = 0;
 /// The index for the esp-now serial communication ringbuffer's tail
 static int16_t rBufTail = 0;
 
+/// The serial decoder's state, kept between calls so each byte is decoded once
+static decodeState_t serialDecodeState = EU_PARSING_FR_START_1;
+/// The packet being decoded from serial
+static espNowPacket_t serialPacket = {0};
+/// The number of MAC or payload bytes of serialPacket decoded so far
+static uint8_t serialDecodeIdx = 0;
+
+/// Packets drained by checkEspNowRxQueue(), CONFIG_ESP_NOW_RX_QUEUE_LEN long
+static espNowPacket_t* rxBatch = NULL;
+/// Counters for received and dropped packets. Written from the Wi-Fi task and the main loop, so guarded by rxStatsLock
+static espNowRxStats_t rxStats = {0};
+/// Protects rxStats
+static portMUX_TYPE rxStatsLock = portMUX_INITIALIZER_UNLOCKED;
+
 //==============================================================================
 // Prototypes
 //==============================================================================
@@ -132,6 +134,11 @@ static esp_err_t espNowDeinitWifi(void);
 static esp_err_t espNowInitUart(bool crossoverPins);
 static esp_err_t espNowDeinitUart(void);
 
+static void espNowFillSerialRing(void);
+static bool espNowDecodeSerialByte(uint8_t byte, espNowPacket_t* out);
+
+static void espNowCountRx(bool dropped);
+
 //==============================================================================
 // External Initializer Functions
 //==============================================================================
@@ -166,9 +173,17 @@ esp_err_t initEspNow(hostEspNowRecvCb_t recvCb, hostEspNowSendCb_t sendCb, gpio_
     if (ESP_NOW_IMMEDIATE != mode && NULL == esp_now_queue)
     {
         // Create a queue to move packets from the receive callback to the main task
-        esp_now_queue = xQueueCreate(10, sizeof(espNowPacket_t));
+        esp_now_queue = xQueueCreate(CONFIG_ESP_NOW_RX_QUEUE_LEN, sizeof(espNowPacket_t));
+    }
+
+    if (NULL == rxBatch)
+    {
+        // Space to drain the whole queue into each main loop pass
+        rxBatch = heap_caps_calloc(CONFIG_ESP_NOW_RX_QUEUE_LEN, sizeof(espNowPacket_t), MALLOC_CAP_SPIRAM);
     }
 
+    espNowResetRxStats();
+
     connectionMode = CM_NOT_CONNECTED;
     return espNowUseWireless();
 }
@@ -194,6 +209,10 @@ void deinitEspNow(void)
         vQueueDelete(esp_now_queue);
         esp_now_queue = NULL;
     }
+
+    heap_caps_free(rxBatch);
+    rxBatch               = NULL;
+    hostEspNowRecvBatchCb = NULL;
 }
 
 /**
@@ -495,6 +514,11 @@ static esp_err_t espNowInitUart(bool crossoverPins)
         .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_APB,
     };
+    // Start decoding from a clean state
+    rBufHead          = 0;
+    rBufTail          = 0;
+    serialDecodeState = EU_PARSING_FR_START_1;
+
     CHECK_OK(uart_driver_install(uartNum, ESP_NOW_SERIAL_RX_BUF_SIZE, 0, 0, NULL, 0));
     CHECK_OK(uart_param_config(uartNum, &uart_config));
 
@@ -536,6 +560,7 @@ static void espNowRecvCb(const esp_now_recv_info_t* esp_now_info, const uint8_t*
 {
     if (ESP_NOW_IMMEDIATE == mode)
     {
+        espNowCountRx(false);
         hostEspNowRecvCb(esp_now_info, (const uint8_t*)data, data_len, esp_now_info->rx_ctrl->rssi);
     }
     else
@@ -560,150 +585,281 @@ static void espNowRecvCb(const esp_now_recv_info_t* esp_now_info, const uint8_t*
         // Copy the RSSI
         packet.rssi = esp_now_info->rx_ctrl->rssi;
 
-        // Queue this packet
-        xQueueSendFromISR(esp_now_queue, &packet, NULL);
+        // Queue this packet, or count it as dropped if the main loop hasn't kept up
+        espNowCountRx(pdTRUE != xQueueSendFromISR(esp_now_queue, &packet, NULL));
     }
 }
 
 /**
- * Check the ESP NOW receive queue. If there are any received packets, send
- * them to hostEspNowRecvCb()
+ * @brief Move bytes from the UART driver into the serial ringbuffer, as many as fit
  */
-void checkEspNowRxQueue(void)
+static void espNowFillSerialRing(void)
 {
-    if (CM_SERIAL == connectionMode)
+    while (true)
     {
-        // Read bytes from the UART
-        char bytesRead[256];
-        int numBytesRead = uart_read_bytes(uartNum, &bytesRead, sizeof(bytesRead), 0);
+        // Leave one byte empty so a full ringbuffer can be told apart from an empty one
+        int16_t space = (rBufHead - rBufTail - 1 + (int16_t)sizeof(ringBuf)) % (int16_t)sizeof(ringBuf);
 
-        // Insert them into the ringBuffer
-        for (uint16_t i = 0; i < numBytesRead; i++)
+        // Read contiguously up to the end of the ringbuffer, then wrap around on the next iteration
+        int16_t contiguous = (int16_t)sizeof(ringBuf) - rBufTail;
+        int16_t toRead     = (space < contiguous) ? space : contiguous;
+        if (toRead <= 0)
         {
-            ringBuf[rBufTail] = bytesRead[i];
-            rBufTail          = (rBufTail + 1) % sizeof(ringBuf);
+            return;
         }
 
-        decodeState_t decodeState = EU_PARSING_FR_START_1;
-        uint8_t rxMac[6];
-        uint8_t rxMacIdx   = 0;
-        uint8_t payloadLen = 0;
-        uint8_t payload[256];
-        uint8_t payloadIdx = 0;
+        int numBytesRead = uart_read_bytes(uartNum, &ringBuf[rBufTail], toRead, 0);
+        if (numBytesRead <= 0)
+        {
+            return;
+        }
+        rBufTail = (rBufTail + numBytesRead) % sizeof(ringBuf);
 
-        // Check the ringBuffer for framed packets
-        int16_t rBufTmpHead = rBufHead;
-        while (rBufTmpHead != rBufTail)
+        if (numBytesRead < toRead)
         {
-            switch (decodeState)
+            // The UART is empty
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Feed one byte received over serial to the decoder. The decoder's state is kept between calls
+ *
+ * @param byte The received byte
+ * @param out The packet to write to when a packet is completed
+ * @return true if this byte completed a packet, false otherwise
+ */
+static bool espNowDecodeSerialByte(uint8_t byte, espNowPacket_t* out)
+{
+    switch (serialDecodeState)
+    {
+        case EU_PARSING_FR_START_1:
+        {
+            // Check for first framing byte
+            if (FRAMING_START_1 == byte)
             {
-                case EU_PARSING_FR_START_1:
-                {
-                    // Check for first framing byte
-                    if (FRAMING_START_1 == ringBuf[rBufTmpHead])
-                    {
-                        decodeState = EU_PARSING_FR_START_2;
-                    }
-                    break;
-                }
-                case EU_PARSING_FR_START_2:
-                {
-                    // Check for second framing byte
-                    if (FRAMING_START_2 == ringBuf[rBufTmpHead])
-                    {
-                        decodeState = EU_PARSING_FR_START_3;
-                    }
-                    break;
-                }
-                case EU_PARSING_FR_START_3:
-                {
-                    // Check for third framing byte
-                    if (FRAMING_START_3 == ringBuf[rBufTmpHead])
-                    {
-                        decodeState = EU_PARSING_MAC;
-                    }
-                    break;
-                }
-                case EU_PARSING_MAC:
-                {
-                    // Save the MAC byte
-                    rxMac[rxMacIdx++] = ringBuf[rBufTmpHead];
-                    // If all MAC bytes have been read
-                    if (6 == rxMacIdx)
-                    {
-                        decodeState = EU_PARSING_LEN;
-                    }
-                    break;
-                }
-                case EU_PARSING_LEN:
-                {
-                    // Save the length byte
-                    payloadLen = ringBuf[rBufTmpHead];
-                    // Immediately move to EU_PARSING_PAYLOAD
-                    decodeState = EU_PARSING_PAYLOAD;
-                    break;
-                }
-                case EU_PARSING_PAYLOAD:
-                {
-                    // Save the payload byte
-                    payload[payloadIdx++] = ringBuf[rBufTmpHead];
-                    // If all payload bytes have been read
-                    if (payloadIdx == payloadLen)
-                    {
-                        esp_now_recv_info_t recvInfo = {
-                            .des_addr = myMac,
-                            .src_addr = rxMac,
-                            .rx_ctrl  = NULL,
-                        };
-                        hostEspNowRecvCb(&recvInfo, payload, payloadLen, 0);
-
-                        // Move the ringBuf head, reset variables
-                        rBufHead    = rBufTmpHead;
-                        rxMacIdx    = 0;
-                        payloadLen  = 0;
-                        payloadIdx  = 0;
-                        decodeState = EU_PARSING_FR_START_1;
-                    }
-                    break;
-                }
+                serialDecodeState = EU_PARSING_FR_START_2;
             }
-            rBufTmpHead = (rBufTmpHead + 1) % sizeof(ringBuf);
+            break;
+        }
+        case EU_PARSING_FR_START_2:
+        {
+            // Check for second framing byte, or start over. This byte may begin a new frame
+            if (FRAMING_START_2 == byte)
+            {
+                serialDecodeState = EU_PARSING_FR_START_3;
+            }
+            else if (FRAMING_START_1 != byte)
+            {
+                serialDecodeState = EU_PARSING_FR_START_1;
+            }
+            break;
+        }
+        case EU_PARSING_FR_START_3:
+        {
+            // Check for third framing byte, or start over
+            if (FRAMING_START_3 == byte)
+            {
+                serialDecodeState = EU_PARSING_MAC;
+                serialDecodeIdx   = 0;
+            }
+            else
+            {
+                serialDecodeState = (FRAMING_START_1 == byte) ? EU_PARSING_FR_START_2 : EU_PARSING_FR_START_1;
+            }
+            break;
+        }
+        case EU_PARSING_MAC:
+        {
+            // Save the MAC byte
+            serialPacket.mac[serialDecodeIdx++] = byte;
+            // If all MAC bytes have been read
+            if (sizeof(serialPacket.mac) == serialDecodeIdx)
+            {
+                serialDecodeState = EU_PARSING_LEN;
+            }
+            break;
+        }
+        case EU_PARSING_LEN:
+        {
+            // Save the length byte
+            serialPacket.len  = byte;
+            serialDecodeIdx   = 0;
+            serialDecodeState = EU_PARSING_PAYLOAD;
+            if (0 != serialPacket.len)
+            {
+                break;
+            }
+            // An empty packet is complete already
+        }
+        // fall through
+        case EU_PARSING_PAYLOAD:
+        {
+            if (serialPacket.len)
+            {
+                // Save the payload byte
+                serialPacket.data[serialDecodeIdx++] = byte;
+            }
+
+            // If all payload bytes have been read
+            if (serialDecodeIdx == serialPacket.len)
+            {
+                out->rssi = 0;
+                memcpy(out->mac, serialPacket.mac, sizeof(out->mac));
+                out->len = serialPacket.len;
+                memcpy(out->data, serialPacket.data, serialPacket.len);
+
+                serialDecodeState = EU_PARSING_FR_START_1;
+                return true;
+            }
+            break;
         }
     }
-    else if ((CM_WIRELESS == connectionMode) && (mode != ESP_NOW_IMMEDIATE))
+    return false;
+}
+
+/**
+ * @brief Set a callback which receives all packets drained by each checkEspNowRxQueue() at once. While set, the
+ * ::hostEspNowRecvCb_t passed to initEspNow() is not called from checkEspNowRxQueue(). This is cleared by
+ * deinitEspNow()
+ *
+ * @param batchCb The callback, or NULL to receive packets one at a time again
+ */
+void espNowSetRecvBatchCb(hostEspNowRecvBatchCb_t batchCb)
+{
+    hostEspNowRecvBatchCb = batchCb;
+}
+
+/**
+ * @brief Move all received packets which are waiting into an array, up to the array's length
+ *
+ * When using serial, this also reads and decodes all bytes waiting in the UART. When using ESP-NOW, this does nothing
+ * in ::ESP_NOW_IMMEDIATE mode, since packets are never queued.
+ *
+ * @param packets The array to write packets to
+ * @param maxPackets The length of the array
+ * @return The number of packets written to the array
+ */
+uint16_t espNowDrainRxQueue(espNowPacket_t* packets, uint16_t maxPackets)
+{
+    uint16_t count = 0;
+    if (CM_SERIAL == connectionMode)
     {
-        espNowPacket_t packet;
-        if (xQueueReceive(esp_now_queue, &packet, 0))
+        espNowFillSerialRing();
+        while (count < maxPackets && rBufHead != rBufTail)
         {
-            // Debug print the received payload
-            // char dbg[256] = {0};
-            // char tmp[8] = {0};
-            // int i;
-            // for (i = 0; i < packet.len; i++)
-            // {
-            //     sprintf(tmp, "%02X ", packet.data[i]);
-            //     strcat(dbg, tmp);
-            // }
-            // ESP_LOGD("ESPNOW", "%s, MAC [%02X:%02X:%02X:%02X:%02X:%02X], Bytes [%s]",
-            //        __func__,
-            //        packet.mac[0],
-            //        packet.mac[1],
-            //        packet.mac[2],
-            //        packet.mac[3],
-            //        packet.mac[4],
-            //        packet.mac[5],
-            //        dbg);
+            uint8_t byte = ringBuf[rBufHead];
+            rBufHead     = (rBufHead + 1) % sizeof(ringBuf);
+            if (espNowDecodeSerialByte(byte, &packets[count]))
+            {
+                espNowCountRx(false);
+                count++;
+            }
+
+            // Top the ringbuffer back up once it's empty, in case more bytes arrived
+            if (rBufHead == rBufTail)
+            {
+                espNowFillSerialRing();
+            }
+        }
+    }
+    else if ((CM_WIRELESS == connectionMode) && (NULL != esp_now_queue))
+    {
+        while (count < maxPackets && xQueueReceive(esp_now_queue, &packets[count], 0))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Check the ESP NOW receive queue. Drain all received packets and send them to the ::hostEspNowRecvBatchCb_t if it is
+ * set, or to hostEspNowRecvCb() one at a time if it isn't
+ */
+void checkEspNowRxQueue(void)
+{
+    if (NULL == rxBatch)
+    {
+        return;
+    }
 
+    // Only drain what the queue could hold, so packets which arrive during the callbacks wait for the next pass
+    uint16_t count = espNowDrainRxQueue(rxBatch, CONFIG_ESP_NOW_RX_QUEUE_LEN);
+    if (0 == count)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&rxStatsLock);
+    if (count > rxStats.maxBatch)
+    {
+        rxStats.maxBatch = count;
+    }
+    portEXIT_CRITICAL(&rxStatsLock);
+
+    if (NULL != hostEspNowRecvBatchCb)
+    {
+        hostEspNowRecvBatchCb(rxBatch, count);
+    }
+    else
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
             esp_now_recv_info_t recvInfo = {
                 .des_addr = myMac,
-                .src_addr = packet.mac,
+                .src_addr = rxBatch[i].mac,
                 .rx_ctrl  = NULL,
             };
-            hostEspNowRecvCb(&recvInfo, packet.data, packet.len, packet.rssi);
+            hostEspNowRecvCb(&recvInfo, rxBatch[i].data, rxBatch[i].len, rxBatch[i].rssi);
         }
     }
 }
 
+/**
+ * @brief Get counters for received and dropped packets since initEspNow() or espNowResetRxStats()
+ *
+ * @param stats The counters are written here
+ */
+void espNowGetRxStats(espNowRxStats_t* stats)
+{
+    // Copy all the counters at once, so they are consistent with each other
+    portENTER_CRITICAL(&rxStatsLock);
+    *stats = rxStats;
+    portEXIT_CRITICAL(&rxStatsLock);
+}
+
+/**
+ * @brief Reset the counters for received and dropped packets to zero
+ */
+void espNowResetRxStats(void)
+{
+    portENTER_CRITICAL(&rxStatsLock);
+    memset(&rxStats, 0, sizeof(rxStats));
+    portEXIT_CRITICAL(&rxStatsLock);
+}
+
+/**
+ * @brief Count a received packet. This is called from the Wi-Fi task as well as the main loop, so it uses the
+ * ISR-safe critical section
+ *
+ * @param dropped true if the packet was dropped because the receive queue was full, false if it was received
+ */
+static void espNowCountRx(bool dropped)
+{
+    portENTER_CRITICAL_SAFE(&rxStatsLock);
+    if (dropped)
+    {
+        rxStats.dropped++;
+    }
+    else
+    {
+        rxStats.received++;
+    }
+    portEXIT_CRITICAL_SAFE(&rxStatsLock);
+}
+
 /**
  * This is a wrapper for esp_now_send(). It also sets the wifi power with
  * wifi_set_user_fixed_rate()
@@ -41,6 +41,14 @@
  * When a packet is received, the ::hostEspNowRecvCb_t callback passed to initEspNow() is called with the received
  * packet.
  *
+ * Unless the mode is ::ESP_NOW_IMMEDIATE, received packets wait in a queue of `CONFIG_ESP_NOW_RX_QUEUE_LEN` packets
+ * until checkEspNowRxQueue() is called. Each call drains every waiting packet, so a burst of packets, like SwadgePass
+ * broadcasts in a crowd, is handled in a single pass. If a ::hostEspNowRecvBatchCb_t is set with
+ * espNowSetRecvBatchCb(), it is called once with the whole batch instead of calling the ::hostEspNowRecvCb_t once per
+ * packet. Packets received while the queue is full are dropped, and espNowGetRxStats() reports how many were.
+ *
+ * Packets received over the wired UART are decoded incrementally as bytes arrive, and are delivered the same way.
+ *
  * \section esp-now_example Example
  *
  * \code{.c}
@@ -102,6 +110,27 @@ typedef enum __attribute__((packed))
     ESP_NOW_IMMEDIATE, ///< ESP-NOW packets are delivered to Swadge modes from the interrupt
 } wifiMode_t;
 
+/**
+ * @brief A packet received over ESP-NOW or the wired UART
+ */
+typedef struct
+{
+    int8_t rssi;       ///< The received signal strength indicator for the packet
+    uint8_t mac[6];    ///< The MAC address of the sender
+    uint8_t len;       ///< The length of the received bytes
+    uint8_t data[255]; ///< The received bytes
+} espNowPacket_t;
+
+/**
+ * @brief Counters for received packets, since initEspNow() or espNowResetRxStats()
+ */
+typedef struct
+{
+    uint32_t received; ///< The number of packets received
+    uint32_t dropped;  ///< The number of packets dropped because the receive queue was full
+    uint16_t maxBatch; ///< The largest number of packets delivered by a single checkEspNowRxQueue()
+} espNowRxStats_t;
+
 //==============================================================================
 // Prototypes
 //==============================================================================
@@ -121,6 +150,12 @@ typedef void (*hostEspNowRecvCb_t)(const esp_now_recv_info_t* esp_now_info, cons
  * @param status The transmission status, either ESP_NOW_SEND_SUCCESS or ESP_NOW_SEND_FAIL
  */
 typedef void (*hostEspNowSendCb_t)(const uint8_t* mac_addr, esp_now_send_status_t status);
+/**
+ * @brief A function typedef for a callback called with all the packets drained by one checkEspNowRxQueue()
+ * @param packets The received packets, oldest first. These are only valid until the callback returns
+ * @param count The number of received packets, at least one
+ */
+typedef void (*hostEspNowRecvBatchCb_t)(const espNowPacket_t* packets, uint16_t count);
 
 esp_err_t initEspNow(hostEspNowRecvCb_t recvCb, hostEspNowSendCb_t sendCb, gpio_num_t rx, gpio_num_t tx,
                      uart_port_t uart, wifiMode_t wifiMode);
@@ -137,5 +172,10 @@ esp_err_t espNowUseSerial(bool crossoverPins);
 
 void espNowSend(const char* data, uint8_t len);
 void checkEspNowRxQueue(void);
+void espNowSetRecvBatchCb(hostEspNowRecvBatchCb_t batchCb);
+uint16_t espNowDrainRxQueue(espNowPacket_t* packets, uint16_t maxPackets);
+
+void espNowGetRxStats(espNowRxStats_t* stats);
+void espNowResetRxStats(void);
 
 #endif /* USER_ESP_NOW_UTILS_H_ */
@@ -7,11 +7,14 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <esp_lcd_panel_io.h>
+#include <esp_lcd_panel_commands.h>
 #include <esp_lcd_panel_vendor.h>
 #include <esp_lcd_panel_ops.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <esp_attr.h>
 #include <esp_lcd_panel_interface.h>
 #include <driver/spi_master.h>
 #include <driver/gpio.h>
@@ -99,7 +102,20 @@ static inline uint32_t get_cCount()
     #error "Please pick a screen size"
 #endif
 
-#define NUM_S_LINES 2
+/**
+ * @brief The number of line buffers used to send PARALLEL_LINES at a time
+ *
+ * With three buffers, one can be converted while one is being sent and another is queued behind it, so palette
+ * conversion, background drawing and DMA all overlap. Each buffer is (TFT_WIDTH * PARALLEL_LINES * 2) bytes of DMA
+ * capable memory.
+ */
+#define NUM_S_LINES 3
+
+/// The number of PARALLEL_LINES tall bands the display is sent in
+#define NUM_BANDS ((TFT_HEIGHT + PARALLEL_LINES - 1) / PARALLEL_LINES)
+
+/// A bitmask with a bit set for every band on the display
+#define ALL_BANDS ((uint32_t)((1ULL << NUM_BANDS) - 1))
 
 //==============================================================================
 // Variables
@@ -111,6 +127,8 @@ static esp_lcd_panel_handle_t panel_handle = NULL;
 static paletteColor_t* pixels              = NULL;
 paletteColor_t* pFrameBuffer               = NULL;
 static uint16_t* s_lines[NUM_S_LINES]      = {0};
+static SemaphoreHandle_t freeLinesSem      = NULL;
+static uint8_t calcLine                    = 0;
 
 static ledc_timer_t tftLedcTimer;
 static ledc_channel_t tftLedcChannel;
@@ -120,6 +138,22 @@ static uint8_t tftBacklightIntensity;
 
 static esp_lcd_panel_io_handle_t tft_io_handle = NULL;
 
+static bool dirtyTrackingEnabled = false;
+static uint32_t dirtyBands       = ALL_BANDS;
+static uint32_t frameBytesSent   = 0;
+static bool asyncScanoutEnabled  = false;
+
+static fnBandRenderCallback_t bandRenderer = NULL;
+static paletteColor_t* bandPixels          = NULL;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool tftColorTransDone(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t* edata,
+                              void* user_ctx);
+static void setWindowTft(int16_t yStart, int16_t yEnd);
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -190,13 +224,14 @@ void initTFT(spi_host_device_t spiHost, gpio_num_t sclk, gpio_num_t mosi, gpio_n
     ESP_ERROR_CHECK(spi_bus_initialize(spiHost, &busCfg, SPI_DMA_CH_AUTO));
 
     esp_lcd_panel_io_spi_config_t io_config = {
-        .dc_gpio_num       = dc,
-        .cs_gpio_num       = cs,
-        .pclk_hz           = LCD_PIXEL_CLOCK_HZ,
-        .lcd_cmd_bits      = LCD_CMD_BITS,
-        .lcd_param_bits    = LCD_PARAM_BITS,
-        .spi_mode          = 0,
-        .trans_queue_depth = 10,
+        .dc_gpio_num         = dc,
+        .cs_gpio_num         = cs,
+        .pclk_hz             = LCD_PIXEL_CLOCK_HZ,
+        .lcd_cmd_bits        = LCD_CMD_BITS,
+        .lcd_param_bits      = LCD_PARAM_BITS,
+        .spi_mode            = 0,
+        .trans_queue_depth   = 10,
+        .on_color_trans_done = tftColorTransDone,
     };
 
     // Attach the LCD to the SPI bus
@@ -231,6 +266,11 @@ void initTFT(spi_host_device_t spiHost, gpio_num_t sclk, gpio_num_t mosi, gpio_n
         assert(s_lines[i] != NULL);
     }
 
+    // All pixel buffers start out free. Each is taken when it's calculated and given back when its DMA is done
+    freeLinesSem = xSemaphoreCreateCounting(NUM_S_LINES, NUM_S_LINES);
+    assert(freeLinesSem != NULL);
+    calcLine = 0;
+
     // Config the TFT
     esp_lcd_panel_swap_xy(panel_handle, SWAP_XY);
     esp_lcd_panel_mirror(panel_handle, MIRROR_X, MIRROR_Y);
@@ -277,6 +317,7 @@ void initTFT(spi_host_device_t spiHost, gpio_num_t sclk, gpio_num_t mosi, gpio_n
  */
 void deinitTFT(void)
 {
+    waitDisplayTft();
     disableTFTBacklight();
 
     esp_lcd_panel_del(panel_handle);
@@ -287,7 +328,13 @@ void deinitTFT(void)
     {
         heap_caps_free(s_lines[i]);
     }
+    vSemaphoreDelete(freeLinesSem);
     heap_caps_free(pixels);
+    pixels       = NULL;
+    pFrameBuffer = NULL;
+    heap_caps_free(bandPixels);
+    bandPixels   = NULL;
+    bandRenderer = NULL;
 }
 
 /**
@@ -295,6 +342,9 @@ void deinitTFT(void)
  */
 void powerDownTft(void)
 {
+    // Let the last frame finish sending
+    waitDisplayTft();
+
     // Disable the backlight. This also puts th TFT to sleep
     disableTFTBacklight();
 }
@@ -313,7 +363,7 @@ void powerUpTft(void)
  * in row order, starting from the top left. This can be used to directly modify
  * individual pixels without calling ::setPxTft()
  *
- * @return The pixel framebuffer
+ * @return The pixel framebuffer, or NULL if a band renderer is set with setBandRendererTft()
  */
 paletteColor_t* getPxTftFramebuffer(void)
 {
@@ -394,9 +444,10 @@ void enableTFTBacklight(void)
  */
 void setPxTft(int16_t x, int16_t y, paletteColor_t px)
 {
-    if (0 <= x && x <= TFT_WIDTH && 0 <= y && y < TFT_HEIGHT && cTransparent != px)
+    if (0 <= x && x <= TFT_WIDTH && 0 <= y && y < TFT_HEIGHT && cTransparent != px && NULL != pixels)
     {
         pixels[y * TFT_WIDTH + x] = px;
+        dirtyBands |= (1 << (y / PARALLEL_LINES));
     }
 }
 
@@ -409,7 +460,7 @@ void setPxTft(int16_t x, int16_t y, paletteColor_t px)
  */
 paletteColor_t getPxTft(int16_t x, int16_t y)
 {
-    if (0 <= x && x <= TFT_WIDTH && 0 <= y && y < TFT_HEIGHT)
+    if (0 <= x && x <= TFT_WIDTH && 0 <= y && y < TFT_HEIGHT && NULL != pixels)
     {
         return pixels[y * TFT_WIDTH + x];
     }
@@ -421,7 +472,186 @@ paletteColor_t getPxTft(int16_t x, int16_t y)
  */
 void clearPxTft(void)
 {
-    memset(pixels, c000, sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH);
+    if (NULL != pixels)
+    {
+        memset(pixels, c000, sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH);
+    }
+    dirtyBands = ALL_BANDS;
+}
+
+/**
+ * @brief Enable or disable dirty band tracking. When enabled, drawDisplayTft() only converts and sends the bands
+ * which were marked dirty since the last frame. When disabled, every band is sent every frame.
+ *
+ * Enabling or disabling tracking marks the whole display as dirty so the next frame is always complete.
+ *
+ * @param enable true to only send dirty bands, false to send the whole display every frame
+ */
+void enableDirtyTrackingTft(bool enable)
+{
+    dirtyTrackingEnabled = enable;
+    dirtyBands           = ALL_BANDS;
+}
+
+/**
+ * @brief Enable or disable asynchronous scanout. When enabled, drawDisplayTft() returns as soon as the last band is
+ * queued, so the next frame can be drawn while the prior one is still being sent. When disabled, drawDisplayTft()
+ * waits for the frame to finish sending before it returns.
+ *
+ * Only enable this if nothing else needs the TFT or its SPI bus to be idle between frames. waitDisplayTft() may be
+ * called to wait for the transfer.
+ *
+ * @param enable true to return before the frame is sent, false to wait for it
+ */
+void enableAsyncScanoutTft(bool enable)
+{
+    asyncScanoutEnabled = enable;
+}
+
+/**
+ * @brief Mark a range of rows as dirty so they are sent to the display on the next call to drawDisplayTft(). This
+ * is called by the drawing functions, and must be called by anything that writes to getPxTftFramebuffer() directly
+ * while dirty band tracking is enabled.
+ *
+ * @param yStart The first row which was modified, inclusive
+ * @param yEnd The last row which was modified, exclusive
+ */
+void markDirtyRowsTft(int32_t yStart, int32_t yEnd)
+{
+    if (yStart < 0)
+    {
+        yStart = 0;
+    }
+    if (yEnd > TFT_HEIGHT)
+    {
+        yEnd = TFT_HEIGHT;
+    }
+    if (yStart >= yEnd)
+    {
+        return;
+    }
+
+    uint32_t firstBand = yStart / PARALLEL_LINES;
+    uint32_t lastBand  = (yEnd - 1) / PARALLEL_LINES;
+    dirtyBands |= ((2u << lastBand) - 1) & ~((1u << firstBand) - 1);
+}
+
+/**
+ * @brief Get the number of bytes sent to the display during the last call to drawDisplayTft(). This is useful to
+ * measure how much dirty band tracking is saving.
+ *
+ * @return The number of pixel bytes sent over SPI for the last frame
+ */
+uint32_t getFrameBytesSentTft(void)
+{
+    return frameBytesSent;
+}
+
+/**
+ * @brief Draw the display one band at a time with a callback instead of from the frame-buffer, or go back to using the
+ * frame-buffer. Setting a band renderer frees the frame-buffer, and removing it allocates a new one, cleared to black.
+ *
+ * @param cb The function to draw each band with, or NULL to use the frame-buffer
+ * @return true if the band renderer was set, false if memory for the band buffer or the frame-buffer couldn't be
+ * allocated, in which case nothing changes
+ */
+bool setBandRendererTft(fnBandRenderCallback_t cb)
+{
+    if (NULL != cb && NULL == bandRenderer)
+    {
+        // Switch from the frame-buffer to a single band
+        bandPixels = (paletteColor_t*)heap_caps_malloc(sizeof(paletteColor_t) * TFT_WIDTH * PARALLEL_LINES,
+                                                       MALLOC_CAP_8BIT);
+        if (NULL == bandPixels)
+        {
+            ESP_LOGE("TFT", "Couldn't allocate the band buffer");
+            return false;
+        }
+        heap_caps_free(pixels);
+        pixels = NULL;
+    }
+    else if (NULL == cb && NULL != bandRenderer)
+    {
+        // Switch from a single band back to the frame-buffer
+        pixels = (paletteColor_t*)heap_caps_malloc(sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH, MALLOC_CAP_8BIT);
+        if (NULL == pixels)
+        {
+            ESP_LOGE("TFT", "Couldn't allocate the frame-buffer");
+            return false;
+        }
+        memset(pixels, c000, sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH);
+        heap_caps_free(bandPixels);
+        bandPixels = NULL;
+    }
+
+    bandRenderer = cb;
+    pFrameBuffer = pixels;
+    dirtyBands   = ALL_BANDS;
+    return true;
+}
+
+/**
+ * @brief Get the band renderer set with setBandRendererTft()
+ *
+ * @return The function drawing each band, or NULL if the frame-buffer is used
+ */
+fnBandRenderCallback_t getBandRendererTft(void)
+{
+    return bandRenderer;
+}
+
+/**
+ * @brief Called from the SPI ISR when a color transaction has finished, which frees up that line buffer
+ *
+ * @param panel_io unused
+ * @param edata unused
+ * @param user_ctx unused
+ * @return true if a higher priority task was woken, false otherwise
+ */
+static bool IRAM_ATTR tftColorTransDone(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t* edata,
+                                        void* user_ctx)
+{
+    BaseType_t taskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(freeLinesSem, &taskWoken);
+    return (pdTRUE == taskWoken);
+}
+
+/**
+ * @brief Set the TFT's frame memory window to cover a range of rows across the whole width of the display. Pixel data
+ * sent after this fills the window in order. This is the same math as the panel driver's draw_bitmap(), but lets a
+ * run of bands be streamed without a command phase in between each one.
+ *
+ * This waits for all in-flight transactions to finish, because a command can't be sent while data is queued.
+ *
+ * @param yStart The first row to write, inclusive
+ * @param yEnd The last row to write, exclusive
+ */
+static void setWindowTft(int16_t yStart, int16_t yEnd)
+{
+    int16_t xs = X_OFFSET;
+    int16_t xe = X_OFFSET + TFT_WIDTH - 1;
+    int16_t ys = Y_OFFSET + yStart;
+    int16_t ye = Y_OFFSET + yEnd - 1;
+    esp_lcd_panel_io_tx_param(tft_io_handle, LCD_CMD_CASET, (uint8_t[]){xs >> 8, xs & 0xFF, xe >> 8, xe & 0xFF}, 4);
+    esp_lcd_panel_io_tx_param(tft_io_handle, LCD_CMD_RASET, (uint8_t[]){ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF}, 4);
+}
+
+/**
+ * @brief Block until every band queued by drawDisplayTft() has been sent to the TFT. When asynchronous scanout is
+ * enabled with enableAsyncScanoutTft(), drawDisplayTft() returns as soon as the last band is queued, so call this if
+ * something needs the TFT to be idle.
+ */
+void waitDisplayTft(void)
+{
+    // Taking every line buffer means none are in flight
+    for (int i = 0; i < NUM_S_LINES; i++)
+    {
+        xSemaphoreTake(freeLinesSem, portMAX_DELAY);
+    }
+    for (int i = 0; i < NUM_S_LINES; i++)
+    {
+        xSemaphoreGive(freeLinesSem);
+    }
 }
 
 /**
@@ -429,81 +659,115 @@ void clearPxTft(void)
  *
  * This function can be called as quickly as possible
  *
- * Because the SPI driver handles transactions in the background, we can
- * calculate the next line while the previous one is being sent.
+ * Bands of PARALLEL_LINES are palette converted into a ring of NUM_S_LINES line buffers and queued as SPI
+ * transactions, so the next band is calculated, and fnBackgroundDrawCallback is called, while prior bands are being
+ * sent by DMA. If asynchronous scanout is enabled with enableAsyncScanoutTft(), this returns as soon as the last band
+ * is queued, otherwise it waits for the frame to finish sending. Either way the framebuffer may be drawn to as soon as
+ * this returns, since DMA only reads from the line buffers.
+ *
+ * If dirty band tracking is enabled with enableDirtyTrackingTft(), bands which were not marked dirty since the last
+ * frame are neither converted nor sent. fnBackgroundDrawCallback is still called for every band.
+ *
+ * If a band renderer is set with setBandRendererTft(), it draws each band into the band buffer right before that band
+ * is converted, instead of the band being read from the frame-buffer. fnBackgroundDrawCallback is not called.
  *
  * @param fnBackgroundDrawCallback A function pointer to draw backgrounds while the transmission is occurring
  */
 void drawDisplayTft(fnBackgroundDrawCallback_t fnBackgroundDrawCallback)
 {
-    // Indexes of the line currently being sent to the LCD and the line we're calculating
-    uint8_t calc_line = 0;
+    // Latch which bands to send. Anything drawn from here on, including by fnBackgroundDrawCallback, is sent next frame.
+    // A band renderer draws every band from scratch, so they're all sent
+    uint32_t bandsToSend = (dirtyTrackingEnabled && NULL == bandRenderer) ? dirtyBands : ALL_BANDS;
+    dirtyBands           = 0;
+    frameBytesSent       = 0;
 
 #ifdef PROC_PROFILE
     uint32_t start, mid, final;
     uart_tx_one_char('f');
 #endif
 
-    // Send the frame, ping ponging the send buffer
     for (uint16_t y = 0; y < TFT_HEIGHT; y += PARALLEL_LINES)
     {
-        // Calculate a line
+        uint32_t band = y / PARALLEL_LINES;
+
+        // Skip bands which haven't changed, but still let the mode draw its background
+        if (bandsToSend & (1 << band))
+        {
+            // If this band starts a run of bands to send, set the window to cover the whole run
+            int32_t lcdCmd = -1;
+            if (0 == band || !(bandsToSend & (1 << (band - 1))))
+            {
+                uint16_t yEnd = y;
+                while (yEnd < TFT_HEIGHT && (bandsToSend & (1 << (yEnd / PARALLEL_LINES))))
+                {
+                    yEnd += PARALLEL_LINES;
+                }
+                setWindowTft(y, yEnd);
+                lcdCmd = LCD_CMD_RAMWR;
+            }
 
 #ifdef PROC_PROFILE
-        start = get_cCount();
+            start = get_cCount();
 #endif
 
-        // Naive approach is ~100k cycles, later optimization at 60k cycles @ 160 MHz
-        // If you quad-pixel it, so you operate on 4 pixels at the same time, you can get it down to 37k cycles.
-        // Also FYI - I tried going palette-less, it only saved 18k per chunk (1.6ms per frame)
-        uint32_t* outColor = (uint32_t*)s_lines[calc_line];
-        uint32_t* inColor  = (uint32_t*)&pixels[y * TFT_WIDTH];
-        for (uint16_t x = 0; x < TFT_WIDTH / 4 * PARALLEL_LINES; x++)
-        {
-            uint32_t colors = *(inColor++);
-            uint32_t word1  = paletteColors[(colors >> 0) & 0xff] | (paletteColors[(colors >> 8) & 0xff] << 16);
-            uint32_t word2  = paletteColors[(colors >> 16) & 0xff] | (paletteColors[(colors >> 24) & 0xff] << 16);
-            outColor[0]     = word1;
-            outColor[1]     = word2;
-            outColor += 2;
-        }
+            // Draw the band while prior bands are still being sent
+            uint32_t* inColor;
+            if (NULL != bandRenderer)
+            {
+                bandRenderer(bandPixels, y, PARALLEL_LINES);
+                inColor = (uint32_t*)bandPixels;
+            }
+            else
+            {
+                inColor = (uint32_t*)&pixels[y * TFT_WIDTH];
+            }
+
+            // Wait for a line buffer whose DMA has finished
+            xSemaphoreTake(freeLinesSem, portMAX_DELAY);
+
+            // Naive approach is ~100k cycles, later optimization at 60k cycles @ 160 MHz
+            // If you quad-pixel it, so you operate on 4 pixels at the same time, you can get it down to 37k cycles.
+            // Also FYI - I tried going palette-less, it only saved 18k per chunk (1.6ms per frame)
+            uint32_t* outColor = (uint32_t*)s_lines[calcLine];
+            for (uint16_t x = 0; x < TFT_WIDTH / 4 * PARALLEL_LINES; x++)
+            {
+                uint32_t colors = *(inColor++);
+                uint32_t word1  = paletteColors[(colors >> 0) & 0xff] | (paletteColors[(colors >> 8) & 0xff] << 16);
+                uint32_t word2  = paletteColors[(colors >> 16) & 0xff] | (paletteColors[(colors >> 24) & 0xff] << 16);
+                outColor[0]     = word1;
+                outColor[1]     = word2;
+                outColor += 2;
+            }
 
 #ifdef PROC_PROFILE
-        uart_tx_one_char('g');
-        mid = get_cCount();
+            uart_tx_one_char('g');
+            mid = get_cCount();
 #endif
 
-        uint8_t sending_line = calc_line;
-        calc_line            = !calc_line;
+            // Queue the calculated data. The first band of a run starts the memory write, the rest continue it.
+            // This returns as soon as the transaction is queued
+            esp_lcd_panel_io_tx_color(tft_io_handle, lcdCmd, s_lines[calcLine],
+                                      TFT_WIDTH * PARALLEL_LINES * sizeof(uint16_t));
+            frameBytesSent += TFT_WIDTH * PARALLEL_LINES * sizeof(uint16_t);
+            calcLine = (calcLine + 1) % NUM_S_LINES;
 
-        if (y != 0 && fnBackgroundDrawCallback)
-        {
-            fnBackgroundDrawCallback(0, y, TFT_WIDTH, PARALLEL_LINES, y / PARALLEL_LINES, TFT_HEIGHT / PARALLEL_LINES);
+#ifdef PROC_PROFILE
+            final = get_cCount();
+            uart_tx_one_char('h');
+#endif
         }
 
-        // (When operating @ 160 MHz)
-        // This code takes 35k cycles when y == 0, but
-        // this code takes ~~100k~~ 125k cycles when y != 0...
-        // NOTE:
-        //  *** You have 780us here, to do whatever you want.  For free. ***
-        //  You should avoid when y == 0, but that means you get 14 chunks
-        //  every frame.
-        //
-        // This is because esp_lcd_panel_draw_bitmap blocks until the chunk
-        // of frames has been sent.
-
-        // Send the calculated data
-        esp_lcd_panel_draw_bitmap(panel_handle, 0, y, TFT_WIDTH, y + PARALLEL_LINES, s_lines[sending_line]);
-
-        if (y == 0 && fnBackgroundDrawCallback)
+        // This band has been converted, so the mode may draw over it while DMA continues
+        if (fnBackgroundDrawCallback && NULL == bandRenderer)
         {
-            fnBackgroundDrawCallback(0, y, TFT_WIDTH, PARALLEL_LINES, y / PARALLEL_LINES, TFT_HEIGHT / PARALLEL_LINES);
+            fnBackgroundDrawCallback(0, y, TFT_WIDTH, PARALLEL_LINES, band, TFT_HEIGHT / PARALLEL_LINES);
         }
+    }
 
-#ifdef PROC_PROFILE
-        final = get_cCount();
-        uart_tx_one_char('h');
-#endif
+    // Unless the caller asked to overlap the next frame with this one, finish sending anything which was queued
+    if (!asyncScanoutEnabled && frameBytesSent)
+    {
+        waitDisplayTft();
     }
 
 #ifdef PROC_PROFILE
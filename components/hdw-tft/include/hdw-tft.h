@@ -17,7 +17,9 @@
  *
  * You don't need to call initTFT() or deinitTFT(). The system does so at the appropriate time.
  * You don't need to call drawDisplayTft() as it is called automatically after each main loop to draw the current
- * frame-buffer to the TFT.
+ * frame-buffer to the TFT. drawDisplayTft() waits for the frame to be sent before returning, unless
+ * enableAsyncScanoutTft() is called, in which case it returns once the frame is queued for DMA so the next frame can be
+ * drawn while the prior one is still being sent. waitDisplayTft() blocks until the transfer is finished.
  *
  * clearPxTft() is used to clear the current frame-buffer.
  * This must be called before drawing a new frame, unless you want to draw over the prior one.
@@ -25,6 +27,20 @@
  * setPxTft() and getPxTft() are used to set and get individual pixels in the frame-buffer, respectively.
  * These are not often used directly as there are helper functions to draw text, shapes, and sprites.
  *
+ * enableDirtyTrackingTft() may be called to only send the parts of the display which changed since the last frame.
+ * This is useful for mostly static screens which don't clear and redraw everything every frame, as it saves SPI time
+ * and CPU. setPxTft() and the text, shape, fill, and WSG drawing functions mark the rows they draw to automatically.
+ * TURBO_SET_PIXEL() and TURBO_SET_PIXEL_BOUNDS() do not, so anything which uses them or writes to
+ * getPxTftFramebuffer() directly must call markDirtyRowsTft() for the rows it modified. getFrameBytesSentTft() returns
+ * how many bytes were sent for the last frame.
+ *
+ * setBandRendererTft() may be called to stop using the frame-buffer entirely. The frame-buffer is freed, and instead
+ * drawDisplayTft() calls the given ::fnBandRenderCallback_t to draw each band into a small band buffer right before it
+ * is converted and sent, so drawing overlaps the SPI transfer of the prior band. While a band renderer is set,
+ * getPxTftFramebuffer() returns NULL, setPxTft(), getPxTft(), and clearPxTft() do nothing, the background draw callback
+ * is not called, and every band is sent every frame. displayList.h is a band renderer which draws a list of commands.
+ * The band renderer is removed when the Swadge mode changes.
+ *
  * disableTFTBacklight() and enableTFTBacklight() may be called to disable and enable the backlight, respectively.
  * This may be useful if the Swadge mode is trying to save power, or the TFT is not necessary.
  * setTFTBacklightBrightness() is used to set the TFT's brightness. This is usually handled globally by a persistent
@@ -122,6 +138,17 @@
  */
 typedef void (*fnBackgroundDrawCallback_t)(int16_t x, int16_t y, int16_t w, int16_t h, int16_t up, int16_t upNum);
 
+/**
+ * @brief This is a typedef for a function pointer passed to setBandRendererTft() which will be called by
+ * drawDisplayTft() to draw each band of the display, instead of reading the band from the frame-buffer
+ *
+ * @param px The band's pixels, TFT_WIDTH wide and h tall in row order. Their prior contents are undefined, so every
+ * pixel must be drawn
+ * @param y The display row the band starts at
+ * @param h The number of rows in the band
+ */
+typedef void (*fnBandRenderCallback_t)(paletteColor_t* px, int16_t y, int16_t h);
+
 void initTFT(spi_host_device_t spiHost, gpio_num_t sclk, gpio_num_t mosi, gpio_num_t dc, gpio_num_t cs, gpio_num_t rst,
              gpio_num_t backlight, bool isPwmBacklight, ledc_channel_t ledcChannel, ledc_timer_t ledcTimer,
              uint8_t brightness);
@@ -137,6 +164,13 @@ paletteColor_t getPxTft(int16_t x, int16_t y);
 paletteColor_t* getPxTftFramebuffer(void);
 void clearPxTft(void);
 void drawDisplayTft(fnBackgroundDrawCallback_t cb);
+void waitDisplayTft(void);
+void enableAsyncScanoutTft(bool enable);
+void enableDirtyTrackingTft(bool enable);
+void markDirtyRowsTft(int32_t yStart, int32_t yEnd);
+uint32_t getFrameBytesSentTft(void);
+bool setBandRendererTft(fnBandRenderCallback_t cb);
+fnBandRenderCallback_t getBandRendererTft(void);
 
 #if defined(__XTENSA__)
     /**
@@ -1,6 +1,7 @@
 #pragma once
 
 void emuSetUseRealTime(bool useRealTime);
+bool emuGetUseRealTime(void);
 void emuSetEspTimerTime(int64_t timeUs);
 void emuTimerPause(void);
 void emuTimerUnpause(void);
@@ -1 +1,10 @@
 #pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char* const pcName, const uint32_t usStackDepth,
+                       void* const pvParameters, UBaseType_t uxPriority, TaskHandle_t* const pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
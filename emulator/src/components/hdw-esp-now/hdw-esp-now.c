@@ -42,6 +42,7 @@
 #include "esp_wifi.h"
 #include "esp_log.h"
 #include "emu_main.h"
+#include "macros.h"
 
 #include "p2pConnection.h"
 
@@ -61,6 +62,13 @@ hostEspNowSendCb_t hostEspNowSendCb = NULL;
 
 int socketFd;
 
+static hostEspNowRecvBatchCb_t hostEspNowRecvBatchCb = NULL;
+
+/// Packets drained by checkEspNowRxQueue()
+static espNowPacket_t rxBatch[CONFIG_ESP_NOW_RX_QUEUE_LEN];
+/// Counters for received packets. The socket's buffer is the queue, so drops can't be counted
+static espNowRxStats_t rxStats = {0};
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -85,6 +93,8 @@ esp_err_t initEspNow(hostEspNowRecvCb_t recvCb, hostEspNowSendCb_t sendCb, gpio_
     hostEspNowRecvCb = recvCb;
     hostEspNowSendCb = sendCb;
 
+    memset(&rxStats, 0, sizeof(rxStats));
+
 #if defined(USING_WINDOWS)
     // Initialize Winsock
     WSADATA wsaData;
@@ -218,42 +228,119 @@ esp_err_t espNowPostLightSleep(void)
 }
 
 /**
- * Check the ESP NOW receive queue. If there are any received packets, send
- * them to hostEspNowRecvCb()
+ * @brief Set a callback which receives all packets drained by each checkEspNowRxQueue() at once
+ *
+ * @param batchCb The callback, or NULL to receive packets one at a time again
  */
-void checkEspNowRxQueue(void)
+void espNowSetRecvBatchCb(hostEspNowRecvBatchCb_t batchCb)
+{
+    hostEspNowRecvBatchCb = batchCb;
+}
+
+/**
+ * @brief Move all received packets which are waiting into an array, up to the array's length
+ *
+ * @param packets The array to write packets to
+ * @param maxPackets The length of the array
+ * @return The number of packets written to the array
+ */
+uint16_t espNowDrainRxQueue(espNowPacket_t* packets, uint16_t maxPackets)
 {
     char recvString[MAXRECVSTRING + 1]; // Buffer for received string
     int recvStringLen;                  // Length of received string
 
-    // While we've received a packet
-    while ((recvStringLen = recvfrom(socketFd, recvString, MAXRECVSTRING, 0, NULL, 0)) > 0)
+    uint8_t ourMac[6] = {0};
+    getMacAddrNvs(ourMac);
+
+    // While we've received a packet and there's room for it
+    uint16_t count = 0;
+    while (count < maxPackets && (recvStringLen = recvfrom(socketFd, recvString, MAXRECVSTRING, 0, NULL, 0)) > 0)
     {
         // If the packet matches the ESP_NOW format
-        uint8_t recvMac[6] = {0};
-        if (6
-            == sscanf(recvString, "ESP_NOW-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX-", &recvMac[0], &recvMac[1],
-                      &recvMac[2], &recvMac[3], &recvMac[4], &recvMac[5]))
+        espNowPacket_t* packet = &packets[count];
+        if (recvStringLen >= 21
+            && 6
+                   == sscanf(recvString, "ESP_NOW-%02hhX%02hhX%02hhX%02hhX%02hhX%02hhX-", &packet->mac[0],
+                             &packet->mac[1], &packet->mac[2], &packet->mac[3], &packet->mac[4], &packet->mac[5]))
         {
             // Make sure the MAC differs from our own
+            if (0 != memcmp(packet->mac, ourMac, sizeof(ourMac)))
+            {
+                packet->rssi = 0x7F;
+                packet->len  = MIN(recvStringLen - 21, (int)sizeof(packet->data));
+                memcpy(packet->data, &recvString[21], packet->len);
+                rxStats.received++;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Check the ESP NOW receive queue. Drain all received packets and send them to the ::hostEspNowRecvBatchCb_t if it is
+ * set, or to hostEspNowRecvCb() one at a time if it isn't
+ */
+void checkEspNowRxQueue(void)
+{
+    // Keep draining until the socket is empty, it can hold more than one batch
+    uint16_t count;
+    do
+    {
+        count = espNowDrainRxQueue(rxBatch, ARRAY_SIZE(rxBatch));
+        if (0 == count)
+        {
+            break;
+        }
+
+        if (count > rxStats.maxBatch)
+        {
+            rxStats.maxBatch = count;
+        }
+
+        if (NULL != hostEspNowRecvBatchCb)
+        {
+            hostEspNowRecvBatchCb(rxBatch, count);
+        }
+        else
+        {
             uint8_t ourMac[6] = {0};
             getMacAddrNvs(ourMac);
-            if (0 != memcmp(recvMac, ourMac, sizeof(ourMac)))
+
+            for (uint16_t i = 0; i < count; i++)
             {
                 // Set up the receive info
                 esp_now_recv_info_t espNowInfo = {0};
-                espNowInfo.src_addr            = recvMac;
+                espNowInfo.src_addr            = rxBatch[i].mac;
                 espNowInfo.des_addr            = ourMac;
 
                 wifi_pkt_rx_ctrl_t packetRxCtrl = {0};
-                packetRxCtrl.rssi               = 0x7F;
+                packetRxCtrl.rssi               = rxBatch[i].rssi;
                 espNowInfo.rx_ctrl              = &packetRxCtrl;
 
-                // If it does, send it to the application through the callback
-                hostEspNowRecvCb(&espNowInfo, (uint8_t*)&recvString[21], recvStringLen - 21, packetRxCtrl.rssi);
+                // Send it to the application through the callback
+                hostEspNowRecvCb(&espNowInfo, rxBatch[i].data, rxBatch[i].len, packetRxCtrl.rssi);
             }
         }
-    }
+    } while (ARRAY_SIZE(rxBatch) == count);
+}
+
+/**
+ * @brief Get counters for received packets since initEspNow() or espNowResetRxStats()
+ *
+ * @param stats The counters are written here
+ */
+void espNowGetRxStats(espNowRxStats_t* stats)
+{
+    *stats = rxStats;
+}
+
+/**
+ * @brief Reset the counters for received packets to zero
+ */
+void espNowResetRxStats(void)
+{
+    memset(&rxStats, 0, sizeof(rxStats));
 }
 
 /**
@@ -310,6 +397,7 @@ void espNowSend(const char* data, uint8_t dataLen)
  */
 void deinitEspNow(void)
 {
+    hostEspNowRecvBatchCb = NULL;
     close(socketFd);
 #if defined(USING_WINDOWS)
     WSACleanup();
@@ -20,6 +20,7 @@
 #include "emu_utils.h"
 #include "hashMap.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 //==============================================================================
 // Defines
@@ -32,6 +33,9 @@
 #define NVS_ENTRY_BYTES      32
 #define NVS_OVERHEAD_ENTRIES 12
 
+// How long to wait after a change before writing the NVS file, so that many changes are written at once
+#define NVS_FLUSH_DELAY_US 1000000
+
 //==============================================================================
 // Structs
 //==============================================================================
@@ -59,6 +63,15 @@ static FILE* openNvsFile(const char* mode);
 static size_t emuGetInjectedBlobLength(const char* namespace, const char* key);
 static void* emuGetInjectedBlob(const char* namespace, const char* key);
 static bool emuGetInjected32(const char* namespace, const char* key, int32_t* out);
+static bool loadNvsJson(void);
+static void unloadNvsJson(void);
+static cJSON* getNvsJson(void);
+static cJSON* getNvsNamespace(const char* namespace, bool create);
+static void setNvsItem(cJSON* jsonNs, const char* key, cJSON* jsonVal);
+static void markNvsDirty(void);
+static void flushNvs(void);
+static void nvsFlushTimerCb(void* arg);
+static void nvsAtExit(void);
 
 //==============================================================================
 // Constants
@@ -83,12 +96,25 @@ static const char** nvsFileName = defaultNvsFiles;
 static bool nvsInjectedDataInit = false;
 static hashMap_t nvsInjectedData;
 
+/// The parsed contents of the NVS file, which all reads and writes use
+static cJSON* nvsJson = NULL;
+/// Whether nvsJson has changes which haven't been written to the NVS file yet
+static bool nvsDirty = false;
+/// A timer to write changes to the NVS file shortly after they are made
+static esp_timer_handle_t nvsFlushTimer = NULL;
+/// Whether nvsAtExit() has been registered
+static bool nvsAtExitRegistered = false;
+/// Incremented every time the in-memory NVS changes
+static uint32_t nvsGeneration = 0;
+/// If not NULL, NVS is kept in this string instead of the NVS file, see emuNvsUseScratch()
+static char* nvsScratch = NULL;
+
 //==============================================================================
 // Functions
 //==============================================================================
 
 /**
- * @brief Initialize the nonvolatile storage
+ * @brief Initialize the nonvolatile storage. The NVS file is read once and kept in memory
  *
  * @param firstTry true if this is the first time NVS is initialized this boot,
  *                 false otherwise
@@ -102,6 +128,25 @@ bool initNvs(bool firstTry)
         nvsInjectedDataInit = true;
     }
 
+    if (!nvsAtExitRegistered)
+    {
+        // Make sure pending writes are saved no matter how the emulator exits
+        atexit(nvsAtExit);
+        nvsAtExitRegistered = true;
+    }
+
+    if (NULL == nvsFlushTimer)
+    {
+        esp_timer_create_args_t nvsFlushTimerArgs = {
+            .callback              = nvsFlushTimerCb,
+            .arg                   = NULL,
+            .dispatch_method       = ESP_TIMER_TASK,
+            .name                  = "nvs_flush",
+            .skip_unhandled_events = true,
+        };
+        esp_timer_create(&nvsFlushTimerArgs, &nvsFlushTimer);
+    }
+
     const char** curFile;
     for (curFile = defaultNvsFiles; curFile < (defaultNvsFiles + (sizeof(defaultNvsFiles) / sizeof(*defaultNvsFiles)));
          curFile++)
@@ -145,7 +190,7 @@ bool initNvs(bool firstTry)
                         fclose(nvsFile);
                         nvsFileName = curFile;
                         printf("Using NVS file %s\n", *nvsFileName);
-                        return true;
+                        return loadNvsJson();
                     }
                     else
                     {
@@ -160,7 +205,7 @@ bool initNvs(bool firstTry)
             // File exists
             nvsFileName = curFile;
             printf("Using NVS file %s\n", *nvsFileName);
-            return true;
+            return loadNvsJson();
         }
 
         printf("Could not load NVS file %s\n", *curFile);
@@ -170,12 +215,21 @@ bool initNvs(bool firstTry)
 }
 
 /**
- * @brief Deinitialize NVS
+ * @brief Deinitialize NVS, writing any pending changes to the NVS file
  *
  * @return true
  */
 bool deinitNvs(void)
 {
+    unloadNvsJson();
+
+    if (NULL != nvsFlushTimer)
+    {
+        esp_timer_stop(nvsFlushTimer);
+        esp_timer_delete(nvsFlushTimer);
+        nvsFlushTimer = NULL;
+    }
+
     if (nvsInjectedDataInit)
     {
         hashIterator_t iter = {0};
@@ -187,7 +241,7 @@ bool deinitNvs(void)
         hashDeinit(&nvsInjectedData);
         nvsInjectedDataInit = false;
     }
-    return true; // Nothing to do
+    return true;
 }
 
 /**
@@ -197,6 +251,20 @@ bool deinitNvs(void)
  */
 bool eraseNvs(void)
 {
+    // Drop the in-memory copy without writing it back
+    cJSON_Delete(nvsJson);
+    nvsJson  = NULL;
+    nvsDirty = false;
+    nvsGeneration++;
+
+    // Leave the NVS file alone while using scratch storage
+    if (NULL != nvsScratch)
+    {
+        free(nvsScratch);
+        nvsScratch = strdup(defaultNvsValue);
+        return loadNvsJson();
+    }
+
     // Check if the json file exists
     if (access(NVS_JSON_FILE, F_OK) != 0)
     {
@@ -257,72 +325,17 @@ bool readNamespaceNvs32(const char* namespace, const char* key, int32_t* outVal)
         return true;
     }
 
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    cJSON* jsonVal = cJSON_GetObjectItemCaseSensitive(getNvsNamespace(namespace, false), key);
+    if (cJSON_IsNumber(jsonVal))
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        if (fsize == 0)
-        {
-            fclose(nvsFile);
-            return false;
-        }
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
-
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-            cJSON* jsonIter;
-
-            if (!json)
-            {
-                return false;
-            }
-
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (cJSON_IsObject(jsonNs))
-            {
-                // Find the requested key
-                char* current_key = NULL;
-                cJSON_ArrayForEach(jsonIter, jsonNs)
-                {
-                    current_key = jsonIter->string;
-                    if (current_key != NULL)
-                    {
-                        // If the key matches
-                        if (0 == strcmp(current_key, key))
-                        {
-                            // Return the value
-                            *outVal = (int32_t)cJSON_GetNumberValue(jsonIter);
-                            cJSON_Delete(json);
-                            return true;
-                        }
-                    }
-                }
-            }
-            cJSON_Delete(json);
-        }
-        else
-        {
-            fclose(nvsFile);
-        }
+        *outVal = (int32_t)cJSON_GetNumberValue(jsonVal);
+        return true;
     }
     return false;
 }
 
 /**
- * @brief Write a 32 bit value to NVS with a given string key
+ * @brief Write a 32 bit value to NVS with a given string key. The NVS file is written shortly after
  *
  * @param namespace The NVS namespace to use
  * @param key The key for the value to write
@@ -331,86 +344,21 @@ bool readNamespaceNvs32(const char* namespace, const char* key, int32_t* outVal)
  */
 bool writeNamespaceNvs32(const char* namespace, const char* key, int32_t val)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    cJSON* jsonNs = getNvsNamespace(namespace, true);
+    if (NULL == jsonNs)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
-
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (NULL == jsonNs)
-            {
-                jsonNs = cJSON_CreateObject();
-                cJSON_AddItemToObject(json, namespace, jsonNs);
-            }
-
-            // Check if the key alredy exists
-            cJSON* jsonIter;
-            bool keyExists = false;
-            cJSON_ArrayForEach(jsonIter, jsonNs)
-            {
-                if (0 == strcmp(jsonIter->string, key))
-                {
-                    keyExists = true;
-                }
-            }
-
-            // Add or replace the item
-            cJSON* jsonVal = cJSON_CreateNumber(val);
-            if (keyExists)
-            {
-                cJSON_ReplaceItemInObject(jsonNs, key, jsonVal);
-            }
-            else
-            {
-                cJSON_AddItemToObject(jsonNs, key, jsonVal);
-            }
-
-            // Write the new JSON back to the file
-            FILE* nvsFileW = openNvsFile("wb");
-            if (NULL != nvsFileW)
-            {
-                char* jsonStr = cJSON_Print(json);
-                fprintf(nvsFileW, "%s", jsonStr);
-                fclose(nvsFileW);
-
-                free(jsonStr);
-                cJSON_Delete(json);
-
-                return true;
-            }
-            else
-            {
-                // Couldn't open file to write
-            }
-            cJSON_Delete(json);
-        }
-        else
-        {
-            // Couldn't read file
-            fclose(nvsFile);
-        }
+        return false;
     }
-    else
+
+    // Don't bother writing the file if nothing changed
+    cJSON* jsonVal = cJSON_GetObjectItemCaseSensitive(jsonNs, key);
+    if (cJSON_IsNumber(jsonVal) && val == (int32_t)cJSON_GetNumberValue(jsonVal))
     {
-        // couldn't open file to read
+        return true;
     }
-    return false;
+
+    setNvsItem(jsonNs, key, cJSON_CreateNumber(val));
+    return true;
 }
 
 /**
@@ -442,72 +390,26 @@ bool readNamespaceNvsBlob(const char* namespace, const char* key, void* out_valu
         return true;
     }
 
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    char* strBlob = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(getNvsNamespace(namespace, false), key));
+    if (NULL != strBlob)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
+        if (out_value != NULL)
         {
-            // Close the file
-            fclose(nvsFile);
-
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-            cJSON* jsonIter;
-
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (NULL != jsonNs && cJSON_IsObject(jsonNs))
-            {
-                // Find the requested key
-                char* current_key = NULL;
-                cJSON_ArrayForEach(jsonIter, jsonNs)
-                {
-                    current_key = jsonIter->string;
-                    if (current_key != NULL)
-                    {
-                        // If the key matches
-                        if (0 == strcmp(current_key, key))
-                        {
-                            // Return the value
-                            char* strBlob = cJSON_GetStringValue(jsonIter);
-
-                            if (out_value != NULL)
-                            {
-                                // The call to read, using returned length
-                                strToBlob(strBlob, out_value, *length);
-                            }
-                            else
-                            {
-                                // The call to get length of blob
-                                *length = strlen(strBlob) / 2;
-                            }
-                            cJSON_Delete(json);
-                            return true;
-                        }
-                    }
-                }
-            }
-            cJSON_Delete(json);
+            // The call to read, using returned length
+            strToBlob(strBlob, out_value, *length);
         }
         else
         {
-            fclose(nvsFile);
+            // The call to get length of blob
+            *length = strlen(strBlob) / 2;
         }
+        return true;
     }
     return false;
 }
 
 /**
- * @brief Write a blob to NVS with a given string key
+ * @brief Write a blob to NVS with a given string key. The NVS file is written shortly after
  *
  * @param namespace The NVS namespace to use
  * @param key The key for the value to write
@@ -517,88 +419,22 @@ bool readNamespaceNvsBlob(const char* namespace, const char* key, void* out_valu
  */
 bool writeNamespaceNvsBlob(const char* namespace, const char* key, const void* value, size_t length)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    cJSON* jsonNs = getNvsNamespace(namespace, true);
+    if (NULL == jsonNs)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
-
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (NULL == jsonNs)
-            {
-                jsonNs = cJSON_CreateObject();
-                cJSON_AddItemToObject(json, namespace, jsonNs);
-            }
-
-            // Check if the key alredy exists
-            cJSON* jsonIter;
-            bool keyExists = false;
-            cJSON_ArrayForEach(jsonIter, jsonNs)
-            {
-                if (0 == strcmp(jsonIter->string, key))
-                {
-                    keyExists = true;
-                }
-            }
-
-            // Add or replace the item
-            char* blobStr  = blobToStr(value, length);
-            cJSON* jsonVal = cJSON_CreateString(blobStr);
-            free(blobStr);
-            if (keyExists)
-            {
-                cJSON_ReplaceItemInObject(jsonNs, key, jsonVal);
-            }
-            else
-            {
-                cJSON_AddItemToObject(jsonNs, key, jsonVal);
-            }
-
-            // Write the new JSON back to the file
-            FILE* nvsFileW = openNvsFile("wb");
-            if (NULL != nvsFileW)
-            {
-                char* jsonStr = cJSON_Print(json);
-                fprintf(nvsFileW, "%s", jsonStr);
-                fclose(nvsFileW);
+        return false;
+    }
 
-                free(jsonStr);
-                cJSON_Delete(json);
+    char* blobStr = blobToStr(value, length);
 
-                return true;
-            }
-            else
-            {
-                // Couldn't open file to write
-            }
-            cJSON_Delete(json);
-        }
-        else
-        {
-            // Couldn't read file
-            fclose(nvsFile);
-        }
-    }
-    else
+    // Don't bother writing the file if nothing changed
+    char* oldStr = cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(jsonNs, key));
+    if (NULL == oldStr || 0 != strcmp(oldStr, blobStr))
     {
-        // couldn't open file to read
+        setNvsItem(jsonNs, key, cJSON_CreateString(blobStr));
     }
-    return false;
+    free(blobStr);
+    return true;
 }
 
 /**
@@ -650,77 +486,12 @@ bool eraseNvsKey(const char* key)
  */
 bool eraseNamespaceNvsKey(const char* namespace, const char* key)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
-    {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
-
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-
-            // Check if the key exists
-            cJSON* jsonIter;
-            bool keyExists = false;
-
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (NULL != jsonNs)
-            {
-                cJSON_ArrayForEach(jsonIter, jsonNs)
-                {
-                    if (0 == strcmp(jsonIter->string, key))
-                    {
-                        keyExists = true;
-                    }
-                }
-            }
-
-            // Remove the key if it exists
-            if (keyExists)
-            {
-                cJSON_DeleteItemFromObject(jsonNs, key);
-            }
-
-            // Write the new JSON back to the file
-            FILE* nvsFileW = openNvsFile("wb");
-            if (NULL != nvsFileW)
-            {
-                char* jsonStr = cJSON_Print(json);
-                fprintf(nvsFileW, "%s", jsonStr);
-                fclose(nvsFileW);
-
-                free(jsonStr);
-                cJSON_Delete(json);
-
-                return keyExists;
-            }
-            else
-            {
-                // Couldn't open file to write
-            }
-            cJSON_Delete(json);
-        }
-        else
-        {
-            // Couldn't read file
-            fclose(nvsFile);
-        }
-    }
-    else
+    cJSON* jsonNs = getNvsNamespace(namespace, false);
+    if (NULL != cJSON_GetObjectItemCaseSensitive(jsonNs, key))
     {
-        // couldn't open file to read
+        cJSON_DeleteItemFromObjectCaseSensitive(jsonNs, key);
+        markNvsDirty();
+        return true;
     }
     return false;
 }
@@ -734,93 +505,72 @@ bool eraseNamespaceNvsKey(const char* namespace, const char* key)
  */
 bool readNvsStats(nvs_stats_t* outStats)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    cJSON* json = getNvsJson();
+    if (NULL == json)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
+        return false;
+    }
 
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-            cJSON* jsonIter;
-            cJSON* namespace;
+    cJSON* jsonIter;
+    cJSON* namespace;
 
-            cJSON_ArrayForEach(namespace, json)
+    cJSON_ArrayForEach(namespace, json)
+    {
+        // 1 entry is always used by each namespace, and there should only ever be 1 namespace
+        outStats->used_entries++;
+        // TODO: I just checked a Swadge and it said it was using 5 namespaces. Why?
+        outStats->namespace_count++;
+        /**
+         * When running readNvsStats() on an actual Swadge, the total NVS
+         * size is displayed as 12 entries less than the partition size.
+         *
+         * It's unknown if this is a percentage of total size,
+         * or a fixed number of overhead/control entries.
+         * I'm assuming it's a fixed number here.
+         */
+        outStats->total_entries = NVS_PARTITION_SIZE / NVS_ENTRY_BYTES - NVS_OVERHEAD_ENTRIES;
+
+        cJSON_ArrayForEach(jsonIter, namespace)
+        {
+            if (jsonIter->string != NULL)
             {
-                // 1 entry is always used by each namespace, and there should only ever be 1 namespace
-                outStats->used_entries++;
-                // TODO: I just checked a Swadge and it said it was using 5 namespaces. Why?
-                outStats->namespace_count++;
-                /**
-                 * When running readNvsStats() on an actual Swadge, the total NVS
-                 * size is displayed as 12 entries less than the partition size.
-                 *
-                 * It's unknown if this is a percentage of total size,
-                 * or a fixed number of overhead/control entries.
-                 * I'm assuming it's a fixed number here.
-                 */
-                outStats->total_entries = NVS_PARTITION_SIZE / NVS_ENTRY_BYTES - NVS_OVERHEAD_ENTRIES;
-
-                cJSON_ArrayForEach(jsonIter, namespace)
+                switch (jsonIter->type)
                 {
-                    if (jsonIter->string != NULL)
+                    case cJSON_Number:
                     {
-                        switch (jsonIter->type)
-                        {
-                            case cJSON_Number:
-                            {
-                                outStats->used_entries += 1;
-                                break;
-                            }
-                            case cJSON_String:
-                            {
-                                char* strBlob = cJSON_GetStringValue(jsonIter);
-
-                                /**
-                                 * Get length of blob
-                                 *
-                                 * When the ESP32 is storing blobs, it uses 1 entry to index chunks,
-                                 * 1 entry per chunk, then 1 entry for every 32 bytes of data, rounding up.
-                                 *
-                                 * I don't know how to find out how many chunks the ESP32 would split
-                                 * certain length blobs into, so for now I'm assuming 1 chunk per blob.
-                                 *
-                                 * Blobs in the JSON are encoded as hexadecimal, so every 2 characters are
-                                 * 1 byte of data. Then, every 32 bytes of data is an entry.
-                                 */
-                                outStats->used_entries += 2 + ceil(strlen(strBlob) / 2.0f / NVS_ENTRY_BYTES);
-                                break;
-                            }
-                            default:
-                            {
-                                break;
-                            }
-                        }
+                        outStats->used_entries += 1;
+                        break;
+                    }
+                    case cJSON_String:
+                    {
+                        char* strBlob = cJSON_GetStringValue(jsonIter);
+
+                        /**
+                         * Get length of blob
+                         *
+                         * When the ESP32 is storing blobs, it uses 1 entry to index chunks,
+                         * 1 entry per chunk, then 1 entry for every 32 bytes of data, rounding up.
+                         *
+                         * I don't know how to find out how many chunks the ESP32 would split
+                         * certain length blobs into, so for now I'm assuming 1 chunk per blob.
+                         *
+                         * Blobs in the JSON are encoded as hexadecimal, so every 2 characters are
+                         * 1 byte of data. Then, every 32 bytes of data is an entry.
+                         */
+                        outStats->used_entries += 2 + ceil(strlen(strBlob) / 2.0f / NVS_ENTRY_BYTES);
+                        break;
+                    }
+                    default:
+                    {
+                        break;
                     }
                 }
             }
-
-            outStats->free_entries = outStats->total_entries - outStats->used_entries;
-            cJSON_Delete(json);
-            return true;
-        }
-        else
-        {
-            fclose(nvsFile);
         }
     }
-    return false;
+
+    outStats->free_entries = outStats->total_entries - outStats->used_entries;
+    return true;
 }
 
 /**
@@ -839,113 +589,85 @@ bool readNvsStats(nvs_stats_t* outStats)
 bool readNamespaceNvsEntryInfos(const char* namespace, nvs_stats_t* outStats, nvs_entry_info_t* outEntryInfos,
                                 size_t* numEntryInfos)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
-    {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
-        {
-            // Close the file
-            fclose(nvsFile);
+    cJSON* jsonIter;
 
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-            cJSON* jsonIter;
-
-            // If the user doesn't want to receive the stats, only use them internally
-            bool freeOutStats = false;
-            if (outStats == NULL)
-            {
-                outStats     = heap_caps_calloc(1, sizeof(nvs_stats_t), MALLOC_CAP_8BIT);
-                freeOutStats = true;
-            }
+    // If the user doesn't want to receive the stats, only use them internally
+    bool freeOutStats = false;
+    if (outStats == NULL)
+    {
+        outStats     = heap_caps_calloc(1, sizeof(nvs_stats_t), MALLOC_CAP_8BIT);
+        freeOutStats = true;
+    }
 
-            if (!readNvsStats(outStats))
-            {
-                if (freeOutStats)
-                {
-                    free(outStats);
-                }
-                return false;
-            }
+    if (!readNvsStats(outStats))
+    {
+        if (freeOutStats)
+        {
+            free(outStats);
+        }
+        return false;
+    }
 
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
+    cJSON* jsonNs = getNvsNamespace(namespace, false);
 
-            if (NULL != jsonNs && cJSON_IsObject(jsonNs))
+    if (NULL != jsonNs)
+    {
+        int i = 0;
+        char* current_key;
+        cJSON_ArrayForEach(jsonIter, jsonNs)
+        {
+            current_key = jsonIter->string;
+            if (current_key != NULL)
             {
-                int i = 0;
-                char* current_key;
-                cJSON_ArrayForEach(jsonIter, jsonNs)
+                if (outEntryInfos != NULL)
                 {
-                    current_key = jsonIter->string;
-                    if (current_key != NULL)
+                    switch (jsonIter->type)
                     {
-                        if (outEntryInfos != NULL)
+                        case cJSON_Number:
                         {
-                            switch (jsonIter->type)
-                            {
-                                case cJSON_Number:
-                                {
 #ifdef USING_U32
-                                    // cJSON cannot store any integer larger than 2^53 or smaller than -(2^53), since
-                                    // those are the limits of a double
-                                    int64_t val = (int64_t)cJSON_GetNumberValue(jsonIter);
-                                    if (val > INT32_MAX)
-                                    {
-                                        outEntryInfos[i].type = NVS_TYPE_U32;
-                                    }
-                                    else
+                            // cJSON cannot store any integer larger than 2^53 or smaller than -(2^53), since
+                            // those are the limits of a double
+                            int64_t val = (int64_t)cJSON_GetNumberValue(jsonIter);
+                            if (val > INT32_MAX)
+                            {
+                                outEntryInfos[i].type = NVS_TYPE_U32;
+                            }
+                            else
 #endif
-                                    {
-                                        outEntryInfos[i].type = NVS_TYPE_I32;
-                                    }
-                                    break;
-                                }
-                                case cJSON_String:
-                                {
-                                    outEntryInfos[i].type = NVS_TYPE_BLOB;
-                                    break;
-                                }
-                                default:
-                                {
-                                    break;
-                                }
+                            {
+                                outEntryInfos[i].type = NVS_TYPE_I32;
                             }
-                            snprintf(outEntryInfos[i].namespace_name, NVS_KEY_NAME_MAX_SIZE, "%s", namespace);
-                            snprintf(outEntryInfos[i].key, NVS_KEY_NAME_MAX_SIZE, "%s", current_key);
+                            break;
+                        }
+                        case cJSON_String:
+                        {
+                            outEntryInfos[i].type = NVS_TYPE_BLOB;
+                            break;
+                        }
+                        default:
+                        {
+                            break;
                         }
-                        i++;
                     }
+                    snprintf(outEntryInfos[i].namespace_name, NVS_KEY_NAME_MAX_SIZE, "%s", namespace);
+                    snprintf(outEntryInfos[i].key, NVS_KEY_NAME_MAX_SIZE, "%s", current_key);
                 }
-
-                if (outEntryInfos == NULL)
-                {
-                    *numEntryInfos = i;
-                }
-            }
-
-            if (freeOutStats)
-            {
-                free(outStats);
+                i++;
             }
-
-            cJSON_Delete(json);
-            return true;
         }
-        else
+
+        if (outEntryInfos == NULL)
         {
-            fclose(nvsFile);
+            *numEntryInfos = i;
         }
     }
-    return false;
+
+    if (freeOutStats)
+    {
+        free(outStats);
+    }
+    return true;
 }
 
 /**
@@ -974,43 +696,209 @@ bool readAllNvsEntryInfos(nvs_stats_t* outStats, nvs_entry_info_t* outEntryInfos
  */
 bool nvsNamespaceInUse(const char* namespace)
 {
+    cJSON* jsonNs = getNvsNamespace(namespace, false);
+    return (NULL != jsonNs) && (cJSON_GetArraySize(jsonNs) != 0);
+}
+
+/**
+ * @brief Read and parse the NVS file into memory, replacing the current in-memory copy. Pending changes to the
+ * current copy are written first
+ *
+ * @return true if the NVS file was loaded, false if it could not be read
+ */
+static bool loadNvsJson(void)
+{
+    unloadNvsJson();
+
+    // Scratch storage replaces the file
+    if (NULL != nvsScratch)
+    {
+        nvsJson = cJSON_Parse(nvsScratch);
+        if (!cJSON_IsObject(nvsJson))
+        {
+            cJSON_Delete(nvsJson);
+            nvsJson = cJSON_CreateObject();
+        }
+        return true;
+    }
+
     // Open the file
     FILE* nvsFile = openNvsFile("rb");
+    if (NULL == nvsFile)
+    {
+        return false;
+    }
+
+    // Get the file size
+    fseek(nvsFile, 0L, SEEK_END);
+    size_t fsize = ftell(nvsFile);
+    fseek(nvsFile, 0L, SEEK_SET);
+
+    // Read the file
+    char* fbuf = malloc(fsize + 1);
+    if (NULL == fbuf)
+    {
+        fclose(nvsFile);
+        return false;
+    }
+    fbuf[fsize] = 0;
+    bool ok     = (fsize == fread(fbuf, 1, fsize, nvsFile));
+    fclose(nvsFile);
 
-    if (NULL != nvsFile)
+    if (ok)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
+        // Parse the JSON. Start over with empty storage if it's corrupt
+        nvsJson = cJSON_Parse(fbuf);
+        if (!cJSON_IsObject(nvsJson))
         {
-            // Close the file
-            fclose(nvsFile);
+            printf("Could not parse NVS file %s, starting with empty storage\n", NVS_JSON_FILE);
+            cJSON_Delete(nvsJson);
+            nvsJson = cJSON_CreateObject();
+        }
+    }
+    free(fbuf);
+    return ok;
+}
 
-            // Parse the JSON
-            cJSON* json   = cJSON_Parse(fbuf);
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-            bool result   = false;
+/**
+ * @brief Write any pending changes to the NVS file and free the in-memory copy
+ */
+static void unloadNvsJson(void)
+{
+    flushNvs();
+    cJSON_Delete(nvsJson);
+    nvsJson = NULL;
+}
 
-            if (NULL != jsonNs && cJSON_IsObject(jsonNs))
-            {
-                result = (cJSON_GetArraySize(jsonNs) != 0);
-            }
+/**
+ * @brief Get the in-memory NVS JSON, loading it from the NVS file if it isn't loaded yet
+ *
+ * @return The root JSON object, or NULL if the NVS file could not be read
+ */
+static cJSON* getNvsJson(void)
+{
+    if (NULL == nvsJson)
+    {
+        loadNvsJson();
+    }
+    return nvsJson;
+}
+
+/**
+ * @brief Get the JSON object for an NVS namespace
+ *
+ * @param namespace The NVS namespace to get
+ * @param create true to create the namespace if it doesn't exist
+ * @return The namespace's JSON object, or NULL if it doesn't exist and wasn't created
+ */
+static cJSON* getNvsNamespace(const char* namespace, bool create)
+{
+    cJSON* json = getNvsJson();
+    if (NULL == json)
+    {
+        return NULL;
+    }
+
+    cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
+    if (NULL == jsonNs && create)
+    {
+        jsonNs = cJSON_CreateObject();
+        cJSON_AddItemToObject(json, namespace, jsonNs);
+    }
+    return cJSON_IsObject(jsonNs) ? jsonNs : NULL;
+}
 
-            cJSON_Delete(json);
-            return result;
+/**
+ * @brief Add or replace a value in an NVS namespace, and schedule the NVS file to be written
+ *
+ * @param jsonNs The namespace's JSON object
+ * @param key The key for the value
+ * @param jsonVal The new value, which the namespace takes ownership of
+ */
+static void setNvsItem(cJSON* jsonNs, const char* key, cJSON* jsonVal)
+{
+    if (NULL != cJSON_GetObjectItemCaseSensitive(jsonNs, key))
+    {
+        cJSON_ReplaceItemInObjectCaseSensitive(jsonNs, key, jsonVal);
+    }
+    else
+    {
+        cJSON_AddItemToObject(jsonNs, key, jsonVal);
+    }
+    markNvsDirty();
+}
+
+/**
+ * @brief Note that the in-memory NVS has changed, and start the timer to write it to the NVS file if it isn't running.
+ * Many writes in a row are batched into a single file write
+ */
+static void markNvsDirty(void)
+{
+    nvsGeneration++;
+    if (!nvsDirty)
+    {
+        nvsDirty = true;
+        if (NULL != nvsFlushTimer)
+        {
+            esp_timer_start_once(nvsFlushTimer, NVS_FLUSH_DELAY_US);
         }
-        else
+    }
+}
+
+/**
+ * @brief Write the in-memory NVS to the NVS file, if it has changed
+ */
+static void flushNvs(void)
+{
+    if (!nvsDirty || NULL == nvsJson)
+    {
+        return;
+    }
+
+    // Scratch storage is never written to the file
+    if (NULL != nvsScratch)
+    {
+        char* jsonStr = cJSON_PrintUnformatted(nvsJson);
+        if (NULL != jsonStr)
         {
-            fclose(nvsFile);
+            free(nvsScratch);
+            nvsScratch = jsonStr;
+            nvsDirty   = false;
         }
+        return;
     }
-    return false;
+
+    FILE* nvsFileW = openNvsFile("wb");
+    if (NULL != nvsFileW)
+    {
+        char* jsonStr = cJSON_Print(nvsJson);
+        fprintf(nvsFileW, "%s", jsonStr);
+        fclose(nvsFileW);
+        free(jsonStr);
+        nvsDirty = false;
+    }
+    else
+    {
+        printf("Could not write NVS file %s\n", NVS_JSON_FILE);
+    }
+}
+
+/**
+ * @brief Timer callback to write pending changes to the NVS file
+ *
+ * @param arg unused
+ */
+static void nvsFlushTimerCb(void* arg __attribute__((unused)))
+{
+    flushNvs();
+}
+
+/**
+ * @brief Write pending changes to the NVS file when the emulator exits
+ */
+static void nvsAtExit(void)
+{
+    flushNvs();
 }
 
 /**
@@ -1168,6 +1056,65 @@ void emuInjectNvs32(const char* namespace, const char* key, int32_t value)
     }
 }
 
+/**
+ * @brief Serialize the entire in-memory NVS to a JSON string
+ *
+ * @return The NVS as an unformatted JSON string, which must be free()'d, or NULL if NVS couldn't be read
+ */
+char* emuNvsExportJson(void)
+{
+    cJSON* json = getNvsJson();
+    if (NULL == json)
+    {
+        return NULL;
+    }
+    return cJSON_PrintUnformatted(json);
+}
+
+/**
+ * @brief Keep NVS in memory for the rest of the session, starting from the given JSON, instead of in the NVS file. Any
+ * changes already made are written to the NVS file first, and afterwards the NVS file is never read or written. This
+ * may be called before NVS is initialized, so the Swadge boots with the given NVS
+ *
+ * @param jsonStr The NVS contents, as returned by emuNvsExportJson()
+ * @return true if the JSON was valid and NVS was replaced, false if NVS was not changed
+ */
+bool emuNvsUseScratch(const char* jsonStr)
+{
+    cJSON* json = cJSON_Parse(jsonStr);
+    bool valid  = cJSON_IsObject(json);
+    cJSON_Delete(json);
+    if (!valid)
+    {
+        return false;
+    }
+
+    // Save changes made so far to the real NVS file
+    flushNvs();
+
+    free(nvsScratch);
+    nvsScratch = strdup(jsonStr);
+
+    // Switch to the scratch contents, now if NVS is already loaded or when it's initialized otherwise
+    if (NULL != nvsJson)
+    {
+        loadNvsJson();
+        nvsGeneration++;
+    }
+    return true;
+}
+
+/**
+ * @brief Get a value which changes every time the in-memory NVS changes. This can be compared against an earlier
+ * value to cheaply check whether NVS was written
+ *
+ * @return The current NVS generation
+ */
+uint32_t emuNvsGetGeneration(void)
+{
+    return nvsGeneration;
+}
+
 static size_t emuGetInjectedBlobLength(const char* namespace, const char* key)
 {
     if (!nvsInjectedDataInit)
@@ -1246,42 +1193,19 @@ static bool emuGetInjected32(const char* namespace, const char* key, int32_t* ou
  */
 void getNvsKeys(const char* namespace, list_t* list)
 {
-    // Open the file
-    FILE* nvsFile = openNvsFile("rb");
-    if (NULL != nvsFile)
+    cJSON* jsonIter;
+    cJSON* jsonNs = getNvsNamespace(namespace, false);
+
+    if (NULL != jsonNs)
     {
-        // Get the file size
-        fseek(nvsFile, 0L, SEEK_END);
-        size_t fsize = ftell(nvsFile);
-        fseek(nvsFile, 0L, SEEK_SET);
-
-        // Read the file
-        char fbuf[fsize + 1];
-        fbuf[fsize] = 0;
-        if (fsize == fread(fbuf, 1, fsize, nvsFile))
+        cJSON_ArrayForEach(jsonIter, jsonNs)
         {
-            // Parse the JSON
-            cJSON* json = cJSON_Parse(fbuf);
-
-            // Check if the key exists
-            cJSON* jsonIter;
-            cJSON* jsonNs = cJSON_GetObjectItemCaseSensitive(json, namespace);
-
-            if (NULL != jsonNs)
-            {
-                cJSON_ArrayForEach(jsonIter, jsonNs)
-                {
-                    // Make a copy of the key
-                    size_t keySize = sizeof(char) * (strlen(jsonIter->string) + 1);
-                    char* keyCopy  = heap_caps_calloc(1, keySize, MALLOC_CAP_8BIT);
-                    memcpy(keyCopy, jsonIter->string, keySize);
-                    // Push it into the list
-                    push(list, keyCopy);
-                }
-            }
-            cJSON_Delete(json);
+            // Make a copy of the key
+            size_t keySize = sizeof(char) * (strlen(jsonIter->string) + 1);
+            char* keyCopy  = heap_caps_calloc(1, keySize, MALLOC_CAP_8BIT);
+            memcpy(keyCopy, jsonIter->string, keySize);
+            // Push it into the list
+            push(list, keyCopy);
         }
-        // Close the file
-        fclose(nvsFile);
     }
-}
\ No newline at end of file
+}
@@ -8,6 +8,20 @@
 #include "hdw-tft.h"
 #include "hdw-tft_emu.h"
 #include "emu_main.h"
+#include "macros.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The height of each band the display is sent in, matching the firmware's PARALLEL_LINES
+#define BAND_LINES 16
+
+/// The number of BAND_LINES tall bands the display is sent in
+#define NUM_BANDS ((TFT_HEIGHT + BAND_LINES - 1) / BAND_LINES)
+
+/// A bitmask with a bit set for every band on the display
+#define ALL_BANDS ((uint32_t)((1ULL << NUM_BANDS) - 1))
 
 //==============================================================================
 // Const variables
@@ -87,6 +101,22 @@ static int bitmapHeight              = 0;
 static int displayMult               = 1;
 static bool tftDisabled              = false;
 static uint8_t tftBrightness         = CONFIG_TFT_MAX_BRIGHTNESS;
+static bool dirtyTrackingEnabled     = false;
+static uint32_t dirtyBands           = ALL_BANDS;
+static uint32_t frameBytesSent       = 0;
+
+/// Draws each band instead of the frame-buffer, if set. The emulator keeps its frame-buffer to draw the bands into
+static fnBandRenderCallback_t bandRenderer = NULL;
+
+/// Every palette index converted to a display color at the current brightness. Out-of-bounds indices are bright red
+static uint32_t brightPalette[256];
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void buildBrightPalette(void);
+static void upscaleRowTft(int16_t y);
 
 //==============================================================================
 // Functions
@@ -182,11 +212,11 @@ void powerUpTft(void)
  * in row order, starting from the top left. This can be used t directly modify
  * individual pixels without calling ::setPxTft()
  *
- * @return The pixel framebuffer
+ * @return The pixel framebuffer, or NULL if a band renderer is set with setBandRendererTft()
  */
 paletteColor_t* getPxTftFramebuffer(void)
 {
-    return frameBuffer;
+    return bandRenderer ? NULL : frameBuffer;
 }
 
 /**
@@ -217,7 +247,7 @@ void enableTFTBacklight(void)
  */
 void setPxTft(int16_t x, int16_t y, paletteColor_t px)
 {
-    if (tftDisabled)
+    if (tftDisabled || bandRenderer)
     {
         return;
     }
@@ -225,6 +255,7 @@ void setPxTft(int16_t x, int16_t y, paletteColor_t px)
     if (0 <= x && x < TFT_WIDTH && 0 <= y && y < TFT_HEIGHT)
     {
         frameBuffer[(y * TFT_WIDTH) + x] = px;
+        dirtyBands |= (1 << (y / BAND_LINES));
     }
 }
 
@@ -237,7 +268,7 @@ void setPxTft(int16_t x, int16_t y, paletteColor_t px)
  */
 paletteColor_t getPxTft(int16_t x, int16_t y)
 {
-    if (tftDisabled)
+    if (tftDisabled || bandRenderer)
     {
         return c000;
     }
@@ -256,6 +287,159 @@ paletteColor_t getPxTft(int16_t x, int16_t y)
 void clearPxTft(void)
 {
     memset(frameBuffer, c000, sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH);
+    dirtyBands = ALL_BANDS;
+}
+
+/**
+ * @brief Draw the display one band at a time with a callback instead of from the frame-buffer, or go back to using the
+ * frame-buffer. Like the firmware, the frame-buffer is not available while a band renderer is set, and is black when
+ * the band renderer is removed.
+ *
+ * @param cb The function to draw each band with, or NULL to use the frame-buffer
+ * @return true, the emulator always has memory for the bands
+ */
+bool setBandRendererTft(fnBandRenderCallback_t cb)
+{
+    if (NULL == cb && NULL != bandRenderer)
+    {
+        memset(frameBuffer, c000, sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH);
+    }
+    bandRenderer = cb;
+    dirtyBands   = ALL_BANDS;
+    return true;
+}
+
+/**
+ * @brief Get the band renderer set with setBandRendererTft()
+ *
+ * @return The function drawing each band, or NULL if the frame-buffer is used
+ */
+fnBandRenderCallback_t getBandRendererTft(void)
+{
+    return bandRenderer;
+}
+
+/**
+ * @brief Enable or disable dirty band tracking. When enabled, drawDisplayTft() only converts the bands which were
+ * marked dirty since the last frame, just like the firmware only sends those bands.
+ *
+ * @param enable true to only send dirty bands, false to send the whole display every frame
+ */
+void enableDirtyTrackingTft(bool enable)
+{
+    dirtyTrackingEnabled = enable;
+    dirtyBands           = ALL_BANDS;
+}
+
+/**
+ * @brief Mark a range of rows as dirty so they are sent to the display on the next call to drawDisplayTft()
+ *
+ * @param yStart The first row which was modified, inclusive
+ * @param yEnd The last row which was modified, exclusive
+ */
+void markDirtyRowsTft(int32_t yStart, int32_t yEnd)
+{
+    if (yStart < 0)
+    {
+        yStart = 0;
+    }
+    if (yEnd > TFT_HEIGHT)
+    {
+        yEnd = TFT_HEIGHT;
+    }
+    if (yStart >= yEnd)
+    {
+        return;
+    }
+
+    uint32_t firstBand = yStart / BAND_LINES;
+    uint32_t lastBand  = (yEnd - 1) / BAND_LINES;
+    dirtyBands |= ((2u << lastBand) - 1) & ~((1u << firstBand) - 1);
+}
+
+/**
+ * @brief Get the number of bytes the firmware would have sent to the display during the last call to
+ * drawDisplayTft()
+ *
+ * @return The number of pixel bytes sent for the last frame
+ */
+uint32_t getFrameBytesSentTft(void)
+{
+    return frameBytesSent;
+}
+
+/**
+ * @brief Convert every palette index to a display color at the current brightness, so drawing doesn't need to scale
+ * each pixel
+ */
+static void buildBrightPalette(void)
+{
+    for (int paletteIdx = 0; paletteIdx < ARRAY_SIZE(brightPalette); paletteIdx++)
+    {
+        // Draw out-of-bounds colors as bright red as a warning
+        uint32_t color = paletteColorsEmu[(paletteIdx < ARRAY_SIZE(paletteColorsEmu)) ? paletteIdx : c500];
+
+#if defined(CNFGOGL)
+        // ARGB
+        uint32_t a = (color) & 0xFF;
+        uint32_t r = (color >> 8) & 0xFF;
+        r          = (r * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+        uint32_t g = (color >> 16) & 0xFF;
+        g          = (g * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+        uint32_t b = (color >> 24) & 0xFF;
+        b          = (b * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+
+        brightPalette[paletteIdx] = (b << 24) | (g << 16) | (r << 8) | (a);
+#else
+        // RGBA
+        uint32_t r = (color >> 0) & 0xFF;
+        r          = (r * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+        uint32_t g = (color >> 8) & 0xFF;
+        g          = (g * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+        uint32_t b = (color >> 16) & 0xFF;
+        b          = (b * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
+        uint32_t a = (color >> 24) & 0xFF;
+
+        brightPalette[paletteIdx] = (a << 24) | (b << 16) | (g << 8) | (r << 0);
+#endif
+    }
+}
+
+/**
+ * @brief Convert one framebuffer row to the scaled display bitmap. The row is converted and stretched horizontally
+ * once, then the scaled row is copied for the rest of the vertical multiplier
+ *
+ * @param y The framebuffer row to convert
+ */
+static void upscaleRowTft(int16_t y)
+{
+    const paletteColor_t* src = &frameBuffer[y * TFT_WIDTH];
+    int dstWidth              = TFT_WIDTH * displayMult;
+    uint32_t* dst             = &scaledBitmapDisplay[y * displayMult * dstWidth];
+
+    if (1 == displayMult)
+    {
+        for (int16_t x = 0; x < TFT_WIDTH; x++)
+        {
+            dst[x] = brightPalette[src[x]];
+        }
+        return;
+    }
+
+    uint32_t* dstPx = dst;
+    for (int16_t x = 0; x < TFT_WIDTH; x++)
+    {
+        uint32_t color = brightPalette[src[x]];
+        for (int mX = 0; mX < displayMult; mX++)
+        {
+            *dstPx++ = color;
+        }
+    }
+
+    for (int mY = 1; mY < displayMult; mY++)
+    {
+        memcpy(&dst[mY * dstWidth], dst, dstWidth * sizeof(uint32_t));
+    }
 }
 
 /**
@@ -275,75 +459,69 @@ void drawDisplayTft(fnBackgroundDrawCallback_t fnBackgroundDrawCallback)
         // Wipe any framebuffer changes
         clearPxTft();
     }
+    else if (bandRenderer)
+    {
+        // Draw each band into the frame-buffer, just before the firmware would convert it
+        for (int16_t bandY = 0; bandY < TFT_HEIGHT; bandY += BAND_LINES)
+        {
+            bandRenderer(&frameBuffer[bandY * TFT_WIDTH], bandY, MIN(BAND_LINES, TFT_HEIGHT - bandY));
+        }
+    }
 
     // Save the framebuffer before it gets cleared by background drawing callbacks
     memcpy(lastBuffer, frameBuffer, TFT_WIDTH * TFT_HEIGHT);
 
+    // Latch which bands to send. Anything drawn from here on, including by fnBackgroundDrawCallback, is sent next frame
+    uint32_t bandsToSend = (dirtyTrackingEnabled && !bandRenderer) ? dirtyBands : ALL_BANDS;
+    dirtyBands           = 0;
+    frameBytesSent       = 0;
+
     /* Copy the current framebuffer to memory that won't be modified by the
      * Swadge mode. rawdraw will use this non-changing bitmap to draw
      */
     int16_t y;
     for (y = 0; y < TFT_HEIGHT; y++)
     {
-        for (int16_t x = 0; x < TFT_WIDTH; x++)
+        // The prior band is finished, so let the mode draw its background
+        if ((y & 0xf) == 0 && fnBackgroundDrawCallback && !bandRenderer && y > 0)
         {
-            for (uint16_t mY = 0; mY < displayMult; mY++)
-            {
-                for (uint16_t mX = 0; mX < displayMult; mX++)
-                {
-                    int dstX  = ((x * displayMult) + mX);
-                    int dstY  = ((y * displayMult) + mY);
-                    int pxIdx = (dstY * (TFT_WIDTH * displayMult)) + dstX;
-
-                    int paletteIdx = frameBuffer[(y * TFT_WIDTH) + x];
-                    // Draw out-of-bounds colors as bright red as a warning
-                    if (paletteIdx >= (sizeof(paletteColorsEmu) / sizeof(paletteColorsEmu[0])))
-                    {
-                        paletteIdx = c500;
-                    }
-
-                    uint32_t color = paletteColorsEmu[paletteIdx];
-
-#if defined(CNFGOGL)
-                    // ARGB
-                    uint32_t a = (color) & 0xFF;
-                    uint32_t r = (color >> 8) & 0xFF;
-                    r          = (r * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-                    uint32_t g = (color >> 16) & 0xFF;
-                    g          = (g * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-                    uint32_t b = (color >> 24) & 0xFF;
-                    b          = (b * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-
-                    color = (b << 24) | (g << 16) | (r << 8) | (a);
-#else
-                    // RGBA
-                    uint32_t r = (color >> 0) & 0xFF;
-                    r          = (r * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-                    uint32_t g = (color >> 8) & 0xFF;
-                    g          = (g * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-                    uint32_t b = (color >> 16) & 0xFF;
-                    b          = (b * tftBrightness) / CONFIG_TFT_MAX_BRIGHTNESS;
-                    uint32_t a = (color >> 24) & 0xFF;
-
-                    color = (a << 24) | (b << 16) | (g << 8) | (r << 0);
-#endif
-                    scaledBitmapDisplay[pxIdx] = color;
-                }
-            }
+            fnBackgroundDrawCallback(0, y - 16, TFT_WIDTH, 16, (y - 16) / 16, TFT_HEIGHT / 16);
         }
 
-        if ((y & 0xf) == 0 && fnBackgroundDrawCallback && y > 0)
+        // Leave bands which haven't changed as they were, like the TFT would
+        if (!(bandsToSend & (1 << (y / BAND_LINES))))
         {
-            fnBackgroundDrawCallback(0, y - 16, TFT_WIDTH, 16, (y - 16) / 16, TFT_HEIGHT / 16);
+            continue;
         }
+        frameBytesSent += TFT_WIDTH * sizeof(uint16_t);
+
+        upscaleRowTft(y);
     }
 
-    if (fnBackgroundDrawCallback)
+    if (fnBackgroundDrawCallback && !bandRenderer)
     {
         fnBackgroundDrawCallback(0, y - 16, TFT_WIDTH, 16, (y - 16) / 16, TFT_HEIGHT / 16);
     }
 }
 
+/**
+ * @brief Block until the last frame has been sent to the TFT. The emulator draws synchronously, so this does nothing
+ */
+void waitDisplayTft(void)
+{
+    // Nothing is ever in flight
+}
+
+/**
+ * @brief Enable or disable asynchronous scanout. The emulator draws synchronously, so this does nothing
+ *
+ * @param enable unused
+ */
+void enableAsyncScanoutTft(bool enable)
+{
+    // Every frame is finished when drawDisplayTft() returns
+}
+
 /**
  * @brief Set TFT Backlight brightness.
  *
@@ -355,6 +533,9 @@ esp_err_t setTFTBacklightBrightness(uint8_t intensity)
 {
     tftBrightness
         = (CONFIG_TFT_MIN_BRIGHTNESS + (((CONFIG_TFT_MAX_BRIGHTNESS - CONFIG_TFT_MIN_BRIGHTNESS) * intensity) / 7));
+    buildBrightPalette();
+    // The whole display needs to be redrawn at the new brightness
+    dirtyBands = ALL_BANDS;
     return ESP_OK;
 }
 
@@ -370,6 +551,9 @@ void setDisplayBitmapMultiplier(uint8_t multiplier)
     // Reallocate scaledBitmapDisplay
     free(scaledBitmapDisplay);
     scaledBitmapDisplay = calloc((multiplier * TFT_WIDTH) * (multiplier * TFT_HEIGHT), sizeof(uint32_t));
+
+    // The new bitmap is blank, so it all needs to be redrawn
+    dirtyBands = ALL_BANDS;
 }
 
 /**
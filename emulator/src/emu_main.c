@@ -118,9 +118,15 @@
 
 static bool isRunning = true;
 
+/// The process exit code to use when the emulator quits
+static int exitCode = 0;
+
 /// The sound driver
 static struct CNFADriver* soundDriver = NULL;
 
+/// Whether each loop advances the time by exactly one frame, while fast-forwarding with nothing else controlling time
+static bool useVirtualTime = false;
+
 //==============================================================================
 // Function Prototypes
 //==============================================================================
@@ -130,6 +136,7 @@ void init_crashSignals(void);
 void signalHandler_crash(int signum, siginfo_t* si, void* vcontext);
 #endif
 
+static void drawEmulatorWindow(void);
 static void drawBitmapPixel(uint32_t* bitmapDisplay, int w, int h, int x, int y, uint32_t col);
 static void EmuSoundCb(struct CNFADriver* sd, short* out, short* in, int framesp, int framesr);
 void handleArgs(int argc, char** argv);
@@ -147,6 +154,16 @@ void emulatorQuit(void)
     isRunning = false;
 }
 
+/**
+ * @brief Set the process exit code to use when the emulator quits, such as when a self-test fails
+ *
+ * @param code The exit code
+ */
+void emulatorSetExitCode(int code)
+{
+    exitCode = code;
+}
+
 /**
  * @brief Parse and handle command line arguments
  *
@@ -228,8 +245,13 @@ int main(int argc, char** argv)
         CNFGSetup("Swadge Simulator", winW, winH);
     }
 
-    // Then initialize audio
-    if (!soundDriver)
+    // Then initialize audio. Audio can't keep up with fast-forwarding, so don't play any
+    if (emulatorArgs.fastForward)
+    {
+        emuSetUseRealTime(false);
+        useVirtualTime = !emulatorArgs.fuzzTime;
+    }
+    else if (!soundDriver)
     {
         soundDriver = CNFAInit(NULL,               // const char* driver_name
                                "Swadge Emulator",  // const char* your_name
@@ -272,6 +294,20 @@ void taskYIELD(void)
     static uint64_t frameNum = 0;
     doExtPostFrameCb(frameNum);
 
+    // Stop once the requested number of frames or amount of time has run
+    if ((emulatorArgs.stopFrames && frameNum >= emulatorArgs.stopFrames)
+        || (emulatorArgs.stopTimeUs && esp_timer_get_time() >= emulatorArgs.stopTimeUs))
+    {
+        isRunning = false;
+    }
+
+    // When fast-forwarding, each loop takes exactly one frame of virtual time, unless the fuzzer is controlling time
+    if (useVirtualTime)
+    {
+        int64_t frameUs = (emulatorArgs.fakeFps > 0) ? (int64_t)(1000000.0 / emulatorArgs.fakeFps) : getFrameRateUs();
+        emuSetEspTimerTime(esp_timer_get_time() + frameUs);
+    }
+
     // Calculate time between calls
     static int64_t tLastCallUs = 0;
     int64_t tElapsedUs         = 0;
@@ -287,10 +323,6 @@ void taskYIELD(void)
         tLastCallUs    = tNowUs;
     }
 
-    // These are persistent!
-    static short lastWindow_w = 0;
-    static short lastWindow_h = 0;
-
     // Below: Support for pausing and unpausing the emulator
     // Keep track of whether we've called the pre-frame callbacks yet
     bool preFrameCalled = false;
@@ -316,106 +348,25 @@ void taskYIELD(void)
             __gcov_dump();
 #endif
 
-            exit(0);
+            exit(exitCode);
             return;
         }
 
         // Check things here which are called by interrupts or timers on the Swadge
         check_esp_timer(tElapsedUs);
 
-        // Grey Background
-        CNFGBGColor = BG_COLOR;
-        CNFGClearFrame();
-
-        // Get the current window dimensions
-        short window_w, window_h;
-        CNFGGetDimensions(&window_w, &window_h);
-        static emuPane_t screenPane;
-
-        emuPaneMinimum_t paneMins[4];
-        bool panesChanged = calculatePaneMinimums(paneMins);
-
-        // If the dimensions changed
-        if (panesChanged || (lastWindow_h != window_h) || (lastWindow_w != window_w))
-        {
-            uint8_t screenMult;
-            // Recalculate the window layout and get the settings for the screen
-            layoutPanes(window_w, window_h, TFT_WIDTH, TFT_HEIGHT, &screenPane, &screenMult);
-
-            // Set the multiplier
-            setDisplayBitmapMultiplier(screenMult);
-
-            // Save for the next loop
-            lastWindow_w = window_w;
-            lastWindow_h = window_h;
-        }
-
-        // Draw dividing lines, if they're on-screen
-        CNFGColor(DIV_COLOR);
-
-        // Draw Left Divider
-        if (paneMins[PANE_LEFT].count > 0)
+        // Without a sound driver, render the sound for this frame anyway so MIDI callbacks keep happening
+        if (emulatorArgs.fastForward && !emuTimerIsPaused())
         {
-            CNFGTackSegment(screenPane.paneX - 1, 0, screenPane.paneX - 1, window_h);
+            emulatorDiscardSound(tElapsedUs);
         }
 
-        // Draw Right Divider
-        if (paneMins[PANE_RIGHT].count > 0)
+        // Draw the window and wait a bit, unless running as fast as possible
+        if (!emulatorArgs.fastForward)
         {
-            CNFGTackSegment(screenPane.paneX + screenPane.paneW, 0, screenPane.paneX + screenPane.paneW, window_h);
+            drawEmulatorWindow();
         }
 
-        // Draw Top Divider
-        if (paneMins[PANE_TOP].count > 0)
-        {
-            CNFGTackSegment(screenPane.paneX, screenPane.paneY - 1, screenPane.paneX + screenPane.paneW,
-                            screenPane.paneY - 1);
-        }
-
-        // Draw Bottom Divider
-        if (paneMins[PANE_BOTTOM].count > 0)
-        {
-            CNFGTackSegment(screenPane.paneX, screenPane.paneY + screenPane.paneH, screenPane.paneX + screenPane.paneW,
-                            screenPane.paneY + screenPane.paneH);
-        }
-
-        // Get the display memory
-        uint16_t bitmapWidth, bitmapHeight;
-        uint32_t* bitmapDisplay = getDisplayBitmap(&bitmapWidth, &bitmapHeight);
-
-        if ((0 != bitmapWidth) && (0 != bitmapHeight) && (NULL != bitmapDisplay))
-        {
-#if defined(CONFIG_GC9307_240x280)
-            uint32_t cornerColor = CORNER_COLOR;
-            if (emuTimerIsPaused())
-            {
-                cornerColor = PAUSED_COLOR;
-            }
-            else if (isScreenRecording())
-            {
-                cornerColor = RECORDING_COLOR;
-            }
-
-            plotRoundedCorners(bitmapDisplay, bitmapWidth, bitmapHeight, (bitmapWidth / TFT_WIDTH) * 40, cornerColor);
-#endif
-            // Update the display, centered
-            CNFGBlitImage(bitmapDisplay, screenPane.paneX, screenPane.paneY, bitmapWidth, bitmapHeight);
-        }
-
-        // After the screen has been fully rendered, call all the render callbacks to render anything else
-        doExtRenderCb(window_w, window_h);
-
-        // Display the image and wait for time to display next frame.
-        CNFGSwapBuffers();
-
-        // Sleep for one ms
-        static struct timespec tRemaining = {0};
-        const struct timespec tSleep      = {
-            .tv_sec  = 0 + tRemaining.tv_sec,
-            .tv_nsec = 1000000 + tRemaining.tv_nsec,
-        };
-        nanosleep(&tSleep, &tRemaining);
-
         // This means that the pre-frame callback gets called once (assuming the post-frame
         // callback didn't already pause) and then, if one of them pauses, they don't get called
         // again until after, which is good since that's the only way we'd be able to handle input
@@ -440,6 +391,110 @@ void taskYIELD(void)
     } while (isRunning && (!preFrameCalled || emuTimerIsPaused()));
 }
 
+/**
+ * @brief Draw the emulator window, including the display, pane dividers, and extension panes, then sleep for a
+ * millisecond
+ */
+static void drawEmulatorWindow(void)
+{
+    // These are persistent!
+    static short lastWindow_w = 0;
+    static short lastWindow_h = 0;
+
+    // Grey Background
+    CNFGBGColor = BG_COLOR;
+    CNFGClearFrame();
+
+    // Get the current window dimensions
+    short window_w, window_h;
+    CNFGGetDimensions(&window_w, &window_h);
+    static emuPane_t screenPane;
+
+    emuPaneMinimum_t paneMins[4];
+    bool panesChanged = calculatePaneMinimums(paneMins);
+
+    // If the dimensions changed
+    if (panesChanged || (lastWindow_h != window_h) || (lastWindow_w != window_w))
+    {
+        uint8_t screenMult;
+        // Recalculate the window layout and get the settings for the screen
+        layoutPanes(window_w, window_h, TFT_WIDTH, TFT_HEIGHT, &screenPane, &screenMult);
+
+        // Set the multiplier
+        setDisplayBitmapMultiplier(screenMult);
+
+        // Save for the next loop
+        lastWindow_w = window_w;
+        lastWindow_h = window_h;
+    }
+
+    // Draw dividing lines, if they're on-screen
+    CNFGColor(DIV_COLOR);
+
+    // Draw Left Divider
+    if (paneMins[PANE_LEFT].count > 0)
+    {
+        CNFGTackSegment(screenPane.paneX - 1, 0, screenPane.paneX - 1, window_h);
+    }
+
+    // Draw Right Divider
+    if (paneMins[PANE_RIGHT].count > 0)
+    {
+        CNFGTackSegment(screenPane.paneX + screenPane.paneW, 0, screenPane.paneX + screenPane.paneW, window_h);
+    }
+
+    // Draw Top Divider
+    if (paneMins[PANE_TOP].count > 0)
+    {
+        CNFGTackSegment(screenPane.paneX, screenPane.paneY - 1, screenPane.paneX + screenPane.paneW,
+                        screenPane.paneY - 1);
+    }
+
+    // Draw Bottom Divider
+    if (paneMins[PANE_BOTTOM].count > 0)
+    {
+        CNFGTackSegment(screenPane.paneX, screenPane.paneY + screenPane.paneH, screenPane.paneX + screenPane.paneW,
+                        screenPane.paneY + screenPane.paneH);
+    }
+
+    // Get the display memory
+    uint16_t bitmapWidth, bitmapHeight;
+    uint32_t* bitmapDisplay = getDisplayBitmap(&bitmapWidth, &bitmapHeight);
+
+    if ((0 != bitmapWidth) && (0 != bitmapHeight) && (NULL != bitmapDisplay))
+    {
+#if defined(CONFIG_GC9307_240x280)
+        uint32_t cornerColor = CORNER_COLOR;
+        if (emuTimerIsPaused())
+        {
+            cornerColor = PAUSED_COLOR;
+        }
+        else if (isScreenRecording())
+        {
+            cornerColor = RECORDING_COLOR;
+        }
+
+        plotRoundedCorners(bitmapDisplay, bitmapWidth, bitmapHeight, (bitmapWidth / TFT_WIDTH) * 40, cornerColor);
+#endif
+        // Update the display, centered
+        CNFGBlitImage(bitmapDisplay, screenPane.paneX, screenPane.paneY, bitmapWidth, bitmapHeight);
+    }
+
+    // After the screen has been fully rendered, call all the render callbacks to render anything else
+    doExtRenderCb(window_w, window_h);
+
+    // Display the image and wait for time to display next frame.
+    CNFGSwapBuffers();
+
+    // Sleep for one ms
+    static struct timespec tRemaining = {0};
+    const struct timespec tSleep      = {
+        .tv_sec  = 0 + tRemaining.tv_sec,
+        .tv_nsec = 1000000 + tRemaining.tv_nsec,
+    };
+    nanosleep(&tSleep, &tRemaining);
+}
+
 /**
  * @brief Helper function to draw to a bitmap display
  *
@@ -668,6 +723,63 @@ int HandleDestroy()
     #pragma GCC diagnostic pop
 #endif
 
+/**
+ * @brief Start or stop fast-forwarding while the emulator is running, such as while seeking through a replay. Nothing
+ * is drawn and no sound is played while fast-forwarding. If the emulator is using real time, each loop takes exactly
+ * one frame of virtual time instead, which starts from the current time and continues back into real time afterwards
+ *
+ * @param fastForward true to run as fast as possible, false to run normally
+ */
+void emulatorSetFastForward(bool fastForward)
+{
+    if (fastForward == (bool)emulatorArgs.fastForward)
+    {
+        return;
+    }
+    emulatorArgs.fastForward = fastForward;
+
+    // Fake time and fuzzed time already advance on their own, so only real time is replaced
+    if (fastForward && emuGetUseRealTime())
+    {
+        emuSetEspTimerTime(esp_timer_get_time());
+        emuSetUseRealTime(false);
+        useVirtualTime = true;
+    }
+    else if (!fastForward && useVirtualTime)
+    {
+        useVirtualTime = false;
+        emuSetUseRealTime(true);
+    }
+}
+
+/**
+ * @brief Render sound output for some amount of Swadge time, and throw it away. When fast-forwarding there is no sound
+ * driver to pull samples, so this keeps MIDI playback, along with its text and song end callbacks, in step with time
+ *
+ * @param elapsedUs The amount of Swadge time to render sound for
+ */
+void emulatorDiscardSound(int64_t elapsedUs)
+{
+    // Carry the fraction of a sample left over between calls, in units of microsecond-samples
+    static int64_t remainder = 0;
+    static short out[DAC_BUF_SIZE * 2];
+
+    int64_t total   = elapsedUs * DAC_SAMPLE_RATE_HZ + remainder;
+    int64_t samples = total / 1000000;
+    remainder       = total % 1000000;
+
+    while (samples > 0)
+    {
+        int count = MIN(samples, DAC_BUF_SIZE);
+#if defined(CONFIG_SOUND_OUTPUT_BUZZER)
+        bzrHandleSoundOutput(out, count, 2);
+#elif defined(CONFIG_SOUND_OUTPUT_SPEAKER)
+        dacHandleSoundOutput(out, count, 2);
+#endif
+        samples -= count;
+    }
+}
+
 /**
  * @brief Callback for sound events, both input and output
  * Handle output here, pass input to handleSoundInput()
@@ -680,7 +792,8 @@ int HandleDestroy()
  */
 static void EmuSoundCb(struct CNFADriver* sd, short* out, short* in, int framesp, int framesr)
 {
-    if (emuTimerIsPaused())
+    // The main loop renders sound while fast-forwarding
+    if (emuTimerIsPaused() || emulatorArgs.fastForward)
     {
         if (out)
         {
@@ -15,4 +15,7 @@
     }
 
 void emulatorQuit(void);
+void emulatorSetExitCode(int code);
+void emulatorSetFastForward(bool fastForward);
+void emulatorDiscardSound(int64_t elapsedUs);
 void plotRoundedCorners(uint32_t* bitmapDisplay, int w, int h, int r, uint32_t col);
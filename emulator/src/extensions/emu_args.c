@@ -85,6 +85,11 @@ emuArgs_t emulatorArgs = {
     .fakeFps    = 0.0,
     .fakeTime   = false,
     .fullscreen = false,
+
+    .fastForward = false,
+    .stopFrames  = 0,
+    .stopTimeUs  = 0,
+
     .hideLeds   = false,
 
     .fuzz        = false,
@@ -111,8 +116,9 @@ emuArgs_t emulatorArgs = {
     .record   = false,
     .playback = false,
 
-    .recordFile = NULL,
-    .replayFile = NULL,
+    .recordFile   = NULL,
+    .replayFile   = NULL,
+    .playbackFrom = -1,
 
     .seed = UINT32_MAX,
 
@@ -121,6 +127,9 @@ emuArgs_t emulatorArgs = {
     .vsync = true,
 
     .joystick = NULL,
+
+    .runTests   = false,
+    .testFilter = NULL,
 };
 
 static const char mainDoc[] = "Emulates a swadge";
@@ -130,6 +139,8 @@ static const char mainDoc[] = "Emulates a swadge";
 // the same in both options and argDocs
 static const char argFakeFps[]       = "fake-fps";
 static const char argFakeTime[]      = "fake-time";
+static const char argFastForward[]   = "fast-forward";
+static const char argFrames[]        = "frames";
 static const char argFullscreen[]    = "fullscreen";
 static const char argFuzz[]          = "fuzz";
 static const char argFuzzButtons[]   = "fuzz-buttons";
@@ -148,10 +159,13 @@ static const char argMode[]          = "mode";
 static const char argModeSwitch[]    = "mode-switch";
 static const char argModeList[]      = "modes-list";
 static const char argPlayback[]      = "playback";
+static const char argPlaybackFrom[]  = "playback-from";
 static const char argRecord[]        = "record";
 static const char argSeed[]          = "seed";
 static const char argShowFps[]       = "show-fps";
+static const char argTest[]          = "test";
 static const char argTouch[]         = "touch";
+static const char argUntilUs[]       = "until-us";
 static const char argVsync[]         = "vsync";
 static const char argHelp[]          = "help";
 static const char argUsage[]         = "usage";
@@ -164,6 +178,8 @@ static const struct option options[] =
 {
     { argFakeFps,     required_argument, NULL,                             0    },
     { argFakeTime,    no_argument,       (int*)&emulatorArgs.fakeTime,     true },
+    { argFastForward, no_argument,       (int*)&emulatorArgs.fastForward,  true },
+    { argFrames,      required_argument, NULL,                             0    },
     { argFullscreen,  no_argument,       (int*)&emulatorArgs.fullscreen,   true },
     { argFuzz,        no_argument,       (int*)&emulatorArgs.fuzz,         true },
     { argFuzzButtons, optional_argument, (int*)&emulatorArgs.fuzzButtons,  true },
@@ -180,12 +196,15 @@ static const struct option options[] =
     { argMegaPulseFile,    required_argument, NULL,                             0    },
     { argMode,        required_argument, NULL,                             'm'  },
     { argPlayback,    required_argument, (int*)&emulatorArgs.playback,     'p'  },
+    { argPlaybackFrom, required_argument, NULL,                            0    },
     { argRecord,      optional_argument, (int*)&emulatorArgs.record,       'r'  },
     { argSeed,        required_argument, (int*)&emulatorArgs.seed,         0    },
     { argShowFps,     optional_argument, (int*)&emulatorArgs.showFps,      'c'  },
     { argModeSwitch,  optional_argument, NULL,                             10   },
     { argModeList,    no_argument,       NULL,                             0    },
+    { argTest,        optional_argument, (int*)&emulatorArgs.runTests,     true },
     { argTouch,       no_argument,       (int*)&emulatorArgs.emulateTouch, 't'  },
+    { argUntilUs,     required_argument, NULL,                             0    },
     { argVsync,       optional_argument, (int*)&emulatorArgs.vsync,        true },
     { argHelp,        no_argument,       NULL,                             'h'  },
     { argUsage,       no_argument,       NULL,                             0    },
@@ -199,6 +218,8 @@ static const optDoc_t argDocs[] =
 {
     { 0,  argFakeFps,     "RATE",  "Set a fake framerate. RATE can be a decimal number"},
     { 0,  argFakeTime,    NULL,    "Use a fake timer that ticks at a constant "},
+    { 0,  argFastForward, NULL,    "Run headless as fast as possible, advancing time by exactly one frame per loop" },
+    { 0,  argFrames,      "N",     "Exit after running N frames" },
     {'f', argFullscreen,  NULL,    "Open in fullscreen mode" },
     { 0,  argFuzz,        NULL,    "Enable fuzzing mode, which injects random input in order to test modes" },
     { 0,  argFuzzButtons, "y|n",   "Set whether buttons are fuzzed" },
@@ -217,10 +238,13 @@ static const optDoc_t argDocs[] =
     { 0,  argModeSwitch,  "TIME",  "Enable or set the timer to switch modes automatically" },
     { 0,  argModeList,    NULL,    "Print out a list of all possible values for MODE" },
     {'p', argPlayback,    "FILE",  "Play back recorded emulator inputs from a file" },
+    { 0,  argPlaybackFrom, "FRAME", "Fast-forward playback to the last keyframe at or before FRAME of a binary recording" },
     {'r', argRecord,      "FILE",  "Record emulator inputs to a file" },
     {'s', argSeed,        "SEED",  "Seed the random number generator with a specific value" },
     {'c', argShowFps,     NULL,    "Display an FPS counter" },
+    { 0,  argTest,        "FILTER", "Run the emulator self-tests, optionally only those whose names contain FILTER, then exit" },
     {'t', argTouch,       NULL,    "Simulate touch pad readings with a virtual touchpad" },
+    { 0,  argUntilUs,     "TIME",  "Exit once the Swadge's clock reaches TIME microseconds" },
     { 0,  argVsync,       "y|n",   "Set whether VSync is enabled" },
     {'h', argHelp,        NULL,    "Give this help list" },
     { 0,  argUsage,       NULL,    "Give a short usage message" },
@@ -269,6 +293,31 @@ static bool handleArgument(const char* optName, const char* arg, int optVal)
             emulatorArgs.fakeFps = 24.0;
         }
     }
+    else if (argFastForward == optName)
+    {
+        // There's no window to draw when fast-forwarding
+        emulatorArgs.headless = true;
+    }
+    else if (argFrames == optName)
+    {
+        char* end               = NULL;
+        emulatorArgs.stopFrames = strtoull(arg, &end, 10);
+        if (end == arg || *end)
+        {
+            printf("ERR: Invalid integer value '%s'\n", arg);
+            return false;
+        }
+    }
+    else if (argUntilUs == optName)
+    {
+        char* end               = NULL;
+        emulatorArgs.stopTimeUs = strtoll(arg, &end, 10);
+        if (end == arg || *end)
+        {
+            printf("ERR: Invalid integer value '%s'\n", arg);
+            return false;
+        }
+    }
     else if (argFuzz == optName)
     {
         // Enable Fuzz
@@ -328,6 +377,18 @@ static bool handleArgument(const char* optName, const char* arg, int optVal)
         }
         return true;
     }
+    else if (argTest == optName)
+    {
+        // There's nothing to see or hear while testing
+        emulatorArgs.runTests    = true;
+        emulatorArgs.headless    = true;
+        emulatorArgs.fastForward = true;
+        if (arg)
+        {
+            emulatorArgs.testFilter = arg;
+        }
+        return true;
+    }
     else if (argMidiFile == optName)
     {
         emulatorArgs.midiFile = arg;
@@ -397,6 +458,16 @@ static bool handleArgument(const char* optName, const char* arg, int optVal)
             emulatorArgs.replayFile = arg;
         }
     }
+    else if (argPlaybackFrom == optName)
+    {
+        char* end                 = NULL;
+        emulatorArgs.playbackFrom = strtoll(arg, &end, 10);
+        if (end == arg || *end || emulatorArgs.playbackFrom < 0)
+        {
+            printf("ERR: Invalid frame value '%s'\n", arg);
+            return false;
+        }
+    }
     else if (argSeed == optName)
     {
         if (arg)
@@ -24,6 +24,15 @@ typedef struct
     float fakeFps;
     int fakeTime;
 
+    /// @brief Whether to run as fast as possible in virtual time, without drawing the window or sleeping
+    int fastForward;
+
+    /// @brief The number of frames to run before exiting, or 0 to run until closed
+    uint64_t stopFrames;
+
+    /// @brief The time in microseconds after which to exit, or 0 to run until closed
+    int64_t stopTimeUs;
+
     int fullscreen;
     int hideLeds;
 
@@ -66,6 +75,9 @@ typedef struct
     /// @brief Name of the file to replay inputs from
     const char* replayFile;
 
+    /// @brief The recorded frame to start playback from, or -1 to play back from the start
+    int64_t playbackFrom;
+
     /// @brief A value to use to manually seed the random number generator
     int seed;
 
@@ -86,6 +98,14 @@ typedef struct
 
     // Mega Pulse EX level file
     const char* megaPulseFile;
+
+    // Tests Extension
+
+    /// @brief Whether to run the emulator self-tests and exit
+    int runTests;
+
+    /// @brief Only run self-tests whose names contain this string, or NULL to run all of them
+    const char* testFilter;
 } emuArgs_t;
 
 //==============================================================================
@@ -22,6 +22,7 @@
 #include "ext_modes.h"
 #include "ext_replay.h"
 #include "ext_spacer_v.h"
+#include "ext_tests.h"
 #include "ext_tools.h"
 #include "ext_touch_1d_horz.h"
 #include "ext_touch_1d_vert.h"
@@ -38,7 +39,7 @@
 static const emuExtension_t* registeredExtensions[] = {
     &vSpacerExtension,    &ledEmuExtension,    &touchEmu1DVertExtension, &touchEmu1DHorzExtension,
     &fuzzerEmuExtension,  &toolsEmuExtension,  &keymapEmuCallback,       &modesEmuExtension,
-    &gamepadEmuExtension, &replayEmuExtension, &midiEmuExtension,
+    &gamepadEmuExtension, &replayEmuExtension, &midiEmuExtension,   &testsEmuExtension,
 };
 
 //==============================================================================
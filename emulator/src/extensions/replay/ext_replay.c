@@ -13,10 +13,13 @@
 #include "ext_tools.h"
 #include "emu_utils.h"
 #include "esp_random_emu.h"
+#include "hdw-nvs_emu.h"
+#include "swadge.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <inttypes.h>
 #include <unistd.h>
 
@@ -28,6 +31,19 @@
 
 #define HEADER "Time,Type,Value\n"
 
+/// The magic bytes at the start of a binary recording
+#define BIN_MAGIC "SWRP"
+/// The magic bytes at the very end of a binary recording with an index
+#define BIN_INDEX_MAGIC "SWRI"
+/// The version of the binary format which is written
+#define BIN_VERSION 1
+/// The file extension which selects the binary format when recording
+#define BIN_EXTENSION ".swr"
+/// The number of frames between keyframes in a binary recording
+#define KEYFRAME_INTERVAL 300
+/// The number of touch and accelerometer values stored in a keyframe
+#define NUM_ANALOG_TYPES 10
+
 #ifdef DEBUG
     #define REPLAY_DEBUG(str, ...) printf(str "\n", __VA_ARGS__);
 #else
@@ -64,6 +80,9 @@ typedef enum
     TOUCH_HORZ_INTENSITY,
     TOUCH_VERT,
     TOUCH_VERT_INTENSITY,
+    NVS_SNAPSHOT,
+    KEYFRAME,
+    INDEX,
     LAST_TYPE,
 } replayLogType_t;
 
@@ -71,6 +90,28 @@ typedef enum
 // Structs
 //==============================================================================
 
+/**
+ * @brief The state needed to start playback partway through a binary recording
+ */
+typedef struct
+{
+    uint64_t frame;                   ///< The frame number when the keyframe was recorded
+    uint32_t nvsOffset;               ///< The file offset of the latest NVS snapshot, or 0 if there is none
+    uint32_t seed;                    ///< The random seed set when the keyframe was recorded
+    buttonBit_t buttons;              ///< The buttons held
+    int32_t analog[NUM_ANALOG_TYPES]; ///< The touch and accelerometer values, in the order of ::analogTypes
+    char* modeName;                   ///< The name of the Swadge mode which was running
+} replayKeyframe_t;
+
+/**
+ * @brief The location of one keyframe in a binary recording
+ */
+typedef struct
+{
+    uint64_t frame;  ///< The frame number of the keyframe
+    uint32_t offset; ///< The file offset of the keyframe record
+} replayIndexEntry_t;
+
 typedef struct
 {
     int64_t time;
@@ -86,6 +127,8 @@ typedef struct
         char* filename;
         char* modeName;
         char* commandStr;
+        char* nvsJson;
+        replayKeyframe_t keyframe;
     };
 } replayEntry_t;
 
@@ -116,6 +159,21 @@ typedef struct
     uint32_t newSeed;
 
     replayEntry_t nextEntry;
+
+    bool binary;                ///< Whether the file uses the binary format instead of CSV
+    int64_t binTime;            ///< The time of the last binary record, which the next one is relative to
+    int32_t binBase[LAST_TYPE]; ///< The last value of each touch and accelerometer type in the binary stream
+    uint64_t nextKeyframe;      ///< The frame at which to record the next keyframe
+    uint32_t nvsOffset;         ///< The file offset of the latest NVS snapshot, or 0 if there is none
+    uint32_t nvsGeneration;     ///< The NVS generation when the latest snapshot was recorded
+    replayIndexEntry_t* index;  ///< The keyframes in the file, in order
+    uint32_t indexLen;          ///< The number of keyframes in ::index
+    uint32_t indexCap;          ///< The allocated length of ::index
+    bool indexLoaded;           ///< Whether ::index has been read from the file being played back
+    int64_t seekFrame;          ///< A frame to seek to once playback starts, or -1 for none
+    int64_t seekKeyframe;       ///< The frame of the keyframe being fast-forwarded to, or -1 if not seeking
+    bool seekFastForward;       ///< Whether fast-forwarding was started for the seek, and stops when it finishes
+    int64_t lastKeyframe;       ///< The frame of the last keyframe played back, or -1 if none has been
 } replay_t;
 
 //==============================================================================
@@ -123,12 +181,33 @@ typedef struct
 //==============================================================================
 
 static bool replayInit(emuArgs_t* emuArgs);
+static void replayDeinit(void);
 static void replayRecordFrame(uint64_t frame);
 static void replayPlaybackFrame(uint64_t frame);
 static void replayPreFrame(uint64_t frame);
 
 static bool readEntry(replayEntry_t* out);
 static void writeEntry(const replayEntry_t* entry);
+static bool readCsvEntry(replayEntry_t* out);
+static void writeCsvEntry(const replayEntry_t* entry);
+static bool readBinEntry(replayEntry_t* out);
+static void writeBinEntry(const replayEntry_t* entry);
+static void freeEntry(replayEntry_t* entry);
+
+static void writeVarint(uint64_t val);
+static void writeZigzag(int64_t val);
+static void writeBinString(const char* str);
+static bool readVarint(uint64_t* out);
+static bool readZigzag(int64_t* out);
+static bool readBinString(char** out);
+
+static void recordNvsSnapshot(int64_t time);
+static void recordKeyframe(uint64_t frame);
+static void writeIndex(void);
+static bool loadIndex(void);
+static void loadInitialNvs(void);
+static void applySeek(uint64_t frame);
+static void finishSeek(void);
 
 //==============================================================================
 // Variables
@@ -137,11 +216,19 @@ static void writeEntry(const replayEntry_t* entry);
 static const char* replayLogTypeStrs[] = {
     "BtnDown", "BtnUp",      "TouchPhi", "TouchR", "TouchI",  "AccelX", "AccelY",  "AccelZ", "Fuzz",
     "Quit",    "Screenshot", "SetMode",  "Seed",   "Command", "TouchH", "TouchHI", "TouchV", "TouchVI",
+    "Nvs",     "Keyframe",   "Index",
+};
+
+/// The touch and accelerometer types, in the order they are stored in a keyframe
+static const replayLogType_t analogTypes[NUM_ANALOG_TYPES] = {
+    TOUCH_PHI,  TOUCH_R,    TOUCH_INTENSITY, TOUCH_HORZ, TOUCH_HORZ_INTENSITY,
+    TOUCH_VERT, TOUCH_VERT_INTENSITY, ACCEL_X, ACCEL_Y, ACCEL_Z,
 };
 
 emuExtension_t replayEmuExtension = {
     .name            = "replay",
     .fnInitCb        = replayInit,
+    .fnDeinitCb      = replayDeinit,
     .fnPreFrameCb    = replayPreFrame,
     .fnPostFrameCb   = NULL,
     .fnKeyCb         = NULL,
@@ -166,7 +253,9 @@ replay_t replay        = {0};
  */
 static bool replayInit(emuArgs_t* emuArgs)
 {
-    replay.lastAccelZ = 256;
+    replay.lastAccelZ   = 256;
+    replay.seekFrame    = -1;
+    replay.seekKeyframe = -1;
 
     if (emuArgs->record)
     {
@@ -177,12 +266,24 @@ static bool replayInit(emuArgs_t* emuArgs)
     else if (emuArgs->playback)
     {
         startPlayback(emuArgs->replayFile);
+        if (emuArgs->playbackFrom >= 0)
+        {
+            seekPlayback(emuArgs->playbackFrom);
+        }
         return (replayInitialized = true);
     }
 
     return false;
 }
 
+/**
+ * @brief Deinitialize the replay extension, finishing any recording in progress
+ */
+static void replayDeinit(void)
+{
+    stopRecording();
+}
+
 static void replayRecordFrame(uint64_t frame)
 {
     replayEntry_t logEntry = {0};
@@ -193,6 +294,12 @@ static void replayRecordFrame(uint64_t frame)
         fwrite(HEADER, 1, strlen(HEADER), replay.file);
     }
 
+    if (replay.binary && frame >= replay.nextKeyframe)
+    {
+        recordKeyframe(frame);
+        replay.nextKeyframe = frame + KEYFRAME_INTERVAL;
+    }
+
     logEntry.time = esp_timer_get_time();
 
     int32_t touchPhi, touchR, touchIntensity;
@@ -250,7 +357,7 @@ static void replayRecordFrame(uint64_t frame)
             {
                 if (touchPhi != replay.lastTouchPhi)
                 {
-                    logEntry.accelVal = touchPhi;
+                    logEntry.touchVal = touchPhi;
                     writeEntry(&logEntry);
                 }
                 break;
@@ -353,13 +460,21 @@ static void replayRecordFrame(uint64_t frame)
             case SET_MODE:
             case RANDOM_SEED:
             case COMMAND:
+            case NVS_SNAPSHOT:
+            case KEYFRAME:
+            case INDEX:
+            case LAST_TYPE:
                 break;
         }
     }
 
-    replay.lastTouchR         = touchR;
-    replay.lastTouchPhi       = touchPhi;
-    replay.lastTouchIntensity = touchIntensity;
+    replay.lastTouchR             = touchR;
+    replay.lastTouchPhi           = touchPhi;
+    replay.lastTouchIntensity     = touchIntensity;
+    replay.lastTouchHorz          = linearTouches[0].position;
+    replay.lastTouchHorzIntensity = linearTouches[0].intensity;
+    replay.lastTouchVert          = linearTouches[1].position;
+    replay.lastTouchVertIntensity = linearTouches[1].intensity;
     replay.lastAccelX         = accelX;
     replay.lastAccelY         = accelY;
     replay.lastAccelZ         = accelZ;
@@ -376,6 +491,13 @@ static void replayRecordFrame(uint64_t frame)
  */
 static void replayPlaybackFrame(uint64_t frame)
 {
+    // Start seeking once the main loop is running
+    if (replay.seekFrame >= 0 && frame >= 1)
+    {
+        applySeek(replay.seekFrame);
+        replay.seekFrame = -1;
+    }
+
     // Unless we've finished reading the file completely
     if (!replay.readCompleted)
     {
@@ -542,6 +664,43 @@ static void replayPlaybackFrame(uint64_t frame)
                     replay.nextEntry.commandStr = NULL;
                     break;
                 }
+
+                case NVS_SNAPSHOT:
+                {
+                    // NVS snapshots are only restored when seeking
+                    freeEntry(&replay.nextEntry);
+                    break;
+                }
+
+                case KEYFRAME:
+                {
+                    // The recorder reseeded the RNG here
+                    const replayKeyframe_t* kf = &replay.nextEntry.keyframe;
+                    emulatorSetEspRandomSeed(kf->seed);
+                    replay.lastKeyframe = kf->frame;
+
+                    // Playback is deterministic, so it should be in the same mode the recorder was
+                    if (NULL != kf->modeName && strcmp(kf->modeName, getSwadgeMode()->modeName))
+                    {
+                        printf("ERR: Replay: Keyframe for frame %" PRIu64 " was recorded in mode '%s', not '%s'\n",
+                               kf->frame, kf->modeName, getSwadgeMode()->modeName);
+                    }
+
+                    if (replay.seekKeyframe >= 0 && kf->frame >= (uint64_t)replay.seekKeyframe)
+                    {
+                        printf("Replay: Seeked to keyframe at frame %" PRIu64 " in mode '%s'\n", kf->frame,
+                               getSwadgeMode()->modeName);
+                        finishSeek();
+                    }
+                    freeEntry(&replay.nextEntry);
+                    break;
+                }
+
+                case INDEX:
+                case LAST_TYPE:
+                {
+                    break;
+                }
             }
 
             // Get the next entry
@@ -549,6 +708,12 @@ static void replayPlaybackFrame(uint64_t frame)
             {
                 printf("Replay: Reached end of recording\n");
                 replay.readCompleted = true;
+                if (replay.seekKeyframe >= 0)
+                {
+                    printf("ERR: Replay: Recording ended before the keyframe at frame %" PRId64 "\n",
+                           replay.seekKeyframe);
+                    finishSeek();
+                }
                 break;
             }
         }
@@ -606,7 +771,39 @@ static void replayPreFrame(uint64_t frame)
     }
 }
 
+/**
+ * @brief Read the next entry from the recording, in whichever format it uses
+ *
+ * @param entry The entry to read into
+ * @return true if an entry was read, false at the end of the recording or if there was an error
+ */
 static bool readEntry(replayEntry_t* entry)
+{
+    if (NULL == replay.file)
+    {
+        return false;
+    }
+    return replay.binary ? readBinEntry(entry) : readCsvEntry(entry);
+}
+
+/**
+ * @brief Write an entry to the recording, in whichever format it uses
+ *
+ * @param entry The entry to write
+ */
+static void writeEntry(const replayEntry_t* entry)
+{
+    if (replay.binary)
+    {
+        writeBinEntry(entry);
+    }
+    else
+    {
+        writeCsvEntry(entry);
+    }
+}
+
+static bool readCsvEntry(replayEntry_t* entry)
 {
     char buffer[1024];
     if (!replay.headerHandled)
@@ -798,7 +995,7 @@ static bool readEntry(replayEntry_t* entry)
     return true;
 }
 
-static void writeEntry(const replayEntry_t* entry)
+static void writeCsvEntry(const replayEntry_t* entry)
 {
     char buffer[1024];
     char* ptr = buffer;
@@ -868,11 +1065,710 @@ static void writeEntry(const replayEntry_t* entry)
             snprintf(ptr, BUFSIZE, "%s\n", entry->commandStr ? entry->commandStr : "");
             break;
         }
+
+        case NVS_SNAPSHOT:
+        case KEYFRAME:
+        case INDEX:
+        case LAST_TYPE:
+        {
+            // Only used by the binary format
+            return;
+        }
     }
 
     fwrite(buffer, 1, strlen(buffer), replay.file);
 }
 
+/**
+ * @brief Free any string owned by an entry
+ *
+ * @param entry The entry to free the strings of
+ */
+static void freeEntry(replayEntry_t* entry)
+{
+    switch (entry->type)
+    {
+        case SCREENSHOT:
+        case SET_MODE:
+        case COMMAND:
+        case NVS_SNAPSHOT:
+        {
+            // These are all the same union member
+            free(entry->filename);
+            entry->filename = NULL;
+            break;
+        }
+
+        case KEYFRAME:
+        {
+            free(entry->keyframe.modeName);
+            entry->keyframe.modeName = NULL;
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Write an unsigned integer to the recording, 7 bits per byte, least significant first
+ *
+ * @param val The value to write
+ */
+static void writeVarint(uint64_t val)
+{
+    uint8_t buf[10];
+    uint8_t len = 0;
+    do
+    {
+        buf[len] = val & 0x7F;
+        val >>= 7;
+        if (val)
+        {
+            buf[len] |= 0x80;
+        }
+        len++;
+    } while (val);
+    fwrite(buf, 1, len, replay.file);
+}
+
+/**
+ * @brief Write a signed integer to the recording, zigzag encoded so small negative values stay short
+ *
+ * @param val The value to write
+ */
+static void writeZigzag(int64_t val)
+{
+    writeVarint(((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+/**
+ * @brief Write a length-prefixed string to the recording. NULL is written as an empty string
+ *
+ * @param str The string to write, or NULL
+ */
+static void writeBinString(const char* str)
+{
+    size_t len = str ? strlen(str) : 0;
+    writeVarint(len);
+    fwrite(str, 1, len, replay.file);
+}
+
+/**
+ * @brief Read an unsigned integer written by writeVarint()
+ *
+ * @param out The value that was read
+ * @return true if the value was read, false if the file ended
+ */
+static bool readVarint(uint64_t* out)
+{
+    uint64_t val = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7)
+    {
+        int c = fgetc(replay.file);
+        if (EOF == c)
+        {
+            return false;
+        }
+        val |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+        {
+            *out = val;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Read a signed integer written by writeZigzag()
+ *
+ * @param out The value that was read
+ * @return true if the value was read, false if the file ended
+ */
+static bool readZigzag(int64_t* out)
+{
+    uint64_t val;
+    if (!readVarint(&val))
+    {
+        return false;
+    }
+    *out = (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+    return true;
+}
+
+/**
+ * @brief Read a string written by writeBinString()
+ *
+ * @param out The string that was read, which must be free()'d, or NULL if it was empty
+ * @return true if the string was read, false if the file ended
+ */
+static bool readBinString(char** out)
+{
+    uint64_t len;
+    if (!readVarint(&len))
+    {
+        return false;
+    }
+
+    *out = NULL;
+    if (0 == len)
+    {
+        return true;
+    }
+
+    char* str = malloc(len + 1);
+    if (NULL == str || len != fread(str, 1, len, replay.file))
+    {
+        free(str);
+        return false;
+    }
+    str[len] = '\0';
+    *out     = str;
+    return true;
+}
+
+/**
+ * @brief Write an entry in the binary format. Each record is a type byte, the time since the previous record, and a
+ * type-specific payload. Touch and accelerometer values are stored as the change since the last value of that type
+ *
+ * @param entry The entry to write
+ */
+static void writeBinEntry(const replayEntry_t* entry)
+{
+    // Entries recorded "as early as possible" with time 0 are written at the current time
+    int64_t delta = entry->time - replay.binTime;
+    if (delta < 0)
+    {
+        delta = 0;
+    }
+    replay.binTime += delta;
+
+    fputc(entry->type, replay.file);
+    writeVarint(delta);
+
+    switch (entry->type)
+    {
+        case BUTTON_PRESS:
+        case BUTTON_RELEASE:
+        {
+            fputc(__builtin_ctz(entry->buttonVal), replay.file);
+            break;
+        }
+
+        case TOUCH_PHI:
+        case TOUCH_R:
+        case TOUCH_INTENSITY:
+        case TOUCH_HORZ:
+        case TOUCH_HORZ_INTENSITY:
+        case TOUCH_VERT:
+        case TOUCH_VERT_INTENSITY:
+        {
+            writeZigzag((int64_t)entry->touchVal - replay.binBase[entry->type]);
+            replay.binBase[entry->type] = entry->touchVal;
+            break;
+        }
+
+        case ACCEL_X:
+        case ACCEL_Y:
+        case ACCEL_Z:
+        {
+            writeZigzag((int64_t)entry->accelVal - replay.binBase[entry->type]);
+            replay.binBase[entry->type] = entry->accelVal;
+            break;
+        }
+
+        case FUZZ:
+        case QUIT:
+        case INDEX:
+        case LAST_TYPE:
+        {
+            break;
+        }
+
+        case SCREENSHOT:
+        case SET_MODE:
+        case COMMAND:
+        case NVS_SNAPSHOT:
+        {
+            // These are all the same union member
+            writeBinString(entry->filename);
+            break;
+        }
+
+        case RANDOM_SEED:
+        {
+            writeVarint(entry->seedVal);
+            break;
+        }
+
+        case KEYFRAME:
+        {
+            // Keyframes are absolute, so playback can start from any of them
+            const replayKeyframe_t* kf = &entry->keyframe;
+            writeVarint(kf->frame);
+            writeVarint(replay.binTime);
+            writeVarint(kf->nvsOffset);
+            writeVarint(kf->seed);
+            fputc(kf->buttons, replay.file);
+            for (int i = 0; i < NUM_ANALOG_TYPES; i++)
+            {
+                writeZigzag(kf->analog[i]);
+                replay.binBase[analogTypes[i]] = kf->analog[i];
+            }
+            writeBinString(kf->modeName);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Read an entry in the binary format
+ *
+ * @param entry The entry to read into
+ * @return true if an entry was read, false at the end of the recording or if there was an error
+ */
+static bool readBinEntry(replayEntry_t* entry)
+{
+    int type = fgetc(replay.file);
+    if (EOF == type || INDEX == type)
+    {
+        // The index is always after the last entry
+        return false;
+    }
+    else if (type >= LAST_TYPE)
+    {
+        printf("ERR: Invalid action type %d in recording\n", type);
+        return false;
+    }
+
+    uint64_t delta;
+    if (!readVarint(&delta))
+    {
+        return false;
+    }
+    replay.binTime += delta;
+
+    entry->type = type;
+    entry->time = replay.binTime;
+
+    switch (entry->type)
+    {
+        case BUTTON_PRESS:
+        case BUTTON_RELEASE:
+        {
+            int bit = fgetc(replay.file);
+            if (EOF == bit || bit >= 8)
+            {
+                return false;
+            }
+            entry->buttonVal = (buttonBit_t)(1 << bit);
+            break;
+        }
+
+        case TOUCH_PHI:
+        case TOUCH_R:
+        case TOUCH_INTENSITY:
+        case TOUCH_HORZ:
+        case TOUCH_HORZ_INTENSITY:
+        case TOUCH_VERT:
+        case TOUCH_VERT_INTENSITY:
+        case ACCEL_X:
+        case ACCEL_Y:
+        case ACCEL_Z:
+        {
+            int64_t diff;
+            if (!readZigzag(&diff))
+            {
+                return false;
+            }
+            replay.binBase[entry->type] += diff;
+            if (entry->type >= ACCEL_X && entry->type <= ACCEL_Z)
+            {
+                entry->accelVal = replay.binBase[entry->type];
+            }
+            else
+            {
+                entry->touchVal = replay.binBase[entry->type];
+            }
+            break;
+        }
+
+        case FUZZ:
+        case QUIT:
+        case INDEX:
+        case LAST_TYPE:
+        {
+            break;
+        }
+
+        case SCREENSHOT:
+        case SET_MODE:
+        case COMMAND:
+        case NVS_SNAPSHOT:
+        {
+            // These are all the same union member
+            return readBinString(&entry->filename);
+        }
+
+        case RANDOM_SEED:
+        {
+            uint64_t seed;
+            if (!readVarint(&seed))
+            {
+                return false;
+            }
+            entry->seedVal = seed;
+            break;
+        }
+
+        case KEYFRAME:
+        {
+            replayKeyframe_t* kf = &entry->keyframe;
+            uint64_t time, nvsOffset, seed;
+            int buttons;
+            if (!readVarint(&kf->frame) || !readVarint(&time) || !readVarint(&nvsOffset) || !readVarint(&seed)
+                || EOF == (buttons = fgetc(replay.file)))
+            {
+                return false;
+            }
+            kf->nvsOffset = nvsOffset;
+            kf->seed      = seed;
+            kf->buttons   = buttons;
+
+            for (int i = 0; i < NUM_ANALOG_TYPES; i++)
+            {
+                int64_t val;
+                if (!readZigzag(&val))
+                {
+                    return false;
+                }
+                kf->analog[i]                  = val;
+                replay.binBase[analogTypes[i]] = val;
+            }
+
+            // Keyframes are absolute, so the time is resynchronized
+            replay.binTime = time;
+            entry->time    = time;
+            return readBinString(&kf->modeName);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Record a snapshot of the whole NVS, which keyframes after it refer to
+ *
+ * @param time The time of the snapshot
+ */
+static void recordNvsSnapshot(int64_t time)
+{
+    char* nvsJson = emuNvsExportJson();
+    if (NULL != nvsJson)
+    {
+        replayEntry_t nvsEntry = {
+            .time    = time,
+            .type    = NVS_SNAPSHOT,
+            .nvsJson = nvsJson,
+        };
+        replay.nvsOffset     = ftell(replay.file);
+        replay.nvsGeneration = emuNvsGetGeneration();
+        writeEntry(&nvsEntry);
+        free(nvsJson);
+    }
+}
+
+/**
+ * @brief Record a keyframe with everything needed to start playback from this frame. The NVS is snapshotted first if
+ * it changed since the last keyframe, and the random number generator is reseeded with a seed stored in the keyframe
+ *
+ * @param frame The current frame number
+ */
+static void recordKeyframe(uint64_t frame)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (0 == replay.nvsOffset || replay.nvsGeneration != emuNvsGetGeneration())
+    {
+        recordNvsSnapshot(now);
+    }
+
+    // Derive the new seed from the current sequence, so recordings made with the same seed stay reproducible
+    replayEntry_t kfEntry = {
+        .time     = now,
+        .type     = KEYFRAME,
+        .keyframe = {
+            .frame     = frame,
+            .nvsOffset = replay.nvsOffset,
+            .seed      = (uint32_t)rand(),
+            .buttons   = replay.lastButtons,
+            .analog    = {replay.lastTouchPhi, replay.lastTouchR, replay.lastTouchIntensity, replay.lastTouchHorz,
+                          replay.lastTouchHorzIntensity, replay.lastTouchVert, replay.lastTouchVertIntensity,
+                          replay.lastAccelX, replay.lastAccelY, replay.lastAccelZ},
+            .modeName  = strdup(getSwadgeMode()->modeName),
+        },
+    };
+
+    // Add it to the index
+    if (replay.indexLen == replay.indexCap)
+    {
+        uint32_t newCap            = replay.indexCap ? replay.indexCap * 2 : 64;
+        replayIndexEntry_t* newIdx = realloc(replay.index, newCap * sizeof(replayIndexEntry_t));
+        if (NULL != newIdx)
+        {
+            replay.index    = newIdx;
+            replay.indexCap = newCap;
+        }
+    }
+    if (replay.indexLen < replay.indexCap)
+    {
+        replay.index[replay.indexLen].frame  = frame;
+        replay.index[replay.indexLen].offset = ftell(replay.file);
+        replay.indexLen++;
+    }
+
+    writeEntry(&kfEntry);
+    emulatorSetEspRandomSeed(kfEntry.keyframe.seed);
+    freeEntry(&kfEntry);
+}
+
+/**
+ * @brief Write the keyframe index after the last entry of a binary recording, followed by a trailer with the offset
+ * of the index
+ */
+static void writeIndex(void)
+{
+    uint32_t indexOffset = ftell(replay.file);
+
+    fputc(INDEX, replay.file);
+    writeVarint(0);
+    writeVarint(replay.indexLen);
+    for (uint32_t i = 0; i < replay.indexLen; i++)
+    {
+        writeVarint(replay.index[i].frame);
+        writeVarint(replay.index[i].offset);
+    }
+
+    uint8_t trailer[8] = {
+        indexOffset & 0xFF,
+        (indexOffset >> 8) & 0xFF,
+        (indexOffset >> 16) & 0xFF,
+        (indexOffset >> 24) & 0xFF,
+    };
+    memcpy(&trailer[4], BIN_INDEX_MAGIC, 4);
+    fwrite(trailer, 1, sizeof(trailer), replay.file);
+}
+
+/**
+ * @brief Load the keyframe index of the binary recording being played back. If the recording has no index, because
+ * the emulator didn't exit cleanly, it is rebuilt by scanning the whole file
+ *
+ * @return true if the index was loaded, false if it couldn't be
+ */
+static bool loadIndex(void)
+{
+    if (replay.indexLoaded)
+    {
+        return true;
+    }
+
+    replay.indexLen = 0;
+
+    // Reading moves the file and changes the delta state, so save it to be restored after
+    long resume       = ftell(replay.file);
+    int64_t savedTime = replay.binTime;
+    int32_t savedBase[LAST_TYPE];
+    memcpy(savedBase, replay.binBase, sizeof(savedBase));
+
+    bool ok = false;
+
+    // Check for the trailer
+    uint8_t trailer[8];
+    if (0 == fseek(replay.file, -(long)sizeof(trailer), SEEK_END)
+        && sizeof(trailer) == fread(trailer, 1, sizeof(trailer), replay.file)
+        && !memcmp(&trailer[4], BIN_INDEX_MAGIC, 4))
+    {
+        uint32_t indexOffset = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+
+        uint64_t delta, count;
+        if (0 == fseek(replay.file, indexOffset, SEEK_SET) && INDEX == fgetc(replay.file) && readVarint(&delta)
+            && readVarint(&count))
+        {
+            replayIndexEntry_t* newIdx = realloc(replay.index, (count ? count : 1) * sizeof(replayIndexEntry_t));
+            if (NULL != newIdx)
+            {
+                replay.index    = newIdx;
+                replay.indexCap = count ? count : 1;
+                ok              = true;
+                for (uint64_t i = 0; i < count && ok; i++)
+                {
+                    uint64_t offset;
+                    ok = readVarint(&replay.index[i].frame) && readVarint(&offset);
+                    replay.index[i].offset = offset;
+                    replay.indexLen++;
+                }
+            }
+        }
+    }
+
+    if (!ok)
+    {
+        // Scan the whole file for keyframes
+        printf("Replay: Recording has no index, scanning for keyframes\n");
+        replay.indexLen = 0;
+        fseek(replay.file, strlen(BIN_MAGIC) + 1, SEEK_SET);
+
+        replayEntry_t entry = {0};
+        uint32_t offset     = ftell(replay.file);
+        while (readBinEntry(&entry))
+        {
+            if (KEYFRAME == entry.type)
+            {
+                if (replay.indexLen == replay.indexCap)
+                {
+                    uint32_t newCap            = replay.indexCap ? replay.indexCap * 2 : 64;
+                    replayIndexEntry_t* newIdx = realloc(replay.index, newCap * sizeof(replayIndexEntry_t));
+                    if (NULL == newIdx)
+                    {
+                        freeEntry(&entry);
+                        break;
+                    }
+                    replay.index    = newIdx;
+                    replay.indexCap = newCap;
+                }
+                replay.index[replay.indexLen].frame  = entry.keyframe.frame;
+                replay.index[replay.indexLen].offset = offset;
+                replay.indexLen++;
+            }
+            freeEntry(&entry);
+            offset = ftell(replay.file);
+        }
+        ok = true;
+    }
+
+    fseek(replay.file, resume, SEEK_SET);
+    replay.binTime = savedTime;
+    memcpy(replay.binBase, savedBase, sizeof(savedBase));
+
+    replay.indexLoaded = ok;
+    return ok;
+}
+
+/**
+ * @brief Play a binary recording back with the NVS it was recorded with. The first NVS snapshot, which is recorded
+ * before the Swadge boots, is loaded into scratch NVS, so playback never changes the NVS file
+ */
+static void loadInitialNvs(void)
+{
+    // Reading moves the file and changes the delta state, so save it to be restored after
+    long resume       = ftell(replay.file);
+    int64_t savedTime = replay.binTime;
+    int32_t savedBase[LAST_TYPE];
+    memcpy(savedBase, replay.binBase, sizeof(savedBase));
+
+    // The snapshot comes before the first keyframe, or the first keyframe refers to it
+    replayEntry_t entry = {0};
+    while (readBinEntry(&entry))
+    {
+        if (KEYFRAME == entry.type && entry.keyframe.nvsOffset)
+        {
+            uint32_t nvsOffset = entry.keyframe.nvsOffset;
+            freeEntry(&entry);
+            if (0 != fseek(replay.file, nvsOffset, SEEK_SET) || !readBinEntry(&entry))
+            {
+                break;
+            }
+        }
+
+        if (NVS_SNAPSHOT == entry.type)
+        {
+            if (emuNvsUseScratch(entry.nvsJson))
+            {
+                printf("Replay: Playing back with the recorded NVS, the NVS file won't be changed\n");
+            }
+            else
+            {
+                printf("ERR: Replay: Couldn't load the recorded NVS\n");
+            }
+        }
+
+        if (NVS_SNAPSHOT == entry.type || KEYFRAME == entry.type)
+        {
+            break;
+        }
+        freeEntry(&entry);
+    }
+    freeEntry(&entry);
+
+    fseek(replay.file, resume, SEEK_SET);
+    replay.binTime = savedTime;
+    memcpy(replay.binBase, savedBase, sizeof(savedBase));
+}
+
+/**
+ * @brief Fast-forward playback to the last keyframe at or before the given frame. Playback stays deterministic because
+ * every recorded input is still played back in order, it just happens without drawing anything. The keyframe is used
+ * to check that playback is in the same mode the recorder was when it's reached
+ *
+ * @param frame The recorded frame number to seek to
+ */
+static void applySeek(uint64_t frame)
+{
+    if (!replay.binary)
+    {
+        printf("ERR: Replay: Only binary (" BIN_EXTENSION ") recordings can be seeked\n");
+        return;
+    }
+
+    if (!loadIndex())
+    {
+        printf("ERR: Replay: Couldn't load the keyframe index\n");
+        return;
+    }
+
+    // Find the last keyframe at or before the frame
+    const replayIndexEntry_t* found = NULL;
+    for (uint32_t i = 0; i < replay.indexLen && replay.index[i].frame <= frame; i++)
+    {
+        found = &replay.index[i];
+    }
+
+    if (NULL == found)
+    {
+        printf("ERR: Replay: No keyframe at or before frame %" PRIu64 "\n", frame);
+        return;
+    }
+
+    // Playback can't be undone, so only seek forward
+    if (replay.lastKeyframe >= 0 && found->frame <= (uint64_t)replay.lastKeyframe)
+    {
+        printf("ERR: Replay: Frame %" PRIu64 " was already played back, restart playback to seek to it\n", frame);
+        return;
+    }
+
+    printf("Replay: Fast-forwarding to keyframe at frame %" PRIu64 "\n", found->frame);
+    replay.seekKeyframe    = found->frame;
+    replay.seekFastForward = !emulatorArgs.fastForward;
+    emulatorSetFastForward(true);
+}
+
+/**
+ * @brief Stop seeking, and stop fast-forwarding if it was started for the seek
+ */
+static void finishSeek(void)
+{
+    if (replay.seekFastForward)
+    {
+        emulatorSetFastForward(false);
+    }
+    replay.seekKeyframe    = -1;
+    replay.seekFastForward = false;
+}
+
 /**
  * @brief Begins recording emulator inputs to the given filename
  *
@@ -880,6 +1776,7 @@ static void writeEntry(const replayEntry_t* entry)
  */
 void startRecording(const char* filename)
 {
+    stopRecording();
     if (replay.file != NULL)
     {
         fclose(replay.file);
@@ -889,15 +1786,37 @@ void startRecording(const char* filename)
     char buf[128];
     if (!filename || !*filename)
     {
-        filename = getTimestampFilename(buf, sizeof(buf) - 1, "rec-", "csv");
+        filename = getTimestampFilename(buf, sizeof(buf) - 1, "rec-", BIN_EXTENSION + 1);
     }
 
+    // Use the binary format for .swr files, and CSV for anything else
+    size_t nameLen = strlen(filename);
+    replay.binary  = (nameLen >= strlen(BIN_EXTENSION)
+                     && !strcasecmp(filename + nameLen - strlen(BIN_EXTENSION), BIN_EXTENSION));
+
     // If specified, use custom filename, otherwise use timestamp one
     printf("\nReplay: Recording inputs to file %s\n", filename);
-    replay.file = fopen(filename, "w");
-    replay.mode = RECORD;
+    replay.file          = fopen(filename, replay.binary ? "wb" : "w");
+    replay.mode          = RECORD;
+    replay.headerHandled = false;
+    replay.binTime       = 0;
+    replay.nextKeyframe  = 0;
+    replay.nvsOffset     = 0;
+    replay.indexLen      = 0;
+    replay.indexLoaded   = false;
+    memset(replay.binBase, 0, sizeof(replay.binBase));
     if (replay.file != NULL)
     {
+        if (replay.binary)
+        {
+            replay.headerHandled = true;
+            fwrite(BIN_MAGIC, 1, strlen(BIN_MAGIC), replay.file);
+            fputc(BIN_VERSION, replay.file);
+
+            // Snapshot the NVS before the Swadge boots, so playback can boot with it too
+            recordNvsSnapshot(0);
+        }
+
         if (emulatorArgs.startMode)
         {
             if (!replay.headerHandled)
@@ -944,6 +1863,10 @@ void stopRecording(void)
 {
     if (replay.file != NULL && replay.mode == RECORD)
     {
+        if (replay.binary)
+        {
+            writeIndex();
+        }
         fclose(replay.file);
         replay.file = NULL;
         printf("\nStopped recording inputs\n");
@@ -962,6 +1885,7 @@ bool isRecordingInput(void)
  */
 void startPlayback(const char* recordingName)
 {
+    stopRecording();
     if (replay.file != NULL)
     {
         fclose(replay.file);
@@ -969,11 +1893,60 @@ void startPlayback(const char* recordingName)
     }
 
     printf("\nReplay: Replaying inputs from file %s\n", recordingName);
-    replay.file = fopen(recordingName, "r");
-    replay.mode = REPLAY;
+    replay.file          = fopen(recordingName, "rb");
+    replay.mode          = REPLAY;
+    replay.headerHandled = false;
+    replay.binary        = false;
+    replay.binTime       = 0;
+    replay.indexLoaded   = false;
+    replay.seekFrame     = -1;
+    replay.lastKeyframe  = -1;
+    finishSeek();
+    memset(replay.binBase, 0, sizeof(replay.binBase));
+
+    if (replay.file != NULL)
+    {
+        // Check for the binary format's magic, otherwise it's CSV
+        char magic[sizeof(BIN_MAGIC)] = {0};
+        if (strlen(BIN_MAGIC) == fread(magic, 1, strlen(BIN_MAGIC), replay.file) && !strcmp(magic, BIN_MAGIC))
+        {
+            int version = fgetc(replay.file);
+            if (BIN_VERSION != version)
+            {
+                printf("ERR: Unsupported binary recording version %d\n", version);
+                fclose(replay.file);
+                replay.file = NULL;
+            }
+            replay.binary        = true;
+            replay.headerHandled = true;
+        }
+        else
+        {
+            rewind(replay.file);
+        }
+    }
+
+    if (replay.binary && NULL != replay.file)
+    {
+        loadInitialNvs();
+    }
 
     // Return true if the file was opened OK and has a valid header and first entry
-    readEntry(&replay.nextEntry);
+    replay.readCompleted = !readEntry(&replay.nextEntry);
+}
+
+/**
+ * @brief Fast-forward playback to the last keyframe at or before a frame of a binary recording. This starts at the
+ * start of the next frame
+ *
+ * @param frame The frame number, as counted when the recording was made
+ */
+void seekPlayback(uint64_t frame)
+{
+    if (replay.mode == REPLAY && replay.file)
+    {
+        replay.seekFrame = frame;
+    }
 }
 
 /**
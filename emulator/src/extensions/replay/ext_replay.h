@@ -59,6 +59,23 @@
  * 10000000,Screenshot,afterFuzz.bmp
  * 10000000,Quit,
  * \endcode
+ *
+ * \section ext_binary_format Binary Recording File Format
+ * Recording files with the extension `.swr`, which is also used for automatically generated names, are written in
+ * a compact binary format instead. Playback detects the format from the file's contents. Binary files start with
+ * the magic bytes `SWRP` and a version byte. Each entry is then a type byte, the time since the previous entry as a
+ * variable-length integer, and a type-specific value. Touchpad and accelerometer values are stored as zigzag-encoded
+ * changes from the previous value of the same type.
+ *
+ * Every ::KEYFRAME_INTERVAL frames, a keyframe entry stores the frame number, absolute time, Swadge mode, inputs,
+ * and a new random seed, which the random number generator is reseeded with. An NVS snapshot entry is written before
+ * the Swadge boots, and precedes a keyframe whenever the NVS changed. When recording stops, an index of keyframe
+ * offsets is written, followed by an eight byte trailer with the index's offset and the magic bytes `SWRI`.
+ *
+ * Binary recordings are played back with the NVS they were recorded with, which is kept in memory, so playback never
+ * changes the NVS file. seekPlayback() fast-forwards playback to the last keyframe at or before a frame, playing back
+ * every input on the way without drawing, so the Swadge ends up in the same state it was recorded in. Playback can
+ * only be seeked forward.
  */
 
 #pragma once
@@ -72,6 +89,7 @@ void startRecording(const char* recordingName);
 void stopRecording(void);
 bool isRecordingInput(void);
 void startPlayback(const char* recordingName);
+void seekPlayback(uint64_t frame);
 void recordScreenshotTaken(const char* name);
 void emulatorRecordRandomSeed(uint32_t seed);
 void emulatorRecordCommand(const char* command);
@@ -0,0 +1,114 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ext_tests.h"
+#include "emu_args.h"
+#include "emu_main.h"
+#include "macros.h"
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief A function which runs a test, and returns true if it passed
+typedef bool (*fnTestCb_t)(void);
+
+/// @brief A named self-test
+typedef struct
+{
+    const char* name; ///< The name of the test, which the filter is matched against
+    fnTestCb_t fn;    ///< The function which runs the test
+    bool optIn;       ///< true to only run this when a filter is given which matches it, like a slow benchmark
+} emuTest_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool testsInitCb(emuArgs_t* emuArgs);
+static void testsPreFrameCb(uint64_t frame);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+emuExtension_t testsEmuExtension = {
+    .name            = "tests",
+    .fnInitCb        = testsInitCb,
+    .fnPreFrameCb    = testsPreFrameCb,
+    .fnPostFrameCb   = NULL,
+    .fnKeyCb         = NULL,
+    .fnMouseMoveCb   = NULL,
+    .fnMouseButtonCb = NULL,
+    .fnRenderCb      = NULL,
+};
+
+/// @brief All of the self-tests, in the order they are run
+static const emuTest_t emuTests[] = {
+    {.name = "cache.trim", .fn = testAssetCacheTrim},
+    {.name = "draw.shapeDirtyRows", .fn = testShapeDirtyRows},
+    {.name = "flatHashMap.bench", .fn = benchFlatHashMap, .optIn = true},
+    {.name = "flatHashMap.robinHood", .fn = testFlatHashRobinHood},
+    {.name = "font.glyphCache", .fn = testFontGlyphCache},
+    {.name = "font.layoutCache", .fn = testFontLayoutCache},
+    {.name = "freertos.queueBlocking", .fn = testQueueBlocking},
+    {.name = "heatshrink.header", .fn = testHeatshrinkHeader},
+    {.name = "list.pool", .fn = testListPool},
+    {.name = "midi.index", .fn = testMidiIndex},
+    {.name = "midi.discardedSoundCallbacks", .fn = testMidiDiscardedSoundCallbacks},
+    {.name = "p2p.window", .fn = testP2pWindow},
+    {.name = "tilemap.cacheScroll", .fn = testTilemapCacheScroll},
+    {.name = "wsg.spans", .fn = testWsgSpans},
+    {.name = "wsg.affineQuarterTurns", .fn = testWsgAffineQuarterTurns},
+};
+
+/// @brief Only run tests whose names contain this, or NULL to run all tests
+static const char* testFilter = NULL;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+static bool testsInitCb(emuArgs_t* emuArgs)
+{
+    testFilter = emuArgs->testFilter;
+    return emuArgs->runTests;
+}
+
+static void testsPreFrameCb(uint64_t frame)
+{
+    // The system is initialized by the first frame, so run everything then
+    if (1 != frame)
+    {
+        return;
+    }
+
+    int numRun    = 0;
+    int numFailed = 0;
+    for (int i = 0; i < (int)ARRAY_SIZE(emuTests); i++)
+    {
+        if (testFilter ? !strstr(emuTests[i].name, testFilter) : emuTests[i].optIn)
+        {
+            continue;
+        }
+
+        printf("TEST %s\n", emuTests[i].name);
+        bool passed = emuTests[i].fn();
+        printf("%s %s\n", passed ? "PASS" : "FAIL", emuTests[i].name);
+        fflush(stdout);
+
+        numRun++;
+        if (!passed)
+        {
+            numFailed++;
+        }
+    }
+
+    printf("%d of %d tests passed\n", numRun - numFailed, numRun);
+    emulatorSetExitCode((numFailed || !numRun) ? 1 : 0);
+    emulatorQuit();
+}
@@ -0,0 +1,88 @@
+/*! \file ext_tests.h
+ *
+ * \section ext_tests Emulator Self-Tests
+ *
+ * The tests extension runs self-tests of Swadge utilities from inside the emulator, once the system is initialized,
+ * then exits. It is enabled with \c --test, optionally with a filter like \c --test=hashMap to only run the tests
+ * whose names contain the filter. Each test prints PASS or FAIL, and the emulator exits with a nonzero code if any test
+ * failed. \c make \c test builds the emulator and runs every test.
+ *
+ * Benchmarks are opt-in and only run when a filter matches them, like \c --test=bench. They print their timings and
+ * pass as long as the code they time gave the right results.
+ *
+ * A test is a function which returns true if it passed. Tests are listed in the table in ext_tests.c, and should use
+ * ::TEST_ASSERT to report what failed.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "emu_ext.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/**
+ * @brief Fail the current test and print the failed condition if the given condition is false
+ *
+ * @param cond The condition which must be true
+ */
+#define TEST_ASSERT(cond)                                                  \
+    do                                                                     \
+    {                                                                      \
+        if (!(cond))                                                       \
+        {                                                                  \
+            printf("    %s:%d: failed '%s'\n", __FILE__, __LINE__, #cond); \
+            return false;                                                  \
+        }                                                                  \
+    } while (0)
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+extern emuExtension_t testsEmuExtension;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+// test_cache.c
+bool testAssetCacheTrim(void);
+
+// test_draw.c
+bool testShapeDirtyRows(void);
+
+// test_flatHashMap.c
+bool benchFlatHashMap(void);
+bool testFlatHashRobinHood(void);
+
+// test_font.c
+bool testFontGlyphCache(void);
+bool testFontLayoutCache(void);
+
+// test_freertos.c
+bool testQueueBlocking(void);
+
+// test_heatshrink.c
+bool testHeatshrinkHeader(void);
+
+// test_list.c
+bool testListPool(void);
+
+// test_midi.c
+bool testMidiIndex(void);
+bool testMidiDiscardedSoundCallbacks(void);
+
+// test_p2p.c
+bool testP2pWindow(void);
+
+// test_tilemap.c
+bool testTilemapCacheScroll(void);
+
+// test_wsg.c
+bool testWsgSpans(void);
+bool testWsgAffineQuarterTurns(void);
@@ -0,0 +1,51 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include "ext_tests.h"
+#include "fs_cache.h"
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that trimming the asset cache keeps unreferenced assets which fit in the budget, and that flushing it
+ * frees them
+ *
+ * @return true if the cache kept and freed the right assets
+ */
+bool testAssetCacheTrim(void)
+{
+    flushAssetCache();
+    uint32_t baseSize = getAssetCacheSize();
+
+    // Load and release an asset, it stays cached while it fits in the budget
+    wsg_t* wsg = loadWsgCached(KID_0_WSG);
+    TEST_ASSERT(NULL != wsg);
+    uint32_t loadedSize = getAssetCacheSize();
+    TEST_ASSERT(loadedSize > baseSize);
+    releaseWsgCached(wsg);
+    TEST_ASSERT(getAssetCacheSize() == loadedSize);
+
+    // Trimming, like a mode switch does, keeps it warm
+    trimAssetCache();
+    TEST_ASSERT(getAssetCacheSize() == loadedSize);
+    wsg_t* again = loadWsgCached(KID_0_WSG);
+    TEST_ASSERT(again == wsg);
+    releaseWsgCached(again);
+
+    // A smaller budget evicts it
+    setAssetCacheBudget(baseSize);
+    TEST_ASSERT(getAssetCacheSize() == baseSize);
+    setAssetCacheBudget(ASSET_CACHE_DEFAULT_BUDGET);
+
+    // Flushing frees unreferenced assets regardless of the budget
+    wsg = loadWsgCached(KID_0_WSG);
+    TEST_ASSERT(NULL != wsg);
+    releaseWsgCached(wsg);
+    TEST_ASSERT(getAssetCacheSize() > baseSize);
+    flushAssetCache();
+    TEST_ASSERT(getAssetCacheSize() == baseSize);
+    return true;
+}
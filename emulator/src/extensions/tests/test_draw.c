@@ -0,0 +1,240 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ext_tests.h"
+#include "hdw-tft.h"
+#include "hdw-tft_emu.h"
+#include "shapes.h"
+#include "fill.h"
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool checkDirtyRows(const char* name, void (*drawFn)(void));
+
+//==============================================================================
+// Draw Cases
+//==============================================================================
+
+// Each case draws below the first band, so rows which aren't marked dirty are never sent
+
+static void drawLineCase(void)
+{
+    drawLine(20, 40, 200, 180, c500, 3);
+}
+
+static void drawLineFastCase(void)
+{
+    drawLineFast(200, 60, 30, 150, c050);
+}
+
+static void drawLineScaledCase(void)
+{
+    drawLineScaled(2, 3, 30, 20, c005, 0, 10, 30, 4, 5);
+}
+
+static void drawRectCase(void)
+{
+    drawRect(40, 70, 100, 190, c550);
+}
+
+static void drawRectScaledCase(void)
+{
+    drawRectScaled(1, 1, 12, 14, c505, 20, 50, 6, 7);
+}
+
+static void drawTriangleCase(void)
+{
+    drawTriangleOutlined(60, 50, 200, 120, 90, 200, c055, c555);
+}
+
+static void drawEllipseCase(void)
+{
+    drawEllipse(140, 120, 60, 35, c500);
+}
+
+static void drawEllipseScaledCase(void)
+{
+    drawEllipseScaled(20, 12, 10, 6, c050, 20, 50, 5, 6);
+}
+
+static void drawCircleCase(void)
+{
+    drawCircle(140, 120, 50, c005);
+}
+
+static void drawCircleScaledCase(void)
+{
+    drawCircleScaled(15, 12, 8, c550, 20, 40, 6, 6);
+}
+
+static void drawCircleQuadrantsCase(void)
+{
+    drawCircleQuadrants(140, 120, 45, true, false, true, false, c505);
+}
+
+static void drawCircleFilledQuadrantsCase(void)
+{
+    drawCircleFilledQuadrants(140, 120, 45, false, true, false, true, c055);
+}
+
+static void drawCircleFilledCase(void)
+{
+    drawCircleFilled(100, 130, 40, c555);
+}
+
+static void drawCircleFilledScaledCase(void)
+{
+    drawCircleFilledScaled(12, 12, 7, c500, 30, 40, 7, 6);
+}
+
+static void drawCircleOutlineCase(void)
+{
+    drawCircleOutline(140, 120, 60, 5, c050);
+}
+
+static void drawEllipseRectCase(void)
+{
+    drawEllipseRect(40, 50, 220, 200, c005);
+}
+
+static void drawQuadBezierCase(void)
+{
+    drawQuadBezier(20, 60, 140, 220, 260, 40, c550);
+}
+
+static void drawQuadRationalBezierCase(void)
+{
+    drawQuadRationalBezier(20, 200, 120, 30, 250, 180, 2.0f, c505);
+}
+
+static void drawCubicBezierCase(void)
+{
+    drawCubicBezier(20, 200, 80, 20, 180, 230, 260, 50, c055);
+}
+
+static void drawCubicBezierScaledCase(void)
+{
+    drawCubicBezierScaled(2, 30, 10, 2, 25, 28, 35, 5, c555, 20, 40, 6, 6);
+}
+
+static void drawRotatedEllipseCase(void)
+{
+    drawRotatedEllipse(140, 120, 70, 30, 0.7f, c500);
+}
+
+static void oddEvenFillCase(void)
+{
+    // Send the outline first, so only the fill is left for the checked frame
+    drawRect(50, 60, 150, 170, c555);
+    drawDisplayTft(NULL);
+    oddEvenFill(50, 60, 150, 170, c555, c050);
+}
+
+static void fillCircleSectorCase(void)
+{
+    fillCircleSector(140, 120, 20, 70, 30, 150, c005);
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that the shape and fill primitives mark the rows they draw to as dirty, so they reach the display when
+ * dirty tracking is enabled
+ *
+ * @return true if every primitive's output was sent
+ */
+bool testShapeDirtyRows(void)
+{
+    if (NULL != getBandRendererTft())
+    {
+        printf("    Skipped, a band renderer is set\n");
+        return true;
+    }
+
+    static const struct
+    {
+        const char* name;
+        void (*fn)(void);
+    } cases[] = {
+        {"drawLine", drawLineCase},
+        {"drawLineFast", drawLineFastCase},
+        {"drawLineScaled", drawLineScaledCase},
+        {"drawRect", drawRectCase},
+        {"drawRectScaled", drawRectScaledCase},
+        {"drawTriangleOutlined", drawTriangleCase},
+        {"drawEllipse", drawEllipseCase},
+        {"drawEllipseScaled", drawEllipseScaledCase},
+        {"drawCircle", drawCircleCase},
+        {"drawCircleScaled", drawCircleScaledCase},
+        {"drawCircleQuadrants", drawCircleQuadrantsCase},
+        {"drawCircleFilledQuadrants", drawCircleFilledQuadrantsCase},
+        {"drawCircleFilled", drawCircleFilledCase},
+        {"drawCircleFilledScaled", drawCircleFilledScaledCase},
+        {"drawCircleOutline", drawCircleOutlineCase},
+        {"drawEllipseRect", drawEllipseRectCase},
+        {"drawQuadBezier", drawQuadBezierCase},
+        {"drawQuadRationalBezier", drawQuadRationalBezierCase},
+        {"drawCubicBezier", drawCubicBezierCase},
+        {"drawCubicBezierScaled", drawCubicBezierScaledCase},
+        {"drawRotatedEllipse", drawRotatedEllipseCase},
+        {"oddEvenFill", oddEvenFillCase},
+        {"fillCircleSector", fillCircleSectorCase},
+    };
+
+    enableDirtyTrackingTft(true);
+    bool passed = true;
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++)
+    {
+        if (!checkDirtyRows(cases[i].name, cases[i].fn))
+        {
+            passed = false;
+        }
+    }
+    enableDirtyTrackingTft(false);
+    clearPxTft();
+
+    return passed;
+}
+
+/**
+ * @brief Draw something with dirty tracking enabled and check that the display matches a fully sent frame
+ *
+ * @param name The name of the primitive, for error messages
+ * @param drawFn A function which draws the primitive
+ * @return true if everything which was drawn was sent to the display
+ */
+static bool checkDirtyRows(const char* name, void (*drawFn)(void))
+{
+    // Start from a blank frame which was fully sent
+    clearPxTft();
+    drawDisplayTft(NULL);
+
+    // Draw and send only the dirty rows
+    drawFn();
+    drawDisplayTft(NULL);
+
+    uint16_t w, h;
+    const uint32_t* bitmap = getDisplayBitmap(&w, &h);
+    uint32_t* tracked      = malloc(w * h * sizeof(uint32_t));
+    memcpy(tracked, bitmap, w * h * sizeof(uint32_t));
+
+    // Send every row and make sure nothing was missed
+    markDirtyRowsTft(0, TFT_HEIGHT);
+    drawDisplayTft(NULL);
+    bool matched = (0 == memcmp(tracked, bitmap, w * h * sizeof(uint32_t)));
+    free(tracked);
+
+    if (!matched)
+    {
+        printf("    %s drew to rows it didn't mark dirty\n", name);
+    }
+    return matched;
+}
@@ -0,0 +1,438 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "ext_tests.h"
+#include "flatHashMap.h"
+#include "hashMap.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The size of the test map's backing array
+#define TEST_MAP_SIZE 64
+
+/// The number of distinct keys, more than the map can hold
+#define TEST_NUM_KEYS 200
+
+/// The number of random puts and removes
+#define TEST_NUM_OPS 4000
+
+/// The number of keys the benchmark puts, gets, and removes each round
+#define BENCH_NUM_KEYS 1024
+
+/// The size of the benchmarked maps, so both are half full at most
+#define BENCH_MAP_SIZE 2048
+
+/// The number of times the benchmark puts, gets, and removes every key
+#define BENCH_ROUNDS 200
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/// @brief The operations the benchmark times
+typedef enum
+{
+    BENCH_PUT,
+    BENCH_GET,
+    BENCH_REMOVE,
+    BENCH_NUM_OPS,
+} benchOp_t;
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief A fixed size binary key for the benchmark
+typedef struct
+{
+    uint32_t words[4]; ///< The key's data
+} benchKey_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static uint32_t hashCollidingKey(const void* key);
+static bool collidingKeyEq(const void* a, const void* b);
+static uint32_t nextRandom(uint32_t* state);
+static bool checkRobinHood(flatHashMap_t* map, const bool* present);
+static uint32_t hashBenchKey(const void* key);
+static bool benchKeyEq(const void* a, const void* b);
+static int64_t benchNowNs(void);
+static uint32_t timeHashMap(hashMap_t* map, const void* const* keys, const void* const* lookups, int64_t* times);
+static uint32_t timeFlatHashMap(flatHashMap_t* map, const void* const* keys, const void* const* lookups,
+                                int64_t* times);
+static void printBench(const char* name, const int64_t* times);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The keys stored in the test map, each is its own index
+static uint32_t testKeys[TEST_NUM_KEYS];
+
+/// The names of the benchmarked operations
+static const char* const benchOpNames[BENCH_NUM_OPS] = {"put", "get", "remove"};
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Hash a key so every four keys collide, which forces long probe runs
+ *
+ * @param key A pointer to a uint32_t key
+ * @return The key's hash
+ */
+static uint32_t hashCollidingKey(const void* key)
+{
+    return *(const uint32_t*)key / 4;
+}
+
+/**
+ * @brief Compare two uint32_t keys
+ *
+ * @param a A key
+ * @param b Another key
+ * @return true if the keys are equal
+ */
+static bool collidingKeyEq(const void* a, const void* b)
+{
+    return *(const uint32_t*)a == *(const uint32_t*)b;
+}
+
+/**
+ * @brief A small deterministic random number generator, so failures are repeatable
+ *
+ * @param state The generator's state
+ * @return The next random number
+ */
+static uint32_t nextRandom(uint32_t* state)
+{
+    *state = (*state * 1664525) + 1013904223;
+    return *state >> 8;
+}
+
+/**
+ * @brief Check the map's Robin Hood invariants, and that it holds exactly the expected keys
+ *
+ * @param map The map to check
+ * @param present Which keys should be in the map, \c TEST_NUM_KEYS long
+ * @return true if every entry is where it belongs and every expected key is found
+ */
+static bool checkRobinHood(flatHashMap_t* map, const bool* present)
+{
+    int count = 0;
+    for (uint32_t idx = 0; idx <= map->mask; idx++)
+    {
+        const flatHashEntry_t* entry = &map->entries[idx];
+        if (0 == entry->dist)
+        {
+            continue;
+        }
+        count++;
+
+        // The distance matches how far the entry is from the slot its hash wants
+        TEST_ASSERT(entry->dist == ((idx - (entry->hash & map->mask)) & map->mask) + 1);
+
+        // An entry away from its slot is never behind an empty slot, or one much closer to its own slot
+        if (entry->dist > 1)
+        {
+            const flatHashEntry_t* prev = &map->entries[(idx - 1) & map->mask];
+            TEST_ASSERT(0 != prev->dist);
+            TEST_ASSERT(entry->dist <= prev->dist + 1);
+        }
+    }
+    TEST_ASSERT(count == map->count);
+
+    for (uint32_t key = 0; key < TEST_NUM_KEYS; key++)
+    {
+        void* value = flatHashGetBin(map, &key);
+        TEST_ASSERT(value == (present[key] ? &testKeys[key] : NULL));
+    }
+    return true;
+}
+
+/**
+ * @brief Hash a ::benchKey_t
+ *
+ * @param key A pointer to a ::benchKey_t
+ * @return The key's hash
+ */
+static uint32_t hashBenchKey(const void* key)
+{
+    return hashBytes(key, sizeof(benchKey_t));
+}
+
+/**
+ * @brief Compare two ::benchKey_t
+ *
+ * @param a A key
+ * @param b Another key
+ * @return true if the keys are equal
+ */
+static bool benchKeyEq(const void* a, const void* b)
+{
+    return bytesEq(a, sizeof(benchKey_t), b, sizeof(benchKey_t));
+}
+
+/**
+ * @brief Get the host's monotonic time, which keeps running even when the emulator's clock is virtual
+ *
+ * @return The time in nanoseconds
+ */
+static int64_t benchNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Put, get, and remove every key in a ::hashMap_t for each round, and add up how long each operation took
+ *
+ * @param map The map to benchmark, initialized and empty
+ * @param keys The \c BENCH_NUM_KEYS keys to put and remove, each with its index plus one as its value
+ * @param lookups Equal copies of the keys at different addresses, to get
+ * @param times The nanoseconds each ::benchOp_t took, added to
+ * @return The number of values which were wrong
+ */
+static uint32_t timeHashMap(hashMap_t* map, const void* const* keys, const void* const* lookups, int64_t* times)
+{
+    uint32_t wrong = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        int64_t start = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            hashPutBin(map, keys[idx], (void*)(intptr_t)(idx + 1));
+        }
+        int64_t put = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            wrong += (hashGetBin(map, lookups[idx]) != (void*)(intptr_t)(idx + 1));
+        }
+        int64_t get = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            wrong += (hashRemoveBin(map, lookups[idx]) != (void*)(intptr_t)(idx + 1));
+        }
+        int64_t removed = benchNowNs();
+
+        times[BENCH_PUT] += put - start;
+        times[BENCH_GET] += get - put;
+        times[BENCH_REMOVE] += removed - get;
+    }
+    return wrong + map->count;
+}
+
+/**
+ * @brief Put, get, and remove every key in a ::flatHashMap_t for each round, and add up how long each operation took
+ *
+ * @param map The map to benchmark, initialized and empty
+ * @param keys The \c BENCH_NUM_KEYS keys to put and remove, each with its index plus one as its value
+ * @param lookups Equal copies of the keys at different addresses, to get
+ * @param times The nanoseconds each ::benchOp_t took, added to
+ * @return The number of values which were wrong
+ */
+static uint32_t timeFlatHashMap(flatHashMap_t* map, const void* const* keys, const void* const* lookups,
+                                int64_t* times)
+{
+    uint32_t wrong = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        int64_t start = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            wrong += !flatHashPutBin(map, keys[idx], (void*)(intptr_t)(idx + 1));
+        }
+        int64_t put = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            wrong += (flatHashGetBin(map, lookups[idx]) != (void*)(intptr_t)(idx + 1));
+        }
+        int64_t get = benchNowNs();
+        for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+        {
+            wrong += (flatHashRemoveBin(map, lookups[idx]) != (void*)(intptr_t)(idx + 1));
+        }
+        int64_t removed = benchNowNs();
+
+        times[BENCH_PUT] += put - start;
+        times[BENCH_GET] += get - put;
+        times[BENCH_REMOVE] += removed - get;
+    }
+    return wrong + map->count;
+}
+
+/**
+ * @brief Print the average time each operation took
+ *
+ * @param name The name of the map and key type which was benchmarked
+ * @param times The total nanoseconds each ::benchOp_t took
+ */
+static void printBench(const char* name, const int64_t* times)
+{
+    printf("    %-18s", name);
+    for (int op = 0; op < BENCH_NUM_OPS; op++)
+    {
+        printf(" %6s %7.1f ns", benchOpNames[op], (double)times[op] / (BENCH_ROUNDS * BENCH_NUM_KEYS));
+    }
+    printf("\n");
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Time putting, getting, and removing string and binary keys with ::flatHashMap_t and ::hashMap_t, and print
+ * the average time of each operation. This is opt-in, run it with \c --test=flatHashMap.bench
+ *
+ * @return true if both maps gave the right values
+ */
+bool benchFlatHashMap(void)
+{
+    static char strKeys[BENCH_NUM_KEYS][16];
+    static char strLookups[BENCH_NUM_KEYS][16];
+    static benchKey_t binKeys[BENCH_NUM_KEYS];
+    static benchKey_t binLookups[BENCH_NUM_KEYS];
+    static const void* keys[2][BENCH_NUM_KEYS];
+    static const void* lookups[2][BENCH_NUM_KEYS];
+    static flatHashEntry_t entries[BENCH_MAP_SIZE];
+
+    // Keys which share a prefix and differ at the end, like asset names
+    for (int idx = 0; idx < BENCH_NUM_KEYS; idx++)
+    {
+        snprintf(strKeys[idx], sizeof(strKeys[idx]), "key_%04d.wsg", idx);
+        memcpy(strLookups[idx], strKeys[idx], sizeof(strKeys[idx]));
+        binKeys[idx]    = (benchKey_t){.words = {(uint32_t)idx * 2654435761u, (uint32_t)idx, 0, ~(uint32_t)idx}};
+        binLookups[idx] = binKeys[idx];
+
+        keys[0][idx]    = strKeys[idx];
+        lookups[0][idx] = strLookups[idx];
+        keys[1][idx]    = &binKeys[idx];
+        lookups[1][idx] = &binLookups[idx];
+    }
+
+    for (int bin = 0; bin < 2; bin++)
+    {
+        int64_t hashTimes[BENCH_NUM_OPS] = {0};
+        int64_t flatTimes[BENCH_NUM_OPS] = {0};
+
+        hashMap_t hashMap;
+        flatHashMap_t flatMap;
+        if (bin)
+        {
+            hashInitBin(&hashMap, BENCH_MAP_SIZE, hashBenchKey, benchKeyEq);
+            TEST_ASSERT(flatHashInitBin(&flatMap, entries, BENCH_MAP_SIZE, hashBenchKey, benchKeyEq));
+        }
+        else
+        {
+            hashInit(&hashMap, BENCH_MAP_SIZE);
+            TEST_ASSERT(flatHashInit(&flatMap, entries, BENCH_MAP_SIZE));
+        }
+
+        uint32_t hashWrong = timeHashMap(&hashMap, keys[bin], lookups[bin], hashTimes);
+        uint32_t flatWrong = timeFlatHashMap(&flatMap, keys[bin], lookups[bin], flatTimes);
+        hashDeinit(&hashMap);
+
+        printBench(bin ? "hashMap binary" : "hashMap string", hashTimes);
+        printBench(bin ? "flatHashMap binary" : "flatHashMap string", flatTimes);
+        TEST_ASSERT(0 == hashWrong);
+        TEST_ASSERT(0 == flatWrong);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Check that ::flatHashMap_t keeps its Robin Hood ordering and finds every key through random puts and removes
+ * with heavily colliding hashes, and that it handles filling up and removing while iterating
+ *
+ * @return true if the map stayed consistent
+ */
+bool testFlatHashRobinHood(void)
+{
+    static flatHashEntry_t entries[TEST_MAP_SIZE];
+    bool present[TEST_NUM_KEYS] = {false};
+    flatHashMap_t map;
+
+    TEST_ASSERT(!flatHashInitBin(&map, entries, TEST_MAP_SIZE - 1, hashCollidingKey, collidingKeyEq));
+    TEST_ASSERT(flatHashInitBin(&map, entries, TEST_MAP_SIZE, hashCollidingKey, collidingKeyEq));
+    for (uint32_t key = 0; key < TEST_NUM_KEYS; key++)
+    {
+        testKeys[key] = key;
+    }
+
+    // Random puts and removes, with the map kept no more than about 3/4 full
+    uint32_t rng = 1;
+    for (int op = 0; op < TEST_NUM_OPS; op++)
+    {
+        uint32_t key = nextRandom(&rng) % TEST_NUM_KEYS;
+        if (map.count < (TEST_MAP_SIZE * 3) / 4 && !(nextRandom(&rng) & 1))
+        {
+            TEST_ASSERT(flatHashPutBin(&map, &testKeys[key], &testKeys[key]));
+            present[key] = true;
+        }
+        else
+        {
+            void* removed = flatHashRemoveBin(&map, &testKeys[key]);
+            TEST_ASSERT(removed == (present[key] ? &testKeys[key] : NULL));
+            present[key] = false;
+        }
+        TEST_ASSERT(checkRobinHood(&map, present));
+    }
+
+    // Fill the map, it holds one fewer entry than its size
+    for (uint32_t key = 0; key < TEST_NUM_KEYS && map.count < TEST_MAP_SIZE - 1; key++)
+    {
+        TEST_ASSERT(flatHashPutBin(&map, &testKeys[key], &testKeys[key]));
+        present[key] = true;
+    }
+    TEST_ASSERT(checkRobinHood(&map, present));
+
+    // New keys don't fit, existing keys can still be updated
+    uint32_t missing = 0;
+    while (present[missing])
+    {
+        missing++;
+    }
+    TEST_ASSERT(!flatHashPutBin(&map, &testKeys[missing], &testKeys[missing]));
+    uint32_t existing = missing ? 0 : missing + 1;
+    TEST_ASSERT(flatHashPutBin(&map, &testKeys[existing], NULL));
+    TEST_ASSERT(NULL == flatHashGetBin(&map, &testKeys[existing]));
+    TEST_ASSERT(flatHashPutBin(&map, &testKeys[existing], &testKeys[existing]));
+    TEST_ASSERT(checkRobinHood(&map, present));
+
+    // Remove odd keys while iterating, every entry is visited exactly once
+    bool wasPresent[TEST_NUM_KEYS];
+    bool visited[TEST_NUM_KEYS] = {false};
+    memcpy(wasPresent, present, sizeof(present));
+    flatHashIterator_t iter = {0};
+    while (flatHashIterate(&map, &iter))
+    {
+        uint32_t key = *(const uint32_t*)iter.key;
+        TEST_ASSERT(!visited[key]);
+        visited[key] = true;
+        if (key & 1)
+        {
+            flatHashIterRemove(&map, &iter);
+            present[key] = false;
+        }
+    }
+    TEST_ASSERT(0 == memcmp(visited, wasPresent, sizeof(visited)));
+    TEST_ASSERT(checkRobinHood(&map, present));
+
+    flatHashClear(&map);
+    memset(present, 0, sizeof(present));
+    TEST_ASSERT(checkRobinHood(&map, present));
+    return true;
+}
@@ -0,0 +1,384 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "font.h"
+#include "fs_font.h"
+#include "fs_wsg.h"
+#include "renderTarget.h"
+#include "wsgCanvas.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The width of the test canvases
+#define TEST_CANVAS_W 96
+/// The height of the test canvases
+#define TEST_CANVAS_H 72
+
+/// The color the test canvases are cleared to
+#define TEST_BG_COLOR c000
+/// The color text is drawn in
+#define TEST_TEXT_COLOR c555
+
+/// The number of frames which draw distinct strings once each, which is more than the layout cache holds
+#define TEST_CHURN_COUNT 40
+
+/// The number of strings which are drawn repeatedly between the distinct strings
+#define TEST_STEADY_COUNT 3
+
+/// The colors shiny text is drawn in, from the outside in
+#define TEST_OUTER_COLOR  c500
+#define TEST_MIDDLE_COLOR c050
+#define TEST_INNER_COLOR  c005
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/// @brief The ways the glyph cache test draws text
+typedef enum
+{
+    GLYPH_TEXT,              ///< drawText(), clipped only by the canvas
+    GLYPH_TEXT_BOUNDS,       ///< drawTextBounds()
+    GLYPH_SHINY_TEXT_BOUNDS, ///< drawShinyTextBounds()
+    GLYPH_CHAR_BOUNDS,       ///< drawCharBounds() with fewer rows than the font
+    GLYPH_SHINY_CHAR_BOUNDS, ///< drawShinyCharBounds() with fewer rows than the font
+    GLYPH_NUM_DRAWS,
+} glyphDraw_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static const char* drawWrapped(wsg_t* canvas, const font_t* font, const char* text, int16_t xStart, int16_t* xOff,
+                               int16_t* yOff, int16_t xMax, int16_t yMax, bool centered);
+static bool drawMatches(wsg_t* expected, wsg_t* actual, const font_t* font, const char* text, int16_t xStart,
+                        int16_t xOff, int16_t yOff, int16_t xMax, int16_t yMax, bool centered);
+static void drawGlyphs(wsg_t* canvas, const font_t* font, glyphDraw_t draw, int16_t xOff, int16_t yOff,
+                       const int16_t* bounds, int h);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Clear a canvas and draw word wrapped text on it
+ *
+ * @param canvas The canvas to draw on
+ * @param font The font to draw with
+ * @param text The text to draw
+ * @param xStart The left edge of the text
+ * @param xOff The X coordinate to start at, set to the X coordinate after the text
+ * @param yOff The Y coordinate to start at, set to the Y coordinate of the last line
+ * @param xMax The right edge of the text
+ * @param yMax The bottom edge of the text
+ * @param centered true to center each line
+ * @return The first character which wasn't drawn, or NULL if all of it was drawn
+ */
+static const char* drawWrapped(wsg_t* canvas, const font_t* font, const char* text, int16_t xStart, int16_t* xOff,
+                               int16_t* yOff, int16_t xMax, int16_t yMax, bool centered)
+{
+    memset(canvas->px, TEST_BG_COLOR, TEST_CANVAS_W * TEST_CANVAS_H);
+    pushRenderTarget(canvas);
+    const char* rest;
+    if (centered)
+    {
+        rest = drawTextWordWrapCentered(font, TEST_TEXT_COLOR, text, xOff, yOff, xMax, yMax);
+    }
+    else
+    {
+        rest = drawTextWordWrapFixed(font, TEST_TEXT_COLOR, text, xStart, *yOff, xOff, yOff, xMax, yMax);
+    }
+    popRenderTarget();
+    return rest;
+}
+
+/**
+ * @brief Draw text the same way twice and check that the pixels, the remaining text, and the final position match
+ *
+ * @param expected The canvas to draw the first time
+ * @param actual The canvas to draw the second time
+ * @param font The font to draw with
+ * @param text The text to draw
+ * @param xStart The left edge of the text
+ * @param xOff The X coordinate to start at
+ * @param yOff The Y coordinate to start at
+ * @param xMax The right edge of the text
+ * @param yMax The bottom edge of the text
+ * @param centered true to center each line
+ * @return true if both draws matched
+ */
+static bool drawMatches(wsg_t* expected, wsg_t* actual, const font_t* font, const char* text, int16_t xStart,
+                        int16_t xOff, int16_t yOff, int16_t xMax, int16_t yMax, bool centered)
+{
+    int16_t expX = xOff, expY = yOff;
+    int16_t actX = xOff, actY = yOff;
+    const char* expRest = drawWrapped(expected, font, text, xStart, &expX, &expY, xMax, yMax, centered);
+    const char* actRest = drawWrapped(actual, font, text, xStart, &actX, &actY, xMax, yMax, centered);
+
+    if (expRest != actRest || expX != actX || expY != actY
+        || 0 != memcmp(expected->px, actual->px, TEST_CANVAS_W * TEST_CANVAS_H))
+    {
+        printf("    \"%.16s\" at (%d, %d) to (%d, %d) drew differently\n", text, xOff, yOff, xMax, yMax);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Clear a canvas and draw text or a character on it in one of the ways the glyph cache changes
+ *
+ * @param canvas The canvas to draw on
+ * @param font The font to draw with
+ * @param draw How to draw
+ * @param xOff The X coordinate to draw at
+ * @param yOff The Y coordinate to draw at
+ * @param bounds The left, top, right, and bottom edges to clip to
+ * @param h The number of rows of a character to draw
+ */
+static void drawGlyphs(wsg_t* canvas, const font_t* font, glyphDraw_t draw, int16_t xOff, int16_t yOff,
+                       const int16_t* bounds, int h)
+{
+    static const char text[] = "Wg@|#j";
+    const font_ch_t* ch      = &font->chars['@' - ' '];
+
+    memset(canvas->px, TEST_BG_COLOR, TEST_CANVAS_W * TEST_CANVAS_H);
+    pushRenderTarget(canvas);
+    switch (draw)
+    {
+        case GLYPH_TEXT:
+        {
+            drawText(font, TEST_TEXT_COLOR, text, xOff, yOff);
+            break;
+        }
+        case GLYPH_TEXT_BOUNDS:
+        {
+            drawTextBounds(font, TEST_TEXT_COLOR, text, xOff, yOff, bounds[0], bounds[1], bounds[2], bounds[3]);
+            break;
+        }
+        case GLYPH_SHINY_TEXT_BOUNDS:
+        {
+            drawShinyTextBounds(font, TEST_OUTER_COLOR, TEST_MIDDLE_COLOR, TEST_INNER_COLOR, text, xOff, yOff,
+                                bounds[0], bounds[1], bounds[2], bounds[3]);
+            break;
+        }
+        case GLYPH_CHAR_BOUNDS:
+        {
+            drawCharBounds(TEST_TEXT_COLOR, h, ch, xOff, yOff, bounds[0], bounds[1], bounds[2], bounds[3]);
+            break;
+        }
+        case GLYPH_SHINY_CHAR_BOUNDS:
+        {
+            drawShinyCharBounds(TEST_OUTER_COLOR, TEST_MIDDLE_COLOR, TEST_INNER_COLOR, h, ch, xOff, yOff, bounds[0],
+                                bounds[1], bounds[2], bounds[3]);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+    popRenderTarget();
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Draw text and characters with a font which draws from its bitmaps and a copy which draws from its glyph cache,
+ * clipped at every edge of the canvas and of smaller bounds, plain and shiny, and with fewer rows than the font, and
+ * check that both draw the same pixels
+ *
+ * @return true if the cached glyphs always drew the same as the bitmaps
+ */
+bool testFontGlyphCache(void)
+{
+    // Left, top, right, and bottom edges, covering the canvas, inside it, and past it
+    static const int16_t bounds[][4] = {
+        {0, 0, TEST_CANVAS_W, TEST_CANVAS_H},
+        {10, 8, 80, 60},
+        {-10, -10, TEST_CANVAS_W + 10, TEST_CANVAS_H + 10},
+    };
+
+    font_t font;
+    font_t cachedFont;
+    TEST_ASSERT(loadFont(IBM_VGA_8_FONT, &font, false));
+    TEST_ASSERT(loadFont(IBM_VGA_8_FONT, &cachedFont, false));
+    TEST_ASSERT(cacheFontGlyphs(&cachedFont, false));
+    TEST_ASSERT(NULL == font.chars['@' - ' '].spans);
+    TEST_ASSERT(NULL != cachedFont.chars['@' - ' '].spans);
+
+    // All the rows, one missing, half, one, and none
+    const int heights[] = {font.height, font.height - 1, font.height / 2, 1, 0};
+
+    wsg_t expected;
+    wsg_t actual;
+    canvasBlankInit(&expected, TEST_CANVAS_W, TEST_CANVAS_H, TEST_BG_COLOR, false);
+    canvasBlankInit(&actual, TEST_CANVAS_W, TEST_CANVAS_H, TEST_BG_COLOR, false);
+
+    bool matched = true;
+    for (int32_t bIdx = 0; bIdx < (int32_t)(sizeof(bounds) / sizeof(bounds[0])); bIdx++)
+    {
+        // Crossing each edge and corner of the bounds, fully inside them, and fully outside them
+        const int16_t* b           = bounds[bIdx];
+        const int16_t offsets[][2] = {
+            {b[0] - 5, b[1] + 2}, {b[0] + 2, b[1] - 5}, {b[2] - 20, b[1] + 2}, {b[0] + 2, b[3] - 5},
+            {b[0] - 3, b[1] - 3}, {b[2] - 6, b[3] - 6}, {b[0] + 4, b[1] + 4}, {b[2] + 2, b[3] + 2},
+        };
+
+        for (int32_t oIdx = 0; oIdx < (int32_t)(sizeof(offsets) / sizeof(offsets[0])); oIdx++)
+        {
+            for (glyphDraw_t draw = 0; draw < GLYPH_NUM_DRAWS; draw++)
+            {
+                for (int32_t hIdx = 0; hIdx < (int32_t)(sizeof(heights) / sizeof(heights[0])); hIdx++)
+                {
+                    // Only characters are drawn with fewer rows
+                    if (hIdx && draw != GLYPH_CHAR_BOUNDS && draw != GLYPH_SHINY_CHAR_BOUNDS)
+                    {
+                        break;
+                    }
+
+                    int16_t xOff = offsets[oIdx][0];
+                    int16_t yOff = offsets[oIdx][1];
+                    drawGlyphs(&expected, &font, draw, xOff, yOff, b, heights[hIdx]);
+                    drawGlyphs(&actual, &cachedFont, draw, xOff, yOff, b, heights[hIdx]);
+                    if (0 != memcmp(expected.px, actual.px, TEST_CANVAS_W * TEST_CANVAS_H))
+                    {
+                        printf("    Draw %d of %d rows at (%d, %d) in (%d, %d) to (%d, %d) drew differently\n",
+                               (int)draw, heights[hIdx], xOff, yOff, b[0], b[1], b[2], b[3]);
+                        matched = false;
+                    }
+                }
+            }
+        }
+    }
+
+    // Freeing the cache goes back to drawing from the bitmaps
+    freeFontGlyphCache(&cachedFont);
+    bool freed = (NULL == cachedFont.spanCache) && (NULL == cachedFont.chars['@' - ' '].spans);
+
+    freeWsg(&expected);
+    freeWsg(&actual);
+    freeFont(&font);
+    freeFont(&cachedFont);
+
+    TEST_ASSERT(freed);
+    return matched;
+}
+
+
+/**
+ * @brief Draw word wrapped text the first time, which wraps it while drawing, and again from its cached layout, and
+ * check that both draw the same pixels. Then draw more distinct strings than the cache holds, like text which changes
+ * every frame, between draws of text which doesn't change, and check that the text which doesn't change still matches
+ *
+ * @return true if the cached layouts always drew the same as wrapping while drawing
+ */
+bool testFontLayoutCache(void)
+{
+    // Newlines, long words, runs of spaces, and text which doesn't fit in the height
+    static const char* const texts[] = {
+        "The quick brown fox jumps over the lazy dog",
+        "Line one\nLine two\n\nLine four after a blank line",
+        "Supercalifragilisticexpialidocious antidisestablishmentarianism",
+        "   leading spaces   and   runs   of   spaces   ",
+        "trailing newline\n",
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore "
+        "magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo",
+        "",
+    };
+
+    // Left edge, starting X, starting Y, right edge, and bottom edge
+    static const int16_t boxes[][5] = {
+        {0, 0, 0, TEST_CANVAS_W, TEST_CANVAS_H},
+        {4, 30, 2, 70, TEST_CANVAS_H},
+        {10, 10, -5, 50, 40},
+        {0, 0, 0, 20, TEST_CANVAS_H},
+        {8, 60, 20, 90, 60},
+    };
+
+    font_t font;
+    TEST_ASSERT(loadFont(IBM_VGA_8_FONT, &font, false));
+
+    wsg_t expected;
+    wsg_t actual;
+    canvasBlankInit(&expected, TEST_CANVAS_W, TEST_CANVAS_H, TEST_BG_COLOR, false);
+    canvasBlankInit(&actual, TEST_CANVAS_W, TEST_CANVAS_H, TEST_BG_COLOR, false);
+
+    bool matched = true;
+    for (int32_t tIdx = 0; tIdx < (int32_t)(sizeof(texts) / sizeof(texts[0])); tIdx++)
+    {
+        for (int32_t bIdx = 0; bIdx < (int32_t)(sizeof(boxes) / sizeof(boxes[0])); bIdx++)
+        {
+            for (int32_t centered = 0; centered < 2; centered++)
+            {
+                // The first draw wraps while drawing, and the second caches the layout and draws from it
+                clearTextLayoutCache(NULL);
+                const int16_t* box = boxes[bIdx];
+                matched &= drawMatches(&expected, &actual, &font, texts[tIdx], box[0], box[1], box[2], box[3], box[4],
+                                       centered);
+            }
+        }
+    }
+
+    // Draw text which doesn't change without its layout, to compare against once it's cached
+    wsg_t steadyCanvases[TEST_STEADY_COUNT];
+    const char* steadyRest[TEST_STEADY_COUNT];
+    int16_t steadyX[TEST_STEADY_COUNT];
+    int16_t steadyY[TEST_STEADY_COUNT];
+    for (int32_t sIdx = 0; sIdx < TEST_STEADY_COUNT; sIdx++)
+    {
+        canvasBlankInit(&steadyCanvases[sIdx], TEST_CANVAS_W, TEST_CANVAS_H, TEST_BG_COLOR, false);
+        clearTextLayoutCache(NULL);
+        steadyX[sIdx]    = 0;
+        steadyY[sIdx]    = 0;
+        steadyRest[sIdx] = drawWrapped(&steadyCanvases[sIdx], &font, texts[sIdx], 0, &steadyX[sIdx], &steadyY[sIdx],
+                                       70, TEST_CANVAS_H, false);
+    }
+
+    // Each frame, draw text which changes every frame once, then the text which doesn't change
+    clearTextLayoutCache(NULL);
+    char changing[32];
+    for (int32_t frame = 0; frame < TEST_CHURN_COUNT; frame++)
+    {
+        snprintf(changing, sizeof(changing), "Score %d of many points", (int)(frame * 7919));
+        int16_t xOff = 0, yOff = 0;
+        drawWrapped(&actual, &font, changing, 0, &xOff, &yOff, 60, TEST_CANVAS_H, false);
+
+        int32_t sIdx     = frame % TEST_STEADY_COUNT;
+        xOff             = 0;
+        yOff             = 0;
+        const char* rest = drawWrapped(&actual, &font, texts[sIdx], 0, &xOff, &yOff, 70, TEST_CANVAS_H, false);
+        if (rest != steadyRest[sIdx] || xOff != steadyX[sIdx] || yOff != steadyY[sIdx]
+            || 0 != memcmp(steadyCanvases[sIdx].px, actual.px, TEST_CANVAS_W * TEST_CANVAS_H))
+        {
+            printf("    \"%.16s\" drew differently between changing text on frame %d\n", texts[sIdx], (int)frame);
+            matched = false;
+        }
+    }
+    for (int32_t sIdx = 0; sIdx < TEST_STEADY_COUNT; sIdx++)
+    {
+        freeWsg(&steadyCanvases[sIdx]);
+    }
+
+    // Measuring with the cache must match measuring without it
+    clearTextLayoutCache(NULL);
+    uint16_t uncachedHeight = textWordWrapHeight(&font, texts[5], 70, TEST_CANVAS_H);
+    uint16_t cachedHeight   = textWordWrapHeight(&font, texts[5], 70, TEST_CANVAS_H);
+    uint8_t lineHeight      = font.height;
+    clearTextLayoutCache(NULL);
+
+    freeWsg(&expected);
+    freeWsg(&actual);
+    freeFont(&font);
+
+    TEST_ASSERT(uncachedHeight == cachedHeight);
+    TEST_ASSERT(uncachedHeight > lineHeight);
+    return matched;
+}
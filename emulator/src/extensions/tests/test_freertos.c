@@ -0,0 +1,109 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdatomic.h>
+
+#include "os_generic.h"
+
+#include "ext_tests.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// How many items the sending task pushes through the queue
+#define NUM_QUEUE_ITEMS 64
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void queueSenderTask(void* arg);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// Set by the sending task once it's done with the queue
+static atomic_bool senderDone;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Send NUM_QUEUE_ITEMS sequential integers to a queue, blocking whenever it's full
+ *
+ * @param arg The queue to send to
+ */
+static void queueSenderTask(void* arg)
+{
+    QueueHandle_t queue = arg;
+    for (int32_t i = 0; i < NUM_QUEUE_ITEMS; i++)
+    {
+        xQueueSend(queue, &i, portMAX_DELAY);
+    }
+    atomic_store(&senderDone, true);
+    vTaskDelete(NULL);
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that the emulated FreeRTOS queues time out when they should, and block without losing or reordering
+ * items when another task is sending
+ *
+ * @return true if the queue behaved
+ */
+bool testQueueBlocking(void)
+{
+    QueueHandle_t queue = xQueueCreate(2, sizeof(int32_t));
+    TEST_ASSERT(NULL != queue);
+
+    // An empty queue times out, immediately or after roughly the requested time
+    int32_t item;
+    TEST_ASSERT(pdFALSE == xQueueReceive(queue, &item, 0));
+    double tStart = OGGetAbsoluteTime();
+    TEST_ASSERT(pdFALSE == xQueueReceive(queue, &item, pdMS_TO_TICKS(50)));
+    TEST_ASSERT(OGGetAbsoluteTime() - tStart >= 0.04);
+
+    // A full queue times out too
+    item = 0;
+    TEST_ASSERT(pdTRUE == xQueueSend(queue, &item, 0));
+    TEST_ASSERT(pdTRUE == xQueueSend(queue, &item, 0));
+    TEST_ASSERT(pdFALSE == xQueueSend(queue, &item, pdMS_TO_TICKS(10)));
+    TEST_ASSERT(2 == uxQueueMessagesWaiting(queue));
+    TEST_ASSERT(pdTRUE == xQueueReceive(queue, &item, 0));
+    TEST_ASSERT(pdTRUE == xQueueReceive(queue, &item, 0));
+
+    // Items sent from another task, which blocks on the small queue, all arrive in order
+    atomic_store(&senderDone, false);
+    TaskHandle_t sender = NULL;
+    TEST_ASSERT(pdPASS == xTaskCreate(queueSenderTask, "queueSender", 2048, queue, 1, &sender));
+    bool inOrder = true;
+    for (int32_t i = 0; i < NUM_QUEUE_ITEMS; i++)
+    {
+        if (pdTRUE != xQueueReceive(queue, &item, pdMS_TO_TICKS(1000)) || item != i)
+        {
+            inOrder = false;
+            break;
+        }
+    }
+
+    // Don't delete the queue until the sender is done with it, draining anything left if the order was wrong
+    while (!atomic_load(&senderDone))
+    {
+        xQueueReceive(queue, &item, pdMS_TO_TICKS(10));
+    }
+    OGJoinThread(sender);
+    vQueueDelete(queue);
+
+    TEST_ASSERT(inOrder);
+    return true;
+}
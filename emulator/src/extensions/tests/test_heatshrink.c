@@ -0,0 +1,139 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "cnfs.h"
+#include "esp_heap_caps.h"
+#include "heatshrink_helper.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The size of the data compressed by the round trip check
+#define TEST_PLAIN_SIZE 512
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool checkHeader(const uint8_t* src, uint32_t srcSize, uint32_t expSize, bool expStored, uint8_t expWindow,
+                        uint8_t expLookahead);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Parse a header and check every field it reports
+ *
+ * @param src The data, starting with the header
+ * @param srcSize The size of the data
+ * @param expSize The expected decompressed size
+ * @param expStored The expected stored flag
+ * @param expWindow The expected window size, as a power of two
+ * @param expLookahead The expected lookahead size, as a power of two
+ * @return true if the header parsed and every field matched
+ */
+static bool checkHeader(const uint8_t* src, uint32_t srcSize, uint32_t expSize, bool expStored, uint8_t expWindow,
+                        uint8_t expLookahead)
+{
+    uint32_t size = 0;
+    bool stored   = !expStored;
+    uint8_t window = 0, lookahead = 0;
+    TEST_ASSERT(heatshrinkParseHeader(src, srcSize, &size, &stored, &window, &lookahead));
+    TEST_ASSERT(expSize == size);
+    TEST_ASSERT(expStored == stored);
+    TEST_ASSERT(expWindow == window);
+    TEST_ASSERT(expLookahead == lookahead);
+    return true;
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that heatshrink headers are parsed for default, stored, and custom profiles, that invalid headers are
+ * rejected, and that data with each kind of header decompresses correctly
+ *
+ * @return true if every header was handled correctly
+ */
+bool testHeatshrinkHeader(void)
+{
+    // The default profile, the size is big-endian
+    static const uint8_t defHdr[] = {HEATSHRINK_HEADER_DEFAULT, 0x01, 0x02, 0x03};
+    TEST_ASSERT(checkHeader(defHdr, sizeof(defHdr), 0x010203, false, HEATSHRINK_DEFAULT_WINDOW_BITS,
+                            HEATSHRINK_DEFAULT_LOOKAHEAD_BITS));
+
+    // A custom profile, window in the high nibble and lookahead in the low nibble
+    static const uint8_t customHdr[] = {0xA4, 0x00, 0x10, 0x00};
+    TEST_ASSERT(checkHeader(customHdr, sizeof(customHdr), 0x1000, false, 10, 4));
+
+    // Stored data, which must all be present
+    static const uint8_t storedData[] = {HEATSHRINK_HEADER_STORED, 0x00, 0x00, 0x05, 'h', 'e', 'l', 'l', 'o'};
+    TEST_ASSERT(checkHeader(storedData, sizeof(storedData), 5, true, HEATSHRINK_DEFAULT_WINDOW_BITS,
+                            HEATSHRINK_DEFAULT_LOOKAHEAD_BITS));
+    TEST_ASSERT(!heatshrinkParseHeader(storedData, sizeof(storedData) - 1, NULL, NULL, NULL, NULL));
+
+    // Invalid headers
+    static const uint8_t smallWindow[]   = {0x34, 0x00, 0x00, 0x01};
+    static const uint8_t bigLookahead[]  = {0x88, 0x00, 0x00, 0x01};
+    static const uint8_t tinyLookahead[] = {0x82, 0x00, 0x00, 0x01};
+    TEST_ASSERT(!heatshrinkParseHeader(smallWindow, sizeof(smallWindow), NULL, NULL, NULL, NULL));
+    TEST_ASSERT(!heatshrinkParseHeader(bigLookahead, sizeof(bigLookahead), NULL, NULL, NULL, NULL));
+    TEST_ASSERT(!heatshrinkParseHeader(tinyLookahead, sizeof(tinyLookahead), NULL, NULL, NULL, NULL));
+    TEST_ASSERT(!heatshrinkParseHeader(defHdr, sizeof(defHdr) - 1, NULL, NULL, NULL, NULL));
+    TEST_ASSERT(!heatshrinkParseHeader(NULL, 0, NULL, NULL, NULL, NULL));
+
+    // Stored data is copied out as-is
+    uint8_t out[TEST_PLAIN_SIZE];
+    uint32_t outSize = 0;
+    TEST_ASSERT(heatshrinkDecompress(out, &outSize, storedData, sizeof(storedData)));
+    TEST_ASSERT(5 == outSize);
+    TEST_ASSERT(0 == memcmp(out, "hello", 5));
+
+    // Data compressed at runtime uses the default profile, and round trips
+    uint8_t plain[TEST_PLAIN_SIZE];
+    uint8_t packed[TEST_PLAIN_SIZE];
+    for (int i = 0; i < TEST_PLAIN_SIZE; i++)
+    {
+        plain[i] = (uint8_t)((i / 8) % 5);
+    }
+    uint32_t packedSize = heatshrinkCompress(packed, plain, TEST_PLAIN_SIZE);
+    TEST_ASSERT(packedSize > 4 && packedSize < TEST_PLAIN_SIZE);
+    TEST_ASSERT(checkHeader(packed, packedSize, TEST_PLAIN_SIZE, false, HEATSHRINK_DEFAULT_WINDOW_BITS,
+                            HEATSHRINK_DEFAULT_LOOKAHEAD_BITS));
+    TEST_ASSERT(heatshrinkDecompress(out, &outSize, packed, packedSize));
+    TEST_ASSERT(TEST_PLAIN_SIZE == outSize);
+    TEST_ASSERT(0 == memcmp(out, plain, TEST_PLAIN_SIZE));
+
+    // MIDI assets use the profile from assets.conf
+    size_t rawSize;
+    const uint8_t* raw = cnfsGetFile(MAXIMUM_HYPE_CREDITS_MID, &rawSize);
+    TEST_ASSERT(NULL != raw);
+    uint32_t midiSize = 0;
+    TEST_ASSERT(checkHeader(raw, (uint32_t)rawSize, ((uint32_t)raw[1] << 16) | (raw[2] << 8) | raw[3], false, 10, 4));
+    TEST_ASSERT(heatshrinkDecompress(NULL, &midiSize, raw, (uint32_t)rawSize));
+
+    // A decoder with the default profile is replaced by one which matches the file
+    uint8_t* midi      = heap_caps_malloc(midiSize, MALLOC_CAP_8BIT);
+    uint8_t* midiAgain = heap_caps_malloc(midiSize, MALLOC_CAP_8BIT);
+    heatshrink_decoder* hsd
+        = heatshrink_decoder_alloc(256, HEATSHRINK_DEFAULT_WINDOW_BITS, HEATSHRINK_DEFAULT_LOOKAHEAD_BITS);
+    uint32_t readSize = 0;
+    bool readOk       = (midi == readHeatshrinkFileInplace(MAXIMUM_HYPE_CREDITS_MID, &readSize, midi, hsd));
+    heatshrink_decoder_free(hsd);
+    bool decompressOk = heatshrinkDecompress(midiAgain, &outSize, raw, (uint32_t)rawSize);
+    bool matches      = (0 == memcmp(midi, midiAgain, midiSize)) && (0 == memcmp(midi, "MThd", 4));
+    heap_caps_free(midi);
+    heap_caps_free(midiAgain);
+
+    TEST_ASSERT(readOk && midiSize == readSize);
+    TEST_ASSERT(decompressOk && midiSize == outSize);
+    TEST_ASSERT(matches);
+    return true;
+}
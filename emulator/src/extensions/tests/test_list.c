@@ -0,0 +1,118 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stdint.h>
+
+#include "ext_tests.h"
+#include "esp_heap_caps.h"
+#include "linked_list.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// Nodes in each slab of the test pool, small so the test spans several slabs
+#define TEST_SLAB_NODES 4
+
+/// Values pushed onto the test list
+#define TEST_NUM_VALS 10
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that lists allocate nodes from their pool's slabs, reuse freed nodes, return nodes to the pool they came
+ * from, and that trimming frees only empty slabs
+ *
+ * @return true if the pool allocated and freed nodes correctly
+ */
+bool testListPool(void)
+{
+    listPool_t pool = {0};
+    TEST_ASSERT(!initListPool(&pool, 0, MALLOC_CAP_8BIT));
+    TEST_ASSERT(initListPool(&pool, TEST_SLAB_NODES, MALLOC_CAP_8BIT));
+
+    listPoolStats_t stats;
+    list_t list = {.pool = &pool};
+
+    // Nodes are allocated in whole slabs
+    for (intptr_t val = 0; val < TEST_NUM_VALS; val++)
+    {
+        push(&list, (void*)val);
+    }
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(TEST_NUM_VALS == list.length);
+    TEST_ASSERT(3 == stats.slabs);
+    TEST_ASSERT(3 * TEST_SLAB_NODES == stats.capacity);
+    TEST_ASSERT(TEST_NUM_VALS == stats.inUse);
+    TEST_ASSERT(TEST_NUM_VALS == stats.allocs);
+    TEST_ASSERT(0 == stats.heapAllocs);
+
+    // The list is intact
+    intptr_t expected = 0;
+    for (node_t* node = list.first; NULL != node; node = node->next)
+    {
+        TEST_ASSERT(expected++ == (intptr_t)node->val);
+    }
+    TEST_ASSERT(TEST_NUM_VALS == expected);
+
+    // A freed node is reused without allocating another slab
+    TEST_ASSERT(5 == (intptr_t)removeIdx(&list, 5));
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(TEST_NUM_VALS - 1 == stats.inUse);
+    TEST_ASSERT(1 == stats.frees);
+    TEST_ASSERT(addIdx(&list, (void*)5, 5));
+    unshift(&list, (void*)-1);
+    TEST_ASSERT(-1 == (intptr_t)shift(&list));
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(3 == stats.slabAllocs);
+    TEST_ASSERT(TEST_NUM_VALS == stats.inUse);
+    TEST_ASSERT(TEST_NUM_VALS + 1 == stats.peakInUse);
+
+    // Trimming keeps slabs with nodes in use
+    trimListPool(&pool);
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(3 == stats.slabs);
+
+    // Nodes added from another pool go back to that pool, not this one
+    listPool_t* defaultPool = getDefaultListPool();
+    listPoolStats_t defaultStats = {0};
+    if (NULL != defaultPool)
+    {
+        getListPoolStats(defaultPool, &defaultStats);
+    }
+    list_t moved = {0};
+    push(&moved, (void*)1);
+    push(&moved, (void*)2);
+    moved.pool = &pool;
+    clear(&moved);
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(TEST_NUM_VALS == stats.inUse);
+    if (NULL != defaultPool)
+    {
+        listPoolStats_t after;
+        getListPoolStats(defaultPool, &after);
+        TEST_ASSERT(defaultStats.inUse == after.inUse);
+    }
+
+    // Once everything is freed, trimming frees every slab
+    clear(&list);
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(0 == stats.inUse);
+    TEST_ASSERT(TEST_NUM_VALS + 2 == stats.frees);
+    trimListPool(&pool);
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(0 == stats.slabs);
+    TEST_ASSERT(0 == stats.capacity);
+
+    // The pool still works after trimming
+    push(&list, (void*)7);
+    getListPoolStats(&pool, &stats);
+    TEST_ASSERT(1 == stats.slabs);
+    TEST_ASSERT(7 == (intptr_t)pop(&list));
+
+    deinitListPool(&pool);
+    return true;
+}
@@ -0,0 +1,230 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "emu_main.h"
+#include "midiFileParser.h"
+#include "midiPlayer.h"
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief Some of the playback state which a checkpoint must restore
+typedef struct
+{
+    uint32_t tempo;      ///< The latest tempo, or UINT32_MAX if there was none
+    uint8_t program[16]; ///< The latest program on each channel, or 0xFF if there was none
+} midiTestState_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void trackTestState(const midiEvent_t* event, void* arg);
+static bool eventsMatch(const midiEvent_t* a, const midiEvent_t* b);
+static void countTextCb(metaEventType_t type, const char* text, uint32_t length);
+static void countSongEndCb(void);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The number of text events and song ends seen during playback
+static int textCount;
+static int songEndCount;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Track the tempo and program changes in a stream of events
+ *
+ * @param event The event to track
+ * @param arg The ::midiTestState_t to update
+ */
+static void trackTestState(const midiEvent_t* event, void* arg)
+{
+    midiTestState_t* state = arg;
+    if (META_EVENT == event->type && TEMPO == event->meta.type)
+    {
+        state->tempo = event->meta.tempo;
+    }
+    else if (MIDI_EVENT == event->type && 0xC0 == (event->midi.status & 0xF0))
+    {
+        state->program[event->midi.status & 0x0F] = event->midi.data[0];
+    }
+}
+
+/**
+ * @brief Check if two events read from the same file are the same event
+ *
+ * @param a One event
+ * @param b The other event
+ * @return true if the events match
+ */
+static bool eventsMatch(const midiEvent_t* a, const midiEvent_t* b)
+{
+    if (a->absTime != b->absTime || a->type != b->type || a->track != b->track)
+    {
+        return false;
+    }
+    else if (MIDI_EVENT == a->type)
+    {
+        return a->midi.status == b->midi.status && a->midi.data[0] == b->midi.data[0]
+               && a->midi.data[1] == b->midi.data[1];
+    }
+    else if (META_EVENT == a->type)
+    {
+        return a->meta.type == b->meta.type && a->meta.length == b->meta.length;
+    }
+    return a->sysex.length == b->sysex.length;
+}
+
+/**
+ * @brief Count a text event from the MIDI player
+ */
+static void countTextCb(metaEventType_t type, const char* text, uint32_t length)
+{
+    textCount++;
+}
+
+/**
+ * @brief Count a song end from the MIDI player
+ */
+static void countSongEndCb(void)
+{
+    songEndCount++;
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that an indexed MIDI file reads the same events as the unindexed file, and that seeking to a checkpoint
+ * restores the tempo and programs in effect there
+ *
+ * @return true if the index matched the file
+ */
+bool testMidiIndex(void)
+{
+    midiFile_t plain   = {0};
+    midiFile_t indexed = {0};
+    TEST_ASSERT(loadMidiFile(MAXIMUM_HYPE_CREDITS_MID, &plain, true));
+    TEST_ASSERT(loadMidiFile(MAXIMUM_HYPE_CREDITS_MID, &indexed, true));
+    TEST_ASSERT(indexMidiFile(&indexed, true));
+
+    midiFileReader_t plainReader   = {0};
+    midiFileReader_t indexedReader = {0};
+    TEST_ASSERT(initMidiParser(&plainReader, &plain));
+    TEST_ASSERT(initMidiParser(&indexedReader, &indexed));
+    plainReader.handleMetaEvents   = true;
+    indexedReader.handleMetaEvents = true;
+
+    // Read both in lockstep
+    midiEvent_t plainEvent;
+    midiEvent_t indexedEvent;
+    uint32_t eventCount = 0;
+    bool match          = true;
+    while (midiNextEvent(&plainReader, &plainEvent))
+    {
+        if (!midiNextEvent(&indexedReader, &indexedEvent) || !eventsMatch(&plainEvent, &indexedEvent))
+        {
+            match = false;
+            break;
+        }
+        eventCount++;
+    }
+    match = match && !midiNextEvent(&indexedReader, &indexedEvent);
+
+    // Seek most of the way into the song
+    uint32_t seekTick = 0;
+    resetMidiParser(&plainReader);
+    for (uint32_t i = 0; i < eventCount * 3 / 4 && midiNextEvent(&plainReader, &plainEvent); i++)
+    {
+        seekTick = plainEvent.absTime;
+    }
+    uint32_t checkpointIdx = midiFindCheckpoint(&indexed, seekTick);
+
+    midiTestState_t seekState = {.tempo = UINT32_MAX};
+    memset(seekState.program, 0xFF, sizeof(seekState.program));
+    resetMidiParser(&indexedReader);
+    bool seeked = midiSeekCheckpoint(&indexedReader, seekTick, trackTestState, &seekState);
+
+    // Read the plain file up to the checkpoint to find the state there
+    midiTestState_t plainState = {.tempo = UINT32_MAX};
+    memset(plainState.program, 0xFF, sizeof(plainState.program));
+    resetMidiParser(&plainReader);
+    for (uint32_t i = 0; i < checkpointIdx && midiNextEvent(&plainReader, &plainEvent); i++)
+    {
+        trackTestState(&plainEvent, &plainState);
+    }
+    bool resumed = midiNextEvent(&plainReader, &plainEvent) && midiNextEvent(&indexedReader, &indexedEvent)
+                   && eventsMatch(&plainEvent, &indexedEvent);
+
+    deinitMidiParser(&plainReader);
+    deinitMidiParser(&indexedReader);
+    unloadMidiFile(&plain);
+    unloadMidiFile(&indexed);
+
+    TEST_ASSERT(eventCount > MIDI_INDEX_CHECKPOINT_INTERVAL);
+    TEST_ASSERT(match);
+    TEST_ASSERT(checkpointIdx > 0);
+    TEST_ASSERT(seeked);
+    TEST_ASSERT(resumed);
+    TEST_ASSERT(seekState.tempo == plainState.tempo);
+    TEST_ASSERT(0 == memcmp(seekState.program, plainState.program, sizeof(plainState.program)));
+    return true;
+}
+
+/**
+ * @brief Check that when the emulator renders sound without a sound driver, like when fast-forwarding, songs still
+ * deliver their text events and end
+ *
+ * @return true if the callbacks were called
+ */
+bool testMidiDiscardedSoundCallbacks(void)
+{
+    midiFile_t song = {0};
+    TEST_ASSERT(loadMidiFile(MAXIMUM_HYPE_CREDITS_TEASER_MID, &song, true));
+
+    // Count how many text events the song has
+    midiFileReader_t reader = {0};
+    TEST_ASSERT(initMidiParser(&reader, &song));
+    reader.handleMetaEvents = true;
+    int songTextCount       = 0;
+    midiEvent_t event;
+    while (midiNextEvent(&reader, &event))
+    {
+        if (META_EVENT == event.type && event.meta.type >= TEXT && event.meta.type <= CUE_POINT)
+        {
+            songTextCount++;
+        }
+    }
+    deinitMidiParser(&reader);
+
+    // Play it without a sound driver, a tenth of a second at a time, for up to five minutes
+    textCount    = 0;
+    songEndCount = 0;
+    globalMidiPlayerPlaySongCb(&song, MIDI_BGM, countSongEndCb);
+    midiPlayer_t* player        = globalMidiPlayerGet(MIDI_BGM);
+    player->loop                = false;
+    player->textMessageCallback = countTextCb;
+    for (int i = 0; i < 3000 && 0 == songEndCount; i++)
+    {
+        emulatorDiscardSound(100000);
+    }
+    player->textMessageCallback = NULL;
+    globalMidiPlayerStop(true);
+    unloadMidiFile(&song);
+
+    TEST_ASSERT(songTextCount > 0);
+    TEST_ASSERT(songTextCount == textCount);
+    TEST_ASSERT(1 == songEndCount);
+    return true;
+}
@@ -0,0 +1,216 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "hdw-esp-now.h"
+#include "p2pConnection.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The mode ID used by both ends of the test connection
+#define TEST_MODE_ID 'T'
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void testEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, uint8_t len, int8_t rssi);
+static void testEspNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status);
+static void testWinRxCb(p2pInfo* p2p, const uint8_t* payload, uint16_t len);
+static void testWinTxCb(p2pInfo* p2p, messageStatus_t status, const uint8_t* data, uint16_t len);
+static void recvFromPeer(p2pMsgType_t type, uint8_t seqNum, const uint8_t* data, uint8_t dataLen);
+static void connectToPeer(void);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The connection under test
+static p2pInfo testP2p;
+/// The MAC of the simulated other Swadge
+static const uint8_t peerMac[6] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+/// The number of windowed messages received, and the last one
+static int rxCount;
+static uint16_t rxLen;
+static uint8_t rxMsg[P2P_MAX_MSG_LEN];
+
+/// The number of windowed messages ACKed and failed, and the length of the last one
+static int txAcked;
+static int txFailed;
+static uint16_t txLen;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Ignore packets received from the socket, the test delivers the peer's packets itself
+ */
+static void testEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, uint8_t len, int8_t rssi)
+{
+}
+
+/**
+ * @brief Pass transmission statuses to the connection under test
+ *
+ * @param mac_addr The MAC the packet was sent to
+ * @param status Whether the packet was sent
+ */
+static void testEspNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status)
+{
+    p2pSendCb(&testP2p, mac_addr, status);
+}
+
+/**
+ * @brief Record a received windowed message
+ */
+static void testWinRxCb(p2pInfo* p2p, const uint8_t* payload, uint16_t len)
+{
+    rxCount++;
+    rxLen = len;
+    memcpy(rxMsg, payload, len);
+}
+
+/**
+ * @brief Record the status of a sent windowed message
+ */
+static void testWinTxCb(p2pInfo* p2p, messageStatus_t status, const uint8_t* data, uint16_t len)
+{
+    if (MSG_ACKED == status)
+    {
+        txAcked++;
+    }
+    else
+    {
+        txFailed++;
+    }
+    txLen = len;
+}
+
+/**
+ * @brief Deliver a packet from the simulated other Swadge to the connection under test
+ *
+ * @param type The message type
+ * @param seqNum The sequence number
+ * @param data The data after the header, may be NULL if dataLen is 0
+ * @param dataLen The length of the data after the header
+ */
+static void recvFromPeer(p2pMsgType_t type, uint8_t seqNum, const uint8_t* data, uint8_t dataLen)
+{
+    p2pDataMsg_t msg    = {0};
+    msg.hdr.startByte   = P2P_START_BYTE;
+    msg.hdr.modeId      = TEST_MODE_ID;
+    msg.hdr.messageType = type;
+    msg.hdr.seqNum      = seqNum;
+    memcpy(msg.hdr.macAddr, testP2p.cnc.myMac, sizeof(msg.hdr.macAddr));
+    if (dataLen > 0)
+    {
+        memcpy(msg.data, data, dataLen);
+    }
+    p2pRecvCb(&testP2p, peerMac, (const uint8_t*)&msg, sizeof(p2pCommonHeader_t) + dataLen, 0);
+}
+
+/**
+ * @brief Run the connection handshake with the simulated other Swadge
+ */
+static void connectToPeer(void)
+{
+    p2pStartConnection(&testP2p);
+
+    // The peer broadcasts, then ACKs the start message sent in response, then sends its own start message
+    p2pConMsg_t conMsg = {
+        .startByte   = P2P_START_BYTE,
+        .modeId      = TEST_MODE_ID,
+        .messageType = P2P_MSG_CONNECT,
+    };
+    p2pRecvCb(&testP2p, peerMac, (const uint8_t*)&conMsg, sizeof(conMsg), 0);
+    recvFromPeer(P2P_MSG_ACK, 100, NULL, 0);
+    recvFromPeer(P2P_MSG_START, 101, NULL, 0);
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that windowed p2p messages are fragmented, reassembled out of order, and ACKed, and that a restart
+ * reports queued messages as failed from p2pPollWindows() and starts the window over for the next connection
+ *
+ * @return true if the window behaved
+ */
+bool testP2pWindow(void)
+{
+    rxCount  = 0;
+    txAcked  = 0;
+    txFailed = 0;
+
+    TEST_ASSERT(ESP_OK
+                == initEspNow(testEspNowRecvCb, testEspNowSendCb, GPIO_NUM_NC, GPIO_NUM_NC, UART_NUM_MAX,
+                              ESP_NOW_IMMEDIATE));
+    p2pInitialize(&testP2p, TEST_MODE_ID, NULL, NULL, -70);
+    bool enabled = p2pEnableWindow(&testP2p, testWinRxCb);
+    connectToPeer();
+    bool connected = testP2p.cnc.isConnected;
+
+    // A three packet message is ACKed by one cumulative ACK for all of its packets
+    uint8_t msg[600];
+    for (int i = 0; i < sizeof(msg); i++)
+    {
+        msg[i] = i * 7;
+    }
+    bool sent         = p2pSendWinMsg(&testP2p, msg, sizeof(msg), testWinTxCb);
+    uint8_t noneLater = 0;
+    recvFromPeer(P2P_MSG_WIN_ACK, 3, &noneLater, 1);
+    int ackedFirst = txAcked;
+    uint16_t acked = txLen;
+
+    // A two packet message is reassembled even if its packets arrive out of order
+    uint8_t frag[P2P_MAX_DATA_LEN];
+    frag[0] = 0;
+    memcpy(&frag[1], &msg[P2P_MAX_DATA_LEN - 1], 300 - (P2P_MAX_DATA_LEN - 1));
+    recvFromPeer(P2P_MSG_WIN_DATA, 1, frag, 1 + 300 - (P2P_MAX_DATA_LEN - 1));
+    int rxEarly = rxCount;
+    frag[0]     = 1;
+    memcpy(&frag[1], msg, P2P_MAX_DATA_LEN - 1);
+    recvFromPeer(P2P_MSG_WIN_DATA, 0, frag, P2P_MAX_DATA_LEN);
+    bool reassembled = (1 == rxCount && 300 == rxLen && 0 == memcmp(rxMsg, msg, 300));
+
+    // Restarting fails the queued message from the main loop, since it may be called from a timer, and starts the window
+    // over for the next connection
+    p2pSendWinMsg(&testP2p, msg, 10, testWinTxCb);
+    p2pRestart(&testP2p);
+    int failedBeforePoll = txFailed;
+    p2pPollWindows();
+    int failed = txFailed;
+    connectToPeer();
+    bool reconnected = testP2p.cnc.isConnected;
+
+    // Both directions count from zero again
+    bool resent = p2pSendWinMsg(&testP2p, msg, 10, testWinTxCb);
+    recvFromPeer(P2P_MSG_WIN_ACK, 1, &noneLater, 1);
+    frag[0] = 0;
+    recvFromPeer(P2P_MSG_WIN_DATA, 0, frag, 11);
+
+    p2pDeinit(&testP2p, true);
+    deinitEspNow();
+
+    TEST_ASSERT(enabled);
+    TEST_ASSERT(connected);
+    TEST_ASSERT(sent);
+    TEST_ASSERT(1 == ackedFirst && sizeof(msg) == acked);
+    TEST_ASSERT(0 == rxEarly);
+    TEST_ASSERT(reassembled);
+    TEST_ASSERT(0 == failedBeforePoll);
+    TEST_ASSERT(1 == failed);
+    TEST_ASSERT(reconnected);
+    TEST_ASSERT(resent);
+    TEST_ASSERT(2 == txAcked);
+    TEST_ASSERT(2 == rxCount && 10 == rxLen);
+    return true;
+}
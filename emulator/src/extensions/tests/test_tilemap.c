@@ -0,0 +1,155 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "fs_wsg.h"
+#include "renderTarget.h"
+#include "tilemap.h"
+#include "wsgCanvas.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The size of each tile in the test atlas
+#define TEST_TILE_SIZE 8
+
+/// The width of the test layers, in tiles
+#define TEST_LAYER_W 13
+/// The height of the test layers, in tiles
+#define TEST_LAYER_H 9
+
+/// The width of the test view, which isn't a whole number of tiles
+#define TEST_VIEW_W 44
+/// The height of the test view, which isn't a whole number of tiles
+#define TEST_VIEW_H 30
+
+/// The color the cache draws behind transparent pixels
+#define TEST_BG_COLOR c012
+
+/// The color the cached canvas is cleared to, which must be drawn over entirely
+#define TEST_CLEAR_COLOR c543
+
+/// The tile which is animated
+#define TEST_ANIM_TILE 5
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool initTestLayer(tilemapLayer_t* layer, tileAtlas_t* atlas);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Create a wrapping, half-speed test layer with every kind of tile, including empty tiles and tiles past the
+ * end of the atlas
+ *
+ * @param layer The layer to create
+ * @param atlas The atlas for the layer
+ * @return true if the layer was created
+ */
+static bool initTestLayer(tilemapLayer_t* layer, tileAtlas_t* atlas)
+{
+    if (!initTilemapLayer(layer, atlas, TEST_LAYER_W, TEST_LAYER_H, false))
+    {
+        return false;
+    }
+    for (int32_t y = 0; y < TEST_LAYER_H; y++)
+    {
+        for (int32_t x = 0; x < TEST_LAYER_W; x++)
+        {
+            setTilemapTile(layer, x, y, (x * 7 + y * 3) % (atlas->numTiles + 2));
+        }
+    }
+    setTilemapTile(layer, 2, 1, TEST_ANIM_TILE);
+    setTilemapTile(layer, 11, 6, TEST_ANIM_TILE);
+
+    layer->parallaxX = TILEMAP_PARALLAX_ONE / 2;
+    layer->offsetY   = 3;
+    layer->wrapX     = true;
+    return true;
+}
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Scroll a cached and an uncached copy of the same layer through small, diagonal, backwards, wrapping, and
+ * jumping camera moves, while tiles animate and change, and check that they draw the same pixels every frame
+ *
+ * @return true if the cached layer always matched
+ */
+bool testTilemapCacheScroll(void)
+{
+    // Camera positions, each drawn as one frame
+    static const int32_t path[][2] = {
+        {0, 0},     {1, 0},    {2, 1},     {9, 1},     {17, 4},   {16, 12},   {15, 11},  {-3, 11},  {-20, -6},
+        {-21, -14}, {40, -14}, {200, 20},  {201, 27},  {190, 27}, {190, -40}, {500, 3},  {513, 9},  {-700, 2},
+        {-699, 3},  {-680, 8}, {-660, 16}, {-640, 24}, {0, 0},    {7, 7},     {8, 8},    {-1, -1},
+    };
+
+    tileAtlas_t atlas;
+    TEST_ASSERT(loadTileAtlas(MARIO_WSG, &atlas, TEST_TILE_SIZE, TEST_TILE_SIZE, false));
+    TEST_ASSERT(atlas.numTiles > TEST_ANIM_TILE + 3);
+    TEST_ASSERT(addTileAnimation(&atlas, TEST_ANIM_TILE, 3, 1000));
+
+    tilemapLayer_t plain;
+    tilemapLayer_t cached;
+    TEST_ASSERT(initTestLayer(&plain, &atlas));
+    TEST_ASSERT(initTestLayer(&cached, &atlas));
+    TEST_ASSERT(enableTilemapLayerCache(&cached, TEST_VIEW_W, TEST_VIEW_H, TEST_BG_COLOR, false));
+
+    wsg_t plainCanvas;
+    wsg_t cachedCanvas;
+    canvasBlankInit(&plainCanvas, TEST_VIEW_W, TEST_VIEW_H, TEST_BG_COLOR, false);
+    canvasBlankInit(&cachedCanvas, TEST_VIEW_W, TEST_VIEW_H, TEST_CLEAR_COLOR, false);
+
+    bool matched = true;
+    for (int step = 0; step < (int)(sizeof(path) / sizeof(path[0])); step++)
+    {
+        // Animate every other frame, and change a tile partway through
+        if (step & 1)
+        {
+            updateTileAtlas(&atlas, 1000);
+        }
+        if (10 == step)
+        {
+            setTilemapTile(&plain, 0, 3, TEST_ANIM_TILE + 3);
+            setTilemapTile(&cached, 0, 3, TEST_ANIM_TILE + 3);
+        }
+
+        memset(plainCanvas.px, TEST_BG_COLOR, TEST_VIEW_W * TEST_VIEW_H);
+        memset(cachedCanvas.px, TEST_CLEAR_COLOR, TEST_VIEW_W * TEST_VIEW_H);
+
+        pushRenderTarget(&plainCanvas);
+        drawTilemapLayer(&plain, path[step][0], path[step][1]);
+        popRenderTarget();
+
+        pushRenderTarget(&cachedCanvas);
+        drawTilemapLayer(&cached, path[step][0], path[step][1]);
+        popRenderTarget();
+
+        if (0 != memcmp(plainCanvas.px, cachedCanvas.px, TEST_VIEW_W * TEST_VIEW_H))
+        {
+            printf("    Cached layer drew differently at (%d, %d)\n", (int)path[step][0], (int)path[step][1]);
+            matched = false;
+        }
+    }
+    bool cacheUsed = cached.cache->valid;
+
+    freeWsg(&plainCanvas);
+    freeWsg(&cachedCanvas);
+    freeTilemapLayer(&plain);
+    freeTilemapLayer(&cached);
+    freeTileAtlas(&atlas);
+
+    TEST_ASSERT(cacheUsed);
+    return matched;
+}
@@ -0,0 +1,286 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include "ext_tests.h"
+#include "hdw-tft.h"
+#include "fs_wsg.h"
+#include "heatshrink_helper.h"
+#include "renderTarget.h"
+#include "wsg.h"
+#include "wsgCanvas.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// A color which no test image uses, so undrawn pixels can be told apart from drawn ones
+#define BG_COLOR c123
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool isSpanEncodedFile(cnfsFileIdx_t fIdx);
+static uint32_t getSpanDataSize(const wsgSpans_t* spr);
+static bool checkSpansDrawMatch(const wsg_t* raw, const wsgSpans_t* spr);
+static bool checkSpansMatch(cnfsFileIdx_t fIdx);
+static void drawWsgRotatePixel(const wsg_t* wsg, wsg_t* canvas, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD,
+                               int32_t rotateDeg);
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+/**
+ * @brief Check that span-encoded WSGs load and draw the same as raw WSGs, both for assets which the
+ * assets_preprocessor span-encoded and for raw assets encoded at load time
+ *
+ * @return true if every image matched
+ */
+bool testWsgSpans(void)
+{
+    // Swadgesona layers are span-encoded by assets/Swadgesona/.opts, the others are raw
+    static const cnfsFileIdx_t spanFiles[] = {H_CURLY_WSG, HA_BIGMA_WSG, BM_BEARD_WSG};
+    static const cnfsFileIdx_t rawFiles[]  = {BATT_1_WSG, SWSN_HAIR_WSG, KID_0_WSG};
+
+    for (int i = 0; i < (int)(sizeof(spanFiles) / sizeof(spanFiles[0])); i++)
+    {
+        TEST_ASSERT(isSpanEncodedFile(spanFiles[i]));
+        TEST_ASSERT(checkSpansMatch(spanFiles[i]));
+    }
+
+    for (int i = 0; i < (int)(sizeof(rawFiles) / sizeof(rawFiles[0])); i++)
+    {
+        TEST_ASSERT(!isSpanEncodedFile(rawFiles[i]));
+        TEST_ASSERT(checkSpansMatch(rawFiles[i]));
+    }
+    return true;
+}
+
+/**
+ * @brief Check that quarter turns drawn by drawWsg(), which uses setupWsgAffine(), match the old rotatePixel() path
+ * for square and non-square WSGs with odd and even sides, every flip, and clipped positions
+ *
+ * @return true if every draw matched
+ */
+bool testWsgAffineQuarterTurns(void)
+{
+    const int32_t sizes[][2] = {{4, 4}, {5, 5}, {5, 3}, {3, 5}, {6, 3}, {3, 6}, {7, 2}, {2, 8}, {9, 4}, {1, 6}};
+    const int32_t offsets[][2] = {{8, 8}, {-2, 9}, {9, -3}, {17, 15}};
+    const int32_t cW = 24;
+    const int32_t cH = 24;
+
+    wsg_t oldCanvas;
+    wsg_t newCanvas;
+    canvasBlankInit(&oldCanvas, cW, cH, BG_COLOR, false);
+    canvasBlankInit(&newCanvas, cW, cH, BG_COLOR, false);
+
+    bool matched = true;
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+    {
+        // Every pixel is a different color, with a few transparent ones
+        wsg_t wsg;
+        canvasBlankInit(&wsg, sizes[s][0], sizes[s][1], cTransparent, false);
+        for (int32_t i = 0; i < wsg.w * wsg.h; i++)
+        {
+            wsg.px[i] = (3 == i % 7) ? cTransparent : (paletteColor_t)(i % 100);
+        }
+
+        for (int32_t rot = 0; rot < 360; rot += 90)
+        {
+            for (int flips = 0; flips < 4; flips++)
+            {
+                for (int o = 0; o < (int)(sizeof(offsets) / sizeof(offsets[0])); o++)
+                {
+                    memset(oldCanvas.px, BG_COLOR, cW * cH);
+                    memset(newCanvas.px, BG_COLOR, cW * cH);
+
+                    drawWsgRotatePixel(&wsg, &oldCanvas, offsets[o][0], offsets[o][1], flips & 1, flips & 2, rot);
+
+                    pushRenderTarget(&newCanvas);
+                    drawWsg(&wsg, offsets[o][0], offsets[o][1], flips & 1, flips & 2, rot);
+                    popRenderTarget();
+
+                    if (0 != memcmp(oldCanvas.px, newCanvas.px, cW * cH))
+                    {
+                        printf("    %dx%d WSG drew differently at %d degrees, flips %d, (%d, %d)\n", (int)wsg.w,
+                               (int)wsg.h, (int)rot, flips, (int)offsets[o][0], (int)offsets[o][1]);
+                        matched = false;
+                    }
+                }
+            }
+        }
+        freeWsg(&wsg);
+    }
+
+    freeWsg(&oldCanvas);
+    freeWsg(&newCanvas);
+    return matched;
+}
+
+/**
+ * @brief Check if the assets_preprocessor stored a WSG as spans
+ *
+ * @param fIdx The WSG file to check
+ * @return true if the file has ::WSG_SPAN_FLAG set in its header
+ */
+static bool isSpanEncodedFile(cnfsFileIdx_t fIdx)
+{
+    uint32_t size = 0;
+    uint8_t* buf  = readHeatshrinkFile(fIdx, &size, false);
+    if (NULL == buf)
+    {
+        return false;
+    }
+    bool isSpans = (size >= 4) && (buf[0] & (WSG_SPAN_FLAG >> 8));
+    heap_caps_free(buf);
+    return isSpans;
+}
+
+/**
+ * @brief Get the number of bytes of span data in a span-encoded WSG, by walking its last row
+ *
+ * @param spr The span-encoded WSG
+ * @return The number of bytes of span data
+ */
+static uint32_t getSpanDataSize(const wsgSpans_t* spr)
+{
+    uint32_t offset  = spr->rowOffsets[spr->h - 1];
+    uint16_t numRuns = (spr->spans[offset] << 8) | spr->spans[offset + 1];
+    offset += 2;
+    while (numRuns--)
+    {
+        offset += 4 + ((spr->spans[offset + 2] << 8) | spr->spans[offset + 3]);
+    }
+    return offset;
+}
+
+/**
+ * @brief Draw a WSG with drawWsgSimple() and its spans with drawWsgSpans() at a range of clipped and unclipped
+ * positions, and check that they drew the same pixels
+ *
+ * @param raw The WSG
+ * @param spr The WSG's spans
+ * @return true if every position matched
+ */
+static bool checkSpansDrawMatch(const wsg_t* raw, const wsgSpans_t* spr)
+{
+    int32_t cW = raw->w + 8;
+    int32_t cH = raw->h + 8;
+    wsg_t simpleCanvas;
+    wsg_t spanCanvas;
+    canvasBlankInit(&simpleCanvas, cW, cH, BG_COLOR, false);
+    canvasBlankInit(&spanCanvas, cW, cH, BG_COLOR, false);
+
+    // Positions which clip each edge, and one which doesn't clip
+    const int32_t offsets[][2] = {
+        {4, 4},    {-3, 4},   {12, 4}, {4, -5}, {4, 13}, {-raw->w / 2, -raw->h / 2}, {cW - 1, cH - 1},
+        {-raw->w + 1, 0},
+    };
+
+    bool matched = true;
+    for (int i = 0; i < (int)(sizeof(offsets) / sizeof(offsets[0])); i++)
+    {
+        memset(simpleCanvas.px, BG_COLOR, cW * cH);
+        memset(spanCanvas.px, BG_COLOR, cW * cH);
+
+        pushRenderTarget(&simpleCanvas);
+        drawWsgSimple(raw, offsets[i][0], offsets[i][1]);
+        popRenderTarget();
+
+        pushRenderTarget(&spanCanvas);
+        drawWsgSpans(spr, offsets[i][0], offsets[i][1]);
+        popRenderTarget();
+
+        if (0 != memcmp(simpleCanvas.px, spanCanvas.px, cW * cH))
+        {
+            printf("    Spans drew differently at (%d, %d)\n", (int)offsets[i][0], (int)offsets[i][1]);
+            matched = false;
+        }
+    }
+
+    freeWsg(&simpleCanvas);
+    freeWsg(&spanCanvas);
+    return matched;
+}
+
+/**
+ * @brief Load a WSG with both loadWsg() and loadWsgSpans(), then check that the spans match wsgToSpans() of the raw
+ * pixels and that they draw the same
+ *
+ * @param fIdx The WSG file to check
+ * @return true if everything matched
+ */
+static bool checkSpansMatch(cnfsFileIdx_t fIdx)
+{
+    wsg_t raw          = {0};
+    wsgSpans_t loaded  = {0};
+    wsgSpans_t encoded = {0};
+    bool matched       = false;
+
+    if (!loadWsg(fIdx, &raw, false) || !loadWsgSpans(fIdx, &loaded, false) || !wsgToSpans(&raw, &encoded, false))
+    {
+        printf("    Couldn't load file %d\n", fIdx);
+    }
+    else if (loaded.w != raw.w || loaded.h != raw.h || getSpanDataSize(&loaded) != getSpanDataSize(&encoded)
+             || 0 != memcmp(loaded.rowOffsets, encoded.rowOffsets, raw.h * sizeof(uint32_t))
+             || 0 != memcmp(loaded.spans, encoded.spans, getSpanDataSize(&encoded)))
+    {
+        // The spans loaded from the file must be the same as spans encoded from the pixels
+        printf("    File %d loaded different spans than it encoded\n", fIdx);
+    }
+    else if (!checkSpansDrawMatch(&raw, &loaded))
+    {
+        printf("    File %d drew differently with spans\n", fIdx);
+    }
+    else
+    {
+        matched = true;
+    }
+
+    freeWsg(&raw);
+    freeWsgSpans(&loaded);
+    freeWsgSpans(&encoded);
+    return matched;
+}
+
+/**
+ * @brief Draw a WSG the way drawWsg() did before it used setupWsgAffine(), by moving each source pixel with
+ * rotatePixel()
+ *
+ * @param wsg The WSG to draw
+ * @param canvas The canvas to draw to
+ * @param xOff The x offset to draw the WSG at
+ * @param yOff The y offset to draw the WSG at
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise, 0-359
+ */
+static void drawWsgRotatePixel(const wsg_t* wsg, wsg_t* canvas, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD,
+                               int32_t rotateDeg)
+{
+    for (int32_t srcY = 0; srcY < wsg->h; srcY++)
+    {
+        int32_t readY = flipUD ? wsg->h - 1 - srcY : srcY;
+        for (int32_t srcX = 0; srcX < wsg->w; srcX++)
+        {
+            int32_t readX        = flipLR ? wsg->w - 1 - srcX : srcX;
+            paletteColor_t color = wsg->px[readY * wsg->w + readX];
+            if (cTransparent != color)
+            {
+                int32_t tx = srcX;
+                int32_t ty = srcY;
+                rotatePixel(&tx, &ty, rotateDeg, wsg->w, wsg->h);
+                tx += xOff;
+                ty += yOff;
+                if (0 <= tx && tx < canvas->w && 0 <= ty && ty < canvas->h)
+                {
+                    canvas->px[ty * canvas->w + tx] = color;
+                }
+            }
+        }
+    }
+}
@@ -11,6 +11,8 @@
 #include "ext_gamepad.h"
 #include "hdw-nvs_emu.h"
 #include "emu_cnfs.h"
+#include "esp_heap_caps.h"
+#include "linked_list.h"
 
 // Console command handlers
 static int screenshotCommandCb(const char** args, int argCount, char* out);
@@ -21,6 +23,7 @@ static int replayCommandCb(const char** args, int argCount, char* out);
 static int fuzzCommandCb(const char** args, int argCount, char* out);
 static int touchCommandCb(const char** args, int argCount, char* out);
 static int ledsCommandCb(const char** args, int argCount, char* out);
+static int memStatsCommandCb(const char** args, int argCount, char* out);
 static int injectCommandCb(const char** args, int argCount, char* out);
 static int joystickCommandCb(const char** args, int argCount, char* out);
 static int helpCommandCb(const char** args, int argCount, char* out);
@@ -33,7 +36,9 @@ static const char* commandDocs[][3] = {
     {"gif", "gif [filename]",
      "starts or stops recording the screen to a GIF named [filename], or an auto-generated file name if not specified"},
     {"mode", "mode [name]", "immediately changes the mode to [name], or lists all mode names if not specified"},
-    {"replay", "replay [filename]", "open and replay recorded inputs from replay file [filename]"},
+    {"replay", "replay [filename] [frame]",
+     "open and replay recorded inputs from replay file [filename], starting from the last keyframe at or before "
+     "[frame] if given"},
     {"record", "record [name]",
      "begin recording inputs into replay file [filename], or an auto-generated file name if not specified"},
     {"fuzz", "fuzz [on|off]", "toggles the fuzzer"},
@@ -56,6 +61,9 @@ static const char* commandDocs[][3] = {
      "sets the deadzone for the touchpad joystick axes"},
     {"joystick preset", "joystick preset <preset-name>",
      "loads a predefined joystick preset. options are swadge or switch."},
+    {"memstats", "memstats",
+     "prints live, peak, and allocation rate stats for each allocation tag and callsite, and list node pool stats, to "
+     "stdout"},
     {"inject", "inject <nvs|asset> <...>", "injects data into NVS or assets"},
     {"inject nvs", "inject nvs [namespace] <key> <int|str|file> <value>",
      "injects data into an NVS key. Value can be either an integer, a string, or a file path"},
@@ -69,7 +77,7 @@ static const consoleCommand_t consoleCommands[] = {
     {.name = "record", .cb = recordCommandCb},         {.name = "fuzz", .cb = fuzzCommandCb},
     {.name = "touchpad", .cb = touchCommandCb},        {.name = "leds", .cb = ledsCommandCb},
     {.name = "inject", .cb = injectCommandCb},         {.name = "help", .cb = helpCommandCb},
-    {.name = "joystick", .cb = joystickCommandCb},
+    {.name = "joystick", .cb = joystickCommandCb},      {.name = "memstats", .cb = memStatsCommandCb},
 };
 
 const consoleCommand_t* getConsoleCommands(void)
@@ -156,6 +164,10 @@ static int replayCommandCb(const char** args, int argCount, char* out)
     if (argCount > 0)
     {
         startPlayback(args[0]);
+        if (argCount > 1)
+        {
+            seekPlayback(strtoull(args[1], NULL, 10));
+        }
         return sprintf(out, "Playback started\n");
     }
     else
@@ -449,6 +461,23 @@ static int ledsCommandCb(const char** args, int argCount, char* out)
     return sprintf(out, "LEDs %s\n", enable ? "enabled" : "disabled");
 }
 
+static int memStatsCommandCb(const char** args, int argCount, char* out)
+{
+    dumpAllocStats();
+
+    listPool_t* pool = getDefaultListPool();
+    if (NULL != pool)
+    {
+        listPoolStats_t stats;
+        getListPoolStats(pool, &stats);
+        printf("List node pool: %" PRIu32 "/%" PRIu32 " nodes in use (peak %" PRIu32 ") in %" PRIu32
+               " slabs, %" PRIu32 " allocs, %" PRIu32 " frees, %" PRIu32 " slab allocs, %" PRIu32 " heap fallbacks\n",
+               stats.inUse, stats.capacity, stats.peakInUse, stats.slabs, stats.allocs, stats.frees, stats.slabAllocs,
+               stats.heapAllocs);
+    }
+    return sprintf(out, "Allocation stats printed\n");
+}
+
 static int injectCommandCb(const char** args, int argCount, char* out)
 {
     if (argCount < 1)
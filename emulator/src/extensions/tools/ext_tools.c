@@ -105,7 +105,8 @@ static char consoleOutput[2048] = {0};
 
 static bool toolsInit(emuArgs_t* emuArgs)
 {
-    if (emuArgs->fakeTime)
+    // Fast-forwarding keeps its own virtual time
+    if (emuArgs->fakeTime && !emuArgs->fastForward)
     {
         emuSetUseRealTime(false);
         useFakeTime = true;
@@ -3,10 +3,18 @@
 //==============================================================================
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <inttypes.h>
 #include <string.h>
 #include <stdbool.h>
 #include "esp_heap_caps.h"
+#ifdef ASSETS_PREPROCESSOR
+    // The assets_preprocessor doesn't build rawdraw, so it uses pthreads directly
+    #include <pthread.h>
+    #include <time.h>
+#else
+    #include "os_generic.h"
+#endif
 #ifdef ESP_PLATFORM
     #include "esp_timer.h"
 #endif
@@ -21,7 +29,14 @@
 #define SPIRAM_SIZE          2093904
 #define SPIRAM_LARGEST_BLOCK 2064384
 
-#define A_TABLE_SIZE 16384
+// The allocation table is open-addressed by pointer, so it must be a power of two and is never filled past
+// A_TABLE_MAX_LIVE entries
+#define A_TABLE_SIZE     32768
+#define A_TABLE_MAX_LIVE ((A_TABLE_SIZE * 3) / 4)
+
+// The per-tag and per-callsite stats tables are open-addressed too, and entries are never removed
+#define A_STATS_SIZE     4096
+#define A_STATS_MAX_LIVE ((A_STATS_SIZE * 3) / 4)
 
 //==============================================================================
 // Enums
@@ -46,6 +61,20 @@ typedef enum
 // Structs
 //==============================================================================
 
+typedef struct
+{
+    bool used;             ///< true if this stats entry is in use
+    const char* file;      ///< The file of the callsite, for callsite stats
+    const char* func;      ///< The function of the callsite, for callsite stats
+    uint32_t line;         ///< The line of the callsite, for callsite stats
+    char tag[32];          ///< The tag, for tag stats
+    uint32_t liveCount;    ///< The number of allocations which haven't been freed
+    size_t liveBytes;      ///< The number of bytes which haven't been freed
+    size_t peakBytes;      ///< The most bytes which were ever allocated at once
+    uint32_t totalAllocs;  ///< The number of allocations ever made
+    uint32_t dumpedAllocs; ///< The value of totalAllocs when stats were last dumped, used to compute the rate
+} allocStats_t;
+
 typedef struct
 {
     void* ptr;
@@ -55,6 +84,8 @@ typedef struct
     const char* func;
     uint32_t line;
     char tag[32];
+    allocStats_t* tagStats;  ///< The stats for this allocation's tag, or NULL if the stats table is full
+    allocStats_t* siteStats; ///< The stats for this allocation's callsite, or NULL if the stats table is full
 } allocation_t;
 
 //==============================================================================
@@ -64,11 +95,42 @@ typedef struct
 allocation_t aTable[A_TABLE_SIZE] = {0};
 size_t usedMemory[MAX_MEM_TYPES]  = {0};
 
+/// The number of entries in aTable
+static uint32_t aTableCount = 0;
+
+/// Stats aggregated by tag, open-addressed by the tag
+static allocStats_t tagStats[A_STATS_SIZE] = {0};
+/// Stats aggregated by callsite, open-addressed by the file and line
+static allocStats_t siteStats[A_STATS_SIZE] = {0};
+/// The time, in seconds, when stats were last dumped or the table was first used
+static double statsDumpTime = 0;
+
+/// Protects the allocation table, since tasks like the asset loader allocate from their own threads
+#ifdef ASSETS_PREPROCESSOR
+static pthread_mutex_t aTableLock = PTHREAD_MUTEX_INITIALIZER;
+#else
+static og_mutex_t aTableLock = NULL;
+#endif
+
 //==============================================================================
 // Function declarations
 //==============================================================================
 
+static double getAllocStatsTime(void);
+static void lockAllocTable(void);
+static void unlockAllocTable(void);
 static void printMemoryOperation(memOp_t op, allocation_t* al);
+static uint32_t hashPtr(const void* ptr);
+static uint32_t hashStr(const char* str, uint32_t hash);
+static allocation_t* findAllocation(const void* ptr);
+static allocation_t* insertAllocation(void* ptr);
+static void removeAllocation(allocation_t* al);
+static allocStats_t* getTagStats(const char* tag);
+static allocStats_t* getSiteStats(const char* file, const char* func, uint32_t line);
+static void countAllocation(allocation_t* al);
+static void countFree(allocation_t* al);
+static int cmpStatsPeak(const void* a, const void* b);
+static void dumpStatsTable(const char* kind, allocStats_t* table);
 static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32_t size, uint32_t caps,
                            const char* file, const char* func, uint32_t line, const char* tag);
 
@@ -76,6 +138,53 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
 // Functions
 //==============================================================================
 
+/**
+ * @brief Get the current time in seconds, for allocation rates
+ *
+ * @return The current time in seconds
+ */
+static double getAllocStatsTime(void)
+{
+#ifdef ASSETS_PREPROCESSOR
+    return (double)time(NULL);
+#else
+    return OGGetAbsoluteTime();
+#endif
+}
+
+/**
+ * @brief Lock the allocation table. The emulator's lock is created on first use, which is always on the main thread
+ * before any other threads are started
+ */
+static void lockAllocTable(void)
+{
+#ifdef ASSETS_PREPROCESSOR
+    pthread_mutex_lock(&aTableLock);
+#else
+    if (NULL == aTableLock)
+    {
+        aTableLock = OGCreateMutex();
+    }
+    OGLockMutex(aTableLock);
+#endif
+    if (0 == statsDumpTime)
+    {
+        statsDumpTime = getAllocStatsTime();
+    }
+}
+
+/**
+ * @brief Unlock the allocation table
+ */
+static void unlockAllocTable(void)
+{
+#ifdef ASSETS_PREPROCESSOR
+    pthread_mutex_unlock(&aTableLock);
+#else
+    OGUnlockMutex(aTableLock);
+#endif
+}
+
 /**
  * @brief Print a saved memory operation as a CSV line. Also prints a CSV header only the first time this function is
  * called
@@ -147,6 +256,289 @@ static void printMemoryOperation(memOp_t op, allocation_t* al)
 #endif
 }
 
+/**
+ * @brief Hash a pointer to its home slot in the allocation table
+ *
+ * @param ptr The pointer to hash
+ * @return The index of the pointer's home slot
+ */
+static uint32_t hashPtr(const void* ptr)
+{
+    // Allocations are at least 16 byte aligned, so the low bits carry no information
+    uint64_t key = ((uintptr_t)ptr) >> 4;
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (A_TABLE_SIZE - 1);
+}
+
+/**
+ * @brief Continue an FNV-1a hash with a string
+ *
+ * @param str The string to hash
+ * @param hash The hash so far, or 2166136261 to start a new one
+ * @return The updated hash
+ */
+static uint32_t hashStr(const char* str, uint32_t hash)
+{
+    while (*str)
+    {
+        hash ^= (uint8_t)(*str++);
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+/**
+ * @brief Find the table entry for an allocated pointer
+ *
+ * @param ptr The pointer to find
+ * @return The entry, or NULL if the pointer isn't in the table
+ */
+static allocation_t* findAllocation(const void* ptr)
+{
+    if (NULL != ptr)
+    {
+        // Linear probe until the pointer or an empty slot is found
+        for (uint32_t idx = hashPtr(ptr); NULL != aTable[idx].ptr; idx = (idx + 1) & (A_TABLE_SIZE - 1))
+        {
+            if (ptr == aTable[idx].ptr)
+            {
+                return &aTable[idx];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Claim an empty table entry for a newly allocated pointer. The caller must fill in the rest of the entry
+ *
+ * @param ptr The pointer to insert, which must not be NULL or already in the table
+ * @return The entry, or NULL if the table is full
+ */
+static allocation_t* insertAllocation(void* ptr)
+{
+    if (A_TABLE_MAX_LIVE <= aTableCount)
+    {
+        return NULL;
+    }
+
+    uint32_t idx = hashPtr(ptr);
+    while (NULL != aTable[idx].ptr)
+    {
+        idx = (idx + 1) & (A_TABLE_SIZE - 1);
+    }
+    aTableCount++;
+    aTable[idx].ptr = ptr;
+    return &aTable[idx];
+}
+
+/**
+ * @brief Remove an entry from the allocation table. Later entries in the same probe run are shifted back so lookups
+ * never need tombstones
+ *
+ * @param al The entry to remove
+ */
+static void removeAllocation(allocation_t* al)
+{
+    uint32_t hole = al - aTable;
+    uint32_t idx  = hole;
+    while (true)
+    {
+        idx = (idx + 1) & (A_TABLE_SIZE - 1);
+        if (NULL == aTable[idx].ptr)
+        {
+            break;
+        }
+
+        // Move the entry into the hole unless its home slot is between the hole and where it is now
+        uint32_t home = hashPtr(aTable[idx].ptr);
+        if (((idx - home) & (A_TABLE_SIZE - 1)) >= ((idx - hole) & (A_TABLE_SIZE - 1)))
+        {
+            aTable[hole] = aTable[idx];
+            hole         = idx;
+        }
+    }
+    memset(&aTable[hole], 0, sizeof(allocation_t));
+    aTableCount--;
+}
+
+/**
+ * @brief Find or create the stats entry for a tag
+ *
+ * @param tag The tag to get stats for
+ * @return The stats entry, or NULL if the stats table is full
+ */
+static allocStats_t* getTagStats(const char* tag)
+{
+    static uint32_t numTags = 0;
+
+    uint32_t idx = hashStr(tag, 2166136261u) & (A_STATS_SIZE - 1);
+    while (tagStats[idx].used)
+    {
+        if (0 == strncmp(tagStats[idx].tag, tag, sizeof(tagStats[idx].tag) - 1))
+        {
+            return &tagStats[idx];
+        }
+        idx = (idx + 1) & (A_STATS_SIZE - 1);
+    }
+
+    if (A_STATS_MAX_LIVE <= numTags)
+    {
+        return NULL;
+    }
+    numTags++;
+    tagStats[idx].used = true;
+    snprintf(tagStats[idx].tag, sizeof(tagStats[idx].tag) - 1, "%s", tag);
+    return &tagStats[idx];
+}
+
+/**
+ * @brief Find or create the stats entry for a callsite
+ *
+ * @param file The file of the callsite
+ * @param func The function of the callsite
+ * @param line The line of the callsite
+ * @return The stats entry, or NULL if the stats table is full
+ */
+static allocStats_t* getSiteStats(const char* file, const char* func, uint32_t line)
+{
+    static uint32_t numSites = 0;
+
+    uint32_t idx = (hashStr(file, 2166136261u) ^ (line * 0x9E3779B1u)) & (A_STATS_SIZE - 1);
+    while (siteStats[idx].used)
+    {
+        if (line == siteStats[idx].line && (file == siteStats[idx].file || 0 == strcmp(file, siteStats[idx].file)))
+        {
+            return &siteStats[idx];
+        }
+        idx = (idx + 1) & (A_STATS_SIZE - 1);
+    }
+
+    if (A_STATS_MAX_LIVE <= numSites)
+    {
+        return NULL;
+    }
+    numSites++;
+    siteStats[idx].used = true;
+    siteStats[idx].file = file;
+    siteStats[idx].func = func;
+    siteStats[idx].line = line;
+    return &siteStats[idx];
+}
+
+/**
+ * @brief Add an allocation to its tag and callsite stats
+ *
+ * @param al The allocation, with its size and stats set
+ */
+static void countAllocation(allocation_t* al)
+{
+    allocStats_t* stats[] = {al->tagStats, al->siteStats};
+    for (int idx = 0; idx < 2; idx++)
+    {
+        if (NULL != stats[idx])
+        {
+            stats[idx]->liveCount++;
+            stats[idx]->totalAllocs++;
+            stats[idx]->liveBytes += al->size;
+            if (stats[idx]->liveBytes > stats[idx]->peakBytes)
+            {
+                stats[idx]->peakBytes = stats[idx]->liveBytes;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Remove an allocation from its tag and callsite stats
+ *
+ * @param al The allocation, with its size and stats set
+ */
+static void countFree(allocation_t* al)
+{
+    allocStats_t* stats[] = {al->tagStats, al->siteStats};
+    for (int idx = 0; idx < 2; idx++)
+    {
+        if (NULL != stats[idx])
+        {
+            stats[idx]->liveCount--;
+            stats[idx]->liveBytes -= al->size;
+        }
+    }
+}
+
+/**
+ * @brief Compare two stats entries by peak bytes, for sorting in descending order with qsort()
+ *
+ * @param a A pointer to an ::allocStats_t pointer
+ * @param b A pointer to an ::allocStats_t pointer
+ * @return A negative number if a should be printed first, a positive number if b should, or 0 if they are equal
+ */
+static int cmpStatsPeak(const void* a, const void* b)
+{
+    const allocStats_t* sA = *(const allocStats_t* const*)a;
+    const allocStats_t* sB = *(const allocStats_t* const*)b;
+    if (sA->peakBytes != sB->peakBytes)
+    {
+        return (sA->peakBytes < sB->peakBytes) ? 1 : -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Print one stats table to stdout in CSV form, largest peak first
+ *
+ * @param kind The kind of stats, printed in the first column
+ * @param table The stats table to print
+ */
+static void dumpStatsTable(const char* kind, allocStats_t* table)
+{
+    static allocStats_t* sorted[A_STATS_SIZE];
+    int numSorted = 0;
+    for (int idx = 0; idx < A_STATS_SIZE; idx++)
+    {
+        if (table[idx].used)
+        {
+            sorted[numSorted++] = &table[idx];
+        }
+    }
+    qsort(sorted, numSorted, sizeof(allocStats_t*), cmpStatsPeak);
+
+    double elapsed = getAllocStatsTime() - statsDumpTime;
+    for (int idx = 0; idx < numSorted; idx++)
+    {
+        allocStats_t* st = sorted[idx];
+        char name[256];
+        if (st->file)
+        {
+            snprintf(name, sizeof(name), "%s:%u %s()", st->file, st->line, st->func);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%s", st->tag);
+        }
+
+        double rate = (elapsed > 0) ? (st->totalAllocs - st->dumpedAllocs) / elapsed : 0;
+        printf("%s,%s,%u,%u,%u,%u,%.1f\n", kind, name, st->liveCount, (uint32_t)st->liveBytes,
+               (uint32_t)st->peakBytes, st->totalAllocs, rate);
+        st->dumpedAllocs = st->totalAllocs;
+    }
+}
+
+/**
+ * @brief Dump allocation stats aggregated by tag and by callsite to stdout in CSV form. The allocation rate is the
+ * number of allocations per second since the last dump
+ */
+void dumpAllocStats(void)
+{
+    lockAllocTable();
+    printf("%s,%s,%s,%s,%s,%s,%s\n", "Kind", "Name", "Live Count", "Live Bytes", "Peak Bytes", "Allocs",
+           "Allocs/s");
+    dumpStatsTable("TAG", tagStats);
+    dumpStatsTable("SITE", siteStats);
+    statsDumpTime = getAllocStatsTime();
+    unlockAllocTable();
+}
+
 /**
  * @brief Dump the current allocation table to stdout in CSV form.
  */
@@ -181,7 +573,7 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
                            const char* file, const char* func, uint32_t line, const char* tag)
 {
     allocation_t* al = NULL;
-    // Find the old entry in the table. if oldEntry is NULL, then an empty entry will be found
+    // Find the old entry in the table. if oldEntry is NULL, then an empty entry will be claimed
     if (NULL == oldEntry)
     {
         if (OP_FREE == op || OP_REALLOC == op)
@@ -191,14 +583,18 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
         }
         else
         {
-            int32_t idx = 0;
-            while (idx < A_TABLE_SIZE && NULL != aTable[idx].ptr)
-            {
-                idx++;
-            }
-            al = &aTable[idx];
+            // NULL if the table is full
+            al = insertAllocation(ptr);
         }
     }
+    else if (OP_REALLOC == op && oldEntry->ptr != ptr)
+    {
+        // The allocation moved, so index it by the new pointer
+        allocation_t moved = *oldEntry;
+        removeAllocation(oldEntry);
+        al  = insertAllocation(ptr);
+        *al = moved;
+    }
     else
     {
         al = oldEntry;
@@ -234,7 +630,8 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
             printMemoryOperation(op, al);
 
             // Erase the table entry
-            memset(al, 0, sizeof(allocation_t));
+            countFree(al);
+            removeAllocation(al);
         }
         else
         {
@@ -248,11 +645,12 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
             // Pick a variable to track overall size
             size_t* usedMem = (MALLOC_CAP_SPIRAM & caps) ? &usedMemory[1] : &usedMemory[0];
 
-            // Save the old size for reallocs
-            uint32_t oldSize = 0;
+            // Take the old allocation out of the totals and stats for reallocs, which may have changed caps
             if (OP_REALLOC == op)
             {
-                oldSize = al->size;
+                size_t* oldUsedMem = (MALLOC_CAP_SPIRAM & al->caps) ? &usedMemory[1] : &usedMemory[0];
+                *oldUsedMem -= al->size;
+                countFree(al);
             }
 
             // Save entry
@@ -270,9 +668,11 @@ static void saveAllocation(memOp_t op, void* ptr, allocation_t* oldEntry, uint32
             {
                 snprintf(al->tag, sizeof(al->tag) - 1, "%s:%u", al->func, al->line);
             }
+            al->tagStats  = getTagStats(al->tag);
+            al->siteStats = getSiteStats(file, func, line);
+            countAllocation(al);
 
             // Adjust space
-            *usedMem -= oldSize;
             *usedMem += al->size;
 
             // Print it
@@ -323,7 +723,12 @@ void* heap_caps_malloc_dbg(size_t size, uint32_t caps, const char* file, const c
 {
 #ifdef MEMORY_DEBUG
     void* ptr = malloc(size);
-    saveAllocation(OP_MALLOC, ptr, NULL, size, caps, file, func, line, tag);
+    if (NULL != ptr)
+    {
+        lockAllocTable();
+        saveAllocation(OP_MALLOC, ptr, NULL, size, caps, file, func, line, tag);
+        unlockAllocTable();
+    }
     return ptr;
 #else
     return malloc(size);
@@ -352,7 +757,12 @@ void* heap_caps_calloc_dbg(size_t n, size_t size, uint32_t caps, const char* fil
 {
 #ifdef MEMORY_DEBUG
     void* ptr = calloc(n, size);
-    saveAllocation(OP_CALLOC, ptr, NULL, n * size, caps, file, func, line, tag);
+    if (NULL != ptr)
+    {
+        lockAllocTable();
+        saveAllocation(OP_CALLOC, ptr, NULL, n * size, caps, file, func, line, tag);
+        unlockAllocTable();
+    }
     return ptr;
 #else
     return calloc(n, size);
@@ -382,26 +792,31 @@ void* heap_caps_realloc_dbg(void* ptr, size_t size, uint32_t caps, const char* f
                             const char* tag)
 {
 #ifdef MEMORY_DEBUG
+    lockAllocTable();
 
     // Find the old entry in the table.
-    allocation_t* oldEntry = NULL;
-    if (NULL != ptr)
-    {
-        int32_t idx = 0;
-        while (idx < A_TABLE_SIZE && ptr != aTable[idx].ptr)
-        {
-            idx++;
-        }
+    allocation_t* oldEntry = findAllocation(ptr);
 
-        // Get the old entry, if it exists
-        if (A_TABLE_SIZE > idx)
+    void* newPtr = realloc(ptr, size);
+    if (NULL == ptr)
+    {
+        // Reallocating NULL is a new allocation
+        if (NULL != newPtr)
         {
-            oldEntry = &aTable[idx];
+            saveAllocation(OP_MALLOC, newPtr, NULL, size, caps, file, func, line, tag);
         }
     }
-
-    void* newPtr = realloc(ptr, size);
-    saveAllocation(OP_REALLOC, newPtr, oldEntry, size, caps, file, func, line, tag);
+    else if (NULL != newPtr)
+    {
+        saveAllocation(OP_REALLOC, newPtr, oldEntry, size, caps, file, func, line, tag);
+    }
+    else if (0 == size)
+    {
+        // Reallocating to zero bytes freed the old allocation
+        saveAllocation(OP_FREE, ptr, oldEntry, 0, 0, file, func, line, tag);
+    }
+    // Otherwise the reallocation failed and the old allocation is untouched
+    unlockAllocTable();
     return newPtr;
 #else
     return realloc(ptr, size);
@@ -424,26 +839,18 @@ void* heap_caps_realloc_dbg(void* ptr, size_t size, uint32_t caps, const char* f
 void heap_caps_free_dbg(void* ptr, const char* file, const char* func, int32_t line, const char* tag)
 {
 #ifdef MEMORY_DEBUG
-
-    // Try to find the old entry in the table. Frees should always follow an alloc
-    allocation_t* oldEntry = NULL;
+    // Freeing NULL is allowed and does nothing
     if (NULL != ptr)
     {
-        int32_t idx = 0;
-        while (idx < A_TABLE_SIZE && ptr != aTable[idx].ptr)
-        {
-            idx++;
-        }
+        lockAllocTable();
 
-        // Get the old entry, if it exists
-        if (A_TABLE_SIZE > idx)
-        {
-            oldEntry = &aTable[idx];
-        }
-    }
+        // Try to find the old entry in the table. Frees should always follow an alloc
+        allocation_t* oldEntry = findAllocation(ptr);
 
-    // If there was a free without a corresponding alloc, oldEntry will be NULL here
-    saveAllocation(OP_FREE, ptr, oldEntry, 0, 0, file, func, line, tag);
+        // If there was a free without a corresponding alloc, oldEntry will be NULL here
+        saveAllocation(OP_FREE, ptr, oldEntry, 0, 0, file, func, line, tag);
+        unlockAllocTable();
+    }
 #endif
     free(ptr);
 }
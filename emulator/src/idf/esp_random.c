@@ -41,7 +41,8 @@ void emulatorSetEspRandomSeed(uint32_t seed_)
 {
     seed = seed_;
 
-    if (seedValueSet)
+    // Reseed right away if the generator is already in use
+    if (seeded || seedValueSet)
     {
         srand(seed);
     }
@@ -286,11 +286,35 @@ void check_esp_timer(uint64_t elapsed_us)
     }
 }
 
+/**
+ * @brief Switch between real time and the fake time set with emuSetEspTimerTime(). When switching back to real time,
+ * real time continues on from the fake time instead of jumping
+ *
+ * @param val true to use real time, false to use fake time
+ */
 void emuSetUseRealTime(bool val)
 {
+    if (val && !useRealTime && 0 != boot_time_in_micros)
+    {
+        struct timespec ts;
+        if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+        {
+            boot_time_in_micros = ((ts.tv_sec * 1000000) + (ts.tv_nsec / 1000)) - total_pause_micros - fakeTime;
+        }
+    }
     useRealTime = val;
 }
 
+/**
+ * @brief Check whether esp_timer_get_time() returns real time or fake time
+ *
+ * @return true if real time is used, false if fake time is used
+ */
+bool emuGetUseRealTime(void)
+{
+    return useRealTime;
+}
+
 void emuSetEspTimerTime(int64_t time)
 {
     fakeTime = time;
@@ -0,0 +1,286 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "os_generic.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief The function and argument for an emulated task, passed to its thread
+ */
+typedef struct
+{
+    TaskFunction_t fn; ///< The task function
+    void* arg;         ///< The argument to the task function
+} emuTask_t;
+
+/**
+ * @brief An emulated FreeRTOS queue. Items are copied into a ring buffer, protected by a mutex. Blocked senders and
+ * receivers wait on condition variables rather than polling
+ */
+struct emuQueue
+{
+    pthread_mutex_t lock;    ///< Protects everything below
+    pthread_cond_t notEmpty; ///< Signaled when an item is added
+    pthread_cond_t notFull;  ///< Signaled when an item is removed
+    uint8_t* items;          ///< The ring buffer of items
+    UBaseType_t itemSize;    ///< The size of each item
+    UBaseType_t length;      ///< The maximum number of items
+    UBaseType_t head;        ///< The index of the oldest item
+    UBaseType_t count;       ///< The number of items in the queue
+};
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static void* emuTaskThread(void* arg);
+static void getQueueDeadline(TickType_t xTicksToWait, struct timespec* deadline);
+static bool waitQueue(QueueHandle_t xQueue, pthread_cond_t* cond, TickType_t xTicksToWait,
+                      const struct timespec* deadline);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief The thread function for an emulated task. Tasks end when their function returns, which happens right after
+ * they call vTaskDelete(NULL)
+ *
+ * @param arg The emuTask_t to run, which is freed here
+ * @return NULL
+ */
+static void* emuTaskThread(void* arg)
+{
+    emuTask_t task = *(emuTask_t*)arg;
+    free(arg);
+    task.fn(task.arg);
+    return NULL;
+}
+
+/**
+ * @brief Create a task, which runs on its own thread in the emulator. Stack depth and priority are ignored
+ *
+ * @param pxTaskCode The task function
+ * @param pcName A name for the task, unused
+ * @param usStackDepth The stack depth, unused
+ * @param pvParameters The argument to pass to the task function
+ * @param uxPriority The task priority, unused
+ * @param pxCreatedTask Optionally, a handle to the created task is written here
+ * @return pdPASS if the task was created, pdFAIL if it was not
+ */
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char* const pcName, const uint32_t usStackDepth,
+                       void* const pvParameters, UBaseType_t uxPriority, TaskHandle_t* const pxCreatedTask)
+{
+    emuTask_t* task = malloc(sizeof(emuTask_t));
+    if (NULL == task)
+    {
+        return pdFAIL;
+    }
+    task->fn  = pxTaskCode;
+    task->arg = pvParameters;
+
+    og_thread_t thread = OGCreateThread(emuTaskThread, task);
+    if (NULL == thread)
+    {
+        free(task);
+        return pdFAIL;
+    }
+
+    if (NULL != pxCreatedTask)
+    {
+        *pxCreatedTask = thread;
+    }
+    return pdPASS;
+}
+
+/**
+ * @brief Delete a task. Only deleting the calling task is supported. Unlike FreeRTOS this returns to the caller, so
+ * the task function must return right after calling this
+ *
+ * @param xTaskToDelete The task to delete, must be NULL
+ */
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    if (NULL != xTaskToDelete)
+    {
+        ESP_LOGE("FreeRTOS", "Only tasks deleting themselves is supported");
+    }
+}
+
+/**
+ * @brief Convert a FreeRTOS tick timeout into an absolute deadline for pthread_cond_timedwait()
+ *
+ * @param xTicksToWait How many ticks to wait, or portMAX_DELAY to wait forever
+ * @param deadline The absolute CLOCK_REALTIME deadline is written here. Unused for portMAX_DELAY
+ */
+static void getQueueDeadline(TickType_t xTicksToWait, struct timespec* deadline)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    if (portMAX_DELAY != xTicksToWait)
+    {
+        uint64_t waitNs = (uint64_t)xTicksToWait * portTICK_PERIOD_MS * 1000000;
+        uint64_t nsec   = (uint64_t)deadline->tv_nsec + waitNs;
+        deadline->tv_sec += nsec / 1000000000;
+        deadline->tv_nsec = nsec % 1000000000;
+    }
+}
+
+/**
+ * @brief Block on one of a queue's condition variables. The queue's lock must be held, and is held again on return
+ *
+ * @param xQueue The queue being waited on
+ * @param cond The condition variable to wait on
+ * @param xTicksToWait How many ticks the caller is willing to wait, or portMAX_DELAY to wait forever
+ * @param deadline The absolute deadline from getQueueDeadline()
+ * @return true if the caller should check the queue again, false if the wait timed out
+ */
+static bool waitQueue(QueueHandle_t xQueue, pthread_cond_t* cond, TickType_t xTicksToWait,
+                      const struct timespec* deadline)
+{
+    if (0 == xTicksToWait)
+    {
+        return false;
+    }
+    else if (portMAX_DELAY == xTicksToWait)
+    {
+        pthread_cond_wait(cond, &xQueue->lock);
+        return true;
+    }
+    return ETIMEDOUT != pthread_cond_timedwait(cond, &xQueue->lock, deadline);
+}
+
+/**
+ * @brief Create a queue of fixed size items
+ *
+ * @param uxQueueLength The maximum number of items in the queue
+ * @param uxItemSize The size of each item
+ * @return The queue, or NULL if it couldn't be allocated
+ */
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    QueueHandle_t q = heap_caps_calloc(1, sizeof(struct emuQueue), MALLOC_CAP_8BIT);
+    if (NULL == q)
+    {
+        return NULL;
+    }
+
+    q->items = heap_caps_calloc(uxQueueLength, uxItemSize, MALLOC_CAP_8BIT);
+    if (NULL == q->items)
+    {
+        heap_caps_free(q);
+        return NULL;
+    }
+
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->notEmpty, NULL);
+    pthread_cond_init(&q->notFull, NULL);
+    q->itemSize = uxItemSize;
+    q->length   = uxQueueLength;
+    return q;
+}
+
+/**
+ * @brief Delete a queue. Nothing may be waiting on it
+ *
+ * @param xQueue The queue to delete
+ */
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    pthread_cond_destroy(&xQueue->notFull);
+    pthread_cond_destroy(&xQueue->notEmpty);
+    pthread_mutex_destroy(&xQueue->lock);
+    heap_caps_free(xQueue->items);
+    heap_caps_free(xQueue);
+}
+
+/**
+ * @brief Copy an item to the back of a queue, waiting for space if it's full
+ *
+ * @param xQueue The queue to send to
+ * @param pvItemToQueue The item to copy into the queue
+ * @param xTicksToWait How many ticks to wait for space, or portMAX_DELAY to wait forever
+ * @return pdTRUE if the item was queued, pdFALSE if the queue stayed full
+ */
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait)
+{
+    struct timespec deadline;
+    getQueueDeadline(xTicksToWait, &deadline);
+
+    pthread_mutex_lock(&xQueue->lock);
+    while (xQueue->count >= xQueue->length)
+    {
+        if (!waitQueue(xQueue, &xQueue->notFull, xTicksToWait, &deadline))
+        {
+            pthread_mutex_unlock(&xQueue->lock);
+            return pdFALSE;
+        }
+    }
+
+    UBaseType_t tail = (xQueue->head + xQueue->count) % xQueue->length;
+    memcpy(&xQueue->items[tail * xQueue->itemSize], pvItemToQueue, xQueue->itemSize);
+    xQueue->count++;
+    pthread_cond_signal(&xQueue->notEmpty);
+    pthread_mutex_unlock(&xQueue->lock);
+    return pdTRUE;
+}
+
+/**
+ * @brief Copy an item from the front of a queue, waiting for one if it's empty
+ *
+ * @param xQueue The queue to receive from
+ * @param pvBuffer Where to copy the item to
+ * @param xTicksToWait How many ticks to wait for an item, or portMAX_DELAY to wait forever
+ * @return pdTRUE if an item was received, pdFALSE if the queue stayed empty
+ */
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait)
+{
+    struct timespec deadline;
+    getQueueDeadline(xTicksToWait, &deadline);
+
+    pthread_mutex_lock(&xQueue->lock);
+    while (0 == xQueue->count)
+    {
+        if (!waitQueue(xQueue, &xQueue->notEmpty, xTicksToWait, &deadline))
+        {
+            pthread_mutex_unlock(&xQueue->lock);
+            return pdFALSE;
+        }
+    }
+
+    memcpy(pvBuffer, &xQueue->items[xQueue->head * xQueue->itemSize], xQueue->itemSize);
+    xQueue->head = (xQueue->head + 1) % xQueue->length;
+    xQueue->count--;
+    pthread_cond_signal(&xQueue->notFull);
+    pthread_mutex_unlock(&xQueue->lock);
+    return pdTRUE;
+}
+
+/**
+ * @brief Get the number of items in a queue
+ *
+ * @param xQueue The queue to check
+ * @return The number of items in the queue
+ */
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    pthread_mutex_lock(&xQueue->lock);
+    UBaseType_t count = xQueue->count;
+    pthread_mutex_unlock(&xQueue->lock);
+    return count;
+}
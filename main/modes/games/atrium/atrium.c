@@ -449,38 +449,34 @@ static void atriumEnterMode(void)
 
     atr->loadAnims = 0;
 
-    // Load images with a common decoder and decode space
+    // Load images with a common decoder. Pixels are decoded straight into each WSG
     {
-        // Initialize memory for a lot of big image loads
         heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-        uint8_t* decodeSpace
-            = heap_caps_calloc(1, 4 + sizeof(paletteColor_t) * TFT_HEIGHT * TFT_WIDTH, MALLOC_CAP_SPIRAM);
 
         for (int idx = 0; idx < ARRAY_SIZE(sonaBodies); idx++)
         {
-            loadWsgInplace(sonaBodies[idx], &atr->bodies[idx], true, decodeSpace, hsd);
+            loadWsgInplace(sonaBodies[idx], &atr->bodies[idx], true, hsd);
         }
 
         for (int idx = 0; idx < ARRAY_SIZE(uiImages); idx++)
         {
-            loadWsgInplace(uiImages[idx], &atr->uiElements[idx], true, decodeSpace, hsd);
+            loadWsgInplace(uiImages[idx], &atr->uiElements[idx], true, hsd);
         }
 
         for (int idx = 0; idx < ARRAY_SIZE(bgImages); idx++)
         {
-            loadWsgInplace(bgImages[idx], &atr->backgroundImages[idx], true, decodeSpace, hsd);
+            loadWsgInplace(bgImages[idx], &atr->backgroundImages[idx], true, hsd);
         }
 
         for (int idx = 0; idx < ARRAY_SIZE(cardImages); idx++)
         {
-            loadWsgInplace(cardImages[idx], &atr->cards[idx], true, decodeSpace, hsd);
+            loadWsgInplace(cardImages[idx], &atr->cards[idx], true, hsd);
         }
         for (int idx = 0; idx < ARRAY_SIZE(concertSonaBodies); idx++)
         {
-            loadWsgInplace(concertSonaBodies[idx], &atr->concertBodies[idx], true, decodeSpace, hsd);
+            loadWsgInplace(concertSonaBodies[idx], &atr->concertBodies[idx], true, hsd);
         }
 
-        heap_caps_free(decodeSpace);
         heatshrink_decoder_free(hsd);
     }
 
@@ -416,8 +416,10 @@ void jukeboxButtonCallback(buttonEvt_t* evt)
                         midiGmOff(globalMidiPlayerGet(MIDI_BGM));
                     }
 
-                    globalMidiPlayerPlaySongCb(&jukebox->bgmMidis[jukebox->categoryIdx][jukebox->songIdx], MIDI_BGM,
-                                               jukeboxBzrDoneCb);
+                    // Index the song so reading its events is cheaper. The index is freed with the song
+                    midiFile_t* song = &jukebox->bgmMidis[jukebox->categoryIdx][jukebox->songIdx];
+                    indexMidiFile(song, true);
+                    globalMidiPlayerPlaySongCb(song, MIDI_BGM, jukeboxBzrDoneCb);
                 }
                 else
                 {
@@ -435,8 +437,10 @@ void jukeboxButtonCallback(buttonEvt_t* evt)
                         midiGmOff(globalMidiPlayerGet(MIDI_SFX));
                     }
 
-                    globalMidiPlayerPlaySongCb(&jukebox->sfxMidis[jukebox->categoryIdx][jukebox->songIdx], MIDI_SFX,
-                                               jukeboxBzrDoneCb);
+                    // Index the song so reading its events is cheaper. The index is freed with the song
+                    midiFile_t* song = &jukebox->sfxMidis[jukebox->categoryIdx][jukebox->songIdx];
+                    indexMidiFile(song, true);
+                    globalMidiPlayerPlaySongCb(song, MIDI_SFX, jukeboxBzrDoneCb);
                 }
                 jukebox->isPlaying            = true;
                 jukebox->usBetweenDecorations = 0;
@@ -2749,6 +2749,8 @@ static void synthSetFile(cnfsFileIdx_t fIdx)
 
         midiPlayerReset(&sd->midiPlayer);
         synthSetupPlayer();
+        // Index the file so seeking doesn't have to parse from the start
+        indexMidiFile(&sd->midiFile, true);
         midiSetFile(&sd->midiPlayer, &sd->midiFile);
         preloadLyrics(&sd->karaoke, &sd->midiFile);
 
@@ -4035,6 +4037,7 @@ static void drawSampleGraph(void)
 {
     // Draw sample graph
     SETUP_FOR_TURBO();
+    markDirtyRowsRenderTarget(0, TFT_HEIGHT);
 
     for (int n = 0; n < 256; n++)
     {
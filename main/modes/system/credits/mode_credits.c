@@ -94,9 +94,10 @@ void creditsEnterMode(void)
     // Allocate memory for this mode
     credits = (credits_t*)heap_caps_calloc(1, sizeof(credits_t), MALLOC_CAP_8BIT);
 
-    // Load a font
+    // Load a font, and cache its glyphs since a screen of text is drawn every frame
     font_t* creditsFont = (font_t*)heap_caps_calloc(1, sizeof(font_t), MALLOC_CAP_8BIT);
     loadFont(OXANIUM_FONT, creditsFont, false);
+    cacheFontGlyphs(creditsFont, false);
 
     // Initialize credits
     initCredits(credits, creditsFont, entries, ARRAY_SIZE(entries));
@@ -198,6 +198,7 @@ static void touchTestBackgroundDrawCallback(int16_t x, int16_t y, int16_t w, int
 {
     // Use TURBO drawing mode to draw individual pixels fast
     SETUP_FOR_TURBO();
+    markDirtyRowsRenderTarget(y, y + h);
 
     // Blank the display
     for (int16_t yp = y; yp < y + h; yp++)
@@ -124,6 +124,8 @@
  *     - wsgCanvas.h: Tools for mixing WSGs into one file to save on memory space
  *     - wsgPalette.h: A layer on top of WSGs to allow the colors to be changed without new WSGs
  * - font.h: Learn how to draw text on the screen
+ * - displayList.h: Draw the display from a list of commands, without a frame-buffer
+ * - tilemap.h: Draw scrolling, layered, animated tile backgrounds
  *
  * \subsection audio_api Audio APIs
  *
@@ -182,6 +184,7 @@
  *
  * - linked_list.h: A basic data structure
  * - hashMap.h: A data structure for storing data in key-value pairs
+ * - flatHashMap.h: An allocation-free key-value map in a caller-supplied array
  *
  * \subsection math_api Math APIs
  *
@@ -230,7 +233,11 @@
 #include "quickSettings.h"
 #include "midiPlayer.h"
 #include "introMode.h"
+#include "fs_async.h"
+#include "fs_cache.h"
+#include "swadgesona.h"
 #include "nameList.h"
+#include "p2pConnection.h"
 
 //==============================================================================
 // Defines
@@ -300,6 +307,8 @@ static bool shouldShowQuickSettings = false;
 static bool shouldHideQuickSettings = false;
 /// @brief A pointer to the Swadge mode under the quick settings
 static const swadgeMode_t* modeBehindQuickSettings = NULL;
+/// @brief The band renderer used by the Swadge mode under the quick settings, which need a frame-buffer
+static fnBandRenderCallback_t bandRendererBehindQuickSettings = NULL;
 
 /// 40 FPS by default
 static uint32_t frameRateUs = DEFAULT_FRAME_RATE_US;
@@ -310,6 +319,9 @@ static int64_t timeExitPressed = 0;
 /// @brief System font
 static font_t sysFont;
 
+/// @brief The default pool for list nodes
+static listPool_t sysListPool;
+
 /// @brief Infinite impulse response filter for mic samples
 static uint32_t samp_iir = 0;
 
@@ -320,7 +332,9 @@ static uint32_t samp_iir = 0;
 static void swadgeModeEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, uint8_t len,
                                    int8_t rssi);
 static void swadgeModeEspNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status);
+static void swadgeModeEspNowRecvBatchCb(const espNowPacket_t* packets, uint16_t count);
 static void setSwadgeMode(void* swadgeMode);
+static void teardownSwadgeMode(bool flushCache);
 static void initOptionalPeripherals(void);
 static void dacCallback(uint8_t* samples, int16_t len);
 
@@ -342,6 +356,10 @@ void app_main(void)
     }
 #endif
 
+    // Allocate list nodes from a pool, before any lists are used
+    initListPool(&sysListPool, LIST_POOL_DEFAULT_SLAB_NODES, MALLOC_CAP_8BIT);
+    setDefaultListPool(&sysListPool);
+
     // Init NVS. Do this first to get test mode status and crashwrap logs
     initNvs(true);
 
@@ -548,8 +566,14 @@ void app_main(void)
         if (NO_WIFI != cSwadgeMode->wifiMode)
         {
             checkEspNowRxQueue();
+
+            // Retry windowed p2p packets on the main loop, after any ACKs were received
+            p2pPollWindows();
         }
 
+        // Call back for any assets which finished loading in the background
+        pollAsyncLoads();
+
         // Only draw to the TFT every frameRateUs
         static uint64_t tAccumDraw = 0;
         tAccumDraw += tElapsedUs;
@@ -574,6 +598,14 @@ void app_main(void)
 
                 cSwadgeMode->fnMainLoop(mainLoopCallDelay);
                 tLastMainLoopCall = tNowUs;
+
+                // Make sure the system UI and the next frame draw to the display
+                if (getRenderTargetDepth())
+                {
+                    ESP_LOGW("SWADGE", "%" PRId32 " render target(s) left pushed after the main loop",
+                             getRenderTargetDepth());
+                    resetRenderTargets();
+                }
             }
 
             // If the menu button is being held
@@ -603,13 +635,23 @@ void app_main(void)
                 // Lower the flag
                 shouldShowQuickSettings = false;
 
-                // Save the current mode
-                modeBehindQuickSettings = cSwadgeMode;
-                cSwadgeModeInit         = false;
-                cSwadgeMode             = &quickSettingsMode;
-                // Show the quick settings
-                quickSettingsMode.fnEnterMode();
-                cSwadgeModeInit = true;
+                // Quick settings draw to the frame-buffer, so stop any band renderer until they're hidden
+                bandRendererBehindQuickSettings = getBandRendererTft();
+                if (!setBandRendererTft(NULL))
+                {
+                    // Not enough memory for a frame-buffer, so quick settings can't be shown
+                    bandRendererBehindQuickSettings = NULL;
+                }
+                else
+                {
+                    // Save the current mode
+                    modeBehindQuickSettings = cSwadgeMode;
+                    cSwadgeModeInit         = false;
+                    cSwadgeMode             = &quickSettingsMode;
+                    // Show the quick settings
+                    quickSettingsMode.fnEnterMode();
+                    cSwadgeModeInit = true;
+                }
             }
             else if (shouldHideQuickSettings)
             {
@@ -617,8 +659,10 @@ void app_main(void)
                 shouldHideQuickSettings = false;
                 // Hide the quick settings
                 quickSettingsMode.fnExitMode();
-                // Restore the mode
+                // Restore the mode and its band renderer, if it had one
                 cSwadgeMode = modeBehindQuickSettings;
+                setBandRendererTft(bandRendererBehindQuickSettings);
+                bandRendererBehindQuickSettings = NULL;
             }
 
             // If trophies are not null, draw
@@ -658,6 +702,7 @@ void app_main(void)
     }
 
     // Deinitialize the swadge mode
+    waitAsyncLoads();
     if (cSwadgeModeInit && NULL != cSwadgeMode->fnExitMode)
     {
         cSwadgeModeInit = false;
@@ -706,6 +751,9 @@ static void initOptionalPeripherals(void)
     {
         initEspNow(&swadgeModeEspNowRecvCb, &swadgeModeEspNowSendCb, GPIO_NUM_NC, GPIO_NUM_NC, UART_NUM_MAX,
                    cSwadgeMode->wifiMode);
+
+        // Deliver bursts of packets all at once if the mode wants that
+        espNowSetRecvBatchCb((NULL != cSwadgeMode->fnEspNowRecvBatchCb) ? &swadgeModeEspNowRecvBatchCb : NULL);
     }
 
     // Init accelerometer
@@ -735,12 +783,8 @@ void deinitSystem(void)
     // Deinit font and sfx
     freeFont(&sysFont);
 
-    // Deinit the swadge mode
-    if (cSwadgeModeInit && NULL != cSwadgeMode->fnExitMode)
-    {
-        cSwadgeModeInit = false;
-        cSwadgeMode->fnExitMode();
-    }
+    // Deinit the swadge mode and free every cached asset
+    teardownSwadgeMode(true);
 
     // Deinitialize everything
     deinitButtons();
@@ -780,6 +824,21 @@ static void swadgeModeEspNowRecvCb(const esp_now_recv_info_t* esp_now_info, cons
     }
 }
 
+/**
+ * Callback from ESP NOW to the current Swadge mode with every packet received since the last main loop. This is only
+ * set if the mode has a batch callback
+ *
+ * @param packets The received packets, oldest first
+ * @param count   The number of received packets
+ */
+static void swadgeModeEspNowRecvBatchCb(const espNowPacket_t* packets, uint16_t count)
+{
+    if (cSwadgeModeInit && NULL != cSwadgeMode->fnEspNowRecvBatchCb)
+    {
+        cSwadgeMode->fnEspNowRecvBatchCb(packets, count);
+    }
+}
+
 /**
  * Callback from ESP NOW to the current Swadge mode whenever a packet is sent
  * It routes through user_main.c, which knows what the current mode is
@@ -809,11 +868,7 @@ static void setSwadgeMode(void* swadgeMode)
     }
 
     // Stop the prior mode
-    cSwadgeModeInit = false;
-    if (cSwadgeMode->fnExitMode)
-    {
-        cSwadgeMode->fnExitMode();
-    }
+    teardownSwadgeMode(false);
 
     // Set and start the new mode
     cSwadgeMode = swadgeMode;
@@ -828,6 +883,49 @@ static void setSwadgeMode(void* swadgeMode)
     cSwadgeModeInit = true;
 }
 
+/**
+ * @brief Exit the current Swadge mode, after any of its background loads finish, and undo everything it may have left
+ * set up so the next mode starts from the same state as the first one
+ *
+ * @param flushCache true to free every unreferenced cached asset, false to keep the ones which fit in the cache budget
+ */
+static void teardownSwadgeMode(bool flushCache)
+{
+    waitAsyncLoads();
+    bool wasInit    = cSwadgeModeInit;
+    cSwadgeModeInit = false;
+    if (wasInit && NULL != cSwadgeMode->fnExitMode)
+    {
+        cSwadgeMode->fnExitMode();
+    }
+
+    // Free what the mode left cached
+    clearSwadgesonaCache();
+    if (flushCache)
+    {
+        flushAssetCache();
+    }
+    else
+    {
+        trimAssetCache();
+    }
+    clearTextLayoutCache(NULL);
+    trimListPool(&sysListPool);
+
+    // Stop the music
+    globalMidiPlayerStop(true);
+
+    // Send the whole display again and wait for it, the next mode may not track dirty rows or draw asynchronously
+    enableDirtyTrackingTft(false);
+    enableAsyncScanoutTft(false);
+    resetRenderTargets();
+
+    // Give the next mode a frame-buffer again
+    dlStop();
+    setBandRendererTft(NULL);
+    bandRendererBehindQuickSettings = NULL;
+}
+
 /**
  * Set up variables to synchronously switch the swadge mode in the main loop
  *
@@ -849,14 +947,7 @@ void softSwitchToPendingSwadge(void)
     if (pendingSwadgeMode)
     {
         // Exit the current mode
-        cSwadgeModeInit = false;
-        if (NULL != cSwadgeMode->fnExitMode)
-        {
-            cSwadgeMode->fnExitMode();
-        }
-
-        // Stop the music
-        globalMidiPlayerStop(true);
+        teardownSwadgeMode(false);
 
         // Switch the mode pointer
         cSwadgeMode       = pendingSwadgeMode;
@@ -1086,3 +1177,13 @@ font_t* getSysFont(void)
 {
     return &sysFont;
 }
+
+/**
+ * @brief Get the Swadge mode which is currently running. If the quick settings are open, this is the mode behind them
+ *
+ * @return The current Swadge mode
+ */
+const swadgeMode_t* getSwadgeMode(void)
+{
+    return (&quickSettingsMode == cSwadgeMode) ? modeBehindQuickSettings : cSwadgeMode;
+}
@@ -198,6 +198,8 @@
 #include "wsg.h"
 #include "shapes.h"
 #include "fill.h"
+#include "renderTarget.h"
+#include "displayList.h"
 #include "menu.h"
 #include "menuManiaRenderer.h"
 #include "menuMegaRenderer.h"
@@ -331,6 +333,16 @@ typedef struct swadgeMode
      */
     void (*fnEspNowRecvCb)(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, uint8_t len, int8_t rssi);
 
+    /**
+     * @brief This function is called once per main loop with every ESP-NOW packet received since the last call. If
+     * this is not NULL, it is called instead of fnEspNowRecvCb, which lets a mode handle a burst of packets at once.
+     * It is not used in ::ESP_NOW_IMMEDIATE mode
+     *
+     * @param packets The received packets, oldest first. These are only valid until this function returns
+     * @param count   The number of received packets
+     */
+    void (*fnEspNowRecvBatchCb)(const espNowPacket_t* packets, uint16_t count);
+
     /**
      * @brief This function is called whenever an ESP-NOW packet is sent. It is just a status callback whether or not
      * the packet was actually sent. This will be called after calling espNowSend().
@@ -395,5 +407,6 @@ void powerUpPeripherals(void);
 // Getters
 font_t* getSysFont(void);
 midiFile_t* getSysSound(void);
+const swadgeMode_t* getSwadgeMode(void);
 
 #endif
@@ -0,0 +1,359 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include "flatHashMap.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <esp_log.h>
+
+//==============================================================================
+// Static Function Prototypes
+//==============================================================================
+
+static uint32_t flatHashMix(uint32_t hash);
+static uint32_t flatHashFind(const flatHashMap_t* map, const void* key);
+static void flatHashRemoveAt(flatHashMap_t* map, uint32_t idx);
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Initialize a map with string keys, backed by the given array
+ *
+ * @param map The map to initialize
+ * @param entries The backing array. It must stay valid while the map is used
+ * @param size The number of entries in the backing array, which must be a power of two. The map holds at most one
+ * fewer entry than this
+ * @return true if the map was initialized, false if \c size was not a power of two
+ */
+bool flatHashInit(flatHashMap_t* map, flatHashEntry_t* entries, uint32_t size)
+{
+    return flatHashInitBin(map, entries, size, hashString, strEq);
+}
+
+/**
+ * @brief Initialize a map with custom key types, backed by the given array
+ *
+ * @param map The map to initialize
+ * @param entries The backing array. It must stay valid while the map is used
+ * @param size The number of entries in the backing array, which must be a power of two. The map holds at most one
+ * fewer entry than this
+ * @param hashFunc The hash function to use for the key datatype
+ * @param eqFunc The comparison function to use for the key datatype
+ * @return true if the map was initialized, false if \c size was not a power of two
+ */
+bool flatHashInitBin(flatHashMap_t* map, flatHashEntry_t* entries, uint32_t size, hashFunction_t hashFunc,
+                     eqFunction_t eqFunc)
+{
+    if (size < 2 || (size & (size - 1)))
+    {
+        ESP_LOGE("FlatHashMap", "Backing array size %" PRIu32 " is not a power of two", size);
+        return false;
+    }
+
+    map->entries  = entries;
+    map->mask     = size - 1;
+    map->hashFunc = hashFunc;
+    map->eqFunc   = eqFunc;
+    flatHashClear(map);
+    return true;
+}
+
+/**
+ * @brief Remove all entries from the map
+ *
+ * @param map The map to clear
+ */
+void flatHashClear(flatHashMap_t* map)
+{
+    memset(map->entries, 0, (map->mask + 1) * sizeof(flatHashEntry_t));
+    map->count = 0;
+}
+
+/**
+ * @brief Scramble a key's hash so every bit affects the slot it wants.
+ *
+ * hashString() and hashBytes() give similar keys nearby hashes, which would fill runs of adjacent slots and make
+ * linear probing slow.
+ *
+ * @param hash The hash from the map's hash function
+ * @return The scrambled hash
+ */
+static uint32_t flatHashMix(uint32_t hash)
+{
+    hash = ((hash >> 16) ^ hash) * 0x45d9f3b;
+    hash = ((hash >> 16) ^ hash) * 0x45d9f3b;
+    return (hash >> 16) ^ hash;
+}
+
+/**
+ * @brief Find the slot holding a key
+ *
+ * Runtime: O(1) average, probes stop at the first entry closer to its slot than the key would be
+ *
+ * @param map The map to search
+ * @param key The key to find
+ * @return The index of the key's slot, or a value greater than the map's mask if it isn't in the map
+ */
+static uint32_t flatHashFind(const flatHashMap_t* map, const void* key)
+{
+    uint32_t hash = flatHashMix(map->hashFunc(key));
+    uint32_t idx  = hash & map->mask;
+
+    for (uint32_t dist = 1;; dist++)
+    {
+        const flatHashEntry_t* entry = &map->entries[idx];
+
+        // An entry closer to its slot means the key would have taken this slot, so it isn't here
+        if (entry->dist < dist)
+        {
+            return UINT32_MAX;
+        }
+
+        if (entry->hash == hash && map->eqFunc(entry->key, key))
+        {
+            return idx;
+        }
+        idx = (idx + 1) & map->mask;
+    }
+}
+
+/**
+ * @brief Remove the entry at a slot, shifting following entries back so no tombstone is left
+ *
+ * @param map The map to remove from
+ * @param idx The slot to empty
+ */
+static void flatHashRemoveAt(flatHashMap_t* map, uint32_t idx)
+{
+    uint32_t next = (idx + 1) & map->mask;
+
+    // Move entries back until one is empty or already in its own slot
+    while (map->entries[next].dist > 1)
+    {
+        map->entries[idx] = map->entries[next];
+        map->entries[idx].dist--;
+        idx  = next;
+        next = (next + 1) & map->mask;
+    }
+
+    memset(&map->entries[idx], 0, sizeof(flatHashEntry_t));
+    map->count--;
+}
+
+/**
+ * @brief Create or update a key-value pair in the map
+ *
+ * Runtime: O(1) average
+ *
+ * @param map The map to update
+ * @param key The key to associate the value with. It must stay valid while it is in the map
+ * @param value The value to add to the map
+ * @return true if the value was stored, false if the key was new and the map is full
+ */
+bool flatHashPutBin(flatHashMap_t* map, const void* key, void* value)
+{
+    flatHashEntry_t carry = {
+        .key   = key,
+        .value = value,
+        .hash  = flatHashMix(map->hashFunc(key)),
+        .dist  = 1,
+    };
+    uint32_t idx = carry.hash & map->mask;
+    bool isNew   = false;
+
+    while (true)
+    {
+        flatHashEntry_t* entry = &map->entries[idx];
+
+        if (!isNew)
+        {
+            // Until the key is known to be new, check for it
+            if (entry->dist != 0 && entry->hash == carry.hash && map->eqFunc(entry->key, key))
+            {
+                entry->value = value;
+                return true;
+            }
+
+            // Reaching an empty slot or an entry closer to its slot means the key isn't in the map
+            if (entry->dist < carry.dist)
+            {
+                if ((uint32_t)map->count >= map->mask)
+                {
+                    return false;
+                }
+                isNew = true;
+                map->count++;
+            }
+        }
+
+        if (0 == entry->dist)
+        {
+            *entry = carry;
+            return true;
+        }
+
+        // Take the place of an entry closer to its slot, and keep probing with that one
+        if (entry->dist < carry.dist)
+        {
+            flatHashEntry_t swap = *entry;
+            *entry               = carry;
+            carry                = swap;
+        }
+
+        idx = (idx + 1) & map->mask;
+        carry.dist++;
+    }
+}
+
+/**
+ * @brief Return the value in the map associated with the given key
+ *
+ * Runtime: O(1) average
+ *
+ * @param map The map to search
+ * @param key The key to retrieve the value for
+ * @return The value associated with the key, or NULL if it isn't in the map
+ */
+void* flatHashGetBin(flatHashMap_t* map, const void* key)
+{
+    uint32_t idx = flatHashFind(map, key);
+    return (idx <= map->mask) ? map->entries[idx].value : NULL;
+}
+
+/**
+ * @brief Remove the value associated with the given key from the map
+ *
+ * Runtime: O(1) average
+ *
+ * @param map The map to remove from
+ * @param key The key to remove
+ * @return The value which was removed, or NULL if the key wasn't in the map
+ */
+void* flatHashRemoveBin(flatHashMap_t* map, const void* key)
+{
+    uint32_t idx = flatHashFind(map, key);
+    if (idx > map->mask)
+    {
+        return NULL;
+    }
+
+    void* value = map->entries[idx].value;
+    flatHashRemoveAt(map, idx);
+    return value;
+}
+
+/**
+ * @brief Create or update a key-value pair in a map with string keys
+ *
+ * @param map The map to update
+ * @param key The string key to associate the value with
+ * @param value The value to add to the map
+ * @return true if the value was stored, false if the key was new and the map is full
+ */
+bool flatHashPut(flatHashMap_t* map, const char* key, void* value)
+{
+    return flatHashPutBin(map, key, value);
+}
+
+/**
+ * @brief Return the value in a map with string keys associated with the given key
+ *
+ * @param map The map to search
+ * @param key The string key to retrieve the value for
+ * @return The value associated with the key, or NULL if it isn't in the map
+ */
+void* flatHashGet(flatHashMap_t* map, const char* key)
+{
+    return flatHashGetBin(map, key);
+}
+
+/**
+ * @brief Remove the value associated with the given key from a map with string keys
+ *
+ * @param map The map to remove from
+ * @param key The string key to remove
+ * @return The value which was removed, or NULL if the key wasn't in the map
+ */
+void* flatHashRemove(flatHashMap_t* map, const char* key)
+{
+    return flatHashRemoveBin(map, key);
+}
+
+/**
+ * @brief Advance an iterator to the next entry in the map
+ *
+ * Slots are visited backwards, starting just before an empty slot. Removing an entry only shifts entries which were
+ * already visited, so flatHashIterRemove() never causes an entry to be skipped or visited twice. The map must not be
+ * otherwise modified during iteration.
+ *
+ * @param map The map to iterate over
+ * @param iter The iterator, which must be zeroed before the first call
+ * @return true if \c iter now holds an entry, false if iteration is done and the iterator was reset
+ */
+bool flatHashIterate(const flatHashMap_t* map, flatHashIterator_t* iter)
+{
+    if (0 == iter->_step)
+    {
+        if (0 == map->count)
+        {
+            return false;
+        }
+
+        // There is always an empty slot, start from there
+        uint32_t start = 0;
+        while (0 != map->entries[start].dist)
+        {
+            start++;
+        }
+        iter->_start = start;
+    }
+
+    while (iter->_step <= map->mask)
+    {
+        iter->_step++;
+        const flatHashEntry_t* entry = &map->entries[(iter->_start - iter->_step) & map->mask];
+        if (0 != entry->dist)
+        {
+            iter->key   = entry->key;
+            iter->value = entry->value;
+            return true;
+        }
+    }
+
+    flatHashIterReset(iter);
+    return false;
+}
+
+/**
+ * @brief Remove the iterator's current entry from the map. Iteration continues normally afterwards
+ *
+ * @param map The map being iterated over
+ * @param iter The iterator, which must hold an entry
+ */
+void flatHashIterRemove(flatHashMap_t* map, flatHashIterator_t* iter)
+{
+    if (0 != iter->_step)
+    {
+        uint32_t idx = (iter->_start - iter->_step) & map->mask;
+        if (0 != map->entries[idx].dist)
+        {
+            flatHashRemoveAt(map, idx);
+        }
+    }
+}
+
+/**
+ * @brief Reset an iterator so the next flatHashIterate() starts from the beginning
+ *
+ * @param iter The iterator to reset
+ */
+void flatHashIterReset(flatHashIterator_t* iter)
+{
+    memset(iter, 0, sizeof(flatHashIterator_t));
+}
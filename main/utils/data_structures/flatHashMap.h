@@ -0,0 +1,129 @@
+/*!
+ * \file flatHashMap.h
+ * \brief An allocation-free, open-addressing map for storing arbitrary key-value pairs
+ *
+ * \section flatHashMap_design Design Philosophy
+ *
+ * ::hashMap_t stores colliding entries in a heap-allocated ::list_t in each bucket, so collisions allocate memory and
+ * lookups chase pointers. This map stores every entry inline in one flat array which the caller provides, so it never
+ * allocates memory and probes run through adjacent memory.
+ *
+ * Collisions are resolved with Robin Hood linear probing. Each entry remembers how far it is from the slot its hash
+ * wants. When inserting, an entry which is further from its slot takes the place of one which is closer, and the
+ * closer one continues probing. This keeps probe lengths short and even, and lets a lookup stop as soon as it finds an
+ * entry closer to its slot than the key being searched for would be.
+ *
+ * Removal uses backward shifting instead of tombstones. Entries after the removed one are moved back a slot until an
+ * empty slot or an entry in its own slot is reached. Removing entries never makes later lookups slower.
+ *
+ * The map never resizes. The backing array's size must be a power of two, and the map holds at most one fewer entry
+ * than that. Lookups stay fast up to about 80% full, so size the array with some headroom.
+ *
+ * Like ::hashMap_t, the map keeps a reference to each key rather than copying it, so keys must stay valid and
+ * unmodified while they are in the map. The same hash and equality functions work with both maps.
+ *
+ * \section flatHashMap_usage Usage
+ *
+ * flatHashInit() sets up a map with string keys in a caller-supplied array of ::flatHashEntry_t.
+ * flatHashInitBin() does the same with custom hash and equality functions.
+ *
+ * flatHashPut() adds a new entry or updates the value of an existing one. It returns false if the map is full.
+ *
+ * flatHashGet() retrieves a value from the map.
+ *
+ * flatHashRemove() removes an entry from the map by its key.
+ *
+ * flatHashClear() removes all entries. There is nothing to deinitialize, the caller owns the array.
+ *
+ * flatHashIterate() loops over the map's entries. flatHashIterRemove() removes the current entry while iterating.
+ * flatHashIterReset() resets an iterator if iteration stopped before flatHashIterate() returned false.
+ *
+ * flatHashPutBin(), flatHashGetBin(), and flatHashRemoveBin() accept a \c void* key rather than a string.
+ *
+ * \section flatHashMap_example Example
+ *
+ * \code{.c}
+ * // The backing array, which must have a power of two size
+ * static flatHashEntry_t entries[64];
+ * static flatHashMap_t map;
+ *
+ * flatHashInit(&map, entries, ARRAY_SIZE(entries));
+ *
+ * flatHashPut(&map, "greeting", "Hello");
+ * flatHashPut(&map, "name", "King Donut");
+ * // Prints 'Hello! Your name is King Donut!'
+ * printf("%s! Your name is %s!\n", (const char*)flatHashGet(&map, "greeting"), (const char*)flatHashGet(&map, "name"));
+ *
+ * // Iterate over all entries
+ * flatHashIterator_t iter = {0};
+ * while (flatHashIterate(&map, &iter))
+ * {
+ *     printf("%s: %s\n", (const char*)iter.key, (const char*)iter.value);
+ * }
+ *
+ * // Remove everything
+ * flatHashClear(&map);
+ * \endcode
+ */
+#ifndef _FLAT_HASH_MAP_H_
+#define _FLAT_HASH_MAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hashMap.h"
+
+/**
+ * @brief A single slot in a ::flatHashMap_t's backing array
+ */
+typedef struct
+{
+    const void* key; ///< The key of this entry
+    void* value;     ///< The value of this entry
+    uint32_t hash;   ///< The scrambled hash of the key
+    uint32_t dist;   ///< One more than the distance from the slot the hash wants, or 0 if this slot is empty
+} flatHashEntry_t;
+
+/**
+ * @brief An open-addressing hash map backed by a caller-supplied array
+ */
+typedef struct
+{
+    flatHashEntry_t* entries; ///< The backing array of entries
+    uint32_t mask;            ///< The size of the backing array minus one
+    int count;                ///< The number of entries in the map
+    hashFunction_t hashFunc;  ///< The key hash function
+    eqFunction_t eqFunc;      ///< The key equality function
+} flatHashMap_t;
+
+/**
+ * @brief Struct used for iterating through a ::flatHashMap_t. Initialize it to zero before the first
+ * flatHashIterate()
+ */
+typedef struct
+{
+    const void* key; ///< The key of the current entry
+    void* value;     ///< The value of the current entry
+
+    uint32_t _start; ///< @internal The slot iteration started from
+    uint32_t _step;  ///< @internal The number of slots visited, or 0 if iteration hasn't started
+} flatHashIterator_t;
+
+bool flatHashInit(flatHashMap_t* map, flatHashEntry_t* entries, uint32_t size);
+bool flatHashInitBin(flatHashMap_t* map, flatHashEntry_t* entries, uint32_t size, hashFunction_t hashFunc,
+                     eqFunction_t eqFunc);
+void flatHashClear(flatHashMap_t* map);
+
+bool flatHashPut(flatHashMap_t* map, const char* key, void* value);
+void* flatHashGet(flatHashMap_t* map, const char* key);
+void* flatHashRemove(flatHashMap_t* map, const char* key);
+
+bool flatHashPutBin(flatHashMap_t* map, const void* key, void* value);
+void* flatHashGetBin(flatHashMap_t* map, const void* key);
+void* flatHashRemoveBin(flatHashMap_t* map, const void* key);
+
+bool flatHashIterate(const flatHashMap_t* map, flatHashIterator_t* iter);
+void flatHashIterRemove(flatHashMap_t* map, flatHashIterator_t* iter);
+void flatHashIterReset(flatHashIterator_t* iter);
+
+#endif
@@ -190,7 +190,9 @@ static hashNode_t* hashFindNode(hashMap_t* map, const void* key, uint32_t* hashO
 
     if (bucket->hasMulti)
     {
-        node = bucket->multi.first->val;
+        // Removing needs the list node even when the first entry matches
+        listNodeOut = bucket->multi.first;
+        node        = listNodeOut->val;
     }
     else
     {
@@ -200,7 +202,8 @@ static hashNode_t* hashFindNode(hashMap_t* map, const void* key, uint32_t* hashO
     if (node->key != NULL && (node->hash != hash || !eqFn(node->key, key)))
     {
         // Node doesn't match!
-        node = NULL;
+        node        = NULL;
+        listNodeOut = NULL;
 
         if (bucket->hasMulti)
         {
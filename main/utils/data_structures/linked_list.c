@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include <esp_log.h>
 #include <esp_random.h>
@@ -22,14 +23,43 @@
     #define VALIDATE_LIST(func, line, nl, list, target)
 #endif
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A slab of nodes for a ::listPool_t. Free nodes are singly linked through their \c next pointers
+ */
+typedef struct listPoolSlab
+{
+    struct listPoolSlab* next; ///< The next slab in the pool
+    node_t* freeNodes;         ///< The first free node in this slab, or NULL if all nodes are in use
+    uint16_t used;             ///< The number of nodes in use from this slab
+    node_t nodes[];            ///< The nodes in this slab
+} listPoolSlab_t;
+
 //==============================================================================
 // Function Prototypes
 //==============================================================================
 
+static node_t* allocNode(list_t* list);
+static void freeNode(list_t* list, node_t* node);
+static listPoolSlab_t* findSlab(listPool_t* pool, node_t* node);
+static bool freePoolNode(listPool_t* pool, node_t* node);
+
 #ifdef TEST_LIST
 static void validateList(const char* func, int line, bool nl, list_t* list, node_t* target);
 #endif
 
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The pool used by lists without their own pool, or NULL to allocate their nodes from the heap
+static listPool_t* defaultPool = NULL;
+/// All initialized pools, linked through ::listPool_t.nextPool
+static listPool_t* allPools = NULL;
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -43,7 +73,7 @@ static void validateList(const char* func, int line, bool nl, list_t* list, node
 void push(list_t* list, void* val)
 {
     VALIDATE_LIST(__func__, __LINE__, true, list, val);
-    node_t* newLast = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    node_t* newLast = allocNode(list);
     newLast->val    = val;
     newLast->next   = NULL;
     newLast->prev   = list->last;
@@ -94,7 +124,7 @@ void* pop(list_t* list)
 
         // Get the last node val, then free it and update length
         retval = target->val;
-        heap_caps_free(target);
+        freeNode(list, target);
         list->length--;
     }
 
@@ -111,7 +141,7 @@ void* pop(list_t* list)
 void unshift(list_t* list, void* val)
 {
     VALIDATE_LIST(__func__, __LINE__, true, list, val);
-    node_t* newFirst = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    node_t* newFirst = allocNode(list);
     newFirst->val    = val;
     newFirst->next   = list->first;
     newFirst->prev   = NULL;
@@ -162,7 +192,7 @@ void* shift(list_t* list)
 
         // Get the first node val, then free it and update length
         retval = target->val;
-        heap_caps_free(target);
+        freeNode(list, target);
         list->length--;
     }
 
@@ -194,7 +224,7 @@ bool addIdx(list_t* list, void* val, uint16_t index)
     // Else if the index we're trying to add to is before the end of the list
     else if (index < list->length - 1)
     {
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        node_t* newNode = allocNode(list);
         newNode->val    = val;
         newNode->next   = NULL;
         newNode->prev   = NULL;
@@ -249,7 +279,7 @@ void addBefore(list_t* list, void* val, node_t* entry)
     else
     {
         node_t* prev    = entry->prev;
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        node_t* newNode = allocNode(list);
         newNode->val    = val;
         newNode->prev   = prev;
         newNode->next   = entry;
@@ -288,7 +318,7 @@ void addAfter(list_t* list, void* val, node_t* entry)
     else
     {
         node_t* next    = entry->next;
-        node_t* newNode = heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        node_t* newNode = allocNode(list);
         newNode->val    = val;
         newNode->prev   = entry;
         newNode->next   = next;
@@ -382,7 +412,7 @@ void* removeIdx(list_t* list, uint16_t index)
         current->next       = target->next;
         current->next->prev = current;
 
-        heap_caps_free(target);
+        freeNode(list, target);
         target = NULL;
 
         list->length--;
@@ -449,7 +479,7 @@ void* removeEntry(list_t* list, node_t* entry)
     VALIDATE_LIST(__func__, __LINE__, false, list, entry);
 
     // free the memory
-    heap_caps_free(entry);
+    freeNode(list, entry);
 
     // Return the value
     return retVal;
@@ -527,6 +557,300 @@ node_t* getNextWraparound(list_t* list, node_t* node)
     return NULL;
 }
 
+/**
+ * @brief Allocate a node for a list, from its pool, the default pool, or the heap
+ *
+ * @param list The list the node will be added to
+ * @return The new node, with no fields set
+ */
+static node_t* allocNode(list_t* list)
+{
+    listPool_t* pool = (NULL != list->pool) ? list->pool : defaultPool;
+    if (NULL == pool)
+    {
+        return heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+    }
+
+    // Find a slab with a free node, starting with the one which most recently had one
+    listPoolSlab_t* slab = pool->hint;
+    if (NULL == slab || NULL == slab->freeNodes)
+    {
+        slab = pool->slabs;
+        while (NULL != slab && NULL == slab->freeNodes)
+        {
+            slab = slab->next;
+        }
+    }
+
+    // All slabs are full, so allocate another
+    if (NULL == slab)
+    {
+        slab = heap_caps_malloc(sizeof(listPoolSlab_t) + (pool->nodesPerSlab * sizeof(node_t)), pool->caps);
+        if (NULL == slab)
+        {
+            // Fall back to the heap rather than failing the list operation
+            pool->stats.heapAllocs++;
+            return heap_caps_malloc(sizeof(node_t), MALLOC_CAP_8BIT);
+        }
+
+        // Link every node in the slab into its free list
+        for (uint16_t idx = 0; idx < pool->nodesPerSlab - 1; idx++)
+        {
+            slab->nodes[idx].next = &slab->nodes[idx + 1];
+        }
+        slab->nodes[pool->nodesPerSlab - 1].next = NULL;
+        slab->freeNodes                          = slab->nodes;
+        slab->used                               = 0;
+
+        // Add it to the pool
+        slab->next  = pool->slabs;
+        pool->slabs = slab;
+        pool->stats.slabs++;
+        pool->stats.slabAllocs++;
+        pool->stats.capacity += pool->nodesPerSlab;
+    }
+
+    // Take the first free node
+    node_t* node    = slab->freeNodes;
+    slab->freeNodes = node->next;
+    slab->used++;
+    pool->hint = slab;
+
+    pool->stats.allocs++;
+    pool->stats.inUse++;
+    if (pool->stats.inUse > pool->stats.peakInUse)
+    {
+        pool->stats.peakInUse = pool->stats.inUse;
+    }
+    return node;
+}
+
+/**
+ * @brief Free a node which was removed from a list, returning it to whichever pool it came from
+ *
+ * @param list The list the node was removed from
+ * @param node The node to free
+ */
+static void freeNode(list_t* list, node_t* node)
+{
+    // Most nodes come from the list's own pool
+    listPool_t* pool = (NULL != list->pool) ? list->pool : defaultPool;
+    if (NULL != pool && freePoolNode(pool, node))
+    {
+        return;
+    }
+
+    // The node may be from a different pool, i.e. if it was added before the list's pool was changed
+    for (listPool_t* other = allPools; NULL != other; other = other->nextPool)
+    {
+        if (other != pool && freePoolNode(other, node))
+        {
+            return;
+        }
+    }
+
+    // Not from any pool, so it came from the heap
+    heap_caps_free(node);
+}
+
+/**
+ * @brief Find the slab in a pool which a node was allocated from
+ *
+ * @param pool The pool to search
+ * @param node The node to find
+ * @return The slab which owns the node, or NULL if the node isn't from this pool
+ */
+static listPoolSlab_t* findSlab(listPool_t* pool, node_t* node)
+{
+    uintptr_t addr      = (uintptr_t)node;
+    uintptr_t slabBytes = pool->nodesPerSlab * sizeof(node_t);
+
+    // Nodes are usually freed near where they were allocated, so check the hint first
+    listPoolSlab_t* hint = pool->hint;
+    if (NULL != hint && addr >= (uintptr_t)hint->nodes && addr < (uintptr_t)hint->nodes + slabBytes)
+    {
+        return hint;
+    }
+
+    for (listPoolSlab_t* slab = pool->slabs; NULL != slab; slab = slab->next)
+    {
+        if (addr >= (uintptr_t)slab->nodes && addr < (uintptr_t)slab->nodes + slabBytes)
+        {
+            return slab;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Return a node to a pool, if it was allocated from that pool
+ *
+ * @param pool The pool to return the node to
+ * @param node The node to return
+ * @return true if the node was from this pool and was returned, false if it isn't from this pool
+ */
+static bool freePoolNode(listPool_t* pool, node_t* node)
+{
+    listPoolSlab_t* slab = findSlab(pool, node);
+    if (NULL == slab)
+    {
+        return false;
+    }
+
+    node->next      = slab->freeNodes;
+    slab->freeNodes = node;
+    slab->used--;
+    pool->hint = slab;
+
+    pool->stats.frees++;
+    pool->stats.inUse--;
+    return true;
+}
+
+/**
+ * @brief Initialize a pool of list nodes. Slabs are allocated as nodes are needed, not here. If the pool is already
+ * initialized, it is left unchanged
+ *
+ * @param pool The pool to initialize
+ * @param nodesPerSlab The number of nodes to allocate at a time, must be at least one
+ * @param caps The heap_caps flags to allocate slabs with, i.e. ::MALLOC_CAP_INTERNAL
+ * @return true if the pool is initialized, false if \c nodesPerSlab was invalid
+ */
+bool initListPool(listPool_t* pool, uint16_t nodesPerSlab, uint32_t caps)
+{
+    if (0 == nodesPerSlab)
+    {
+        ESP_LOGE("List", "A list pool needs at least one node per slab");
+        return false;
+    }
+
+    for (listPool_t* other = allPools; NULL != other; other = other->nextPool)
+    {
+        if (other == pool)
+        {
+            return true;
+        }
+    }
+
+    memset(pool, 0, sizeof(listPool_t));
+    pool->nodesPerSlab = nodesPerSlab;
+    pool->caps         = caps;
+
+    pool->nextPool = allPools;
+    allPools       = pool;
+    return true;
+}
+
+/**
+ * @brief Free all slabs in a pool. Every list using the pool must be cleared first, or it will be left with freed
+ * nodes. If this is the default pool, lists go back to allocating nodes from the heap
+ *
+ * @param pool The pool to deinitialize
+ */
+void deinitListPool(listPool_t* pool)
+{
+    if (pool->stats.inUse > 0)
+    {
+        ESP_LOGW("List", "Freeing a list pool with %" PRIu32 " nodes in use", pool->stats.inUse);
+    }
+
+    while (NULL != pool->slabs)
+    {
+        listPoolSlab_t* next = pool->slabs->next;
+        heap_caps_free(pool->slabs);
+        pool->slabs = next;
+    }
+
+    // Stop finding nodes in this pool
+    for (listPool_t** other = &allPools; NULL != *other; other = &(*other)->nextPool)
+    {
+        if (*other == pool)
+        {
+            *other = pool->nextPool;
+            break;
+        }
+    }
+    if (defaultPool == pool)
+    {
+        defaultPool = NULL;
+    }
+
+    memset(pool, 0, sizeof(listPool_t));
+}
+
+/**
+ * @brief Free every slab in a pool which has no nodes in use
+ *
+ * @param pool The pool to trim
+ */
+void trimListPool(listPool_t* pool)
+{
+    listPoolSlab_t** slab = &pool->slabs;
+    while (NULL != *slab)
+    {
+        if (0 == (*slab)->used)
+        {
+            listPoolSlab_t* empty = *slab;
+            *slab                 = empty->next;
+            heap_caps_free(empty);
+
+            pool->stats.slabs--;
+            pool->stats.capacity -= pool->nodesPerSlab;
+        }
+        else
+        {
+            slab = &(*slab)->next;
+        }
+    }
+    pool->hint = pool->slabs;
+}
+
+/**
+ * @brief Set the pool used by lists which don't have their own ::list_t.pool. Nodes already allocated are still
+ * freed to wherever they came from
+ *
+ * @param pool An initialized pool, or NULL to allocate nodes from the heap
+ */
+void setDefaultListPool(listPool_t* pool)
+{
+    defaultPool = pool;
+}
+
+/**
+ * @brief Get the pool used by lists which don't have their own ::list_t.pool
+ *
+ * @return The default pool, or NULL if nodes are allocated from the heap
+ */
+listPool_t* getDefaultListPool(void)
+{
+    return defaultPool;
+}
+
+/**
+ * @brief Get allocation statistics for a pool
+ *
+ * @param pool The pool to get statistics for
+ * @param stats Written with the pool's statistics
+ */
+void getListPoolStats(const listPool_t* pool, listPoolStats_t* stats)
+{
+    *stats = pool->stats;
+}
+
+/**
+ * @brief Reset the cumulative statistics for a pool. The peak is reset to the number of nodes currently in use
+ *
+ * @param pool The pool to reset statistics for
+ */
+void resetListPoolStats(listPool_t* pool)
+{
+    pool->stats.peakInUse  = pool->stats.inUse;
+    pool->stats.allocs     = 0;
+    pool->stats.frees      = 0;
+    pool->stats.slabAllocs = 0;
+    pool->stats.heapAllocs = 0;
+}
+
 #ifdef TEST_LIST
 
 /**
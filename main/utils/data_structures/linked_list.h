@@ -21,6 +21,21 @@
  *
  * Links are allocated, so when done with a list, be sure to call clear() when done.
  *
+ * \section linked_list_pools Node Pools
+ *
+ * Allocating every node with heap_caps_malloc() is slow and fragments the heap when lists grow and shrink often. A
+ * ::listPool_t allocates nodes in fixed-size slabs instead, and keeps freed nodes on a free list to be reused.
+ *
+ * A list allocates its nodes from the pool in ::list_t.pool. If that is NULL, the default pool set with
+ * setDefaultListPool() is used. If there is no default pool, nodes are allocated from the heap. The system sets up a
+ * default pool at boot, so most lists use it without any changes.
+ *
+ * Empty slabs are kept for reuse until trimListPool() is called. The system trims the default pool after each mode
+ * exits. getListPoolStats() reports how many nodes are in use, the peak, and how many slabs were allocated, which is
+ * useful for picking a slab size.
+ *
+ * Pools are not thread safe. Only use lists with a pool from one task, normally the main loop.
+ *
  * \section linked_list_example Example
  *
  * Creating an empty list:
@@ -54,6 +69,23 @@
  * }
  * \endcode
  *
+ * Giving a hot list its own pool:
+ * \code{.c}
+ * static listPool_t particlePool;
+ * static list_t particles;
+ *
+ * // 64 nodes per slab, in internal RAM
+ * initListPool(&particlePool, 64, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+ * particles.pool = &particlePool;
+ *
+ * // Use the list normally
+ * push(&particles, particle);
+ *
+ * // Clear the list before freeing the pool
+ * clear(&particles);
+ * deinitListPool(&particlePool);
+ * \endcode
+ *
  * Removing values from a list:
  * \code{.c}
  * // Remove from head
@@ -69,6 +101,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/// The number of nodes in each slab of the system's default list pool
+#define LIST_POOL_DEFAULT_SLAB_NODES 32
+
 /**
  * @brief A node in a doubly linked list with pointers to the previous and next values (which may be NULL), and a \c
  * void* to arbritray data
@@ -85,11 +120,40 @@ typedef struct node
  */
 typedef struct
 {
-    node_t* first; ///< The first node in the list
-    node_t* last;  ///< The last node in the list
-    int length;    ///< The number of nodes in the list
+    node_t* first;         ///< The first node in the list
+    node_t* last;          ///< The last node in the list
+    int length;            ///< The number of nodes in the list
+    struct listPool* pool; ///< The pool to allocate nodes from, or NULL to use the default pool
 } list_t;
 
+/**
+ * @brief Allocation statistics for a ::listPool_t
+ */
+typedef struct
+{
+    uint32_t slabs;      ///< The number of slabs currently allocated
+    uint32_t capacity;   ///< The number of nodes in all currently allocated slabs
+    uint32_t inUse;      ///< The number of nodes currently allocated from slabs
+    uint32_t peakInUse;  ///< The most nodes allocated from slabs at once
+    uint32_t allocs;     ///< The number of nodes allocated from slabs
+    uint32_t frees;      ///< The number of nodes returned to slabs
+    uint32_t slabAllocs; ///< The number of slabs allocated
+    uint32_t heapAllocs; ///< The number of nodes allocated from the heap because a slab couldn't be allocated
+} listPoolStats_t;
+
+/**
+ * @brief A pool of ::node_t, allocated in fixed-size slabs, which lists may allocate their nodes from
+ */
+typedef struct listPool
+{
+    struct listPoolSlab* slabs; ///< All slabs allocated for this pool, most recent first
+    struct listPoolSlab* hint;  ///< The slab most likely to have a free node, or to own a node being freed
+    struct listPool* nextPool;  ///< The next initialized pool, used to find which pool owns a node
+    uint16_t nodesPerSlab;      ///< The number of nodes in each slab
+    uint32_t caps;              ///< The heap_caps flags to allocate slabs with
+    listPoolStats_t stats;      ///< Allocation statistics for this pool
+} listPool_t;
+
 void push(list_t* list, void* val);
 void* pop(list_t* list);
 void unshift(list_t* list, void* val);
@@ -104,6 +168,14 @@ void* removeVal(list_t* list, void* val);
 void clear(list_t* list);
 node_t* getNextWraparound(list_t* list, node_t* node);
 
+bool initListPool(listPool_t* pool, uint16_t nodesPerSlab, uint32_t caps);
+void deinitListPool(listPool_t* pool);
+void trimListPool(listPool_t* pool);
+void setDefaultListPool(listPool_t* pool);
+listPool_t* getDefaultListPool(void);
+void getListPoolStats(const listPool_t* pool, listPoolStats_t* stats);
+void resetListPoolStats(listPool_t* pool);
+
 #ifdef TEST_LIST
 // Exercise the linked list functions
 void listTester(void);
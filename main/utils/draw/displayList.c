@@ -0,0 +1,599 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include "displayList.h"
+#include "renderTarget.h"
+#include "shapes.h"
+#include "macros.h"
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/**
+ * @brief The types of commands in the display list
+ */
+typedef enum
+{
+    DL_RECT,          ///< drawRect()
+    DL_RECT_FILLED,   ///< drawRectFilled()
+    DL_LINE,          ///< drawLine()
+    DL_CIRCLE,        ///< drawCircle()
+    DL_CIRCLE_FILLED, ///< drawCircleFilled()
+    DL_WSG,           ///< drawWsg()
+    DL_WSG_SIMPLE,    ///< drawWsgSimple()
+    DL_TEXT,          ///< drawText()
+    DL_CALLBACK,      ///< A function from dlDrawCallback()
+} dlCmdType_t;
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A single command in the display list
+ */
+typedef struct
+{
+    dlCmdType_t type;     ///< What this command draws
+    paletteColor_t color; ///< The color to draw with, if this command has one
+    int16_t yMin;         ///< The first display row this command may draw to, inclusive
+    int16_t yMax;         ///< The last display row this command may draw to, inclusive
+    union
+    {
+        struct
+        {
+            int16_t x0;        ///< The first X coordinate
+            int16_t y0;        ///< The first Y coordinate
+            int16_t x1;        ///< The second X coordinate
+            int16_t y1;        ///< The second Y coordinate
+            int16_t dashWidth; ///< The dash width for lines, 0 for solid
+        } shape; ///< Parameters for rectangles and lines
+        struct
+        {
+            int16_t xm; ///< The X coordinate of the center
+            int16_t ym; ///< The Y coordinate of the center
+            int16_t r;  ///< The radius
+        } circle; ///< Parameters for circles
+        struct
+        {
+            const wsg_t* wsg;  ///< The WSG to draw
+            int16_t xOff;      ///< The X coordinate of the WSG's top left
+            int16_t yOff;      ///< The Y coordinate of the WSG's top left
+            int16_t rotateDeg; ///< The rotation in degrees, for DL_WSG
+            bool flipLR;       ///< true to flip horizontally, for DL_WSG
+            bool flipUD;       ///< true to flip vertically, for DL_WSG
+        } wsg; ///< Parameters for WSGs
+        struct
+        {
+            const font_t* font; ///< The font to draw with
+            int32_t textIdx;    ///< The index of the text in the display list's text buffer
+            int16_t xOff;       ///< The X coordinate of the text's top left
+            int16_t yOff;       ///< The Y coordinate of the text's top left
+        } text; ///< Parameters for text
+        struct
+        {
+            dlDrawFn_t fn; ///< The function to call
+            void* arg;     ///< The argument to pass to the function
+        } cb; ///< Parameters for callbacks
+    };
+} dlCmd_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool dlAddCmd(dlCmdType_t type, paletteColor_t color, int32_t yMin, int32_t yMax, dlCmd_t** cmd);
+static void dlRenderBand(paletteColor_t* px, int16_t y, int16_t h);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The commands in the display list, in the order they are drawn
+static dlCmd_t* cmds = NULL;
+/// The number of commands in cmds
+static int32_t numCmds = 0;
+/// The number of commands cmds has space for
+static int32_t maxCmds = 0;
+/// NULL-terminated text for DL_TEXT commands
+static char* textBuf = NULL;
+/// The number of bytes used in textBuf
+static int32_t textUsed = 0;
+/// The number of bytes textBuf has space for
+static int32_t textSize = 0;
+/// The color each band is filled with before commands are drawn
+static paletteColor_t bgColor = c000;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Allocate the display list and start drawing the display from it instead of the frame-buffer, which is freed.
+ * The display list starts empty with a black background.
+ *
+ * @param maxCommands The maximum number of commands which may be in the display list at once
+ * @param textBytes The maximum number of bytes of text which may be in the display list at once, including one
+ * NULL terminator per dlDrawText()
+ * @return true if the display list was started, false if it's already started or memory couldn't be allocated
+ */
+bool dlStart(int32_t maxCommands, int32_t textBytes)
+{
+    if (NULL != cmds)
+    {
+        ESP_LOGE("DL", "Display list already started");
+        return false;
+    }
+
+    cmds = (dlCmd_t*)heap_caps_calloc(maxCommands, sizeof(dlCmd_t), MALLOC_CAP_8BIT);
+    if (textBytes > 0)
+    {
+        textBuf = (char*)heap_caps_malloc(textBytes, MALLOC_CAP_8BIT);
+    }
+    if (NULL == cmds || (textBytes > 0 && NULL == textBuf))
+    {
+        ESP_LOGE("DL", "Couldn't allocate the display list");
+        heap_caps_free(cmds);
+        heap_caps_free(textBuf);
+        cmds    = NULL;
+        textBuf = NULL;
+        return false;
+    }
+
+    maxCmds  = maxCommands;
+    textSize = textBytes;
+    dlClear(c000);
+
+    // Free the frame-buffer and draw from the display list
+    if (!setBandRendererTft(dlRenderBand))
+    {
+        dlStop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stop drawing the display from the display list and free it. The frame-buffer is allocated again and is
+ * cleared to black. This does nothing if the display list isn't started.
+ */
+void dlStop(void)
+{
+    if (dlRenderBand == getBandRendererTft())
+    {
+        setBandRendererTft(NULL);
+    }
+
+    heap_caps_free(cmds);
+    heap_caps_free(textBuf);
+    cmds     = NULL;
+    textBuf  = NULL;
+    maxCmds  = 0;
+    textSize = 0;
+    numCmds  = 0;
+    textUsed = 0;
+}
+
+/**
+ * @brief Check if the display list is started
+ *
+ * @return true if dlStart() was called without a matching dlStop()
+ */
+bool dlIsStarted(void)
+{
+    return NULL != cmds;
+}
+
+/**
+ * @brief Remove every command from the display list and set the background color
+ *
+ * @param bg The color to fill the display with before any commands are drawn
+ */
+void dlClear(paletteColor_t bg)
+{
+    numCmds  = 0;
+    textUsed = 0;
+    bgColor  = (cTransparent == bg) ? c000 : bg;
+}
+
+/**
+ * @brief Add a command to the end of the display list
+ *
+ * @param type The type of command
+ * @param color The color the command draws with
+ * @param yMin The first display row the command may draw to, inclusive
+ * @param yMax The last display row the command may draw to, inclusive
+ * @param[out] cmd Set to the command to fill in parameters for, or NULL if it's entirely off the display
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+static bool dlAddCmd(dlCmdType_t type, paletteColor_t color, int32_t yMin, int32_t yMax, dlCmd_t** cmd)
+{
+    *cmd = NULL;
+
+    // Commands which can't touch the display are dropped rather than culled in every band
+    if (yMax < 0 || yMin >= TFT_HEIGHT)
+    {
+        return true;
+    }
+
+    if (numCmds >= maxCmds)
+    {
+        ESP_LOGW("DL", "Display list is full");
+        return false;
+    }
+
+    *cmd          = &cmds[numCmds++];
+    (*cmd)->type  = type;
+    (*cmd)->color = color;
+    (*cmd)->yMin  = MAX(yMin, 0);
+    (*cmd)->yMax  = MIN(yMax, TFT_HEIGHT - 1);
+    return true;
+}
+
+/**
+ * @brief Add a rectangle outline to the display list, drawn like drawRect()
+ *
+ * @param x0 The X coordinate of the first corner
+ * @param y0 The Y coordinate of the first corner
+ * @param x1 The X coordinate of the second corner
+ * @param y1 The Y coordinate of the second corner
+ * @param col The color to draw
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_RECT, col, MIN(y0, y1), MAX(y0, y1), &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->shape.x0 = x0;
+        cmd->shape.y0 = y0;
+        cmd->shape.x1 = x1;
+        cmd->shape.y1 = y1;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a filled rectangle to the display list, drawn like drawRectFilled()
+ *
+ * @param x0 The X coordinate of the first corner
+ * @param y0 The Y coordinate of the first corner
+ * @param x1 The X coordinate of the second corner
+ * @param y1 The Y coordinate of the second corner
+ * @param col The color to draw
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawRectFilled(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_RECT_FILLED, col, MIN(y0, y1), MAX(y0, y1), &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->shape.x0 = x0;
+        cmd->shape.y0 = y0;
+        cmd->shape.x1 = x1;
+        cmd->shape.y1 = y1;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a line to the display list, drawn like drawLine()
+ *
+ * @param x0 The X coordinate of the start of the line
+ * @param y0 The Y coordinate of the start of the line
+ * @param x1 The X coordinate of the end of the line
+ * @param y1 The Y coordinate of the end of the line
+ * @param col The color to draw
+ * @param dashWidth The width of each dash, or 0 for a solid line
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col, int16_t dashWidth)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_LINE, col, MIN(y0, y1), MAX(y0, y1), &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->shape.x0        = x0;
+        cmd->shape.y0        = y0;
+        cmd->shape.x1        = x1;
+        cmd->shape.y1        = y1;
+        cmd->shape.dashWidth = dashWidth;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a circle outline to the display list, drawn like drawCircle()
+ *
+ * @param xm The X coordinate of the center
+ * @param ym The Y coordinate of the center
+ * @param r The radius
+ * @param col The color to draw
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawCircle(int16_t xm, int16_t ym, int16_t r, paletteColor_t col)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_CIRCLE, col, ym - r, ym + r, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->circle.xm = xm;
+        cmd->circle.ym = ym;
+        cmd->circle.r  = r;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a filled circle to the display list, drawn like drawCircleFilled()
+ *
+ * @param xm The X coordinate of the center
+ * @param ym The Y coordinate of the center
+ * @param r The radius
+ * @param col The color to draw
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawCircleFilled(int16_t xm, int16_t ym, int16_t r, paletteColor_t col)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_CIRCLE_FILLED, col, ym - r, ym + r, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->circle.xm = xm;
+        cmd->circle.ym = ym;
+        cmd->circle.r  = r;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a WSG to the display list, drawn like drawWsg(). The WSG is not copied and must not be freed until the
+ * display list is cleared
+ *
+ * @param wsg The WSG to draw
+ * @param xOff The X coordinate to draw the WSG at
+ * @param yOff The Y coordinate to draw the WSG at
+ * @param flipLR true to flip the WSG horizontally
+ * @param flipUD true to flip the WSG vertically
+ * @param rotateDeg The number of degrees to rotate the WSG clockwise, around its center
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawWsg(const wsg_t* wsg, int16_t xOff, int16_t yOff, bool flipLR, bool flipUD, int16_t rotateDeg)
+{
+    if (NULL == wsg)
+    {
+        return true;
+    }
+
+    // A rotated WSG stays within half of its width plus height from its center
+    int32_t yMin = yOff;
+    int32_t yMax = yOff + wsg->h - 1;
+    if (0 != rotateDeg % 360)
+    {
+        yMin = yOff - (wsg->w / 2) - 1;
+        yMax = yOff + wsg->h + (wsg->w / 2) + 1;
+    }
+
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_WSG, c000, yMin, yMax, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->wsg.wsg       = wsg;
+        cmd->wsg.xOff      = xOff;
+        cmd->wsg.yOff      = yOff;
+        cmd->wsg.rotateDeg = rotateDeg;
+        cmd->wsg.flipLR    = flipLR;
+        cmd->wsg.flipUD    = flipUD;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a WSG to the display list, drawn like drawWsgSimple(). The WSG is not copied and must not be freed until
+ * the display list is cleared
+ *
+ * @param wsg The WSG to draw
+ * @param xOff The X coordinate to draw the WSG at
+ * @param yOff The Y coordinate to draw the WSG at
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff)
+{
+    if (NULL == wsg)
+    {
+        return true;
+    }
+
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_WSG_SIMPLE, c000, yOff, yOff + wsg->h - 1, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->wsg.wsg  = wsg;
+        cmd->wsg.xOff = xOff;
+        cmd->wsg.yOff = yOff;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a line of text to the display list, drawn like drawText(). The text is copied, but the font is not and
+ * must not be freed until the display list is cleared
+ *
+ * @param font The font to draw with
+ * @param color The color of the text
+ * @param text The text to draw
+ * @param xOff The X coordinate to draw the text at
+ * @param yOff The Y coordinate to draw the text at
+ * @return true if the command was added or is off the display, false if the display list or its text buffer is full
+ */
+bool dlDrawText(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff)
+{
+    int32_t len = strlen(text) + 1;
+    if (textUsed + len > textSize)
+    {
+        ESP_LOGW("DL", "Display list text buffer is full");
+        return false;
+    }
+
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_TEXT, color, yOff, yOff + font->height, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        memcpy(&textBuf[textUsed], text, len);
+        cmd->text.font    = font;
+        cmd->text.textIdx = textUsed;
+        cmd->text.xOff    = xOff;
+        cmd->text.yOff    = yOff;
+        textUsed += len;
+    }
+    return true;
+}
+
+/**
+ * @brief Add a function to the display list which draws anything else. It is called once for each band between yMin
+ * and yMax while the band is the render target, so it may use any drawing function, but must subtract the band's
+ * starting row from every y coordinate it draws at.
+ *
+ * @param fn The function to call
+ * @param arg An argument to pass to the function
+ * @param yMin The first display row the function draws to, inclusive
+ * @param yMax The last display row the function draws to, inclusive
+ * @return true if the command was added or is off the display, false if the display list is full
+ */
+bool dlDrawCallback(dlDrawFn_t fn, void* arg, int16_t yMin, int16_t yMax)
+{
+    dlCmd_t* cmd;
+    if (!dlAddCmd(DL_CALLBACK, c000, yMin, yMax, &cmd))
+    {
+        return false;
+    }
+    if (NULL != cmd)
+    {
+        cmd->cb.fn  = fn;
+        cmd->cb.arg = arg;
+    }
+    return true;
+}
+
+/**
+ * @brief Draw one band of the display from the display list. This is the ::fnBandRenderCallback_t given to
+ * setBandRendererTft()
+ *
+ * @param px The band's pixels, TFT_WIDTH wide and h tall
+ * @param y The display row the band starts at
+ * @param h The number of rows in the band
+ */
+static void dlRenderBand(paletteColor_t* px, int16_t y, int16_t h)
+{
+    memset(px, bgColor, sizeof(paletteColor_t) * TFT_WIDTH * h);
+
+    // Draw into the band, clipped to it, with every command moved up by the band's starting row
+    wsg_t band = {
+        .px = px,
+        .w  = TFT_WIDTH,
+        .h  = h,
+    };
+    if (!pushRenderTarget(&band))
+    {
+        return;
+    }
+
+    int16_t yEnd = y + h;
+    for (int32_t i = 0; i < numCmds; i++)
+    {
+        const dlCmd_t* cmd = &cmds[i];
+
+        // Skip commands which don't touch this band
+        if (cmd->yMax < y || cmd->yMin >= yEnd)
+        {
+            continue;
+        }
+
+        switch (cmd->type)
+        {
+            case DL_RECT:
+            {
+                drawRect(cmd->shape.x0, cmd->shape.y0 - y, cmd->shape.x1, cmd->shape.y1 - y, cmd->color);
+                break;
+            }
+            case DL_RECT_FILLED:
+            {
+                drawRectFilled(cmd->shape.x0, cmd->shape.y0 - y, cmd->shape.x1, cmd->shape.y1 - y, cmd->color);
+                break;
+            }
+            case DL_LINE:
+            {
+                drawLine(cmd->shape.x0, cmd->shape.y0 - y, cmd->shape.x1, cmd->shape.y1 - y, cmd->color,
+                         cmd->shape.dashWidth);
+                break;
+            }
+            case DL_CIRCLE:
+            {
+                drawCircle(cmd->circle.xm, cmd->circle.ym - y, cmd->circle.r, cmd->color);
+                break;
+            }
+            case DL_CIRCLE_FILLED:
+            {
+                drawCircleFilled(cmd->circle.xm, cmd->circle.ym - y, cmd->circle.r, cmd->color);
+                break;
+            }
+            case DL_WSG:
+            {
+                drawWsg(cmd->wsg.wsg, cmd->wsg.xOff, cmd->wsg.yOff - y, cmd->wsg.flipLR, cmd->wsg.flipUD,
+                        cmd->wsg.rotateDeg);
+                break;
+            }
+            case DL_WSG_SIMPLE:
+            {
+                drawWsgSimple(cmd->wsg.wsg, cmd->wsg.xOff, cmd->wsg.yOff - y);
+                break;
+            }
+            case DL_TEXT:
+            {
+                drawText(cmd->text.font, cmd->color, &textBuf[cmd->text.textIdx], cmd->text.xOff,
+                         cmd->text.yOff - y);
+                break;
+            }
+            case DL_CALLBACK:
+            {
+                cmd->cb.fn(cmd->cb.arg, y);
+                break;
+            }
+        }
+    }
+
+    popRenderTarget();
+}
@@ -0,0 +1,90 @@
+/*! \file displayList.h
+ *
+ * \section displayList_design Design Philosophy
+ *
+ * Normally every mode draws into the TFT's frame-buffer, which is TFT_WIDTH * TFT_HEIGHT bytes, and then the whole
+ * frame-buffer is converted and sent to the display. A display list lets a mode draw without a frame-buffer at all.
+ *
+ * Instead of drawing, the mode adds drawing commands like rectangles, lines, circles, WSGs, and text to the display
+ * list. When the display is drawn, each PARALLEL_LINES tall band is drawn into a small band buffer by running only the
+ * commands which overlap that band, right before the band is converted and sent. The frame-buffer is freed while the
+ * display list is started, so that memory is available for the mode, and drawing each band overlaps with sending the
+ * prior one.
+ *
+ * The cost is that every command which overlaps a band is run for that band, so a command spanning the whole display
+ * is run once per band. Each run is clipped to the band, so this mostly costs setup time. Modes with many small
+ * sprites and few full-screen effects benefit the most.
+ *
+ * While the display list is started, drawing functions called from the main loop draw nothing, since there is no
+ * frame-buffer to draw into. The system's exit progress bar and trophy banners are not shown, but quick settings are,
+ * by using a frame-buffer until they are closed.
+ *
+ * \section displayList_usage Usage
+ *
+ * dlStart() allocates the display list and frees the frame-buffer. dlStop() frees the display list and allocates the
+ * frame-buffer again. The display list is stopped automatically when the mode exits.
+ *
+ * dlClear() removes all commands and sets the background color. Commands stay in the display list and are drawn every
+ * frame until dlClear() is called, so a mode which draws the same thing every frame only needs to add it once.
+ *
+ * dlDrawRect(), dlDrawRectFilled(), dlDrawLine(), dlDrawCircle(), dlDrawCircleFilled(), dlDrawWsg(),
+ * dlDrawWsgSimple(), and dlDrawText() add commands which draw like drawRect(), drawRectFilled(), drawLine(),
+ * drawCircle(), drawCircleFilled(), drawWsg(), drawWsgSimple(), and drawText(). Commands are drawn in the order they
+ * were added. WSGs and fonts are not copied, so they must not be freed until the display list is cleared. Text is
+ * copied.
+ *
+ * dlDrawCallback() adds a command which calls a function to draw anything else. The function is called for each band
+ * between the given rows, and must subtract the band's starting row from every y coordinate it draws at.
+ *
+ * \section displayList_example Example
+ *
+ * \code{.c}
+ * // Start the display list when entering the mode
+ * dlStart(64, 256);
+ *
+ * // Each frame, replace the prior frame's commands
+ * dlClear(c001);
+ * dlDrawRectFilled(0, 200, TFT_WIDTH, TFT_HEIGHT, c020);
+ * dlDrawWsgSimple(&playerWsg, playerX, playerY);
+ * dlDrawText(&ibm, c555, "Score", 10, 10);
+ *
+ * // Stop the display list when done
+ * dlStop();
+ * \endcode
+ */
+
+#ifndef _DISPLAY_LIST_H_
+#define _DISPLAY_LIST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hdw-tft.h"
+#include "palette.h"
+#include "wsg.h"
+#include "font.h"
+
+/**
+ * @brief A function which draws part of the display for dlDrawCallback()
+ *
+ * @param arg The argument given to dlDrawCallback()
+ * @param bandY The display row the band starts at, which must be subtracted from every y coordinate drawn at
+ */
+typedef void (*dlDrawFn_t)(void* arg, int16_t bandY);
+
+bool dlStart(int32_t maxCommands, int32_t textBytes);
+void dlStop(void);
+bool dlIsStarted(void);
+void dlClear(paletteColor_t bg);
+
+bool dlDrawRect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col);
+bool dlDrawRectFilled(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col);
+bool dlDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t col, int16_t dashWidth);
+bool dlDrawCircle(int16_t xm, int16_t ym, int16_t r, paletteColor_t col);
+bool dlDrawCircleFilled(int16_t xm, int16_t ym, int16_t r, paletteColor_t col);
+bool dlDrawWsg(const wsg_t* wsg, int16_t xOff, int16_t yOff, bool flipLR, bool flipUD, int16_t rotateDeg);
+bool dlDrawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff);
+bool dlDrawText(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff);
+bool dlDrawCallback(dlDrawFn_t fn, void* arg, int16_t yMin, int16_t yMax);
+
+#endif
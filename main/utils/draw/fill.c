@@ -7,6 +7,7 @@
 
 #include "hdw-tft.h"
 #include "macros.h"
+#include "renderTarget.h"
 #include "shapes.h"
 #include "trigonometry.h"
 #include "fill.h"
@@ -25,7 +26,7 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
 //==============================================================================
 
 /**
- * @brief Fill a rectangular area on a display with a single color
+ * @brief Fill a rectangular area on the current render target with a single color
  *
  * @param x1 The x coordinate to start the fill (top left)
  * @param y1 The y coordinate to start the fill (top left)
@@ -39,9 +40,10 @@ void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColo
     // This function has been micro optimized by cnlohr on 2022-09-07,
     // using gcc version 8.4.0 (crosstool-NG esp-2021r2-patch3)
 
-    // Only draw on the display
-    int xMin = CLAMP(x1, 0, TFT_WIDTH);
-    int xMax = CLAMP(x2, 0, TFT_WIDTH);
+    // Only draw on the render target
+    const wsg_t* target = getRenderTarget();
+    int xMin            = CLAMP(x1, 0, target->w);
+    int xMax            = CLAMP(x2, 0, target->w);
 
     // Quick return if nothing would be drawn
     int copyLen = xMax - xMin;
@@ -50,11 +52,12 @@ void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColo
         return;
     }
 
-    int yMin = CLAMP(y1, 0, TFT_HEIGHT);
-    int yMax = CLAMP(y2, 0, TFT_HEIGHT);
+    int yMin = CLAMP(y1, 0, target->h);
+    int yMax = CLAMP(y2, 0, target->h);
+    markDirtyRowsRenderTarget(yMin, yMax);
 
-    uint32_t dw         = TFT_WIDTH;
-    paletteColor_t* pxs = getPxTftFramebuffer() + yMin * dw + xMin;
+    uint32_t dw         = target->w;
+    paletteColor_t* pxs = target->px + yMin * dw + xMin;
 
     // Set each pixel
     for (int y = yMin; y < yMax; y++)
@@ -77,6 +80,7 @@ void fillDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, paletteColo
 void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t shadeLevel, paletteColor_t color)
 {
     SETUP_FOR_TURBO();
+    const wsg_t* target = getRenderTarget();
     int16_t xMin, yMin, xMax, yMax;
     if (x1 < x2)
     {
@@ -103,11 +107,11 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
     {
         xMin = 0;
     }
-    if (xMax >= (int16_t)TFT_WIDTH)
+    if (xMax >= (int16_t)target->w)
     {
-        xMax = TFT_WIDTH - 1;
+        xMax = target->w - 1;
     }
-    if (xMin >= (int16_t)TFT_WIDTH)
+    if (xMin >= (int16_t)target->w)
     {
         return;
     }
@@ -119,11 +123,11 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
     {
         yMin = 0;
     }
-    if (yMax >= (int16_t)TFT_HEIGHT)
+    if (yMax >= (int16_t)target->h)
     {
-        yMax = TFT_HEIGHT - 1;
+        yMax = target->h - 1;
     }
-    if (yMin >= (int16_t)TFT_HEIGHT)
+    if (yMin >= (int16_t)target->h)
     {
         return;
     }
@@ -131,6 +135,7 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
     {
         return;
     }
+    markDirtyRowsRenderTarget(yMin, yMax + 1);
 
     for (int16_t dy = yMin; dy <= yMax; dy++)
     {
@@ -228,24 +233,27 @@ void shadeDisplayArea(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t sh
 void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, paletteColor_t fillColor)
 {
     SETUP_FOR_TURBO();
+    const wsg_t* target = getRenderTarget();
 
     // Adjust the bounding box if it's out of bounds
     if (x0 < 0)
     {
         x0 = 0;
     }
-    if (x1 > TFT_WIDTH)
+    if (x1 > target->w)
     {
-        x1 = TFT_WIDTH;
+        x1 = target->w;
     }
     if (y0 < 0)
     {
         y0 = 0;
     }
-    if (y1 > TFT_HEIGHT)
+    if (y1 > target->h)
     {
-        y1 = TFT_HEIGHT;
+        y1 = target->h;
     }
+    markDirtyRowsRenderTarget(y0, y1);
+
     for (int y = y0; y < y1; y++)
     {
         // Assume starting outside the shape or on border for each row
@@ -256,7 +264,7 @@ void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, p
         // Pre-scan the row for even number of transitions. Algo only works for even number of transitions.
         for (int x = x0; x < x1; x++)
         {
-            if (boundaryColor == getPxTft(x, y))
+            if (boundaryColor == getPxRenderTarget(x, y))
             {
                 // Flip this boolean, don't color the boundary
                 if (!insideHysteresis)
@@ -278,7 +286,7 @@ void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, p
             for (int x = x0; x < x1; x++)
             {
                 // If a boundary is hit
-                if (boundaryColor == getPxTft(x, y))
+                if (boundaryColor == getPxRenderTarget(x, y))
                 {
                     // Flip this boolean, don't color the boundary
                     if (!insideHysteresis)
@@ -323,13 +331,13 @@ void oddEvenFill(int x0, int y0, int x1, int y1, paletteColor_t boundaryColor, p
  */
 void floodFill(uint16_t x, uint16_t y, paletteColor_t col, uint16_t xMin, uint16_t yMin, uint16_t xMax, uint16_t yMax)
 {
-    if (getPxTft(x, y) == col)
+    if (getPxRenderTarget(x, y) == col)
     {
         // makes no sense to fill with the same color, so just don't
         return;
     }
 
-    _floodFill(x, y, getPxTft(x, y), col, xMin, yMin, xMax, yMax);
+    _floodFill(x, y, getPxRenderTarget(x, y), col, xMin, yMin, xMax, yMax);
 }
 
 /**
@@ -354,11 +362,11 @@ static void _floodFill(uint16_t x, uint16_t y, paletteColor_t search, paletteCol
     while (true)
     {
         uint16_t ox = x, oy = y;
-        while (y != yMin && getPxTft(x, y - 1) == search)
+        while (y != yMin && getPxRenderTarget(x, y - 1) == search)
         {
             y--;
         }
-        while (x != xMin && getPxTft(x - 1, y) == search)
+        while (x != xMin && getPxRenderTarget(x - 1, y) == search)
         {
             x--;
         }
@@ -398,7 +406,7 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
         // this via the recursion below, we'll increase the starting value of 'x' and reduce the last row length to
         // match. then we'll continue trying to set the narrower rectangular block
         if (lastRowLength != 0
-            && getPxTft(x, y) != search) // if this is not the first row and the leftmost cell is filled...
+            && getPxRenderTarget(x, y) != search) // if this is not the first row and the leftmost cell is filled...
         {
             do
             {
@@ -406,7 +414,7 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
                 {
                     return; // shorten the row. if it's full, we're done
                 }
-            } while (getPxTft(++x, y) != search); // otherwise, update the starting point of the main scan to match
+            } while (getPxRenderTarget(++x, y) != search); // otherwise, update the starting point of the main scan to match
             sx = x;
         }
         // we also want to handle the opposite case, | **|, where we begin scanning a 2-wide rectangular block and
@@ -414,14 +422,14 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
         // with recursion but we'd prefer to adjust x and lastRowLength instead
         else
         {
-            for (; x != xMin && getPxTft(x - 1, y) == search; rowLength++, lastRowLength++)
+            for (; x != xMin && getPxRenderTarget(x - 1, y) == search; rowLength++, lastRowLength++)
             {
-                setPxTft(--x, y, fill); // to avoid scanning the cells twice, we'll fill them and update rowLength here
+                setPxRenderTarget(--x, y, fill); // to avoid scanning the cells twice, we'll fill them and update rowLength here
                 // if there's something above the new starting point, handle that recursively. this deals with cases
                 // like |* **| when we begin filling from (2,0), move down to (2,1), and then move left to (0,1).
                 // the  |****| main scan assumes the portion of the previous row from x to x+lastRowLength has already
                 // been filled. adjusting x and lastRowLength breaks that assumption in this case, so we must fix it
-                if (y != yMin && getPxTft(x, y - 1) == search)
+                if (y != yMin && getPxRenderTarget(x, y - 1) == search)
                 {
                     _floodFill(x, y - 1, search, fill, xMin, yMin, xMax,
                                yMax); // use _Fill since there may be more up and left
@@ -432,9 +440,9 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
         // now at this point we can begin to scan the current row in the rectangular block. the span of the previous
         // row from x (inclusive) to x+lastRowLength (exclusive) has already been filled, so we don't need to
         // check it. so scan across to the right in the current row
-        for (; sx < xMax && getPxTft(sx, y) == search; rowLength++, sx++)
+        for (; sx < xMax && getPxRenderTarget(sx, y) == search; rowLength++, sx++)
         {
-            setPxTft(sx, y, fill);
+            setPxRenderTarget(sx, y, fill);
         }
         // now we've scanned this row. if the block is rectangular, then the previous row has already been scanned,
         // so we don't need to look upwards and we're going to scan the next row in the next iteration so we don't
@@ -447,7 +455,7 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
             for (int end = x + lastRowLength;
                  ++sx < end;) // 'end' is the end of the previous row, so scan the current row to
             {                 // there. any clear cells would have been connected to the previous
-                if (getPxTft(sx, y) == search)
+                if (getPxRenderTarget(sx, y) == search)
                 {
                     _floodFillInner(sx, y, search, fill, xMin, yMin, xMax,
                                     yMax); // row. the cells up and left must be set so use FillCore
@@ -460,7 +468,7 @@ static void _floodFillInner(uint16_t x, uint16_t y, paletteColor_t search, palet
         {
             for (int ux = x + lastRowLength; ++ux < sx;) // sx is the end of the current row
             {
-                if (getPxTft(ux, y - 1) == search)
+                if (getPxRenderTarget(ux, y - 1) == search)
                 {
                     _floodFill(ux, y - 1, search, fill, xMin, yMin, xMax,
                                yMax); // since there may be clear cells up and left, use _Fill
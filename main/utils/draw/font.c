@@ -4,11 +4,23 @@
 
 #include <string.h>
 #include <esp_heap_caps.h>
+#include <esp_log.h>
 
 #include "macros.h"
 #include "hdw-tft.h"
+#include "renderTarget.h"
 #include "font.h"
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The number of word wrapped text layouts which are cached
+#define TEXT_LAYOUT_CACHE_SIZE 16
+
+/// The number of recently missed layouts which are remembered, so text is only cached once it's drawn again
+#define TEXT_LAYOUT_MISS_SIZE 8
+
 //==============================================================================
 // Enums
 //==============================================================================
@@ -21,6 +33,40 @@ typedef enum
     TEXT_CENTER  = 0x04, /// Flag for drawTextWordWrapFlags() to center text horizontally
 } wordWrapFlags_t;
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief One step of word wrapping text, either a line of text or a newline
+ */
+typedef struct
+{
+    uint16_t offset; ///< The offset of the line in the text, after leading spaces
+    uint8_t len;     ///< The number of characters in the line
+    bool newline;    ///< true if this step is a newline rather than a line of text
+    uint16_t width;  ///< The width of the line, in pixels
+    int16_t y;       ///< The Y offset of the line from the first line
+} textLine_t;
+
+/**
+ * @brief A cached layout of word wrapped text, relative to where the text starts
+ */
+typedef struct
+{
+    const font_t* font;  ///< The font the text was laid out with, or NULL if this layout is unused
+    uint8_t fontHeight;  ///< The font's height when the text was laid out
+    int32_t charSpacing; ///< The character spacing when the text was laid out
+    uint32_t hash;       ///< A hash of the text
+    uint16_t textLen;    ///< The length of the text
+    int16_t firstX;      ///< The X offset of the first line from the left edge
+    int16_t width;       ///< The width the text was wrapped to
+    textLine_t* lines;   ///< The lines and newlines, in order
+    uint16_t numLines;   ///< The number of lines and newlines
+    bool repeats;        ///< true if the last line is empty and repeats until the bottom is reached
+    uint32_t lastUsed;   ///< When this layout was last used, to replace the least recently used layout
+} textLayout_t;
+
 //==============================================================================
 // Static Function Declarations
 //==============================================================================
@@ -39,6 +85,18 @@ static void drawCharBoundsPrivate(paletteColor_t color, paletteColor_t middleCol
 
 int32_t gCharSpacing = 1;
 
+/// Cached layouts of word wrapped text
+static textLayout_t textLayouts[TEXT_LAYOUT_CACHE_SIZE];
+
+/// Incremented each time a layout is used
+static uint32_t textLayoutClock;
+
+/// Keys of layouts which recently weren't cached, see getTextLayoutKey()
+static uint32_t textLayoutMisses[TEXT_LAYOUT_MISS_SIZE];
+
+/// The next entry in textLayoutMisses to replace
+static uint32_t textLayoutMissIdx;
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -95,7 +153,8 @@ void drawShinyCharBounds(paletteColor_t outerColor, paletteColor_t middleColor,
  */
 void drawChar(paletteColor_t color, int h, const font_ch_t* ch, int16_t xOff, int16_t yOff)
 {
-    drawCharBoundsPrivate(color, color, color, h, ch, xOff, yOff, 0, 0, TFT_WIDTH, TFT_HEIGHT);
+    const wsg_t* target = getRenderTarget();
+    drawCharBoundsPrivate(color, color, color, h, ch, xOff, yOff, 0, 0, target->w, target->h);
 }
 
 /**
@@ -195,8 +254,9 @@ int16_t drawShinyTextBounds(const font_t* font, paletteColor_t outerColor, palet
 int16_t drawTextShadow(const font_t* font, paletteColor_t color, paletteColor_t shadowColor, const char* text,
                        int16_t xOff, int16_t yOff)
 {
-    int16_t end = drawTextBounds(font, shadowColor, text, xOff + 1, yOff + 1, 0, 0, TFT_WIDTH, TFT_HEIGHT);
-    drawTextBounds(font, color, text, xOff, yOff, 0, 0, TFT_WIDTH, TFT_HEIGHT);
+    const wsg_t* target = getRenderTarget();
+    int16_t end = drawTextBounds(font, shadowColor, text, xOff + 1, yOff + 1, 0, 0, target->w, target->h);
+    drawTextBounds(font, color, text, xOff, yOff, 0, 0, target->w, target->h);
     return end;
 }
 
@@ -212,7 +272,8 @@ int16_t drawTextShadow(const font_t* font, paletteColor_t color, paletteColor_t
  */
 int16_t drawText(const font_t* font, paletteColor_t color, const char* text, int16_t xOff, int16_t yOff)
 {
-    return drawTextBounds(font, color, text, xOff, yOff, 0, 0, TFT_WIDTH, TFT_HEIGHT);
+    const wsg_t* target = getRenderTarget();
+    return drawTextBounds(font, color, text, xOff, yOff, 0, 0, target->w, target->h);
 }
 
 /**
@@ -230,8 +291,9 @@ int16_t drawText(const font_t* font, paletteColor_t color, const char* text, int
 int16_t drawShinyText(const font_t* font, paletteColor_t outerColor, paletteColor_t middleColor,
                       paletteColor_t innerColor, const char* text, int16_t xOff, int16_t yOff)
 {
-    return drawShinyTextBounds(font, outerColor, middleColor, innerColor, text, xOff, yOff, 0, 0, TFT_WIDTH,
-                               TFT_HEIGHT);
+    const wsg_t* target = getRenderTarget();
+    return drawShinyTextBounds(font, outerColor, middleColor, innerColor, text, xOff, yOff, 0, 0, target->w,
+                               target->h);
 }
 
 /**
@@ -260,102 +322,408 @@ uint16_t textWidth(const font_t* font, const char* text)
     return width;
 }
 
-static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t color, const char* text, int16_t xStart,
-                                         int16_t yStart, int16_t* xOff, int16_t* yOff, int16_t xMax, int16_t yMax,
-                                         uint16_t flags)
+/**
+ * @brief Find the next line of word wrapped text, which breaks at ' ', '-', or '\\n'
+ *
+ * @param font The font to measure the text with
+ * @param text The text to wrap, starting at the line
+ * @param atLineStart true if the line starts at the left edge, so leading spaces are skipped
+ * @param textX The X coordinate the line starts at
+ * @param xMax The maximum x-coordinate at which any text may be drawn
+ * @param[out] len The number of characters in the line
+ * @param[out] width The width of the line, in pixels
+ * @return A pointer to the start of the line, after leading spaces. If this points to a newline, the line is empty
+ */
+static const char* wrapTextLine(const font_t* font, const char* text, bool atLineStart, int16_t textX, int16_t xMax,
+                                uint8_t* len, uint16_t* width)
 {
-    const char* textPtr = text;
-    int16_t textX = *xOff, textY = *yOff;
     char buf[64];
 
-    // don't dereference that null pointer
-    if (text == NULL)
+    // skip leading spaces if we're at the start of the line
+    for (; atLineStart && *text == ' '; text++)
     {
-        return NULL;
+        ;
     }
 
-    // while there is text left to print, and the text would not exceed the Y-bounds...
-    while (*textPtr && (textY + font->height <= yMax))
+    // newlines are handled by the caller
+    if (*text == '\n')
     {
-        *yOff = textY;
+        *len   = 0;
+        *width = 0;
+        return text;
+    }
 
-        // skip leading spaces if we're at the start of the line
-        for (; textX == xStart && *textPtr == ' '; textPtr++)
+    // copy as much text as will fit into the buffer
+    // leaving room for a null-terminator in case the string is longer
+    strncpy(buf, text, sizeof(buf) - 1);
+    // Always null terminate
+    buf[sizeof(buf) - 1] = 0;
+
+    // shorten the text until it fits
+    while (textX + textWidth(font, buf) > xMax)
+    {
+        // Find all line breaking characters
+        char* lastSpace = strrchr(buf, ' ');
+        char* lastDash  = strrchr(buf, '-');
+        char* lastNl    = strrchr(buf, '\n');
+
+        // Nothing more to split on, carry on
+        if (NULL == lastSpace && NULL == lastDash && NULL == lastNl)
         {
-            ;
+            break;
         }
 
-        // handle newlines
-        if (*textPtr == '\n')
+        // Find the last breaking character
+        char* lastBreak = MAX(MAX(lastSpace, lastDash), lastNl);
+
+        // Drop a null terminator to shrink the string
+        *lastBreak = '\0';
+    }
+
+    // Look for newlines in the current line
+    for (int32_t i = 0; i < sizeof(buf); i++)
+    {
+        if ('\n' == buf[i])
         {
-            textX = xStart;
-            textY += font->height + gCharSpacing;
-            textPtr++;
-            continue;
+            // Newline found, end line here
+            buf[i] = 0;
+            break;
         }
+    }
+
+    *len   = strlen(buf);
+    *width = textWidth(font, buf);
+    return text;
+}
+
+/**
+ * @brief Draw one line of word wrapped text if it is on the render target, or measure it if not
+ *
+ * @param font The font to use when drawing the text
+ * @param color The color of the text to be drawn
+ * @param line The start of the line of text
+ * @param len The number of characters in the line
+ * @param width The width of the line, in pixels
+ * @param textX The X coordinate the line starts at
+ * @param textY The Y coordinate the line starts at
+ * @param xStart The left edge of the text
+ * @param xMax The maximum x-coordinate at which any text may be drawn
+ * @param flags ::wordWrapFlags_t to draw, measure, or center the line
+ * @return The X coordinate after the line
+ */
+static int16_t drawTextLine(const font_t* font, paletteColor_t color, const char* line, uint8_t len, uint16_t width,
+                            int16_t textX, int16_t textY, int16_t xStart, int16_t xMax, uint16_t flags)
+{
+    if (!(flags & TEXT_MEASURE) && textY + font->height >= 0 && textY <= getRenderTarget()->h)
+    {
+        char buf[64];
+        memcpy(buf, line, len);
+        buf[len] = '\0';
+
+        if (flags & TEXT_CENTER)
+        {
+            int16_t cOffset = xStart + (xMax - xStart - width) / 2;
+            return drawText(font, color, buf, cOffset, textY);
+        }
+        return drawText(font, color, buf, textX, textY);
+    }
+
+    // drawText returns the next text position, which is gCharSpacing px past the last char
+    // textWidth returns, well, the text width, so add gCharSpacing to account for the last pixel
+    return width + gCharSpacing;
+}
+
+/**
+ * @brief Hash text to find its cached layout
+ *
+ * @param text The text to hash, as a null-terminated string
+ * @param[out] len The length of the text
+ * @return The FNV-1a hash of the text
+ */
+static uint32_t hashText(const char* text, size_t* len)
+{
+    uint32_t hash     = 2166136261u;
+    const char* start = text;
+    while (*text)
+    {
+        hash = (hash ^ (uint8_t)*text++) * 16777619u;
+    }
+    *len = text - start;
+    return hash;
+}
 
-        // copy as much text as will fit into the buffer
-        // leaving room for a null-terminator in case the string is longer
-        strncpy(buf, textPtr, sizeof(buf) - 1);
-        // Always null terminate
-        buf[sizeof(buf) - 1] = 0;
+/**
+ * @brief Lay out word wrapped text without a bottom edge, relative to where the text starts
+ *
+ * @param font The font to lay out the text with
+ * @param text The text to lay out, as a null-terminated string
+ * @param firstX The X offset of the first line from the left edge
+ * @param width The width to wrap the text to
+ * @param layout The layout to fill in, which must be empty
+ * @return true if the text was laid out, false if memory couldn't be allocated or the text is too tall
+ */
+static bool layoutText(const font_t* font, const char* text, int16_t firstX, int16_t width, textLayout_t* layout)
+{
+    const char* textPtr = text;
+    int16_t textX       = firstX;
+    int32_t textY       = 0;
+    int32_t maxLines    = 0;
 
-        // shorten the text until it fits
-        while (textX + textWidth(font, buf) > xMax)
+    while (*textPtr)
+    {
+        if (textY > INT16_MAX || layout->numLines == UINT16_MAX)
         {
-            // Find all line breaking characters
-            char* lastSpace = strrchr(buf, ' ');
-            char* lastDash  = strrchr(buf, '-');
-            char* lastNl    = strrchr(buf, '\n');
+            return false;
+        }
 
-            // Nothing more to split on, carry on
-            if (NULL == lastSpace && NULL == lastDash && NULL == lastNl)
+        // Make room for another line
+        if (layout->numLines == maxLines)
+        {
+            maxLines          = MIN(UINT16_MAX, MAX(8, maxLines * 2));
+            textLine_t* grown = heap_caps_realloc(layout->lines, maxLines * sizeof(textLine_t), MALLOC_CAP_8BIT);
+            if (NULL == grown)
             {
-                break;
+                return false;
             }
+            layout->lines = grown;
+        }
 
-            // Find the last breaking character
-            char* lastBreak = MAX(MAX(lastSpace, lastDash), lastNl);
+        const char* lineStart = textPtr;
+        textLine_t* line      = &layout->lines[layout->numLines++];
+        textPtr               = wrapTextLine(font, textPtr, 0 == textX, textX, width, &line->len, &line->width);
+        line->offset          = textPtr - text;
+        line->newline         = ('\n' == *textPtr);
+        line->y               = textY;
 
-            // Drop a null terminator to shrink the string
-            *lastBreak = '\0';
+        if (line->newline)
+        {
+            textX = 0;
+            textY += font->height + gCharSpacing;
+            textPtr++;
+            continue;
         }
 
-        // Look for newlines in the current line
-        for (int32_t i = 0; i < sizeof(buf); i++)
+        textPtr += line->len;
+        if (*textPtr)
         {
-            if ('\n' == buf[i])
+            // A line at the left edge which can't fit any text will be the same on every following line
+            if (textPtr == lineStart && 0 == textX)
             {
-                // Newline found, end line here
-                buf[i] = 0;
+                layout->repeats = true;
                 break;
             }
+            textX = 0;
+            textY += font->height + gCharSpacing;
         }
+    }
+    return true;
+}
 
-        // the line must have enough space for the rest of the buffer
-        // print the line, and advance the text pointer and offset
-        if (!(flags & TEXT_MEASURE) && textY + font->height >= 0 && textY <= TFT_HEIGHT)
+/**
+ * @brief Combine everything a layout depends on into a key for remembering missed layouts
+ *
+ * @param font The font to lay out the text with
+ * @param hash The hash of the text
+ * @param firstX The X offset of the first line from the left edge
+ * @param width The width to wrap the text to
+ * @return The key, which is never 0
+ */
+static uint32_t getTextLayoutKey(const font_t* font, uint32_t hash, int16_t firstX, int16_t width)
+{
+    uint32_t key = hash ^ (uint32_t)(uintptr_t)font;
+    key          = (key ^ (uint16_t)firstX) * 16777619u;
+    key          = (key ^ (uint16_t)width) * 16777619u;
+    key          = (key ^ font->height ^ ((uint32_t)gCharSpacing << 8)) * 16777619u;
+    return key ? key : 1;
+}
+
+/**
+ * @brief Get the cached layout of word wrapped text, laying it out if it isn't cached.
+ *
+ * Text is only laid out and cached the second time it misses the cache, so text which changes every frame is wrapped
+ * while drawing instead, and doesn't evict the layouts of text which is drawn repeatedly.
+ *
+ * @param font The font to lay out the text with
+ * @param text The text to lay out, as a null-terminated string
+ * @param firstX The X offset of the first line from the left edge
+ * @param width The width to wrap the text to
+ * @return The layout, or NULL if the text isn't cached yet or couldn't be laid out
+ */
+static const textLayout_t* getTextLayout(const font_t* font, const char* text, int16_t firstX, int16_t width)
+{
+    size_t len;
+    uint32_t hash = hashText(text, &len);
+    if (len > UINT16_MAX)
+    {
+        return NULL;
+    }
+
+    // Look for the layout, and the least recently used layout to replace if it isn't found
+    textLayout_t* oldest = &textLayouts[0];
+    for (int32_t lIdx = 0; lIdx < TEXT_LAYOUT_CACHE_SIZE; lIdx++)
+    {
+        textLayout_t* layout = &textLayouts[lIdx];
+        if (layout->font == font && layout->hash == hash && layout->textLen == len && layout->firstX == firstX
+            && layout->width == width && layout->fontHeight == font->height && layout->charSpacing == gCharSpacing)
         {
-            if (flags & TEXT_CENTER)
-            {
-                int16_t tWidth  = textWidth(font, buf);
-                int16_t cOffset = xStart + (xMax - xStart - tWidth) / 2;
-                textX           = drawText(font, color, buf, cOffset, textY);
-            }
-            else
-            {
-                textX = drawText(font, color, buf, textX, textY);
-            }
+            layout->lastUsed = ++textLayoutClock;
+            return layout;
+        }
+        if (layout->lastUsed < oldest->lastUsed)
+        {
+            oldest = layout;
+        }
+    }
+
+    // Remember the first miss, and only cache the text if it misses again
+    uint32_t key = getTextLayoutKey(font, hash, firstX, width);
+    int32_t mIdx;
+    for (mIdx = 0; mIdx < TEXT_LAYOUT_MISS_SIZE; mIdx++)
+    {
+        if (textLayoutMisses[mIdx] == key)
+        {
+            textLayoutMisses[mIdx] = 0;
+            break;
+        }
+    }
+    if (TEXT_LAYOUT_MISS_SIZE == mIdx)
+    {
+        textLayoutMisses[textLayoutMissIdx] = key;
+        textLayoutMissIdx                   = (textLayoutMissIdx + 1) % TEXT_LAYOUT_MISS_SIZE;
+        return NULL;
+    }
+
+    // Lay the text out in place of the least recently used layout
+    heap_caps_free(oldest->lines);
+    memset(oldest, 0, sizeof(textLayout_t));
+    if (!layoutText(font, text, firstX, width, oldest))
+    {
+        heap_caps_free(oldest->lines);
+        memset(oldest, 0, sizeof(textLayout_t));
+        return NULL;
+    }
+
+    oldest->font        = font;
+    oldest->fontHeight  = font->height;
+    oldest->charSpacing = gCharSpacing;
+    oldest->hash        = hash;
+    oldest->textLen     = len;
+    oldest->firstX      = firstX;
+    oldest->width       = width;
+    oldest->lastUsed    = ++textLayoutClock;
+    return oldest;
+}
+
+/**
+ * @brief Draw word wrapped text from its cached layout, with the same results as drawTextWordWrapFlags()
+ *
+ * @param font The font to use when drawing the text
+ * @param color The color of the text to be drawn
+ * @param text The text which was laid out
+ * @param layout The text's layout
+ * @param xStart The left edge of the text
+ * @param xOff The X-coordinate to begin drawing the text at, set to the X-coordinate after the text
+ * @param yOff The Y-coordinate to begin drawing the text at, set to the Y-coordinate of the last line
+ * @param xMax The maximum x-coordinate at which any text may be drawn
+ * @param yMax The maximum y-coordinate at which text may be drawn
+ * @param flags ::wordWrapFlags_t to draw, measure, or center the text
+ * @return A pointer to the first unprinted character within `text`, or NULL if all text has been written
+ */
+static const char* drawTextLayout(const font_t* font, paletteColor_t color, const char* text,
+                                  const textLayout_t* layout, int16_t xStart, int16_t* xOff, int16_t* yOff,
+                                  int16_t xMax, int16_t yMax, uint16_t flags)
+{
+    const char* textPtr = text;
+    int16_t textX       = *xOff;
+    int32_t yFirst      = *yOff;
+    int32_t textY       = yFirst;
+
+    int32_t lIdx;
+    for (lIdx = 0; lIdx < layout->numLines; lIdx++)
+    {
+        const textLine_t* line = &layout->lines[lIdx];
+
+        // stop when the line would exceed the Y-bounds
+        textY = yFirst + line->y;
+        if (textY + font->height > yMax)
+        {
+            break;
+        }
+        *yOff = textY;
+
+        if (line->newline)
+        {
+            textX   = xStart;
+            textPtr = text + line->offset + 1;
+            continue;
         }
-        else
+
+        textX   = drawTextLine(font, color, text + line->offset, line->len, line->width, textX, textY, xStart, xMax,
+                               flags);
+        textPtr = text + line->offset + line->len;
+        if (*textPtr)
         {
-            // drawText returns the next text position, which is gCharSpacing px past the last char
-            // textWidth returns, well, the text width, so add gCharSpacing to account for the last pixel
-            textX = textWidth(font, buf) + gCharSpacing;
+            textX = xStart;
         }
+    }
+
+    // An empty last line repeats, drawing nothing, until the bottom is reached
+    if (layout->repeats && lIdx == layout->numLines)
+    {
+        int32_t lineH = font->height + gCharSpacing;
+        for (textY += lineH; textY + font->height <= yMax; textY += lineH)
+        {
+            *yOff = textY;
+        }
+    }
+
+    *xOff = textX;
+    return *textPtr ? textPtr : NULL;
+}
+
+static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t color, const char* text, int16_t xStart,
+                                         int16_t yStart, int16_t* xOff, int16_t* yOff, int16_t xMax, int16_t yMax,
+                                         uint16_t flags)
+{
+    // don't dereference that null pointer
+    if (text == NULL)
+    {
+        return NULL;
+    }
 
-        // Reset for the next line
-        textPtr += strlen(buf);
+    // Use the cached layout, so the text is only wrapped once
+    const textLayout_t* layout = getTextLayout(font, text, *xOff - xStart, xMax - xStart);
+    if (NULL != layout)
+    {
+        return drawTextLayout(font, color, text, layout, xStart, xOff, yOff, xMax, yMax, flags);
+    }
+
+    // Otherwise wrap the text one line at a time while drawing it, as it hasn't been drawn recently
+    const char* textPtr = text;
+    int16_t textX = *xOff, textY = *yOff;
+
+    // while there is text left to print, and the text would not exceed the Y-bounds...
+    while (*textPtr && (textY + font->height <= yMax))
+    {
+        *yOff = textY;
+
+        uint8_t len;
+        uint16_t width;
+        textPtr = wrapTextLine(font, textPtr, textX == xStart, textX, xMax, &len, &width);
+
+        // handle newlines
+        if (*textPtr == '\n')
+        {
+            textX = xStart;
+            textY += font->height + gCharSpacing;
+            textPtr++;
+            continue;
+        }
+
+        // the line must have enough space for the rest of the buffer
+        // print the line, and advance the text pointer and offset
+        textX = drawTextLine(font, color, textPtr, len, width, textX, textY, xStart, xMax, flags);
+        textPtr += len;
 
         // If there's another line
         if (*textPtr)
@@ -372,6 +740,38 @@ static const char* drawTextWordWrapFlags(const font_t* font, paletteColor_t colo
     return *textPtr ? textPtr : NULL;
 }
 
+/**
+ * @brief Get the color of a row of a shiny character, the same as drawCharBoundsPrivate() uses for bitmaps
+ *
+ * @param color The color of the center quarter of the character
+ * @param middleColor The color of the third, sixth, and seventh eighths of the character
+ * @param outerColor The color of the upper quarter and lower eighth of the character
+ * @param y The row being drawn
+ * @param h The number of rows being drawn
+ * @return The color of the row
+ */
+static paletteColor_t getShinyColor(paletteColor_t color, paletteColor_t middleColor, paletteColor_t outerColor, int y,
+                                    int h)
+{
+    if (y < h / 4)
+    {
+        return outerColor;
+    }
+    else if (y < h / 2)
+    {
+        return middleColor;
+    }
+    else if (y < (h * 5) / 8)
+    {
+        return color;
+    }
+    else if (y < (h * 7) / 8)
+    {
+        return middleColor;
+    }
+    return outerColor;
+}
+
 static void drawCharBoundsPrivate(paletteColor_t color, paletteColor_t middleColor, paletteColor_t outerColor, int h,
                                   const font_ch_t* ch, int16_t xOff, int16_t yOff, int16_t xMin, int16_t yMin,
                                   int16_t xMax, int16_t yMax)
@@ -391,6 +791,28 @@ static void drawCharBoundsPrivate(paletteColor_t color, paletteColor_t middleCol
     // Get a pointer to the end of the bitmap
     const uint8_t* endOfBitmap = &bitmap[((wch * h) + 7) >> 3] - 1;
 
+    // Never draw outside the render target, whatever the bounds are
+    const wsg_t* target = getRenderTarget();
+    if (xMin < 0)
+    {
+        xMin = 0;
+    }
+    if (yMin < 0)
+    {
+        yMin = 0;
+    }
+    if (xMax > target->w)
+    {
+        xMax = target->w;
+    }
+    if (yMax > target->h)
+    {
+        yMax = target->h;
+    }
+
+    // Remember where the top of the character is before it's clipped
+    int16_t yGlyph = yOff;
+
     // Don't draw off the bottom of the screen.
     if (yOff + h > yMax)
     {
@@ -406,11 +828,42 @@ static void drawCharBoundsPrivate(paletteColor_t color, paletteColor_t middleCol
         bitIdx -= yOff * wch;
         bitmap += bitIdx >> 3;
         bitIdx &= 7;
-        h += yOff;
-        yOff = 0;
+        h -= yMin - yOff;
+        yOff = yMin;
     }
 
-    paletteColor_t* pxOutput = getPxTftFramebuffer() + (yOff * TFT_WIDTH);
+    paletteColor_t* pxOutput = target->px + (yOff * target->w);
+    markDirtyRowsRenderTarget(yOff, yOff + h);
+
+    // If the glyph is cached, draw whole runs of pixels instead of unpacking bits
+    if (NULL != ch->spans)
+    {
+        bool shiny = (color != middleColor || color != outerColor);
+        for (int32_t sIdx = 0; sIdx < ch->numSpans; sIdx++)
+        {
+            const fontSpan_t* span = &ch->spans[sIdx];
+
+            // Runs are sorted top to bottom, so skip runs above the bounds and stop below them
+            int y = yGlyph + span->y - yOff;
+            if (y < 0)
+            {
+                continue;
+            }
+            else if (y >= h)
+            {
+                break;
+            }
+
+            int startX = MAX(xOff + span->x, xMin);
+            int endX   = MIN(xOff + span->x + span->len, xMax);
+            if (startX < endX)
+            {
+                paletteColor_t spanColor = shiny ? getShinyColor(color, middleColor, outerColor, y, h) : color;
+                memset(&pxOutput[(y * target->w) + startX], spanColor, endX - startX);
+            }
+        }
+        return;
+    }
 
     for (int y = 0; y < h; y++)
     {
@@ -505,7 +958,7 @@ static void drawCharBoundsPrivate(paletteColor_t color, paletteColor_t middleCol
         bitIdx += truncate;
         bitmap += bitIdx >> 3;
         bitIdx &= 7;
-        pxOutput += TFT_WIDTH;
+        pxOutput += target->w;
     }
 }
 
@@ -644,7 +1097,8 @@ void makeOutlineFont(font_t* srcFont, font_t* dstFont, bool spiRam)
     }
 
     // Copy the height
-    dstFont->height = srcFont->height;
+    dstFont->height    = srcFont->height;
+    dstFont->spanCache = NULL;
 
     // For each character
     for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(dstFont->chars); cIdx++)
@@ -654,7 +1108,9 @@ void makeOutlineFont(font_t* srcFont, font_t* dstFont, bool spiRam)
         font_ch_t* sCh = &srcFont->chars[cIdx];
 
         // Copy the character width
-        oCh->width = sCh->width;
+        oCh->width    = sCh->width;
+        oCh->spans    = NULL;
+        oCh->numSpans = 0;
 
         // Allocate space for the outline bitmap
         int pixels  = dstFont->height * oCh->width;
@@ -706,7 +1162,8 @@ int16_t drawTextMarquee(const font_t* font, paletteColor_t color, const char* te
     int16_t gapW = 4 * textWidth(font, " ");
 
     int16_t offset   = *timer / MARQUEE_SPEED;
-    int16_t endX     = drawTextBounds(font, color, text, xOff - offset, yOff, xOff, 0, xMax, TFT_HEIGHT);
+    int16_t yMax     = getRenderTarget()->h;
+    int16_t endX     = drawTextBounds(font, color, text, xOff - offset, yOff, xOff, 0, xMax, yMax);
     int16_t endStart = endX + gapW;
 
     // Restart the timer when the end text reaches the start
@@ -717,7 +1174,7 @@ int16_t drawTextMarquee(const font_t* font, paletteColor_t color, const char* te
 
     if (endStart < xMax)
     {
-        return drawTextBounds(font, color, text, endStart, yOff, xOff, 0, xMax, TFT_HEIGHT);
+        return drawTextBounds(font, color, text, endStart, yOff, xOff, 0, xMax, yMax);
     }
 
     return endX;
@@ -760,7 +1217,7 @@ bool drawTextEllipsize(const font_t* font, paletteColor_t color, const char* tex
             }
         }
 
-        drawTextBounds(font, color, text, xOff, yOff, 0, 0, xOff + trimW, TFT_HEIGHT);
+        drawTextBounds(font, color, text, xOff, yOff, 0, 0, xOff + trimW, getRenderTarget()->h);
         drawText(font, color, "...", xOff + trimW + gCharSpacing, yOff);
 
         return true;
@@ -794,7 +1251,7 @@ int16_t drawTextMulticolored(const font_t* font, const char* text, int16_t xOff,
     for (int i = 0; i < segmentCount; i++)
     {
         result = drawTextBounds(font, colors[i % colorCount], text, xOff, yOff, xOff + (w * i / segmentCount), 0,
-                                xOff + (w * (i + 1) / segmentCount), TFT_HEIGHT);
+                                xOff + (w * (i + 1) / segmentCount), getRenderTarget()->h);
     }
 
     return result;
@@ -809,3 +1266,128 @@ void setGlobalCharSpacing(int32_t spacing)
 {
     gCharSpacing = spacing;
 }
+
+/**
+ * @brief Expand a character's bitmap into horizontal runs of set pixels
+ *
+ * @param ch The character to expand
+ * @param h The height of the character
+ * @param spans The runs to write, or NULL to only count them
+ * @return The number of runs in the character
+ */
+static int32_t expandGlyphSpans(const font_ch_t* ch, int h, fontSpan_t* spans)
+{
+    int32_t numSpans = 0;
+    for (int y = 0; y < h; y++)
+    {
+        int runStart = -1;
+        for (int x = 0; x <= ch->width; x++)
+        {
+            int pxIdx = (y * ch->width) + x;
+            bool set  = (x < ch->width) && (ch->bitmap[pxIdx >> 3] & (1 << (pxIdx & 7)));
+            if (set && runStart < 0)
+            {
+                runStart = x;
+            }
+            else if (!set && runStart >= 0)
+            {
+                if (NULL != spans)
+                {
+                    spans[numSpans].y   = y;
+                    spans[numSpans].x   = runStart;
+                    spans[numSpans].len = x - runStart;
+                }
+                numSpans++;
+                runStart = -1;
+            }
+        }
+    }
+    return numSpans;
+}
+
+/**
+ * @brief Cache a font's characters as horizontal runs of pixels, so they are drawn a run at a time rather than a bit at
+ * a time. The cache is freed by freeFont() or freeFontGlyphCache()
+ *
+ * @param font The font to cache
+ * @param spiRam true to allocate memory in SPI RAM, false to allocate memory in normal RAM
+ * @return true if the glyphs were cached, false if memory couldn't be allocated
+ */
+bool cacheFontGlyphs(font_t* font, bool spiRam)
+{
+    freeFontGlyphCache(font);
+
+    // Count the runs in every character
+    int32_t numSpans = 0;
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        if (NULL != font->chars[cIdx].bitmap)
+        {
+            numSpans += expandGlyphSpans(&font->chars[cIdx], font->height, NULL);
+        }
+    }
+
+    // Allocate at least one run, so a font with no set pixels still gets a cache
+    font->spanCache = heap_caps_malloc_tag(sizeof(fontSpan_t) * MAX(numSpans, 1),
+                                           spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, "fontSpans");
+    if (NULL == font->spanCache)
+    {
+        ESP_LOGE("FONT", "Couldn't allocate %" PRId32 " glyph runs", numSpans);
+        return false;
+    }
+
+    // Expand each character's runs
+    fontSpan_t* spans = font->spanCache;
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        font_ch_t* ch = &font->chars[cIdx];
+        if (NULL != ch->bitmap)
+        {
+            ch->numSpans = expandGlyphSpans(ch, font->height, spans);
+            ch->spans    = spans;
+            spans += ch->numSpans;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Free a font's glyph cache, so its characters are drawn from their bitmaps
+ *
+ * @param font The font to free the glyph cache from
+ */
+void freeFontGlyphCache(font_t* font)
+{
+    for (int16_t cIdx = 0; cIdx < ARRAY_SIZE(font->chars); cIdx++)
+    {
+        font->chars[cIdx].spans    = NULL;
+        font->chars[cIdx].numSpans = 0;
+    }
+
+    if (NULL != font->spanCache)
+    {
+        heap_caps_free(font->spanCache);
+        font->spanCache = NULL;
+    }
+}
+
+/**
+ * @brief Clear cached layouts of word wrapped text. This is called when a mode exits and when a font is freed
+ *
+ * @param font The font to clear layouts for, or NULL to clear every layout
+ */
+void clearTextLayoutCache(const font_t* font)
+{
+    for (int32_t lIdx = 0; lIdx < TEXT_LAYOUT_CACHE_SIZE; lIdx++)
+    {
+        textLayout_t* layout = &textLayouts[lIdx];
+        if (NULL == font || layout->font == font)
+        {
+            heap_caps_free(layout->lines);
+            memset(layout, 0, sizeof(textLayout_t));
+        }
+    }
+
+    // Forget every miss, since a freed font's address may be reused
+    memset(textLayoutMisses, 0, sizeof(textLayoutMisses));
+}
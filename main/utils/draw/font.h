@@ -27,6 +27,18 @@
  * textWordWrapHeight() is used to measure the height of a word-wrapped text block.
  * There is no function to get the height of text because it is accessible in ::font_t.height.
  *
+ * \section font_cache Caching
+ *
+ * cacheFontGlyphs() expands each character's bitmap into horizontal runs of pixels, so characters are drawn a run at a
+ * time instead of a bit at a time. This uses more memory than the bitmaps, so it is optional, and is best for fonts
+ * which draw a lot of text every frame. The runs are freed with the font, or earlier with freeFontGlyphCache().
+ *
+ * Word wrapped text which is drawn or measured more than once is laid out and the line breaks are cached, so measuring
+ * text with textWordWrapHeight() and then drawing it, or drawing the same text every frame, doesn't lay it out again.
+ * Layouts are found by the text's contents, so text which changes is laid out again automatically. Text which changes
+ * every frame is wrapped as it's drawn instead of being cached. The cache is cleared when a mode exits, and
+ * clearTextLayoutCache() clears it sooner.
+ *
  * \section font_example Example
  *
  * \code{.c}
@@ -48,14 +60,26 @@
 
 #include "palette.h"
 
+/**
+ * @brief A horizontal run of set pixels in one row of a font_ch_t, see cacheFontGlyphs()
+ */
+typedef struct
+{
+    uint8_t y;   ///< The row of this run
+    uint8_t x;   ///< The column this run starts at
+    uint8_t len; ///< The number of pixels in this run
+} fontSpan_t;
+
 /**
  * @brief A character used in a font_t. Each character is a bitmap with the same height as the other characters in the
  * font.
  */
 typedef struct
 {
-    uint8_t width;   ///< The width of this character
-    uint8_t* bitmap; ///< This character's bitmap data
+    uint8_t width;           ///< The width of this character
+    uint8_t* bitmap;         ///< This character's bitmap data
+    const fontSpan_t* spans; ///< This character's runs of pixels, top to bottom, or NULL if glyphs aren't cached
+    uint16_t numSpans;       ///< The number of runs in spans
 } font_ch_t;
 
 /**
@@ -66,6 +90,7 @@ typedef struct
 {
     uint8_t height;                 ///< The height of this font. All chars have the same height
     font_ch_t chars['~' - ' ' + 2]; ///< An array of characters, enough space for all printed ASCII chars, and pi
+    fontSpan_t* spanCache;          ///< The runs of pixels for every character, or NULL if glyphs aren't cached
 } font_t;
 
 void drawChar(paletteColor_t color, int h, const font_ch_t* ch, int16_t xOff, int16_t yOff);
@@ -104,4 +129,8 @@ int16_t drawTextMulticolored(const font_t* font, const char* text, int16_t xOff,
                              const paletteColor_t* colors, uint32_t colorCount, uint32_t segmentCount);
 void setGlobalCharSpacing(int32_t spacing);
 
+bool cacheFontGlyphs(font_t* font, bool spiRam);
+void freeFontGlyphCache(font_t* font);
+void clearTextLayoutCache(const font_t* font);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,198 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include <esp_log.h>
+
+#include "renderTarget.h"
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// The stack of pushed render targets, the last one is current
+static wsg_t* targetStack[RENDER_TARGET_STACK_SIZE];
+/// The number of render targets in targetStack
+static int32_t targetDepth = 0;
+/// A WSG describing the TFT's frame-buffer, the render target when the stack is empty
+static wsg_t tftTarget = {
+    .px = NULL,
+    .w  = TFT_WIDTH,
+    .h  = TFT_HEIGHT,
+};
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Set a WSG as the render target. All drawing functions will draw into this WSG until popRenderTarget() is
+ * called
+ *
+ * @param target The WSG to draw into. Its pixels must be writable
+ * @return true if the render target was set, false if the stack is full or the WSG has no pixels
+ */
+bool pushRenderTarget(wsg_t* target)
+{
+    if (NULL == target || NULL == target->px)
+    {
+        ESP_LOGE("RT", "Can't draw to a WSG without pixels");
+        return false;
+    }
+
+    if (targetDepth >= RENDER_TARGET_STACK_SIZE)
+    {
+        ESP_LOGE("RT", "Render target stack is full");
+        return false;
+    }
+
+    targetStack[targetDepth++] = target;
+    return true;
+}
+
+/**
+ * @brief Restore the render target which was set before the last call to pushRenderTarget()
+ */
+void popRenderTarget(void)
+{
+    if (targetDepth > 0)
+    {
+        targetDepth--;
+    }
+    else
+    {
+        ESP_LOGW("RT", "Popped render target with none pushed");
+    }
+}
+
+/**
+ * @brief Pop all render targets so drawing goes to the display. This is called automatically between frames and when
+ * switching Swadge modes
+ */
+void resetRenderTargets(void)
+{
+    targetDepth = 0;
+}
+
+/**
+ * @brief Get the number of render targets which are pushed
+ *
+ * @return The number of render targets which are pushed, 0 if drawing is going to the display
+ */
+int32_t getRenderTargetDepth(void)
+{
+    return targetDepth;
+}
+
+/**
+ * @brief Get the current render target. When no render target is pushed, this is a WSG describing the TFT's
+ * frame-buffer, or an empty WSG if a band renderer is set with setBandRendererTft(). The returned WSG must not be freed
+ *
+ * @return The WSG which drawing functions draw into
+ */
+const wsg_t* getRenderTarget(void)
+{
+    if (targetDepth > 0)
+    {
+        return targetStack[targetDepth - 1];
+    }
+
+    // Fetch this every time in case the frame-buffer moved
+    tftTarget.px = getPxTftFramebuffer();
+    if (NULL == tftTarget.px)
+    {
+        // There is no frame-buffer while a band renderer is set, so clip everything away
+        static paletteColor_t noPixel;
+        tftTarget.px = &noPixel;
+        tftTarget.w  = 0;
+        tftTarget.h  = 0;
+    }
+    else
+    {
+        tftTarget.w = TFT_WIDTH;
+        tftTarget.h = TFT_HEIGHT;
+    }
+    return &tftTarget;
+}
+
+/**
+ * @brief Check if drawing is going to the display
+ *
+ * @return true if no render target is pushed, false if drawing is going into a WSG
+ */
+bool isRenderTargetTft(void)
+{
+    return 0 == targetDepth;
+}
+
+/**
+ * @brief Set a single pixel in the current render target, with bounds check
+ *
+ * @param x The x coordinate of the pixel to set
+ * @param y The y coordinate of the pixel to set
+ * @param px The color of the pixel to set
+ */
+void setPxRenderTarget(int16_t x, int16_t y, paletteColor_t px)
+{
+    if (0 == targetDepth)
+    {
+        setPxTft(x, y, px);
+        return;
+    }
+
+    const wsg_t* target = targetStack[targetDepth - 1];
+    if (0 <= x && x < target->w && 0 <= y && y < target->h)
+    {
+        target->px[(y * target->w) + x] = px;
+    }
+}
+
+/**
+ * @brief Get a single pixel in the current render target
+ *
+ * @param x The x coordinate of the pixel to get
+ * @param y The y coordinate of the pixel to get
+ * @return The color of the given pixel, or black if out of bounds
+ */
+paletteColor_t getPxRenderTarget(int16_t x, int16_t y)
+{
+    if (0 == targetDepth)
+    {
+        return getPxTft(x, y);
+    }
+
+    const wsg_t* target = targetStack[targetDepth - 1];
+    if (0 <= x && x < target->w && 0 <= y && y < target->h)
+    {
+        return target->px[(y * target->w) + x];
+    }
+    return c000;
+}
+
+/**
+ * @brief Fill the whole current render target with a single color
+ *
+ * @param px The color to fill with, which may be ::cTransparent
+ */
+void clearRenderTarget(paletteColor_t px)
+{
+    const wsg_t* target = getRenderTarget();
+    memset(target->px, px, sizeof(paletteColor_t) * target->w * target->h);
+    markDirtyRowsRenderTarget(0, target->h);
+}
+
+/**
+ * @brief Mark a range of rows as dirty if drawing is going to the display. This does nothing when drawing into a WSG
+ *
+ * @param yStart The first row which was modified, inclusive
+ * @param yEnd The last row which was modified, exclusive
+ */
+void markDirtyRowsRenderTarget(int32_t yStart, int32_t yEnd)
+{
+    if (0 == targetDepth)
+    {
+        markDirtyRowsTft(yStart, yEnd);
+    }
+}
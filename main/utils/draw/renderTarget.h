@@ -0,0 +1,156 @@
+/*! \file renderTarget.h
+ *
+ * \section renderTarget_design Design Philosophy
+ *
+ * By default every drawing function draws to the TFT's frame-buffer. A render target redirects drawing into a ::wsg_t
+ * instead. Shapes, fills, text, and WSGs drawn while a render target is set are drawn into that WSG, clipped to its
+ * size, and the display is not touched.
+ *
+ * This lets a mode draw something expensive once, like a static background, a HUD, or word-wrapped text, and then draw
+ * the finished WSG every frame with drawWsgSimple() or drawWsgTile(), which are much faster than drawing it all again.
+ *
+ * Render targets are a stack, so a function may set its own render target and restore the prior one when it is done,
+ * without knowing what the caller was drawing to.
+ *
+ * The macros SETUP_FOR_TURBO(), TURBO_SET_PIXEL(), and TURBO_SET_PIXEL_BOUNDS() from hdw-tft.h are redefined by this
+ * header to draw to the current render target, so code which uses them honors render targets too. Code which writes
+ * to getPxTftFramebuffer() directly does not, and should use getRenderTarget() instead.
+ *
+ * \section renderTarget_usage Usage
+ *
+ * pushRenderTarget() sets a ::wsg_t as the render target. The WSG's pixels must be writable, so it should be created
+ * with canvasBlankInit() or loaded with loadWsg() rather than being a span-encoded or shared cached image.
+ *
+ * popRenderTarget() restores the render target which was set before the last pushRenderTarget(). Every push must be
+ * popped before the mode's main loop returns. If a render target is still set then, a warning is logged and the
+ * display is set as the render target again.
+ *
+ * getRenderTarget() returns the current render target, which is a ::wsg_t describing the TFT frame-buffer when no
+ * render target is pushed. isRenderTargetTft() returns if drawing is going to the display.
+ *
+ * setPxRenderTarget() and getPxRenderTarget() set and get single pixels in the render target, like setPxTft() and
+ * getPxTft() do for the display. clearRenderTarget() fills the whole render target with one color, which may be
+ * ::cTransparent so the WSG can be drawn over something else.
+ *
+ * markDirtyRowsRenderTarget() calls markDirtyRowsTft() only if drawing is going to the display.
+ *
+ * \section renderTarget_example Example
+ *
+ * \code{.c}
+ * // Create a transparent WSG to draw a HUD into
+ * wsg_t hud;
+ * canvasBlankInit(&hud, TFT_WIDTH, 32, cTransparent, true);
+ *
+ * // Draw the HUD once
+ * pushRenderTarget(&hud);
+ * drawRoundedRect(0, 0, TFT_WIDTH, 32, 8, c112, c555);
+ * drawText(&font, c555, "Score", 10, 10);
+ * popRenderTarget();
+ *
+ * // Then each frame, draw the finished HUD to the display
+ * drawWsgSimple(&hud, 0, 0);
+ *
+ * // Free the HUD when done
+ * freeWsg(&hud);
+ * \endcode
+ */
+
+#ifndef _RENDER_TARGET_H_
+#define _RENDER_TARGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hdw-tft.h"
+#include "palette.h"
+#include "wsg.h"
+
+/// The maximum number of render targets which may be pushed at once
+#define RENDER_TARGET_STACK_SIZE 8
+
+bool pushRenderTarget(wsg_t* target);
+void popRenderTarget(void);
+void resetRenderTargets(void);
+int32_t getRenderTargetDepth(void);
+const wsg_t* getRenderTarget(void);
+bool isRenderTargetTft(void);
+
+void setPxRenderTarget(int16_t x, int16_t y, paletteColor_t px);
+paletteColor_t getPxRenderTarget(int16_t x, int16_t y);
+void clearRenderTarget(paletteColor_t px);
+void markDirtyRowsRenderTarget(int32_t yStart, int32_t yEnd);
+
+// Redefine the turbo pixel macros from hdw-tft.h to draw to the current render target
+#undef SETUP_FOR_TURBO
+#undef TURBO_SET_PIXEL
+#undef TURBO_SET_PIXEL_BOUNDS
+
+#if defined(__XTENSA__)
+    /**
+     * Initialize variables to set pixels in the current render target faster than setPxRenderTarget()
+     */
+    #define SETUP_FOR_TURBO()                                  \
+        const wsg_t* turboTarget = getRenderTarget();          \
+        register uint32_t dispPx = (uint32_t)turboTarget->px;  \
+        register uint32_t dispW  = turboTarget->w;             \
+        register uint32_t dispH  = turboTarget->h;             \
+        (void)dispH
+
+    /**
+     * Set a single pixel in the current render target. This does not bounds check.
+     * SETUP_FOR_TURBO() must be called before this.
+     */
+    #define TURBO_SET_PIXEL(opxc, opy, colorVal)                                                              \
+        asm volatile("mul16u a4, %[width], %[y]\nadd a4, a4, %[px]\nadd a4, a4, %[opx]\ns8i %[val],a4, 0"     \
+                     :                                                                                        \
+                     : [opx] "a"(opxc), [y] "a"(opy), [px] "a"(dispPx), [val] "a"(colorVal), [width] "a"(dispW) \
+                     : "a4");
+
+    /**
+     * Set a single pixel in the current render target. This checks the render target's bounds.
+     * SETUP_FOR_TURBO() must be called before this.
+     */
+    #define TURBO_SET_PIXEL_BOUNDS(opxc, opy, colorVal)                                                        \
+        asm volatile(                                                                                          \
+            "bgeu %[opx], %[width], failthrough%=\nbgeu %[y], %[height], failthrough%=\nmul16u a4, %[width], " \
+            "%[y]\nadd a4, a4, %[px]\nadd a4, a4, %[opx]\ns8i %[val],a4, 0\nfailthrough%=:\n"                  \
+            :                                                                                                  \
+            : [opx] "a"(opxc), [y] "a"(opy), [px] "a"(dispPx), [val] "a"(colorVal), [width] "a"(dispW),        \
+              [height] "a"(dispH)                                                                              \
+            : "a4");
+#else
+    /// @brief Get the current render target
+    #define SETUP_FOR_TURBO() const wsg_t* turboTarget = getRenderTarget()
+
+    /**
+     * @brief Set a pixel in the current render target, and exit if it is out of bounds. Like the firmware, this writes
+     * the pixel directly and does not mark the row dirty.
+     */
+    #define TURBO_SET_PIXEL(opxc, opy, colorVal)                                                \
+        do                                                                                      \
+        {                                                                                       \
+            if ((opxc) < 0 || (opxc) >= turboTarget->w || (opy) < 0 || (opy) >= turboTarget->h) \
+            {                                                                                   \
+                fprintf(stderr, "PXL OOB (%d, %d)\n", (int)(opxc), (int)(opy));                 \
+                exit(1);                                                                        \
+            }                                                                                   \
+            turboTarget->px[((opy) * turboTarget->w) + (opxc)] = colorVal;                      \
+        } while (0)
+
+    /**
+     * @brief Set a pixel in the current render target, if it is in bounds. Like the firmware, this writes the pixel
+     * directly and does not mark the row dirty.
+     */
+    #define TURBO_SET_PIXEL_BOUNDS(opxc, opy, colorVal)                                          \
+        do                                                                                       \
+        {                                                                                        \
+            if (0 <= (opxc) && (opxc) < turboTarget->w && 0 <= (opy) && (opy) < turboTarget->h) \
+            {                                                                                    \
+                turboTarget->px[((opy) * turboTarget->w) + (opxc)] = colorVal;                   \
+            }                                                                                    \
+        } while (0)
+#endif
+
+#endif
@@ -11,6 +11,7 @@
 #include "shapes.h"
 #include "fill.h"
 #include "macros.h"
+#include "renderTarget.h"
 
 //==============================================================================
 // Defines
@@ -19,17 +20,11 @@
 #define FIXEDPOINT   16
 #define FIXEDPOINTD2 15
 
-#if defined(__XTENSA__)
-    /* SETUP_FOR_TURBO() is defined in hdw-tft.h, but it is overridden here because accessing dispPxL is faster than
-     * getPxTftFramebuffer() */
-    #undef SETUP_FOR_TURBO
-    #define SETUP_FOR_TURBO() register uint32_t dispPx = (uint32_t)dispPxL;
-#endif
-
 //==============================================================================
 // Function Prototypes
 //==============================================================================
 
+static void markDirtyShapeRows(int yA, int yB, int yOrigin, int yScale);
 static void drawLineInner(int x0, int y0, int x1, int y1, paletteColor_t col, int dashWidth, int xOrigin, int yOrigin,
                           int xScale, int yScale);
 static void drawRectInner(int x0, int y0, int x1, int y1, paletteColor_t col, int xOrigin, int yOrigin, int xScale,
@@ -51,29 +46,32 @@ static void drawCubicBezierSegInner(int x0, int y0, float x1, float y1, float x2
 static void drawCubicBezierInner(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, paletteColor_t col,
                                  int xOrigin, int yOrigin, int xScale, int yScale);
 
-//==============================================================================
-// Variables
-//==============================================================================
-
-#if defined(__XTENSA__)
-/* @brief Static local pointer to the framebuffer. Using this, for some reason, is faster than normal draw calls. This
- * is only set for __XTENSA__ because it jams a pointer into a 32 bit variable */
-static uint32_t dispPxL = 0;
-#endif
-
 //==============================================================================
 // Functions
 //==============================================================================
 
 /**
- * @brief Initialize shape drawing by making a static local pointer to the framebuffer
- * This is done for speed reasons
+ * @brief Mark the display rows a shape may draw to as dirty. The TURBO macros write pixels directly without marking
+ * rows, so each shape marks its vertical extent once before drawing.
+ *
+ * @param yA One vertical extent of the shape, in scaled pixels
+ * @param yB The other vertical extent of the shape, in scaled pixels
+ * @param yOrigin The Y-origin, in display pixels, of the scaled pixel area
+ * @param yScale The height of each scaled pixel
+ */
+static void markDirtyShapeRows(int yA, int yB, int yOrigin, int yScale)
+{
+    int y0 = yOrigin + yA * yScale;
+    int y1 = yOrigin + yB * yScale;
+    markDirtyRowsRenderTarget(MIN(y0, y1), MAX(y0, y1) + 1);
+}
+
+/**
+ * @brief Initialize shape drawing by resetting the render target to the display
  */
 void initShapes(void)
 {
-#if defined(__XTENSA__)
-    dispPxL = (uint32_t)getPxTftFramebuffer();
-#endif
+    resetRenderTargets();
 }
 
 /**
@@ -100,6 +98,7 @@ static void drawLineInner(int x0, int y0, int x1, int y1, paletteColor_t col, in
                           int xScale, int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(y0, y1, yOrigin, yScale);
     int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
     int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
     int err       = dx + dy; /* error value e_xy */
@@ -201,6 +200,8 @@ void drawLineScaled(int x0, int y0, int x1, int y1, paletteColor_t col, int dash
 void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t color)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(y0, y1, 0, 1);
+    const wsg_t* target = getRenderTarget();
     // Tune this as a function of the size of your viewing window, line accuracy, and worst-case scenario incoming
     // lines.
     int dx            = (x1 - x0);
@@ -217,8 +218,8 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
     // Checks if both edges are outside of bounds
     // This is a simple, yet incomplete line clipping algorithm similar to Cohen–Sutherland
     // that ignores more complex cases of diagonal lines outside the viewing area
-    if ((x0 < 0 && x1 < 0) || (x0 >= TFT_WIDTH && x1 >= TFT_WIDTH) || //
-        (y0 < 0 && y1 < 0) || (y0 >= TFT_HEIGHT && y1 >= TFT_HEIGHT))
+    if ((x0 < 0 && x1 < 0) || (x0 >= target->w && x1 >= target->w) || //
+        (y0 < 0 && y1 < 0) || (y0 >= target->h && y1 >= target->h))
     {
         return;
     }
@@ -235,10 +236,10 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
             dxA = 0 - cx;
             cx  = 0;
         }
-        if (cx > (int)TFT_WIDTH - 1)
+        if (cx > (int)target->w - 1)
         {
-            dxA = (cx - ((int)TFT_WIDTH - 1));
-            cx  = (int)TFT_WIDTH - 1;
+            dxA = (cx - ((int)target->w - 1));
+            cx  = (int)target->w - 1;
         }
         if (dxA || xerrdiv <= yerrdiv)
         {
@@ -251,7 +252,7 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
                 {
                     return;
                 }
-                if (cy > (int)TFT_HEIGHT - 1 && y1 > (int)TFT_HEIGHT - 1)
+                if (cy > (int)target->h - 1 && y1 > (int)target->h - 1)
                 {
                     return;
                 }
@@ -267,10 +268,10 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
             dyA = 0 - cy;
             cy  = 0;
         }
-        if (cy > (int)TFT_HEIGHT - 1)
+        if (cy > (int)target->h - 1)
         {
-            dyA = (cy - ((int)TFT_HEIGHT - 1));
-            cy  = (int)TFT_HEIGHT - 1;
+            dyA = (cy - ((int)target->h - 1));
+            cy  = (int)target->h - 1;
         }
         if (dyA || xerrdiv > yerrdiv)
         {
@@ -283,7 +284,7 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
                 {
                     return;
                 }
-                if (cx > (int)TFT_WIDTH - 1 && x1 > (int)TFT_WIDTH - 1)
+                if (cx > (int)target->w - 1 && x1 > (int)target->w - 1)
                 {
                     return;
                 }
@@ -301,7 +302,7 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
     // Also this checks for vertical/horizontal violations.
     if (dx > 0)
     {
-        if (cx > (int)TFT_WIDTH - 1)
+        if (cx > (int)target->w - 1)
         {
             return;
         }
@@ -324,7 +325,7 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
 
     if (dy > 0)
     {
-        if (cy > (int)TFT_HEIGHT - 1)
+        if (cy > (int)target->h - 1)
         {
             return;
         }
@@ -359,9 +360,9 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
         {
             x1 = 0;
         }
-        if (x1 > (int)TFT_WIDTH - 1)
+        if (x1 > (int)target->w - 1)
         {
-            x1 = (int)TFT_WIDTH - 1;
+            x1 = (int)target->w - 1;
         }
         x1 += sdx; // Tricky - make sure the "next" mark we hit doesn't overflow.
 
@@ -369,9 +370,9 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
         {
             y1 = 0;
         }
-        if (y1 > (int)TFT_HEIGHT - 1)
+        if (y1 > (int)target->h - 1)
         {
-            y1 = (int)TFT_HEIGHT - 1;
+            y1 = (int)target->h - 1;
         }
 
         for (; cy != y1; cy += sdy)
@@ -398,9 +399,9 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
         {
             y1 = 0;
         }
-        if (y1 > (int)TFT_HEIGHT - 1)
+        if (y1 > (int)target->h - 1)
         {
-            y1 = (int)TFT_HEIGHT - 1;
+            y1 = (int)target->h - 1;
         }
         y1 += sdy; // Tricky: Make sure the NEXT mark we hit doens't overflow.
 
@@ -408,9 +409,9 @@ void drawLineFast(int16_t x0, int16_t y0, int16_t x1, int16_t y1, paletteColor_t
         {
             x1 = 0;
         }
-        if (x1 > (int)TFT_WIDTH - 1)
+        if (x1 > (int)target->w - 1)
         {
-            x1 = (int)TFT_WIDTH - 1;
+            x1 = (int)target->w - 1;
         }
 
         for (; cx != x1; cx += sdx)
@@ -448,6 +449,7 @@ static void drawRectInner(int x0, int y0, int x1, int y1, paletteColor_t col, in
                           int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(y0, y1 - 1, yOrigin, yScale);
 
     // Vertical lines
     for (int y = y0; y < y1; y++)
@@ -489,6 +491,7 @@ void drawRect(int x0, int y0, int x1, int y1, paletteColor_t col)
  */
 void drawRectFilled(int x0, int y0, int x1, int y1, paletteColor_t col)
 {
+    const wsg_t* target = getRenderTarget();
     if (col == cTransparent)
     {
         return;
@@ -528,24 +531,24 @@ void drawRectFilled(int x0, int y0, int x1, int y1, paletteColor_t col)
         y1 = 0;
     }
 
-    if (x0 > TFT_WIDTH - 1)
+    if (x0 > target->w - 1)
     {
-        x0 = TFT_WIDTH - 1;
+        x0 = target->w - 1;
     }
 
-    if (y0 > TFT_HEIGHT - 1)
+    if (y0 > target->h - 1)
     {
-        y0 = TFT_HEIGHT - 1;
+        y0 = target->h - 1;
     }
 
-    if (x1 > TFT_WIDTH - 1)
+    if (x1 > target->w - 1)
     {
-        x1 = TFT_WIDTH;
+        x1 = target->w;
     }
 
-    if (y1 > TFT_HEIGHT - 1)
+    if (y1 > target->h - 1)
     {
-        y1 = TFT_HEIGHT;
+        y1 = target->h;
     }
 
     fillDisplayArea(x0, y0, x1, y1, col);
@@ -661,6 +664,8 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
                           paletteColor_t fillColor, paletteColor_t outlineColor)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(MIN(v0y, MIN(v1y, v2y)), MAX(v0y, MAX(v1y, v2y)), 0, 1);
+    const wsg_t* target = getRenderTarget();
 
     int16_t i16tmp;
 
@@ -789,20 +794,20 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             int endx     = x0B;
             int suppress = 1;
 
-            if (y >= 0 && y < (int)TFT_HEIGHT)
+            if (y >= 0 && y < (int)target->h)
             {
                 suppress = 0;
                 if (x < 0)
                 {
                     x = 0;
                 }
-                if (endx > (int)(TFT_WIDTH))
+                if (endx > (int)(target->w))
                 {
-                    endx = (int)(TFT_WIDTH);
+                    endx = (int)(target->w);
                 }
 
                 // Draw left line
-                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)TFT_WIDTH)
+                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)target->w)
                 {
                     TURBO_SET_PIXEL(x0A, y, outlineColor);
                     x++;
@@ -818,7 +823,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
                 }
 
                 // Draw right line
-                if (cTransparent != outlineColor && x0B < (int)TFT_WIDTH && x0B >= 0)
+                if (cTransparent != outlineColor && x0B < (int)target->w && x0B >= 0)
                 {
                     TURBO_SET_PIXEL(x0B, y, outlineColor);
                 }
@@ -830,8 +835,8 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             while (errA >= (1 << FIXEDPOINT) && x0A != v1x)
             {
                 x0A += sdxA;
-                // if( x0A < 0 || x0A > (TFT_WIDTH-1) ) break;
-                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)TFT_WIDTH && !suppress)
+                // if( x0A < 0 || x0A > (target->w-1) ) break;
+                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)target->w && !suppress)
                 {
                     TURBO_SET_PIXEL(x0A, y, outlineColor);
                 }
@@ -840,8 +845,8 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             while (errB >= (1 << FIXEDPOINT) && x0B != v2x)
             {
                 x0B += sdxB;
-                // if( x0B < 0 || x0B > (TFT_WIDTH-1) ) break;
-                if (cTransparent != outlineColor && x0B >= 0 && x0B < (int)TFT_WIDTH && !suppress)
+                // if( x0B < 0 || x0B > (target->w-1) ) break;
+                if (cTransparent != outlineColor && x0B >= 0 && x0B < (int)target->w && !suppress)
                 {
                     TURBO_SET_PIXEL(x0B, y, outlineColor);
                 }
@@ -890,9 +895,9 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             errB = 1 << FIXEDPOINTD2;
         }
 
-        if (yend > (int)(TFT_HEIGHT - 1))
+        if (yend > (int)(target->h - 1))
         {
-            yend = (int)TFT_HEIGHT - 1;
+            yend = (int)target->h - 1;
         }
 
         if (xerrnumeratorA > 1000000 || xerrnumeratorB > 1000000)
@@ -909,7 +914,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             }
             if (x0A == x0B)
             {
-                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)TFT_WIDTH && y >= 0 && y < (int)TFT_HEIGHT)
+                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)target->w && y >= 0 && y < (int)target->h)
                 {
                     TURBO_SET_PIXEL(x0A, y, outlineColor);
                 }
@@ -923,20 +928,20 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             int endx     = x0B;
             int suppress = 1;
 
-            if (y >= 0 && y <= (int)(TFT_HEIGHT - 1))
+            if (y >= 0 && y <= (int)(target->h - 1))
             {
                 suppress = 0;
                 if (x < 0)
                 {
                     x = 0;
                 }
-                if (endx >= (int)(TFT_WIDTH))
+                if (endx >= (int)(target->w))
                 {
-                    endx = (TFT_WIDTH);
+                    endx = (target->w);
                 }
 
                 // Draw left line
-                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)(TFT_WIDTH))
+                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)(target->w))
                 {
                     TURBO_SET_PIXEL(x0A, y, outlineColor);
                     x++;
@@ -952,7 +957,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
                 }
 
                 // Draw right line
-                if (cTransparent != outlineColor && x0B < (int)(TFT_WIDTH) && x0B >= 0)
+                if (cTransparent != outlineColor && x0B < (int)(target->w) && x0B >= 0)
                 {
                     TURBO_SET_PIXEL(x0B, y, outlineColor);
                 }
@@ -964,8 +969,8 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             while (errA >= (1 << FIXEDPOINT))
             {
                 x0A += sdxA;
-                // if( x0A < 0 || x0A > (TFT_WIDTH-1) ) break;
-                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)(TFT_WIDTH) && !suppress)
+                // if( x0A < 0 || x0A > (target->w-1) ) break;
+                if (cTransparent != outlineColor && x0A >= 0 && x0A < (int)(target->w) && !suppress)
                 {
                     TURBO_SET_PIXEL(x0A, y, outlineColor);
                 }
@@ -978,7 +983,7 @@ void drawTriangleOutlined(int16_t v0x, int16_t v0y, int16_t v1x, int16_t v1y, in
             while (errB >= (1 << FIXEDPOINT))
             {
                 x0B += sdxB;
-                if (cTransparent != outlineColor && x0B >= 0 && x0B < (int)(TFT_WIDTH) && !suppress)
+                if (cTransparent != outlineColor && x0B >= 0 && x0B < (int)(target->w) && !suppress)
                 {
                     TURBO_SET_PIXEL(x0B, y, outlineColor);
                 }
@@ -1009,6 +1014,7 @@ static void drawEllipseInner(int xm, int ym, int a, int b, paletteColor_t col, i
                              int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - b - 1, ym + b + 1, yOrigin, yScale);
 
     int x = -a, y = 0;                                        /* II. quadrant from bottom left to top right */
     long e2 = (long)b * b, err = (long)x * (2 * e2 + x) + e2; /* error of 1.step */
@@ -1071,6 +1077,7 @@ void drawEllipseScaled(int xm, int ym, int a, int b, paletteColor_t col, int xOr
 void drawEllipse(int xm, int ym, int a, int b, paletteColor_t col)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - b - 1, ym + b + 1, 0, 1);
 
     long x = -a, y = 0;                      /* II. quadrant from bottom left to top right */
     long e2 = b, dx = (1 + 2 * x) * e2 * e2; /* error increment  */
@@ -1116,13 +1123,15 @@ void drawEllipse(int xm, int ym, int a, int b, paletteColor_t col)
  */
 static void drawCircleInner(int xm, int ym, int r, paletteColor_t col, int xOrigin, int yOrigin, int xScale, int yScale)
 {
+    const wsg_t* target = getRenderTarget();
     // Don't draw off if off screen
-    if (((xm + r) < 0 || (xm - r) > TFT_WIDTH) || ((ym + r) < 0 || (ym - r) > TFT_HEIGHT))
+    if (((xm + r) < 0 || (xm - r) > target->w) || ((ym + r) < 0 || (ym - r) > target->h))
     {
         return;
     }
 
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - r, ym + r, yOrigin, yScale);
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
@@ -1191,6 +1200,7 @@ void drawCircleScaled(int xm, int ym, int r, paletteColor_t col, int xOrigin, in
 void drawCircleQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3, bool q4, paletteColor_t col)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - r, ym + r, 0, 1);
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
@@ -1238,6 +1248,7 @@ void drawCircleQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3, bool
 void drawCircleFilledQuadrants(int xm, int ym, int r, bool q1, bool q2, bool q3, bool q4, paletteColor_t col)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - r, ym + r, 0, 1);
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
@@ -1308,6 +1319,7 @@ static void drawCircleFilledInner(int xm, int ym, int r, paletteColor_t col, int
                                   int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - r, ym + r, yOrigin, yScale);
 
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
     do
@@ -1342,6 +1354,7 @@ static void drawCircleFilledInner(int xm, int ym, int r, paletteColor_t col, int
 void drawCircleOutline(int xm, int ym, int r, int stroke, paletteColor_t col)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(ym - r, ym + r, 0, 1);
 
     // Outer circle
     int x = -r, y = 0, err = 2 - 2 * r; /* bottom left to top right */
@@ -1401,14 +1414,16 @@ void drawCircleOutline(int xm, int ym, int r, int stroke, paletteColor_t col)
  */
 void drawCircleFilled(int xm, int ym, int r, paletteColor_t col)
 {
+    const wsg_t* target = getRenderTarget();
     // Quick bounds check first
-    if (xm + r < 0 || xm - r >= TFT_WIDTH || ym + r < 0 || ym - r >= TFT_HEIGHT)
+    if (xm + r < 0 || xm - r >= target->w || ym + r < 0 || ym - r >= target->h)
     {
         return;
     }
 
     // Get a framebuffer to draw to
-    paletteColor_t* fb = getPxTftFramebuffer();
+    paletteColor_t* fb = target->px;
+    markDirtyShapeRows(ym - r, ym + r, 0, 1);
 
     // Variables for tracing the circle
     int x         = -r;
@@ -1424,23 +1439,23 @@ void drawCircleFilled(int xm, int ym, int r, paletteColor_t col)
         {
             // Find where X starts and ends on this row, clamped to the display
             int xMin   = xm + x;
-            xMin       = CLAMP(xMin, 0, TFT_WIDTH);
+            xMin       = CLAMP(xMin, 0, target->w);
             int xMax   = xm - x + 1;
-            xMax       = CLAMP(xMax, 0, TFT_WIDTH);
+            xMax       = CLAMP(xMax, 0, target->w);
             int xWidth = xMax - xMin;
 
             // Fill a row of the lower half of the circle, if on screen
             int ymp = (ym + y);
-            if (0 <= ymp && ymp < TFT_HEIGHT)
+            if (0 <= ymp && ymp < target->h)
             {
-                memset(&fb[TFT_WIDTH * ymp + xMin], col, xWidth);
+                memset(&fb[target->w * ymp + xMin], col, xWidth);
             }
 
             // Fill a row of the upper half of the circle, if on screen
             int ymn = (ym - y);
-            if (0 <= ymn && ymn < TFT_HEIGHT)
+            if (0 <= ymn && ymn < target->h)
             {
-                memset(&fb[TFT_WIDTH * ymn + xMin], col, xWidth);
+                memset(&fb[target->w * ymn + xMin], col, xWidth);
             }
         }
         else
@@ -1507,6 +1522,7 @@ static void drawEllipseRectInner(int x0, int y0, int x1, int y1, paletteColor_t
                                  int xScale, int yScale) /* rectangular parameter enclosing the ellipse */
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(MIN(y0, y1) - 1, MAX(y0, y1) + 1, yOrigin, yScale);
 
     long a = abs(x1 - x0), b = abs(y1 - y0), b1 = b & 1;          /* diameter */
     float dx = 4 * (1.0f - a) * b * b, dy = 4 * (b1 + 1) * a * a; /* error increment */
@@ -1614,6 +1630,7 @@ static void drawQuadBezierSegInner(int x0, int y0, int x1, int y1, int x2, int y
                                    int yOrigin, int xScale, int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(MIN(y0, MIN(y1, y2)), MAX(y0, MAX(y1, y2)), yOrigin, yScale);
 
     int sx = x2 - x1, sy = y2 - y1;
     long xx = x0 - x1, yy = y0 - y1; /* relative values for checks */
@@ -1831,6 +1848,7 @@ void drawQuadBezierScaled(int x0, int y0, int x1, int y1, int x2, int y2, palett
 void drawQuadRationalBezierSeg(int x0, int y0, int x1, int y1, int x2, int y2, float w, paletteColor_t col)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(MIN(y0, MIN(y1, y2)), MAX(y0, MAX(y1, y2)), 0, 1);
 
     int sx = x2 - x1, sy = y2 - y1; /* relative values for checks */
     float dx = x0 - x2, dy = y0 - y2, xx = x0 - x1, yy = y0 - y1;
@@ -2069,6 +2087,8 @@ static void drawCubicBezierSegInner(int x0, int y0, float x1, float y1, float x2
                                     paletteColor_t col, int xOrigin, int yOrigin, int xScale, int yScale)
 {
     SETUP_FOR_TURBO();
+    markDirtyShapeRows(MIN(MIN(y0, y3), (int)floorf(MIN(y1, y2))), MAX(MAX(y0, y3), (int)ceilf(MAX(y1, y2))),
+                       yOrigin, yScale);
 
     int f, fx, fy, leg = 1;
     int sx = x0 < x3 ? 1 : -1, sy = y0 < y3 ? 1 : -1; /* step direction */
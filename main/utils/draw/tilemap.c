@@ -0,0 +1,741 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include "tilemap.h"
+#include "cnfs.h"
+#include "fs_wsg.h"
+#include "renderTarget.h"
+#include "macros.h"
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/**
+ * @brief How a tile's pixels are drawn
+ */
+typedef enum
+{
+    TILE_TRANSPARENT, ///< Every pixel is transparent, so the tile is skipped
+    TILE_OPAQUE,      ///< No pixel is transparent, so rows are copied whole
+    TILE_MIXED,       ///< Some pixels are transparent, so they are checked one by one
+} tileFlag_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static int32_t floorDiv(int64_t a, int32_t b);
+static int32_t posMod(int32_t a, int32_t b);
+static uint8_t getLayerTile(const tilemapLayer_t* layer, int32_t col, int32_t row);
+static void blitTile(const tileAtlas_t* atlas, uint8_t tile, const wsg_t* dst, int32_t dx, int32_t dy);
+static void drawCacheCell(tilemapLayer_t* layer, int32_t col, int32_t row);
+static void drawCacheCells(tilemapLayer_t* layer, int32_t colStart, int32_t colEnd, int32_t rowStart, int32_t rowEnd);
+static void updateLayerCache(tilemapLayer_t* layer, int32_t lx, int32_t ly);
+
+//==============================================================================
+// Static Functions
+//==============================================================================
+
+/**
+ * @brief Divide, rounding towards negative infinity
+ *
+ * @param a The dividend
+ * @param b The divisor, which must be positive
+ * @return a / b, rounded down
+ */
+static int32_t floorDiv(int64_t a, int32_t b)
+{
+    return (a >= 0) ? (a / b) : -((b - 1 - a) / b);
+}
+
+/**
+ * @brief Find a modulus which is never negative
+ *
+ * @param a The dividend
+ * @param b The divisor, which must be positive
+ * @return a mod b, from 0 to b - 1
+ */
+static int32_t posMod(int32_t a, int32_t b)
+{
+    int32_t m = a % b;
+    return (m < 0) ? (m + b) : m;
+}
+
+/**
+ * @brief Get a tile in a layer, wrapping or returning an empty tile outside of it
+ *
+ * @param layer The layer to get a tile from
+ * @param col The column of the tile, which may be outside the layer
+ * @param row The row of the tile, which may be outside the layer
+ * @return The tile index
+ */
+static uint8_t getLayerTile(const tilemapLayer_t* layer, int32_t col, int32_t row)
+{
+    if (layer->wrapX)
+    {
+        col = posMod(col, layer->w);
+    }
+    else if (col < 0 || col >= layer->w)
+    {
+        return TILEMAP_EMPTY;
+    }
+
+    if (layer->wrapY)
+    {
+        row = posMod(row, layer->h);
+    }
+    else if (row < 0 || row >= layer->h)
+    {
+        return TILEMAP_EMPTY;
+    }
+
+    return layer->tiles[row * layer->w + col];
+}
+
+/**
+ * @brief Draw the current frame of a tile into a WSG, clipped to the WSG
+ *
+ * @param atlas The atlas to draw the tile from
+ * @param tile The tile index to draw
+ * @param dst The WSG to draw into
+ * @param dx The X coordinate of the tile's top left in the WSG
+ * @param dy The Y coordinate of the tile's top left in the WSG
+ */
+static void blitTile(const tileAtlas_t* atlas, uint8_t tile, const wsg_t* dst, int32_t dx, int32_t dy)
+{
+    tile               = atlas->drawTile[tile];
+    uint8_t drawMethod = atlas->flags[tile];
+    if (TILE_TRANSPARENT == drawMethod)
+    {
+        return;
+    }
+
+    // Clip the tile to the destination once
+    int32_t x0 = MAX(dx, 0);
+    int32_t y0 = MAX(dy, 0);
+    int32_t x1 = MIN(dx + atlas->tileW, (int32_t)dst->w);
+    int32_t y1 = MIN(dy + atlas->tileH, (int32_t)dst->h);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    int32_t srcW              = atlas->wsg.w;
+    int32_t srcX              = ((tile - 1) % atlas->cols) * atlas->tileW + (x0 - dx);
+    int32_t srcY              = ((tile - 1) / atlas->cols) * atlas->tileH + (y0 - dy);
+    const paletteColor_t* src = &atlas->wsg.px[srcY * srcW + srcX];
+    paletteColor_t* out       = &dst->px[y0 * dst->w + x0];
+    int32_t len               = x1 - x0;
+
+    if (TILE_OPAQUE == drawMethod)
+    {
+        for (int32_t y = y0; y < y1; y++)
+        {
+            memcpy(out, src, len);
+            src += srcW;
+            out += dst->w;
+        }
+    }
+    else
+    {
+        for (int32_t y = y0; y < y1; y++)
+        {
+            for (int32_t x = 0; x < len; x++)
+            {
+                if (cTransparent != src[x])
+                {
+                    out[x] = src[x];
+                }
+            }
+            src += srcW;
+            out += dst->w;
+        }
+    }
+}
+
+/**
+ * @brief Draw a single tile of a layer into the layer's cache, over its background color
+ *
+ * @param layer The layer with the cache to draw into
+ * @param col The layer column to draw, which must be in the cached columns
+ * @param row The layer row to draw, which must be in the cached rows
+ */
+static void drawCacheCell(tilemapLayer_t* layer, int32_t col, int32_t row)
+{
+    tilemapCache_t* cache = layer->cache;
+    tileAtlas_t* atlas    = layer->atlas;
+    int32_t dx            = posMod(col, cache->cols) * atlas->tileW;
+    int32_t dy            = posMod(row, cache->rows) * atlas->tileH;
+
+    paletteColor_t* out = &cache->wsg.px[dy * cache->wsg.w + dx];
+    for (int32_t y = 0; y < atlas->tileH; y++)
+    {
+        memset(out, cache->bgColor, atlas->tileW);
+        out += cache->wsg.w;
+    }
+    blitTile(atlas, getLayerTile(layer, col, row), &cache->wsg, dx, dy);
+}
+
+/**
+ * @brief Draw a range of a layer's tiles into the layer's cache
+ *
+ * @param layer The layer with the cache to draw into
+ * @param colStart The first layer column to draw, inclusive
+ * @param colEnd The last layer column to draw, exclusive
+ * @param rowStart The first layer row to draw, inclusive
+ * @param rowEnd The last layer row to draw, exclusive
+ */
+static void drawCacheCells(tilemapLayer_t* layer, int32_t colStart, int32_t colEnd, int32_t rowStart, int32_t rowEnd)
+{
+    for (int32_t row = rowStart; row < rowEnd; row++)
+    {
+        for (int32_t col = colStart; col < colEnd; col++)
+        {
+            drawCacheCell(layer, col, row);
+        }
+    }
+}
+
+/**
+ * @brief Bring a layer's cache up to date for the layer's scroll position. Only tiles which scrolled into the cache
+ * and animated tiles which changed frames are drawn, unless the cache is invalid or the layer scrolled too far
+ *
+ * @param layer The layer with the cache to update
+ * @param lx The X coordinate of the layer which is at the left of the display
+ * @param ly The Y coordinate of the layer which is at the top of the display
+ */
+static void updateLayerCache(tilemapLayer_t* layer, int32_t lx, int32_t ly)
+{
+    tilemapCache_t* cache = layer->cache;
+    tileAtlas_t* atlas    = layer->atlas;
+    int32_t col0          = floorDiv(lx, atlas->tileW);
+    int32_t row0          = floorDiv(ly, atlas->tileH);
+
+    if (!cache->valid || ABS(col0 - cache->col0) >= cache->cols || ABS(row0 - cache->row0) >= cache->rows)
+    {
+        // Draw everything
+        drawCacheCells(layer, col0, col0 + cache->cols, row0, row0 + cache->rows);
+        cache->valid = true;
+    }
+    else
+    {
+        // Draw the newly exposed columns, then the newly exposed rows
+        if (col0 > cache->col0)
+        {
+            drawCacheCells(layer, cache->col0 + cache->cols, col0 + cache->cols, row0, row0 + cache->rows);
+        }
+        else if (col0 < cache->col0)
+        {
+            drawCacheCells(layer, col0, cache->col0, row0, row0 + cache->rows);
+        }
+
+        if (row0 > cache->row0)
+        {
+            drawCacheCells(layer, col0, col0 + cache->cols, cache->row0 + cache->rows, row0 + cache->rows);
+        }
+        else if (row0 < cache->row0)
+        {
+            drawCacheCells(layer, col0, col0 + cache->cols, row0, cache->row0);
+        }
+
+        // Redraw animated tiles if they changed frames
+        if (cache->animGeneration != atlas->animGeneration)
+        {
+            for (int32_t row = row0; row < row0 + cache->rows; row++)
+            {
+                for (int32_t col = col0; col < col0 + cache->cols; col++)
+                {
+                    if (atlas->animated[getLayerTile(layer, col, row)])
+                    {
+                        drawCacheCell(layer, col, row);
+                    }
+                }
+            }
+        }
+    }
+
+    cache->col0           = col0;
+    cache->row0           = row0;
+    cache->animGeneration = atlas->animGeneration;
+}
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Load a tile atlas from a WSG in ROM. The WSG is split into tiles from left to right, then top to bottom,
+ * and tile index \c n draws the \c n-1th tile. Any partial tiles at the right or bottom edge are ignored
+ *
+ * @param fIdx The cnfsFileIdx_t of the WSG to load
+ * @param atlas The atlas to load into
+ * @param tileW The width of each tile
+ * @param tileH The height of each tile
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
+ * than normal RAM
+ * @return true if the atlas was loaded, false if it wasn't
+ */
+bool loadTileAtlas(cnfsFileIdx_t fIdx, tileAtlas_t* atlas, uint16_t tileW, uint16_t tileH, bool spiRam)
+{
+    memset(atlas, 0, sizeof(tileAtlas_t));
+    if (0 == tileW || 0 == tileH)
+    {
+        ESP_LOGE("TILEMAP", "Tiles must have a size");
+        return false;
+    }
+
+    if (!loadWsg(fIdx, &atlas->wsg, spiRam))
+    {
+        ESP_LOGE("TILEMAP", "Couldn't load tile atlas %d", fIdx);
+        return false;
+    }
+
+    atlas->tileW    = tileW;
+    atlas->tileH    = tileH;
+    atlas->cols     = atlas->wsg.w / tileW;
+    atlas->numTiles = MIN(atlas->cols * (atlas->wsg.h / tileH), TILEMAP_MAX_TILES);
+
+    // Find how to draw each tile. Indices past the last tile, and the empty tile, stay transparent
+    for (int32_t tile = 0; tile <= TILEMAP_MAX_TILES; tile++)
+    {
+        atlas->drawTile[tile] = tile;
+    }
+    for (int32_t tile = 1; tile <= atlas->numTiles; tile++)
+    {
+        const paletteColor_t* px = &atlas->wsg.px[((tile - 1) / atlas->cols) * tileH * atlas->wsg.w
+                                                  + ((tile - 1) % atlas->cols) * tileW];
+        int32_t numTransparent   = 0;
+        for (int32_t y = 0; y < tileH; y++)
+        {
+            for (int32_t x = 0; x < tileW; x++)
+            {
+                if (cTransparent == px[y * atlas->wsg.w + x])
+                {
+                    numTransparent++;
+                }
+            }
+        }
+
+        if (0 == numTransparent)
+        {
+            atlas->flags[tile] = TILE_OPAQUE;
+        }
+        else if (tileW * tileH == numTransparent)
+        {
+            atlas->flags[tile] = TILE_TRANSPARENT;
+        }
+        else
+        {
+            atlas->flags[tile] = TILE_MIXED;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Free a tile atlas
+ *
+ * @param atlas The atlas to free
+ */
+void freeTileAtlas(tileAtlas_t* atlas)
+{
+    freeWsg(&atlas->wsg);
+    atlas->numTiles = 0;
+}
+
+/**
+ * @brief Animate a tile. Wherever the tile is in a layer, it is drawn as the next tile in the atlas after each frame,
+ * until the last frame, and then the animation repeats. Call updateTileAtlas() to advance animations.
+ *
+ * @param atlas The atlas to add an animation to
+ * @param firstTile The tile index to animate, which is also the first frame
+ * @param numFrames The number of consecutive tiles in the animation
+ * @param frameUs The time each frame is shown, in microseconds
+ * @return true if the animation was added, false if there are too many animations or not enough tiles
+ */
+bool addTileAnimation(tileAtlas_t* atlas, uint8_t firstTile, uint8_t numFrames, int32_t frameUs)
+{
+    if (atlas->numAnims >= TILEMAP_MAX_ANIMS)
+    {
+        ESP_LOGE("TILEMAP", "Too many tile animations");
+        return false;
+    }
+
+    if (TILEMAP_EMPTY == firstTile || 0 == numFrames || frameUs <= 0 || firstTile + numFrames - 1 > atlas->numTiles)
+    {
+        ESP_LOGE("TILEMAP", "Invalid animation for tile %d", firstTile);
+        return false;
+    }
+
+    tileAnim_t* anim = &atlas->anims[atlas->numAnims++];
+    anim->firstTile  = firstTile;
+    anim->numFrames  = numFrames;
+    anim->frame      = 0;
+    anim->frameUs    = frameUs;
+    anim->timerUs    = 0;
+
+    atlas->animated[firstTile] = true;
+    atlas->drawTile[firstTile] = firstTile;
+    atlas->animGeneration++;
+    return true;
+}
+
+/**
+ * @brief Advance a tile atlas's animations. This should be called once per frame.
+ *
+ * @param atlas The atlas to animate
+ * @param elapsedUs The time since this was last called, in microseconds
+ */
+void updateTileAtlas(tileAtlas_t* atlas, int64_t elapsedUs)
+{
+    bool changed = false;
+    for (int32_t aIdx = 0; aIdx < atlas->numAnims; aIdx++)
+    {
+        tileAnim_t* anim = &atlas->anims[aIdx];
+        int32_t oldFrame = anim->frame;
+
+        // Skip whole loops if a lot of time passed
+        anim->timerUs = (anim->timerUs + elapsedUs) % ((int64_t)anim->frameUs * anim->numFrames);
+        while (anim->timerUs >= anim->frameUs)
+        {
+            anim->timerUs -= anim->frameUs;
+            anim->frame = (anim->frame + 1) % anim->numFrames;
+        }
+
+        if (oldFrame != anim->frame)
+        {
+            atlas->drawTile[anim->firstTile] = anim->firstTile + anim->frame;
+            changed                          = true;
+        }
+    }
+
+    if (changed)
+    {
+        atlas->animGeneration++;
+    }
+}
+
+/**
+ * @brief Load a layer from a level file in ROM. The first byte of the file is the width in tiles, the second is the
+ * height in tiles, and then there is one tile index per byte in row order. Anything after the tiles is ignored
+ *
+ * @param fIdx The cnfsFileIdx_t of the level file to load
+ * @param layer The layer to load into
+ * @param atlas The atlas to draw the layer's tiles from
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
+ * than normal RAM
+ * @return true if the layer was loaded, false if it wasn't
+ */
+bool loadTilemapLayer(cnfsFileIdx_t fIdx, tilemapLayer_t* layer, tileAtlas_t* atlas, bool spiRam)
+{
+    size_t sz;
+    uint8_t* buf = cnfsReadFile(fIdx, &sz, spiRam);
+    if (NULL == buf)
+    {
+        ESP_LOGE("TILEMAP", "Failed to read %d", fIdx);
+        return false;
+    }
+
+    if (sz < 2 || 0 == buf[0] || 0 == buf[1] || sz < 2 + (buf[0] * buf[1]))
+    {
+        ESP_LOGE("TILEMAP", "Level file %d is too short", fIdx);
+        heap_caps_free(buf);
+        return false;
+    }
+
+    memset(layer, 0, sizeof(tilemapLayer_t));
+    layer->w         = buf[0];
+    layer->h         = buf[1];
+    layer->atlas     = atlas;
+    layer->parallaxX = TILEMAP_PARALLAX_ONE;
+    layer->parallaxY = TILEMAP_PARALLAX_ONE;
+
+    // Move the tiles to the start of the buffer rather than allocating and copying
+    memmove(buf, &buf[2], layer->w * layer->h);
+    layer->tiles = buf;
+    return true;
+}
+
+/**
+ * @brief Create an empty layer
+ *
+ * @param layer The layer to create
+ * @param atlas The atlas to draw the layer's tiles from
+ * @param w The width of the layer, in tiles
+ * @param h The height of the layer, in tiles
+ * @param spiRam true to allocate in SPI RAM, false to allocate in normal RAM
+ * @return true if the layer was created, false if memory couldn't be allocated
+ */
+bool initTilemapLayer(tilemapLayer_t* layer, tileAtlas_t* atlas, uint16_t w, uint16_t h, bool spiRam)
+{
+    memset(layer, 0, sizeof(tilemapLayer_t));
+    if (0 == w || 0 == h)
+    {
+        ESP_LOGE("TILEMAP", "Layers must have a size");
+        return false;
+    }
+
+    layer->tiles = (uint8_t*)heap_caps_calloc(w * h, sizeof(uint8_t), spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (NULL == layer->tiles)
+    {
+        ESP_LOGE("TILEMAP", "Couldn't allocate a %dx%d layer", w, h);
+        return false;
+    }
+
+    layer->w         = w;
+    layer->h         = h;
+    layer->atlas     = atlas;
+    layer->parallaxX = TILEMAP_PARALLAX_ONE;
+    layer->parallaxY = TILEMAP_PARALLAX_ONE;
+    return true;
+}
+
+/**
+ * @brief Free a layer and its cache
+ *
+ * @param layer The layer to free
+ */
+void freeTilemapLayer(tilemapLayer_t* layer)
+{
+    if (NULL != layer->cache)
+    {
+        heap_caps_free(layer->cache->wsg.px);
+        heap_caps_free(layer->cache);
+        layer->cache = NULL;
+    }
+    heap_caps_free(layer->tiles);
+    layer->tiles = NULL;
+}
+
+/**
+ * @brief Keep a pre-rendered cache of a layer's visible tiles. When the camera scrolls less than a screen, only newly
+ * exposed tiles are drawn into the cache, and the cache is copied to the display.
+ *
+ * The layer is drawn opaque with the given background color behind its tiles. If the layer is drawn to a render
+ * target larger than the view size, the cache is not used.
+ *
+ * @param layer The layer to cache
+ * @param viewW The width of the area the layer is drawn to, usually TFT_WIDTH
+ * @param viewH The height of the area the layer is drawn to, usually TFT_HEIGHT
+ * @param bgColor The color to draw behind the layer's tiles
+ * @param spiRam true to allocate in SPI RAM, false to allocate in normal RAM
+ * @return true if the cache was allocated, false if it wasn't
+ */
+bool enableTilemapLayerCache(tilemapLayer_t* layer, uint16_t viewW, uint16_t viewH, paletteColor_t bgColor,
+                             bool spiRam)
+{
+    if (NULL != layer->cache)
+    {
+        // Replace any existing cache
+        heap_caps_free(layer->cache->wsg.px);
+        heap_caps_free(layer->cache);
+        layer->cache = NULL;
+    }
+
+    tilemapCache_t* cache = (tilemapCache_t*)heap_caps_calloc(1, sizeof(tilemapCache_t), MALLOC_CAP_8BIT);
+    if (NULL == cache)
+    {
+        ESP_LOGE("TILEMAP", "Couldn't allocate a layer cache");
+        return false;
+    }
+
+    // One more tile than the view in each direction, so any scroll position fits
+    tileAtlas_t* atlas = layer->atlas;
+    cache->cols        = (viewW + atlas->tileW - 1) / atlas->tileW + 1;
+    cache->rows        = (viewH + atlas->tileH - 1) / atlas->tileH + 1;
+    cache->wsg.w       = cache->cols * atlas->tileW;
+    cache->wsg.h       = cache->rows * atlas->tileH;
+    cache->wsg.px      = (paletteColor_t*)heap_caps_malloc(sizeof(paletteColor_t) * cache->wsg.w * cache->wsg.h,
+                                                           spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (NULL == cache->wsg.px)
+    {
+        ESP_LOGE("TILEMAP", "Couldn't allocate a %dx%d layer cache", cache->wsg.w, cache->wsg.h);
+        heap_caps_free(cache);
+        return false;
+    }
+
+    cache->bgColor = (cTransparent == bgColor) ? c000 : bgColor;
+    cache->valid   = false;
+    layer->cache   = cache;
+    return true;
+}
+
+/**
+ * @brief Get a tile in a layer
+ *
+ * @param layer The layer to get a tile from
+ * @param x The column of the tile
+ * @param y The row of the tile
+ * @return The tile index, or ::TILEMAP_EMPTY if the coordinates are outside the layer
+ */
+uint8_t getTilemapTile(const tilemapLayer_t* layer, int32_t x, int32_t y)
+{
+    if (x < 0 || x >= layer->w || y < 0 || y >= layer->h)
+    {
+        return TILEMAP_EMPTY;
+    }
+    return layer->tiles[y * layer->w + x];
+}
+
+/**
+ * @brief Set a tile in a layer. If the layer is cached, the tile is redrawn in the cache wherever it is visible
+ *
+ * @param layer The layer to set a tile in
+ * @param x The column of the tile
+ * @param y The row of the tile
+ * @param tile The tile index to set
+ */
+void setTilemapTile(tilemapLayer_t* layer, int32_t x, int32_t y, uint8_t tile)
+{
+    if (x < 0 || x >= layer->w || y < 0 || y >= layer->h)
+    {
+        return;
+    }
+    layer->tiles[y * layer->w + x] = tile;
+
+    tilemapCache_t* cache = layer->cache;
+    if (NULL == cache || !cache->valid)
+    {
+        return;
+    }
+
+    // A wrapping layer may show the same tile more than once, so check every cached column and row
+    for (int32_t row = cache->row0; row < cache->row0 + cache->rows; row++)
+    {
+        if ((layer->wrapY ? posMod(row, layer->h) : row) != y)
+        {
+            continue;
+        }
+        for (int32_t col = cache->col0; col < cache->col0 + cache->cols; col++)
+        {
+            if ((layer->wrapX ? posMod(col, layer->w) : col) == x)
+            {
+                drawCacheCell(layer, col, row);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draw a single layer to the current render target. Only visible tiles are drawn, and each is clipped once
+ *
+ * @param layer The layer to draw
+ * @param camX The X coordinate of the camera's top left, before the layer's parallax
+ * @param camY The Y coordinate of the camera's top left, before the layer's parallax
+ */
+void drawTilemapLayer(tilemapLayer_t* layer, int32_t camX, int32_t camY)
+{
+    tileAtlas_t* atlas  = layer->atlas;
+    const wsg_t* target = getRenderTarget();
+    if (NULL == layer->tiles || NULL == atlas || 0 == atlas->numTiles || 0 == target->w || 0 == target->h)
+    {
+        return;
+    }
+
+    // Find the part of the layer at the top left of the render target
+    int32_t lx = floorDiv((int64_t)camX * layer->parallaxX, TILEMAP_PARALLAX_ONE) + layer->offsetX;
+    int32_t ly = floorDiv((int64_t)camY * layer->parallaxY, TILEMAP_PARALLAX_ONE) + layer->offsetY;
+    markDirtyRowsRenderTarget(0, target->h);
+
+    tilemapCache_t* cache = layer->cache;
+    if (NULL != cache && target->w <= cache->wsg.w - atlas->tileW && target->h <= cache->wsg.h - atlas->tileH)
+    {
+        updateLayerCache(layer, lx, ly);
+
+        // Copy the cache row by row, in up to two pieces where it wraps around
+        int32_t cx          = posMod(lx, cache->wsg.w);
+        int32_t firstLen    = MIN(cache->wsg.w - cx, (int32_t)target->w);
+        paletteColor_t* out = target->px;
+        for (int32_t y = 0; y < target->h; y++)
+        {
+            const paletteColor_t* src = &cache->wsg.px[posMod(ly + y, cache->wsg.h) * cache->wsg.w];
+            memcpy(out, &src[cx], firstLen);
+            if (firstLen < target->w)
+            {
+                memcpy(&out[firstLen], src, target->w - firstLen);
+            }
+            out += target->w;
+        }
+        return;
+    }
+
+    // Draw each visible tile
+    int32_t col0 = floorDiv(lx, atlas->tileW);
+    int32_t row0 = floorDiv(ly, atlas->tileH);
+    int32_t col1 = floorDiv(lx + target->w - 1, atlas->tileW);
+    int32_t row1 = floorDiv(ly + target->h - 1, atlas->tileH);
+    for (int32_t row = row0; row <= row1; row++)
+    {
+        int32_t dy = row * atlas->tileH - ly;
+        for (int32_t col = col0; col <= col1; col++)
+        {
+            uint8_t tile = getLayerTile(layer, col, row);
+            if (TILEMAP_EMPTY != tile)
+            {
+                blitTile(atlas, tile, target, col * atlas->tileW - lx, dy);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Clear a tilemap, removing all layers and moving the camera to the origin
+ *
+ * @param tilemap The tilemap to clear
+ */
+void initTilemap(tilemap_t* tilemap)
+{
+    memset(tilemap, 0, sizeof(tilemap_t));
+}
+
+/**
+ * @brief Add a layer to a tilemap in front of the other layers. The layer is not copied, so it must not be freed while
+ * the tilemap is used
+ *
+ * @param tilemap The tilemap to add a layer to
+ * @param layer The layer to add
+ * @return true if the layer was added, false if the tilemap has too many layers
+ */
+bool addTilemapLayer(tilemap_t* tilemap, tilemapLayer_t* layer)
+{
+    if (tilemap->numLayers >= TILEMAP_MAX_LAYERS)
+    {
+        ESP_LOGE("TILEMAP", "Too many tilemap layers");
+        return false;
+    }
+    tilemap->layers[tilemap->numLayers++] = layer;
+    return true;
+}
+
+/**
+ * @brief Move a tilemap's camera
+ *
+ * @param tilemap The tilemap to move the camera of
+ * @param x The X coordinate of the camera's top left, in pixels
+ * @param y The Y coordinate of the camera's top left, in pixels
+ */
+void setTilemapCamera(tilemap_t* tilemap, int32_t x, int32_t y)
+{
+    tilemap->camX = x;
+    tilemap->camY = y;
+}
+
+/**
+ * @brief Draw every layer of a tilemap to the current render target, back to front
+ *
+ * @param tilemap The tilemap to draw
+ */
+void drawTilemap(tilemap_t* tilemap)
+{
+    for (int32_t lIdx = 0; lIdx < tilemap->numLayers; lIdx++)
+    {
+        drawTilemapLayer(tilemap->layers[lIdx], tilemap->camX, tilemap->camY);
+    }
+}
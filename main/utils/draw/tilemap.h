@@ -0,0 +1,210 @@
+/*! \file tilemap.h
+ *
+ * \section tilemap_design Design Philosophy
+ *
+ * A tilemap draws a large scrolling background from a grid of small tiles, so each scrolling game doesn't need to
+ * write its own tile drawing.
+ *
+ * A ::tileAtlas_t is a single WSG holding every tile in a grid, loaded from the filesystem. When it is loaded, each
+ * tile is checked for transparency. Fully opaque tiles are drawn by copying whole rows with \c memcpy(), fully
+ * transparent tiles are skipped, and only tiles which mix the two are drawn pixel by pixel.
+ *
+ * A ::tilemapLayer_t is a grid of tile indices which uses an atlas. Index 0 is empty, and index \c n draws tile \c n-1
+ * from the atlas. This matches the level files written by the Tiled extensions in \c tools/, where the first two bytes
+ * are the width and height in tiles, followed by one byte per tile in row order. Each layer has its own parallax, so
+ * a far background can scroll slower than the foreground, and may wrap around at its edges.
+ *
+ * A ::tilemap_t is a stack of layers and a camera. drawTilemap() draws the layers back to front, and each layer only
+ * draws the tiles which are visible through the camera, clipped once per tile rather than per pixel.
+ *
+ * Tiles can be animated. An animation cycles a tile index through consecutive tiles in the atlas, and every layer using
+ * that atlas draws the current frame.
+ *
+ * A layer may keep a cache of its visible tiles, pre-rendered into a buffer a tile larger than the display in each
+ * direction. The cache wraps around, so when the camera scrolls by less than a screen, only the newly exposed column or
+ * row of tiles is drawn into it, and then the cache is copied to the display row by row. This makes a busy background
+ * almost as cheap to draw as a single full-screen image. A cached layer is drawn opaque, with its transparent pixels
+ * filled with a background color, so it should be the back layer.
+ *
+ * \section tilemap_usage Usage
+ *
+ * loadTileAtlas() loads an atlas WSG and splits it into tiles of the given size. freeTileAtlas() frees it.
+ * addTileAnimation() animates a run of tiles, and updateTileAtlas() advances the animations, and should be called once
+ * per frame.
+ *
+ * loadTilemapLayer() loads a layer from a level file, and initTilemapLayer() creates an empty one. freeTilemapLayer()
+ * frees either. getTilemapTile() and setTilemapTile() get and set tiles in a layer. enableTilemapLayerCache() adds a
+ * cache to a layer.
+ *
+ * initTilemap() clears a tilemap, addTilemapLayer() adds layers from back to front, setTilemapCamera() moves the
+ * camera, and drawTilemap() draws it to the current render target. drawTilemapLayer() draws a single layer.
+ *
+ * Tilemaps draw to the current render target (see renderTarget.h), so the same tilemap may be drawn to a smaller WSG
+ * for a minimap or split screen.
+ *
+ * \section tilemap_example Example
+ *
+ * \code{.c}
+ * tileAtlas_t atlas;
+ * tilemapLayer_t background;
+ * tilemapLayer_t level;
+ * tilemap_t tilemap;
+ *
+ * // Load a 16x16 pixel tile atlas, with tile 5 animated over 4 frames
+ * loadTileAtlas(LEVEL_TILES_WSG, &atlas, 16, 16, false);
+ * addTileAnimation(&atlas, 5, 4, 100000);
+ *
+ * // Load the layers. The background scrolls at half speed and is cached
+ * loadTilemapLayer(LEVEL_BG_BIN, &background, &atlas, false);
+ * background.parallaxX = TILEMAP_PARALLAX_ONE / 2;
+ * background.wrapX     = true;
+ * enableTilemapLayerCache(&background, TFT_WIDTH, TFT_HEIGHT, c012, true);
+ * loadTilemapLayer(LEVEL_1_BIN, &level, &atlas, false);
+ *
+ * initTilemap(&tilemap);
+ * addTilemapLayer(&tilemap, &background);
+ * addTilemapLayer(&tilemap, &level);
+ *
+ * // Each frame
+ * updateTileAtlas(&atlas, elapsedUs);
+ * setTilemapCamera(&tilemap, playerX - TFT_WIDTH / 2, 0);
+ * drawTilemap(&tilemap);
+ *
+ * // When done
+ * freeTilemapLayer(&level);
+ * freeTilemapLayer(&background);
+ * freeTileAtlas(&atlas);
+ * \endcode
+ */
+
+#ifndef _TILEMAP_H_
+#define _TILEMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "palette.h"
+#include "wsg.h"
+#include "cnfs_image.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The tile index for an empty tile, which draws nothing
+#define TILEMAP_EMPTY 0
+
+/// The most tiles an atlas may have, since layers store one byte per tile and 0 is empty
+#define TILEMAP_MAX_TILES 255
+
+/// The most animations an atlas may have
+#define TILEMAP_MAX_ANIMS 16
+
+/// The most layers a tilemap may have
+#define TILEMAP_MAX_LAYERS 4
+
+/// The parallax for a layer which scrolls with the camera
+#define TILEMAP_PARALLAX_ONE 256
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief An animation which cycles a run of consecutive tiles
+ */
+typedef struct
+{
+    uint8_t firstTile; ///< The tile index of the first frame, and the index which is animated
+    uint8_t numFrames; ///< The number of consecutive tiles in the animation
+    uint8_t frame;     ///< The current frame
+    int32_t frameUs;   ///< The time each frame is shown, in microseconds
+    int32_t timerUs;   ///< The time the current frame has been shown, in microseconds
+} tileAnim_t;
+
+/**
+ * @brief A WSG split into equally sized tiles, with information about each tile to draw it quickly
+ */
+typedef struct
+{
+    wsg_t wsg;                               ///< The WSG holding every tile
+    uint16_t tileW;                          ///< The width of each tile
+    uint16_t tileH;                          ///< The height of each tile
+    uint16_t cols;                           ///< The number of tiles in each row of the WSG
+    uint16_t numTiles;                       ///< The number of tiles in the WSG
+    uint8_t flags[TILEMAP_MAX_TILES + 1];    ///< Whether each tile index is opaque, transparent, or mixed
+    uint8_t animated[TILEMAP_MAX_TILES + 1]; ///< Nonzero for each tile index which is animated
+    uint8_t drawTile[TILEMAP_MAX_TILES + 1]; ///< The tile index to draw for each tile index, after animation
+    tileAnim_t anims[TILEMAP_MAX_ANIMS];     ///< The animations
+    uint8_t numAnims;                        ///< The number of animations
+    uint32_t animGeneration;                 ///< Incremented whenever an animation changes frames
+} tileAtlas_t;
+
+/**
+ * @brief A pre-rendered, wrapping cache of a layer's visible tiles
+ */
+typedef struct
+{
+    wsg_t wsg;               ///< The cached pixels, a whole number of tiles in each direction
+    uint16_t cols;           ///< The number of tile columns in the cache
+    uint16_t rows;           ///< The number of tile rows in the cache
+    int32_t col0;            ///< The first layer column in the cache
+    int32_t row0;            ///< The first layer row in the cache
+    bool valid;              ///< false if the whole cache must be drawn again
+    uint32_t animGeneration; ///< The atlas's animGeneration when animated tiles were last drawn to the cache
+    paletteColor_t bgColor;  ///< The color drawn behind transparent pixels
+} tilemapCache_t;
+
+/**
+ * @brief A grid of tile indices drawn with a tile atlas
+ */
+typedef struct
+{
+    uint8_t* tiles;        ///< The tile indices in row order, ::TILEMAP_EMPTY for no tile
+    uint16_t w;            ///< The width of the layer, in tiles
+    uint16_t h;            ///< The height of the layer, in tiles
+    tileAtlas_t* atlas;    ///< The atlas to draw tiles from
+    int32_t parallaxX;     ///< The horizontal scroll speed, where ::TILEMAP_PARALLAX_ONE scrolls with the camera
+    int32_t parallaxY;     ///< The vertical scroll speed, where ::TILEMAP_PARALLAX_ONE scrolls with the camera
+    int32_t offsetX;       ///< A horizontal offset added after parallax, in pixels
+    int32_t offsetY;       ///< A vertical offset added after parallax, in pixels
+    bool wrapX;            ///< true to repeat the layer horizontally, false to leave it empty outside its width
+    bool wrapY;            ///< true to repeat the layer vertically, false to leave it empty outside its height
+    tilemapCache_t* cache; ///< The cache of visible tiles, or NULL to draw every visible tile each frame
+} tilemapLayer_t;
+
+/**
+ * @brief Layers drawn back to front through a camera
+ */
+typedef struct
+{
+    tilemapLayer_t* layers[TILEMAP_MAX_LAYERS]; ///< The layers, back to front
+    uint8_t numLayers;                          ///< The number of layers
+    int32_t camX;                               ///< The X coordinate of the camera's top left, in pixels
+    int32_t camY;                               ///< The Y coordinate of the camera's top left, in pixels
+} tilemap_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+bool loadTileAtlas(cnfsFileIdx_t fIdx, tileAtlas_t* atlas, uint16_t tileW, uint16_t tileH, bool spiRam);
+void freeTileAtlas(tileAtlas_t* atlas);
+bool addTileAnimation(tileAtlas_t* atlas, uint8_t firstTile, uint8_t numFrames, int32_t frameUs);
+void updateTileAtlas(tileAtlas_t* atlas, int64_t elapsedUs);
+
+bool loadTilemapLayer(cnfsFileIdx_t fIdx, tilemapLayer_t* layer, tileAtlas_t* atlas, bool spiRam);
+bool initTilemapLayer(tilemapLayer_t* layer, tileAtlas_t* atlas, uint16_t w, uint16_t h, bool spiRam);
+void freeTilemapLayer(tilemapLayer_t* layer);
+bool enableTilemapLayerCache(tilemapLayer_t* layer, uint16_t viewW, uint16_t viewH, paletteColor_t bgColor,
+                             bool spiRam);
+uint8_t getTilemapTile(const tilemapLayer_t* layer, int32_t x, int32_t y);
+void setTilemapTile(tilemapLayer_t* layer, int32_t x, int32_t y, uint8_t tile);
+void drawTilemapLayer(tilemapLayer_t* layer, int32_t camX, int32_t camY);
+
+void initTilemap(tilemap_t* tilemap);
+bool addTilemapLayer(tilemap_t* tilemap, tilemapLayer_t* layer);
+void setTilemapCamera(tilemap_t* tilemap, int32_t x, int32_t y);
+void drawTilemap(tilemap_t* tilemap);
+
+#endif
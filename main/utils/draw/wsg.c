@@ -8,6 +8,7 @@
 #include "macros.h"
 #include "trigonometry.h"
 #include "fill.h"
+#include "renderTarget.h"
 #include "wsg.h"
 
 //==============================================================================
@@ -124,54 +125,17 @@ void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool fli
 
     if (rotateDeg)
     {
-        SETUP_FOR_TURBO();
-        int32_t wsgw = wsg->w;
-        int32_t wsgh = wsg->h;
-        for (int32_t srcY = 0; srcY < wsgh; srcY++)
-        {
-            int32_t usey = srcY;
-
-            // Reflect over X axis?
-            if (flipUD)
-            {
-                usey = wsg->h - 1 - usey;
-            }
-
-            const paletteColor_t* linein = &wsg->px[usey * wsgw];
-
-            // Reflect over Y axis?
-            int32_t readX    = 0;
-            int32_t advanceX = 1;
-            if (flipLR)
-            {
-                readX    = wsgw - 1;
-                advanceX = -1;
-            }
-
-            for (int32_t srcX = 0; srcX != wsgw; srcX++)
-            {
-                // Draw if not transparent
-                paletteColor_t color = linein[readX];
-                if (cTransparent != color)
-                {
-                    int32_t tx = srcX;
-                    int32_t ty = srcY;
-
-                    rotatePixel(&tx, &ty, rotateDeg, wsgw, wsgh);
-
-                    tx += xOff;
-                    ty += yOff;
-                    TURBO_SET_PIXEL_BOUNDS(tx, ty, color);
-                }
-                readX += advanceX;
-            }
-        }
+        // Map each destination pixel back to the WSG, which is faster and leaves no gaps
+        drawWsgAffine(wsg, xOff, yOff, flipLR, flipUD, rotateDeg, WSG_SCALE_ONE, WSG_SCALE_ONE);
     }
     else
     {
         // Draw the image's pixels (no rotation or transformation)
-        uint32_t w         = TFT_WIDTH;
-        paletteColor_t* px = getPxTftFramebuffer();
+        markDirtyRowsRenderTarget(yOff, yOff + wsg->h);
+        const wsg_t* target = getRenderTarget();
+        uint32_t w          = target->w;
+        uint32_t h          = target->h;
+        paletteColor_t* px  = target->px;
 
         uint16_t wsgw = wsg->w;
         uint16_t wsgh = wsg->h;
@@ -247,7 +211,7 @@ void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool fli
 
             // It is too complicated to detect both directions and backoff correctly, so we just do this here.
             // It does slow things down a "tiny" bit.  People in the future could optimize out this check.
-            if (dstY >= TFT_HEIGHT)
+            if (dstY >= h)
             {
                 continue;
             }
@@ -269,6 +233,173 @@ void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool fli
     }
 }
 
+/**
+ * @brief Set up an affine WSG draw. The destination box around the scaled and rotated WSG is clipped to the render
+ * target once, and the fixed-point source coordinates at its top left and their per-column and per-row steps are
+ * found, so each destination pixel only needs two additions to find its source pixel.
+ *
+ * This is used by drawWsgAffine() and drawWsgPaletteAffine(), and may be used to write other affine blitters.
+ *
+ * @param aff The affine draw to set up
+ * @param wsg The WSG which will be drawn
+ * @param target The render target which will be drawn into
+ * @param xOff The x offset of the scaled WSG's top left before rotation
+ * @param yOff The y offset of the scaled WSG's top left before rotation
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise around the scaled WSG's center, may be any value. Quarter
+ * turns use the same pivots as rotatePixel(), so they draw the same pixels
+ * @param xScale The horizontal scale, where ::WSG_SCALE_ONE is the original width
+ * @param yScale The vertical scale, where ::WSG_SCALE_ONE is the original height
+ * @return true if anything may be drawn, false if the WSG is entirely outside the render target or a scale isn't
+ * positive
+ */
+bool setupWsgAffine(wsgAffine_t* aff, const wsg_t* wsg, const wsg_t* target, int32_t xOff, int32_t yOff, bool flipLR,
+                    bool flipUD, int32_t rotateDeg, int32_t xScale, int32_t yScale)
+{
+    if (xScale <= 0 || yScale <= 0 || 0 == wsg->w || 0 == wsg->h)
+    {
+        return false;
+    }
+
+    rotateDeg    = ((rotateDeg % 360) + 360) % 360;
+    int32_t sinA = getSin1024(rotateDeg);
+    int32_t cosA = getCos1024(rotateDeg);
+    int64_t w    = wsg->w;
+    int64_t h    = wsg->h;
+
+    // Like rotatePixel(), rotate by whole quarter turns first, around the points it uses, so those rotations draw the
+    // same pixels as before. All source points are in 16.16 fixed point
+    int64_t pivotX = w * 32768;
+    int64_t pivotY = h * 32768;
+    if (90 <= rotateDeg && rotateDeg < 180)
+    {
+        pivotX = h * 32768 + (w / 2 - h / 2) * 65536;
+    }
+    else if (270 <= rotateDeg)
+    {
+        pivotY = w * 32768 + (h / 2 - w / 2) * 65536;
+    }
+
+    // Then rotate by the rest of the angle around the center of the middle pixel, which moves the quarter turn's pivot
+    int32_t sinR   = getSin1024(rotateDeg % 90);
+    int32_t cosR   = getCos1024(rotateDeg % 90);
+    int64_t midPxX = (w / 2) * 65536 + 32768;
+    int64_t midPxY = (h / 2) * 65536 + 32768;
+    int64_t movedX = ((pivotX - midPxX) * cosR - (pivotY - midPxY) * sinR) / 1024 + midPxX;
+    int64_t movedY = ((pivotX - midPxX) * sinR + (pivotY - midPxY) * cosR) / 1024 + midPxY;
+
+    // The destination point the pivot lands on, after scaling
+    int64_t anchorX = (int64_t)xOff * 65536 + movedX * xScale / 1024;
+    int64_t anchorY = (int64_t)yOff * 65536 + movedY * yScale / 1024;
+
+    // Find the box around the scaled and rotated WSG, centered where the WSG's center lands, then clip it
+    int64_t dstW  = w * xScale;
+    int64_t dstH  = h * yScale;
+    int64_t offX  = (w * 32768 - pivotX) * xScale / 1024;
+    int64_t offY  = (h * 32768 - pivotY) * yScale / 1024;
+    int32_t halfW = (ABS(cosA) * dstW + ABS(sinA) * dstH) / (2 * 1024 * 1024) + 2;
+    int32_t halfH = (ABS(sinA) * dstW + ABS(cosA) * dstH) / (2 * 1024 * 1024) + 2;
+    int32_t midX  = (anchorX + (offX * cosA - offY * sinA) / 1024) / 65536;
+    int32_t midY  = (anchorY + (offX * sinA + offY * cosA) / 1024) / 65536;
+    aff->x0       = MAX(midX - halfW, 0);
+    aff->y0       = MAX(midY - halfH, 0);
+    aff->x1       = MIN(midX + halfW + 1, (int32_t)target->w);
+    aff->y1       = MIN(midY + halfH + 1, (int32_t)target->h);
+    if (aff->x0 >= aff->x1 || aff->y0 >= aff->y1)
+    {
+        return false;
+    }
+
+    // Rotating back by the angle and unscaling maps a destination offset from the anchor to a source offset
+    aff->duDx = (int64_t)cosA * 65536 / xScale;
+    aff->dvDx = (int64_t)-sinA * 65536 / yScale;
+    aff->duDy = (int64_t)sinA * 65536 / xScale;
+    aff->dvDy = (int64_t)cosA * 65536 / yScale;
+
+    // Sample at the center of the first destination pixel
+    int64_t px = (int64_t)aff->x0 * 65536 + 32768 - anchorX;
+    int64_t py = (int64_t)aff->y0 * 65536 + 32768 - anchorY;
+    aff->u0    = (px * cosA + py * sinA) / xScale + pivotX;
+    aff->v0    = (py * cosA - px * sinA) / yScale + pivotY;
+
+    // Flip by walking the source backwards
+    if (flipLR)
+    {
+        aff->u0   = w * 65536 - 1 - aff->u0;
+        aff->duDx = -aff->duDx;
+        aff->duDy = -aff->duDy;
+    }
+    if (flipUD)
+    {
+        aff->v0   = h * 65536 - 1 - aff->v0;
+        aff->dvDx = -aff->dvDx;
+        aff->dvDy = -aff->dvDy;
+    }
+    return true;
+}
+
+/**
+ * @brief Draw a WSG to the display flipped, scaled, and rotated, with transparency. The WSG is scaled so its top left
+ * is at (xOff, yOff), then flipped, then rotated clockwise around its center.
+ *
+ * Each destination pixel is mapped back to the WSG, so this costs the area drawn rather than the WSG's area, and
+ * there are no gaps at any angle or scale.
+ *
+ * @param wsg  The WSG to draw to the display
+ * @param xOff The x offset of the scaled WSG's top left before rotation
+ * @param yOff The y offset of the scaled WSG's top left before rotation
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise, may be any value
+ * @param xScale The horizontal scale, where ::WSG_SCALE_ONE is the original width
+ * @param yScale The vertical scale, where ::WSG_SCALE_ONE is the original height
+ */
+void drawWsgAffine(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg,
+                   int32_t xScale, int32_t yScale)
+{
+    if (NULL == wsg->px)
+    {
+        return;
+    }
+
+    const wsg_t* target = getRenderTarget();
+    wsgAffine_t aff;
+    if (!setupWsgAffine(&aff, wsg, target, xOff, yOff, flipLR, flipUD, rotateDeg, xScale, yScale))
+    {
+        return;
+    }
+    markDirtyRowsRenderTarget(aff.y0, aff.y1);
+
+    // Unsigned compares check both sides of the source at once
+    uint32_t srcW = (uint32_t)wsg->w << 16;
+    uint32_t srcH = (uint32_t)wsg->h << 16;
+
+    int32_t rowU = aff.u0;
+    int32_t rowV = aff.v0;
+    for (int32_t dstY = aff.y0; dstY < aff.y1; dstY++)
+    {
+        paletteColor_t* lineOut = &target->px[dstY * target->w];
+        int32_t u               = rowU;
+        int32_t v               = rowV;
+        for (int32_t dstX = aff.x0; dstX < aff.x1; dstX++)
+        {
+            if ((uint32_t)u < srcW && (uint32_t)v < srcH)
+            {
+                paletteColor_t color = wsg->px[(v >> 16) * wsg->w + (u >> 16)];
+                if (cTransparent != color)
+                {
+                    lineOut[dstX] = color;
+                }
+            }
+            u += aff.duDx;
+            v += aff.dvDx;
+        }
+        rowU += aff.duDy;
+        rowV += aff.dvDy;
+    }
+}
+
 /**
  * @brief Draw a WSG to the display without flipping or rotation
  *
@@ -287,18 +418,20 @@ void drawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff)
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
     int wWidth                   = wsg->w;
     int xMin                     = CLAMP(xOff, 0, dWidth);
     int xMax                     = CLAMP(xOff + wWidth, 0, dWidth);
-    int yMin                     = CLAMP(yOff, 0, TFT_HEIGHT);
-    int yMax                     = CLAMP(yOff + wsg->h, 0, TFT_HEIGHT);
-    paletteColor_t* px           = getPxTftFramebuffer();
+    int yMin                     = CLAMP(yOff, 0, target->h);
+    int yMax                     = CLAMP(yOff + wsg->h, 0, target->h);
+    paletteColor_t* px           = target->px;
     int numX                     = xMax - xMin;
     int wsgY                     = (yMin - yOff);
     int wsgX                     = (xMin - xOff);
     paletteColor_t* lineout      = &px[(yMin * dWidth) + xMin];
     const paletteColor_t* linein = &wsg->px[wsgY * wWidth + wsgX];
+    markDirtyRowsRenderTarget(yMin, yMax);
 
     // Draw each pixel
     for (int y = yMin; y < yMax; y++)
@@ -337,8 +470,9 @@ void drawWsgSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, int16_t x
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
-    int dHeight                  = TFT_HEIGHT;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
+    int dHeight                  = target->h;
     int wWidth                   = wsg->w;
     int xMax                     = CLAMP(xOff + wWidth * xScale, 0, dWidth);
     int yMax                     = CLAMP(yOff + wsg->h * yScale, 0, dHeight);
@@ -350,7 +484,7 @@ void drawWsgSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, int16_t x
     // Draw each pixel, scaled
     for (int y = yOff, iy = 0; y < yMax && iy < wsg->h; y += yScale, iy++)
     {
-        if (y >= TFT_HEIGHT)
+        if (y >= dHeight)
         {
             return;
         }
@@ -366,7 +500,7 @@ void drawWsgSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, int16_t x
 
         for (int x = xOff, ix = 0; x < xMax && ix < wsg->w; x += xScale, ix++)
         {
-            if (x >= TFT_WIDTH)
+            if (x >= dWidth)
             {
                 // next line
                 break;
@@ -408,18 +542,20 @@ void drawWsgSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff)
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
     int wWidth                   = wsg->w;
     int xMin                     = CLAMP(xOff, 0, dWidth);
     int xMax                     = CLAMP(xOff + (wWidth / 2), 0, dWidth);
-    int yMin                     = CLAMP(yOff, 0, TFT_HEIGHT);
-    int yMax                     = CLAMP(yOff + (wsg->h / 2), 0, TFT_HEIGHT);
-    paletteColor_t* px           = getPxTftFramebuffer();
+    int yMin                     = CLAMP(yOff, 0, target->h);
+    int yMax                     = CLAMP(yOff + (wsg->h / 2), 0, target->h);
+    paletteColor_t* px           = target->px;
     int numX                     = xMax - xMin;
     int wsgY                     = (yMin - yOff);
     int wsgX                     = (xMin - xOff);
     paletteColor_t* lineout      = &px[(yMin * dWidth) + xMin];
     const paletteColor_t* linein = &wsg->px[wsgY * wWidth + wsgX];
+    markDirtyRowsRenderTarget(yMin, yMax);
 
     // Draw each pixel
     for (int y = yMin; y < yMax; y++)
@@ -449,19 +585,20 @@ void drawWsgSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff)
  */
 void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff)
 {
-    if (xOff > TFT_WIDTH)
+    const wsg_t* target = getRenderTarget();
+    if (xOff > target->w)
     {
         return;
     }
 
     // Bound in the Y direction
     int32_t yStart = (yOff < 0) ? 0 : yOff;
-    int32_t yEnd   = ((yOff + wsg->h) > TFT_HEIGHT) ? TFT_HEIGHT : (yOff + wsg->h);
+    int32_t yEnd   = ((yOff + wsg->h) > target->h) ? target->h : (yOff + wsg->h);
 
     int wWidth                  = wsg->w;
-    int dWidth                  = TFT_WIDTH;
+    int dWidth                  = target->w;
     const paletteColor_t* pxWsg = &wsg->px[(yOff < 0) ? (wsg->h - (yEnd - yStart)) * wWidth : 0];
-    paletteColor_t* pxDisp      = &(getPxTftFramebuffer()[yStart * dWidth + xOff]);
+    paletteColor_t* pxDisp      = &(target->px[yStart * dWidth + xOff]);
 
     // Bound in the X direction
     int32_t copyLen = wsg->w;
@@ -473,10 +610,11 @@ void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff)
         xOff = 0;
     }
 
-    if (xOff + copyLen > TFT_WIDTH)
+    if (xOff + copyLen > dWidth)
     {
-        copyLen = TFT_WIDTH - xOff;
+        copyLen = dWidth - xOff;
     }
+    markDirtyRowsRenderTarget(yStart, yEnd);
 
     // copy each row
     for (int32_t y = yStart; y < yEnd; y++)
@@ -487,4 +625,71 @@ void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff)
         pxDisp += dWidth;
         pxWsg += wWidth;
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief Draw a span-encoded WSG to the display without flipping or rotation. Each opaque run is copied with
+ * memcpy() and transparent runs are skipped without being read.
+ *
+ * @param spr  The span-encoded WSG to draw to the display
+ * @param xOff The x offset to draw the WSG at
+ * @param yOff The y offset to draw the WSG at
+ */
+void drawWsgSpans(const wsgSpans_t* spr, int32_t xOff, int32_t yOff)
+{
+    if (NULL == spr->rowOffsets)
+    {
+        return;
+    }
+
+    // Only draw in bounds
+    const wsg_t* target = getRenderTarget();
+    int32_t dWidth      = target->w;
+    int32_t yMin        = CLAMP(yOff, 0, target->h);
+    int32_t yMax        = CLAMP(yOff + spr->h, 0, target->h);
+    if (yMin >= yMax || xOff >= dWidth || xOff + spr->w <= 0)
+    {
+        return;
+    }
+
+    paletteColor_t* lineout = &target->px[yMin * dWidth];
+    markDirtyRowsRenderTarget(yMin, yMax);
+
+    for (int32_t y = yMin; y < yMax; y++)
+    {
+        const uint8_t* row = &spr->spans[spr->rowOffsets[y - yOff]];
+        uint16_t numRuns   = (row[0] << 8) | row[1];
+        row += 2;
+
+        while (numRuns--)
+        {
+            int32_t x                = xOff + ((row[0] << 8) | row[1]);
+            int32_t len              = (row[2] << 8) | row[3];
+            const paletteColor_t* in = (const paletteColor_t*)&row[4];
+            row                      = &row[4 + len];
+
+            // Runs are sorted left to right, so nothing after this one is on screen
+            if (x >= dWidth)
+            {
+                break;
+            }
+
+            // Clip the run to the display
+            if (x < 0)
+            {
+                in -= x;
+                len += x;
+                x = 0;
+            }
+            if (x + len > dWidth)
+            {
+                len = dWidth - x;
+            }
+
+            if (len > 0)
+            {
+                memcpy(&lineout[x], in, len);
+            }
+        }
+        lineout += dWidth;
+    }
+}
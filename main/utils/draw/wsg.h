@@ -27,6 +27,23 @@
  * - drawWsgSimpleScaled():  Draw a WSG to the display with transparency at a specified scale. Scales are integer
  * values, so 2x, 3x, 4x... are the valid options.
  * - drawWsgSimpleHalf(): Draw a WSG to the display with transparency at half the original resolution.
+ * - drawWsgAffine(): Draw a WSG to the display with transparency, rotation, flipping, and independent horizontal and
+ * vertical scales, which need not be integers. Each pixel drawn is mapped back to the WSG with fixed-point math, so the
+ * cost depends on the drawn size rather than the WSG's size, and rotated WSGs have no gaps. drawWsg() uses this to
+ * rotate.
+ * - drawWsgSpans(): Draw a span-encoded WSG (::wsgSpans_t) to the display with transparency. Opaque runs are copied
+ * with \c memcpy() and transparent runs are skipped entirely, so this is faster than drawWsgSimple() for sprites with
+ * a lot of transparency. It cannot be rotated, flipped, or scaled.
+ *
+ * \section wsg_spans Span Encoding
+ *
+ * A WSG may be stored as a list of opaque spans per row rather than as raw pixels. This is done by the \c
+ * assets_preprocessor when the \c wsg.spans option is set for an image. Span-encoded files have ::WSG_SPAN_FLAG set in
+ * the width in the header. Each row is a two byte big-endian run count, then for each run a two byte big-endian x
+ * offset, a two byte big-endian length, and that many pixels. Transparent pixels are never stored.
+ *
+ * Span-encoded files may be loaded with either loadWsg(), which expands them to raw pixels, or loadWsgSpans(), which
+ * keeps them as spans. loadWsgSpans() will also encode raw WSG files at load time.
  *
  * \section wsg_example Example
  *
@@ -60,11 +77,55 @@ typedef struct
     uint16_t h;         ///< The height of the image
 } wsg_t;
 
+/// The scale passed to drawWsgAffine() to draw a WSG at its original size
+#define WSG_SCALE_ONE 1024
+
+/// Set in the width of a WSG file header when the pixels are stored as opaque spans, see \ref wsg_spans
+#define WSG_SPAN_FLAG 0x8000
+
+/**
+ * @brief The destination area and fixed-point source mapping for an affine WSG draw, set up by setupWsgAffine()
+ *
+ * Source coordinates are 16.16 fixed point, already flipped, so the source pixel for a destination pixel is
+ * (u >> 16, v >> 16) when both are in bounds.
+ */
+typedef struct
+{
+    int32_t x0;   ///< The first destination column to draw, inclusive
+    int32_t y0;   ///< The first destination row to draw, inclusive
+    int32_t x1;   ///< The last destination column to draw, exclusive
+    int32_t y1;   ///< The last destination row to draw, exclusive
+    int32_t u0;   ///< The source X coordinate at (x0, y0)
+    int32_t v0;   ///< The source Y coordinate at (x0, y0)
+    int32_t duDx; ///< How much the source X coordinate changes per destination column
+    int32_t dvDx; ///< How much the source Y coordinate changes per destination column
+    int32_t duDy; ///< How much the source X coordinate changes per destination row
+    int32_t dvDy; ///< How much the source Y coordinate changes per destination row
+} wsgAffine_t;
+
+/**
+ * @brief A sprite stored as opaque spans of paletteColor_t per row, see \ref wsg_spans
+ *
+ * The row offsets and span data are a single allocation starting at \c rowOffsets
+ */
+typedef struct
+{
+    uint32_t* rowOffsets; ///< The offset into spans where each row starts
+    uint8_t* spans;       ///< The span-encoded rows, immediately after the row offsets
+    uint16_t w;           ///< The width of the image
+    uint16_t h;           ///< The height of the image
+} wsgSpans_t;
+
 void rotatePixel(int32_t* x, int32_t* y, int32_t rotateDeg, int32_t width, int32_t height);
 void drawWsg(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg);
 void drawWsgSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff);
 void drawWsgSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, int16_t xScale, int16_t yScale);
 void drawWsgTile(const wsg_t* wsg, int32_t xOff, int32_t yOff);
 void drawWsgSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff);
+void drawWsgSpans(const wsgSpans_t* spr, int32_t xOff, int32_t yOff);
+bool setupWsgAffine(wsgAffine_t* aff, const wsg_t* wsg, const wsg_t* target, int32_t xOff, int32_t yOff, bool flipLR,
+                    bool flipUD, int32_t rotateDeg, int32_t xScale, int32_t yScale);
+void drawWsgAffine(const wsg_t* wsg, int32_t xOff, int32_t yOff, bool flipLR, bool flipUD, int32_t rotateDeg,
+                   int32_t xScale, int32_t yScale);
 
 #endif
\ No newline at end of file
@@ -74,11 +74,14 @@ void canvasDraw(wsg_t* canvas, cnfsFileIdx_t image, int startX, int startY, bool
 void canvasDrawPal(wsg_t* canvas, cnfsFileIdx_t image, int startX, int startY, bool flipX, bool flipY,
                    int32_t rotateDeg, wsgPalette_t* pal)
 {
-    // Load the WSG from the file Idx
-    uint32_t decompressedSize = 0;
-    uint8_t* decompressedBuf  = readHeatshrinkFile(image, &decompressedSize, false);
-    int w                     = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    int h                     = (decompressedBuf[2] << 8) | decompressedBuf[3];
+    // Load the WSG from the file Idx. This also expands span-encoded WSGs
+    wsg_t img = {0};
+    if (!loadWsg(image, &img, false))
+    {
+        return;
+    }
+    int w = img.w;
+    int h = img.h;
 
     // Overlay the new image using the offsets
     // - Offsets can be negative to move them up or left
@@ -105,9 +108,7 @@ void canvasDrawPal(wsg_t* canvas, cnfsFileIdx_t image, int startX, int startY, b
             int nX   = (flipX) ? w - x - 1 : x;
             int nY   = (flipY) ? h - y - 1 : y;
             // Set color to put onto canvas
-            paletteColor_t col
-                = colorShift
-                      ->newColors[decompressedBuf[(nY * w) + nX + 4]]; // 4 is the offset into the data past the dims
+            paletteColor_t col = colorShift->newColors[img.px[(nY * w) + nX]];
             // Check if pixel is out of bounds or transparent, continue if so
             if (col == cTransparent ||  // If transparent
                 xPos < 0 ||             // If pixel is too far lef
@@ -139,5 +140,5 @@ void canvasDrawPal(wsg_t* canvas, cnfsFileIdx_t image, int startX, int startY, b
     }
 
     // Free buffered data
-    heap_caps_free(decompressedBuf);
+    freeWsg(&img);
 }
\ No newline at end of file
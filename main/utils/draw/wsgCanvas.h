@@ -36,6 +36,8 @@
  * Lastly, call freeWsg() when done with the canvas, just like any other WSG.
  *
  * The canvas can be used like any WSG, so all wsg drawing functions work on it once it has been created.
+ * A canvas may also be passed to pushRenderTarget(), after which shapes, fills, and text are drawn into it too. See
+ * renderTarget.h.
  *
  * \code {.c}
 // Create structs
@@ -18,6 +18,7 @@
 #include "trigonometry.h"
 #include "macros.h"
 #include "fill.h"
+#include "renderTarget.h"
 
 //==============================================================================
 // Functions
@@ -47,54 +48,17 @@ void drawWsgPalette(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t*
 
     if (rotateDeg)
     {
-        SETUP_FOR_TURBO();
-        int32_t wsgw = wsg->w;
-        int32_t wsgh = wsg->h;
-        for (int32_t srcY = 0; srcY < wsgh; srcY++)
-        {
-            int32_t usey = srcY;
-
-            // Reflect over X axis?
-            if (flipUD)
-            {
-                usey = wsg->h - 1 - usey;
-            }
-
-            const paletteColor_t* linein = &wsg->px[usey * wsgw];
-
-            // Reflect over Y axis?
-            int32_t readX    = 0;
-            int32_t advanceX = 1;
-            if (flipLR)
-            {
-                readX    = wsgw - 1;
-                advanceX = -1;
-            }
-
-            for (int32_t srcX = 0; srcX != wsgw; srcX++)
-            {
-                // Draw if not transparent
-                paletteColor_t color = palette->newColors[linein[readX]];
-                if (cTransparent != color)
-                {
-                    int32_t tx = srcX;
-                    int32_t ty = srcY;
-
-                    rotatePixel(&tx, &ty, rotateDeg, wsgw, wsgh);
-
-                    tx += xOff;
-                    ty += yOff;
-                    TURBO_SET_PIXEL_BOUNDS(tx, ty, color);
-                }
-                readX += advanceX;
-            }
-        }
+        // Map each destination pixel back to the WSG, which is faster and leaves no gaps
+        drawWsgPaletteAffine(wsg, xOff, yOff, palette, flipLR, flipUD, rotateDeg, WSG_SCALE_ONE, WSG_SCALE_ONE);
     }
     else
     {
         // Draw the image's pixels (no rotation or transformation)
-        uint32_t w         = TFT_WIDTH;
-        paletteColor_t* px = getPxTftFramebuffer();
+        markDirtyRowsRenderTarget(yOff, yOff + wsg->h);
+        const wsg_t* target = getRenderTarget();
+        uint32_t w          = target->w;
+        uint32_t h          = target->h;
+        paletteColor_t* px  = target->px;
 
         uint16_t wsgw = wsg->w;
         uint16_t wsgh = wsg->h;
@@ -170,7 +134,7 @@ void drawWsgPalette(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t*
 
             // It is too complicated to detect both directions and backoff correctly, so we just do this here.
             // It does slow things down a "tiny" bit.  People in the future could optimize out this check.
-            if (dstY >= TFT_HEIGHT)
+            if (dstY >= h)
             {
                 continue;
             }
@@ -194,6 +158,66 @@ void drawWsgPalette(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t*
     }
 }
 
+/**
+ * @brief Draw a WSG to the display flipped, scaled, and rotated, utilizing a palette. The WSG is scaled so its top
+ * left is at (xOff, yOff), then flipped, then rotated clockwise around its center. See drawWsgAffine()
+ *
+ * @param wsg  The WSG to draw to the display
+ * @param xOff The x offset of the scaled WSG's top left before rotation
+ * @param yOff The y offset of the scaled WSG's top left before rotation
+ * @param palette The new palette used to translate the colors
+ * @param flipLR true to flip the image across the Y axis
+ * @param flipUD true to flip the image across the X axis
+ * @param rotateDeg The number of degrees to rotate clockwise, may be any value
+ * @param xScale The horizontal scale, where ::WSG_SCALE_ONE is the original width
+ * @param yScale The vertical scale, where ::WSG_SCALE_ONE is the original height
+ */
+void drawWsgPaletteAffine(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t* palette, bool flipLR,
+                          bool flipUD, int32_t rotateDeg, int32_t xScale, int32_t yScale)
+{
+    if (NULL == wsg->px)
+    {
+        return;
+    }
+
+    const wsg_t* target = getRenderTarget();
+    wsgAffine_t aff;
+    if (!setupWsgAffine(&aff, wsg, target, xOff, yOff, flipLR, flipUD, rotateDeg, xScale, yScale))
+    {
+        return;
+    }
+    markDirtyRowsRenderTarget(aff.y0, aff.y1);
+
+    // Unsigned compares check both sides of the source at once
+    uint32_t srcW = (uint32_t)wsg->w << 16;
+    uint32_t srcH = (uint32_t)wsg->h << 16;
+
+    int32_t rowU = aff.u0;
+    int32_t rowV = aff.v0;
+    for (int32_t dstY = aff.y0; dstY < aff.y1; dstY++)
+    {
+        paletteColor_t* lineOut = &target->px[dstY * target->w];
+        int32_t u               = rowU;
+        int32_t v               = rowV;
+        for (int32_t dstX = aff.x0; dstX < aff.x1; dstX++)
+        {
+            if ((uint32_t)u < srcW && (uint32_t)v < srcH)
+            {
+                // Remap and check transparency together
+                paletteColor_t color = palette->newColors[wsg->px[(v >> 16) * wsg->w + (u >> 16)]];
+                if (cTransparent != color)
+                {
+                    lineOut[dstX] = color;
+                }
+            }
+            u += aff.duDx;
+            v += aff.dvDx;
+        }
+        rowU += aff.duDy;
+        rowV += aff.dvDy;
+    }
+}
+
 /**
  * @brief Draw a WSG to the display without flipping or rotation
  *
@@ -213,18 +237,20 @@ void drawWsgPaletteSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgPalet
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
     int wWidth                   = wsg->w;
     int xMin                     = CLAMP(xOff, 0, dWidth);
     int xMax                     = CLAMP(xOff + wWidth, 0, dWidth);
-    int yMin                     = CLAMP(yOff, 0, TFT_HEIGHT);
-    int yMax                     = CLAMP(yOff + wsg->h, 0, TFT_HEIGHT);
-    paletteColor_t* px           = getPxTftFramebuffer();
+    int yMin                     = CLAMP(yOff, 0, target->h);
+    int yMax                     = CLAMP(yOff + wsg->h, 0, target->h);
+    paletteColor_t* px           = target->px;
     int numX                     = xMax - xMin;
     int wsgY                     = (yMin - yOff);
     int wsgX                     = (xMin - xOff);
     paletteColor_t* lineout      = &px[(yMin * dWidth) + xMin];
     const paletteColor_t* linein = &wsg->px[wsgY * wWidth + wsgX];
+    markDirtyRowsRenderTarget(yMin, yMax);
 
     // Draw each pixel
     for (int y = yMin; y < yMax; y++)
@@ -265,8 +291,9 @@ void drawWsgPaletteSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, ws
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
-    int dHeight                  = TFT_HEIGHT;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
+    int dHeight                  = target->h;
     int wWidth                   = wsg->w;
     int xMax                     = CLAMP(xOff + wWidth * xScale, 0, dWidth);
     int yMax                     = CLAMP(yOff + wsg->h * yScale, 0, dHeight);
@@ -278,7 +305,7 @@ void drawWsgPaletteSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, ws
     // Draw each pixel, scaled
     for (int y = yOff, iy = 0; y < yMax && iy < wsg->h; y += yScale, iy++)
     {
-        if (y >= TFT_HEIGHT)
+        if (y >= dHeight)
         {
             return;
         }
@@ -294,7 +321,7 @@ void drawWsgPaletteSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, ws
 
         for (int x = xOff, ix = 0; x < xMax && ix < wsg->w; x += xScale, ix++)
         {
-            if (x >= TFT_WIDTH)
+            if (x >= dWidth)
             {
                 // next line
                 break;
@@ -337,18 +364,20 @@ void drawWsgPaletteSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgP
     }
 
     // Only draw in bounds
-    int dWidth                   = TFT_WIDTH;
+    const wsg_t* target          = getRenderTarget();
+    int dWidth                   = target->w;
     int wWidth                   = wsg->w;
     int xMin                     = CLAMP(xOff, 0, dWidth);
     int xMax                     = CLAMP(xOff + (wWidth / 2), 0, dWidth);
-    int yMin                     = CLAMP(yOff, 0, TFT_HEIGHT);
-    int yMax                     = CLAMP(yOff + (wsg->h / 2), 0, TFT_HEIGHT);
-    paletteColor_t* px           = getPxTftFramebuffer();
+    int yMin                     = CLAMP(yOff, 0, target->h);
+    int yMax                     = CLAMP(yOff + (wsg->h / 2), 0, target->h);
+    paletteColor_t* px           = target->px;
     int numX                     = xMax - xMin;
     int wsgY                     = (yMin - yOff);
     int wsgX                     = (xMin - xOff);
     paletteColor_t* lineout      = &px[(yMin * dWidth) + xMin];
     const paletteColor_t* linein = &wsg->px[wsgY * wWidth + wsgX];
+    markDirtyRowsRenderTarget(yMin, yMax);
 
     // Draw each pixel
     for (int y = yMin; y < yMax; y++)
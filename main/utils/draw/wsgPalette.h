@@ -28,12 +28,13 @@
  *
  * If wsgPaletteReset() isn't called for the palette being used, all colors not specifically assigned will be black.
  *
- * There are four drawing functions provided with the palette
+ * There are five drawing functions provided with the palette
  * - drawWsgPalette(): Draws the WSG with the appropriate palette
  * - drawWsgPaletteSimple(): Draws the WSG with palette, but can't be rotated or flipped.
  * - drawWsgPaletteSimpleScaled(): Draws the WSG with palette at a larger size set by the provided scale (integer
  values, 2x, 3x, 4x...).
  * - drawWsgPaletteSimpleHalf(): Draws the WSG at half scale with the included palette.
+ * - drawWsgPaletteAffine(): Draws the WSG with palette, flipped, rotated, and at any horizontal and vertical scale.
  *
  * \section wsgPalette_example Example
  *
@@ -85,6 +86,8 @@ void drawWsgPaletteSimple(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgPalet
 void drawWsgPaletteSimpleScaled(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgPalette_t* palette, int16_t xScale,
                                 int16_t yScale);
 void drawWsgPaletteSimpleHalf(const wsg_t* wsg, int16_t xOff, int16_t yOff, wsgPalette_t* palette);
+void drawWsgPaletteAffine(const wsg_t* wsg, int32_t xOff, int32_t yOff, wsgPalette_t* palette, bool flipLR,
+                          bool flipUD, int32_t rotateDeg, int32_t xScale, int32_t yScale);
 void wsgPaletteReset(wsgPalette_t* palette);
 void wsgPaletteSet(wsgPalette_t* palette, paletteColor_t replaced, paletteColor_t newColor);
 void wsgPaletteSetGroup(wsgPalette_t* palette, paletteColor_t* replacedColors, paletteColor_t* newColors,
@@ -0,0 +1,275 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stddef.h>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#include "fs_async.h"
+#include "fs_wsg.h"
+#include "fs_font.h"
+#include "fs_json.h"
+#include "midiFileParser.h"
+
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// The most loads which may be queued or waiting for their callbacks at once
+#define ASYNC_LOAD_QUEUE_LEN 32
+
+/// The loader task's stack size, in bytes
+#define ASYNC_LOAD_STACK_SIZE 4096
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A single queued load, passed to the loader task and back
+ */
+typedef struct
+{
+    asyncAssetType_t type; ///< The type of asset to load
+    cnfsFileIdx_t fIdx;    ///< The file to load
+    void* asset;           ///< The asset to load into
+    bool spiRam;           ///< true to load to SPI RAM, false for normal RAM
+    asyncLoadCb_t cb;      ///< The callback to call when done, may be NULL
+    void* arg;             ///< The argument for the callback
+    bool success;          ///< Set by the loader task
+} asyncLoad_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool initAsyncLoader(void);
+static void asyncLoaderTask(void* arg);
+static void dispatchAsyncLoad(TickType_t ticksToWait);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// Loads sent from the main loop to the loader task
+static QueueHandle_t requestQueue = NULL;
+/// Completed loads sent from the loader task back to the main loop
+static QueueHandle_t doneQueue = NULL;
+/// Loads which have been queued but not dispatched yet. Only touched from the main loop
+static uint32_t loadsPending = 0;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Create the queues and the loader task, the first time an asset is loaded asynchronously
+ *
+ * @return true if the loader is running, false if it couldn't be started
+ */
+static bool initAsyncLoader(void)
+{
+    if (NULL != requestQueue)
+    {
+        return true;
+    }
+
+    requestQueue = xQueueCreate(ASYNC_LOAD_QUEUE_LEN, sizeof(asyncLoad_t));
+    doneQueue    = xQueueCreate(ASYNC_LOAD_QUEUE_LEN, sizeof(asyncLoad_t));
+
+    BaseType_t created = pdFAIL;
+    if (NULL != requestQueue && NULL != doneQueue)
+    {
+        created = xTaskCreate(asyncLoaderTask, "assetLoader", ASYNC_LOAD_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1, NULL);
+    }
+
+    if (pdPASS != created)
+    {
+        ESP_LOGE("ASYNC", "Failed to start the asset loader");
+        if (NULL != requestQueue)
+        {
+            vQueueDelete(requestQueue);
+            requestQueue = NULL;
+        }
+        if (NULL != doneQueue)
+        {
+            vQueueDelete(doneQueue);
+            doneQueue = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The loader task. This runs forever, loading assets in the order they were queued
+ *
+ * @param arg Unused
+ */
+static void asyncLoaderTask(void* arg)
+{
+    asyncLoad_t load;
+    while (pdTRUE == xQueueReceive(requestQueue, &load, portMAX_DELAY))
+    {
+        switch (load.type)
+        {
+            case ASYNC_WSG:
+            {
+                load.success = loadWsg(load.fIdx, (wsg_t*)load.asset, load.spiRam);
+                break;
+            }
+            case ASYNC_WSG_SPANS:
+            {
+                load.success = loadWsgSpans(load.fIdx, (wsgSpans_t*)load.asset, load.spiRam);
+                break;
+            }
+            case ASYNC_FONT:
+            {
+                load.success = loadFont(load.fIdx, (font_t*)load.asset, load.spiRam);
+                break;
+            }
+            case ASYNC_JSON:
+            {
+                char* json              = loadJson(load.fIdx, load.spiRam);
+                *((char**)(load.asset)) = json;
+                load.success            = (NULL != json);
+                break;
+            }
+            case ASYNC_MIDI:
+            {
+                load.success = loadMidiFile(load.fIdx, (midiFile_t*)load.asset, load.spiRam);
+                break;
+            }
+            default:
+            {
+                load.success = false;
+                break;
+            }
+        }
+
+        // There is always space, since loadsPending never exceeds the queue length
+        xQueueSend(doneQueue, &load, portMAX_DELAY);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Receive one completed load and call its callback
+ *
+ * @param ticksToWait How long to wait for a load to complete, 0 to not wait
+ */
+static void dispatchAsyncLoad(TickType_t ticksToWait)
+{
+    asyncLoad_t load;
+    if (pdTRUE == xQueueReceive(doneQueue, &load, ticksToWait))
+    {
+        loadsPending--;
+        if (!load.success)
+        {
+            ESP_LOGE("ASYNC", "Failed to load cnfsIdx %d", load.fIdx);
+        }
+        if (NULL != load.cb)
+        {
+            load.cb(load.fIdx, load.asset, load.success, load.arg);
+        }
+    }
+}
+
+/**
+ * @brief Queue an asset to be loaded in the background. The asset must not be used until the callback is called
+ *
+ * If ::ASYNC_LOAD_QUEUE_LEN loads are already pending, this waits for the oldest to finish and dispatches it first
+ *
+ * @param type The type of asset to load
+ * @param fIdx The file to load
+ * @param asset The asset to load into, see ::asyncAssetType_t for what type this must be
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM
+ * @param cb A function to call from the main loop when the load is complete, may be NULL
+ * @param arg An argument to pass to the callback
+ * @return true if the load was queued, false if the loader couldn't be started
+ */
+bool loadAssetAsync(asyncAssetType_t type, cnfsFileIdx_t fIdx, void* asset, bool spiRam, asyncLoadCb_t cb,
+                    void* arg)
+{
+    if (!initAsyncLoader())
+    {
+        return false;
+    }
+
+    // Make room, so the loader task can never block on the done queue
+    while (loadsPending >= ASYNC_LOAD_QUEUE_LEN)
+    {
+        dispatchAsyncLoad(portMAX_DELAY);
+    }
+
+    asyncLoad_t load = {
+        .type   = type,
+        .fIdx   = fIdx,
+        .asset  = asset,
+        .spiRam = spiRam,
+        .cb     = cb,
+        .arg    = arg,
+    };
+    xQueueSend(requestQueue, &load, portMAX_DELAY);
+    loadsPending++;
+    return true;
+}
+
+/**
+ * @brief Queue a batch of WSGs to be loaded in the background. The callback is called once per WSG
+ *
+ * @param fIdxs The files to load
+ * @param wsgs The WSGs to load into, the same length as fIdxs
+ * @param count The number of WSGs to load
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM
+ * @param cb A function to call from the main loop when each load is complete, may be NULL
+ * @param arg An argument to pass to the callback
+ * @return true if all loads were queued, false if the loader couldn't be started
+ */
+bool loadWsgsAsync(const cnfsFileIdx_t* fIdxs, wsg_t* wsgs, uint32_t count, bool spiRam, asyncLoadCb_t cb, void* arg)
+{
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        if (!loadAssetAsync(ASYNC_WSG, fIdxs[idx], &wsgs[idx], spiRam, cb, arg))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Get the number of asynchronous loads which are queued, in progress, or done but not yet dispatched
+ *
+ * @return The number of pending loads. When this is zero, all queued assets are loaded
+ */
+uint32_t getAsyncLoadsPending(void)
+{
+    return loadsPending;
+}
+
+/**
+ * @brief Call the callbacks for all completed loads without waiting. This is called every main loop iteration
+ */
+void pollAsyncLoads(void)
+{
+    while (loadsPending && doneQueue && uxQueueMessagesWaiting(doneQueue))
+    {
+        dispatchAsyncLoad(0);
+    }
+}
+
+/**
+ * @brief Wait for all queued loads to complete and call their callbacks
+ */
+void waitAsyncLoads(void)
+{
+    while (loadsPending)
+    {
+        dispatchAsyncLoad(portMAX_DELAY);
+    }
+}
@@ -0,0 +1,84 @@
+/*! \file fs_async.h
+ *
+ * \section fs_async_design Design Philosophy
+ *
+ * Loading assets with loadWsg(), loadFont(), loadJson(), or loadMidiFile() blocks until the asset is decompressed.
+ * When a mode loads dozens of assets in its \c fnEnterMode, the display stalls until they are all done.
+ *
+ * These functions queue asset loads to a background FreeRTOS task instead (a worker thread in the emulator). The
+ * loads run in order with the same loaders, and each completion is reported on the main loop, either by polling
+ * getAsyncLoadsPending() or with a ::asyncLoadCb_t callback. This lets a mode draw a progress screen, or start
+ * gameplay, while the rest of its assets stream in.
+ *
+ * Callbacks are always called from the main loop, never from the loader task, so they may safely touch mode state.
+ *
+ * \section fs_async_usage Usage
+ *
+ * Queue loads with loadAssetAsync(), or loadWsgsAsync() for a batch of WSGs. The destination asset must stay valid,
+ * and must not be read or written, until its callback is called or getAsyncLoadsPending() returns zero.
+ *
+ * Completions are dispatched by pollAsyncLoads(), which the system calls every main loop iteration. waitAsyncLoads()
+ * blocks until all queued loads are complete. The system calls it before a mode's \c fnExitMode, so a mode never
+ * exits with loads in flight.
+ *
+ * Assets loaded this way are freed with their normal functions, like freeWsg().
+ *
+ * \section fs_async_example Example
+ *
+ * \code{.c}
+ * static void spriteLoaded(cnfsFileIdx_t fIdx, void* asset, bool success, void* arg)
+ * {
+ *     loadedCount++;
+ * }
+ *
+ * // In fnEnterMode, queue the loads
+ * loadWsgsAsync(spriteIdxs, sprites, ARRAY_SIZE(spriteIdxs), true, spriteLoaded, NULL);
+ *
+ * // In fnMainLoop, draw progress until everything is loaded
+ * if (getAsyncLoadsPending())
+ * {
+ *     drawText(&font, c555, "Loading...", 0, 0);
+ *     return;
+ * }
+ * \endcode
+ */
+
+#ifndef _FS_ASYNC_H_
+#define _FS_ASYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cnfs_image.h"
+#include "wsg.h"
+
+/**
+ * @brief The types of assets that may be loaded asynchronously, and the loader used for each
+ */
+typedef enum
+{
+    ASYNC_WSG,       ///< loadWsg() into a ::wsg_t
+    ASYNC_WSG_SPANS, ///< loadWsgSpans() into a ::wsgSpans_t
+    ASYNC_FONT,      ///< loadFont() into a ::font_t
+    ASYNC_JSON,      ///< loadJson() into a \c char*, pass a \c char** as the asset
+    ASYNC_MIDI,      ///< loadMidiFile() into a ::midiFile_t
+} asyncAssetType_t;
+
+/**
+ * @brief A function called from the main loop when an asynchronous load is complete
+ *
+ * @param fIdx The file that was loaded
+ * @param asset The asset that was loaded into
+ * @param success true if the asset loaded, false if it failed and should not be used
+ * @param arg The argument given when the load was queued
+ */
+typedef void (*asyncLoadCb_t)(cnfsFileIdx_t fIdx, void* asset, bool success, void* arg);
+
+bool loadAssetAsync(asyncAssetType_t type, cnfsFileIdx_t fIdx, void* asset, bool spiRam, asyncLoadCb_t cb,
+                    void* arg);
+bool loadWsgsAsync(const cnfsFileIdx_t* fIdxs, wsg_t* wsgs, uint32_t count, bool spiRam, asyncLoadCb_t cb, void* arg);
+uint32_t getAsyncLoadsPending(void);
+void pollAsyncLoads(void);
+void waitAsyncLoads(void);
+
+#endif
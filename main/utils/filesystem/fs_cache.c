@@ -0,0 +1,375 @@
+//==============================================================================
+// Includes
+//==============================================================================
+
+#include <stddef.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include "fs_cache.h"
+#include "fs_wsg.h"
+#include "fs_font.h"
+#include "linked_list.h"
+#include "macros.h"
+
+//==============================================================================
+// Enums
+//==============================================================================
+
+/**
+ * @brief The types of assets which may be cached
+ */
+typedef enum
+{
+    CACHE_WSG,  ///< A ::wsg_t
+    CACHE_FONT, ///< A ::font_t
+    CACHE_MIDI, ///< A ::midiFile_t
+} cacheType_t;
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A single cached asset. The asset must be the first member so a handle can be converted back to its entry
+ */
+typedef struct
+{
+    union
+    {
+        wsg_t wsg;       ///< The asset, if this is a ::CACHE_WSG
+        font_t font;     ///< The asset, if this is a ::CACHE_FONT
+        midiFile_t midi; ///< The asset, if this is a ::CACHE_MIDI
+    } asset;             ///< The shared asset, handles point here
+    cnfsFileIdx_t fIdx;  ///< The file this asset was loaded from
+    cacheType_t type;    ///< The type of asset
+    uint32_t refs;       ///< The number of handles which have not been released
+    uint32_t size;       ///< The approximate number of bytes this asset uses
+    node_t* lruNode;     ///< This entry's node in the LRU list while it is unreferenced, NULL otherwise
+} cacheEntry_t;
+
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static cacheEntry_t* acquireCachedAsset(cnfsFileIdx_t fIdx, cacheType_t type);
+static void releaseCachedAsset(void* asset, cacheType_t type);
+static uint32_t loadCachedAsset(cacheEntry_t* entry);
+static void evictCachedAsset(cacheEntry_t* entry);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// Cached entries indexed by ::cnfsFileIdx_t, allocated the first time an asset is cached
+static cacheEntry_t** cacheEntries = NULL;
+/// Unreferenced entries, least recently used first. Holds type ::cacheEntry_t*
+static list_t cacheLru = {0};
+/// The total size of all cached assets, referenced or not
+static uint32_t cacheSize = 0;
+/// The size past which unreferenced assets are evicted
+static uint32_t cacheBudget = ASSET_CACHE_DEFAULT_BUDGET;
+
+//==============================================================================
+// Functions
+//==============================================================================
+
+/**
+ * @brief Load an asset into a cache entry, to SPI RAM
+ *
+ * @param entry The entry to load into, with the file index and type set
+ * @return The approximate number of bytes used by the asset, or 0 if it failed to load
+ */
+static uint32_t loadCachedAsset(cacheEntry_t* entry)
+{
+    switch (entry->type)
+    {
+        case CACHE_WSG:
+        {
+            wsg_t* wsg = &entry->asset.wsg;
+            if (loadWsg(entry->fIdx, wsg, true))
+            {
+                return sizeof(cacheEntry_t) + (wsg->w * wsg->h * sizeof(paletteColor_t));
+            }
+            break;
+        }
+        case CACHE_FONT:
+        {
+            font_t* font = &entry->asset.font;
+            if (loadFont(entry->fIdx, font, true))
+            {
+                uint32_t size = sizeof(cacheEntry_t);
+                for (int idx = 0; idx < ARRAY_SIZE(font->chars); idx++)
+                {
+                    if (NULL != font->chars[idx].bitmap)
+                    {
+                        size += ((font->height * font->chars[idx].width) + 7) / 8;
+                    }
+                }
+                return size;
+            }
+            break;
+        }
+        case CACHE_MIDI:
+        {
+            midiFile_t* midi = &entry->asset.midi;
+            if (loadMidiFile(entry->fIdx, midi, true))
+            {
+                return sizeof(cacheEntry_t) + midi->length + (midi->trackCount * sizeof(midiTrack_t));
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Get a referenced entry for an asset, loading it if it isn't cached
+ *
+ * @param fIdx The file to load
+ * @param type The type of asset to load it as
+ * @return The entry, with its reference count incremented, or NULL if it couldn't be loaded
+ */
+static cacheEntry_t* acquireCachedAsset(cnfsFileIdx_t fIdx, cacheType_t type)
+{
+    if (fIdx < 0 || fIdx >= CNFS_NUM_FILES)
+    {
+        ESP_LOGE("CACHE", "Invalid cnfsIdx %d", fIdx);
+        return NULL;
+    }
+
+    if (NULL == cacheEntries)
+    {
+        cacheEntries = heap_caps_calloc(CNFS_NUM_FILES, sizeof(cacheEntry_t*), MALLOC_CAP_SPIRAM);
+        if (NULL == cacheEntries)
+        {
+            return NULL;
+        }
+    }
+
+    // Check if this asset is already cached
+    cacheEntry_t* entry = cacheEntries[fIdx];
+    if (NULL != entry)
+    {
+        if (entry->type != type)
+        {
+            ESP_LOGE("CACHE", "cnfsIdx %d is already cached as a different type", fIdx);
+            return NULL;
+        }
+
+        // Take it off the LRU list, it's in use again
+        if (NULL != entry->lruNode)
+        {
+            removeEntry(&cacheLru, entry->lruNode);
+            entry->lruNode = NULL;
+        }
+        entry->refs++;
+        return entry;
+    }
+
+    // Not cached, load it
+#ifndef __XTENSA__
+    char tag[32];
+    sprintf(tag, "cache %d", fIdx);
+#endif
+    entry = heap_caps_calloc_tag(1, sizeof(cacheEntry_t), MALLOC_CAP_SPIRAM, tag);
+    if (NULL == entry)
+    {
+        return NULL;
+    }
+    entry->fIdx = fIdx;
+    entry->type = type;
+    entry->size = loadCachedAsset(entry);
+    if (0 == entry->size)
+    {
+        heap_caps_free(entry);
+        return NULL;
+    }
+    entry->refs        = 1;
+    cacheEntries[fIdx] = entry;
+
+    cacheSize += entry->size;
+
+    // Make room for the new asset, if possible
+    trimAssetCache();
+    return entry;
+}
+
+/**
+ * @brief Release a reference to a cached asset. If it is no longer referenced, it becomes the most recently used
+ * eviction candidate
+ *
+ * @param asset A handle returned by one of the cached loaders
+ * @param type The type of asset the handle is
+ */
+static void releaseCachedAsset(void* asset, cacheType_t type)
+{
+    if (NULL == asset)
+    {
+        return;
+    }
+
+    // The asset is the first member of the entry
+    cacheEntry_t* entry = (cacheEntry_t*)asset;
+    if (entry->type != type || NULL == cacheEntries || cacheEntries[entry->fIdx] != entry || 0 == entry->refs)
+    {
+        ESP_LOGE("CACHE", "Released an asset which isn't cached");
+        return;
+    }
+
+    entry->refs--;
+    if (0 == entry->refs)
+    {
+        push(&cacheLru, entry);
+        entry->lruNode = cacheLru.last;
+        trimAssetCache();
+    }
+}
+
+/**
+ * @brief Free an unreferenced cached asset and its entry
+ *
+ * @param entry The entry to free, which must not be on the LRU list
+ */
+static void evictCachedAsset(cacheEntry_t* entry)
+{
+    switch (entry->type)
+    {
+        case CACHE_WSG:
+        {
+            freeWsg(&entry->asset.wsg);
+            break;
+        }
+        case CACHE_FONT:
+        {
+            freeFont(&entry->asset.font);
+            break;
+        }
+        case CACHE_MIDI:
+        {
+            unloadMidiFile(&entry->asset.midi);
+            break;
+        }
+    }
+
+    cacheEntries[entry->fIdx] = NULL;
+    cacheSize -= entry->size;
+    heap_caps_free(entry);
+}
+
+/**
+ * @brief Evict least recently used unreferenced assets until the cache fits in its budget, or there is nothing left
+ * to evict. Unlike flushAssetCache(), recently used assets which fit in the budget stay cached
+ */
+void trimAssetCache(void)
+{
+    while (cacheSize > cacheBudget && cacheLru.length > 0)
+    {
+        cacheEntry_t* entry = shift(&cacheLru);
+        entry->lruNode      = NULL;
+        evictCachedAsset(entry);
+    }
+}
+
+/**
+ * @brief Get a shared handle to a WSG, loading it if it isn't cached. The handle must not be modified
+ *
+ * @param fIdx The WSG file to load
+ * @return The shared WSG, or NULL if it couldn't be loaded. Release it with releaseWsgCached()
+ */
+wsg_t* loadWsgCached(cnfsFileIdx_t fIdx)
+{
+    cacheEntry_t* entry = acquireCachedAsset(fIdx, CACHE_WSG);
+    return entry ? &entry->asset.wsg : NULL;
+}
+
+/**
+ * @brief Release a shared WSG handle
+ *
+ * @param wsg A handle returned by loadWsgCached(), or NULL
+ */
+void releaseWsgCached(wsg_t* wsg)
+{
+    releaseCachedAsset(wsg, CACHE_WSG);
+}
+
+/**
+ * @brief Get a shared handle to a font, loading it if it isn't cached. The handle must not be modified
+ *
+ * @param fIdx The font file to load
+ * @return The shared font, or NULL if it couldn't be loaded. Release it with releaseFontCached()
+ */
+font_t* loadFontCached(cnfsFileIdx_t fIdx)
+{
+    cacheEntry_t* entry = acquireCachedAsset(fIdx, CACHE_FONT);
+    return entry ? &entry->asset.font : NULL;
+}
+
+/**
+ * @brief Release a shared font handle
+ *
+ * @param font A handle returned by loadFontCached(), or NULL
+ */
+void releaseFontCached(font_t* font)
+{
+    releaseCachedAsset(font, CACHE_FONT);
+}
+
+/**
+ * @brief Get a shared handle to a MIDI file, loading it if it isn't cached. The handle must not be modified
+ *
+ * @param fIdx The MIDI file to load
+ * @return The shared MIDI file, or NULL if it couldn't be loaded. Release it with releaseMidiFileCached()
+ */
+midiFile_t* loadMidiFileCached(cnfsFileIdx_t fIdx)
+{
+    cacheEntry_t* entry = acquireCachedAsset(fIdx, CACHE_MIDI);
+    return entry ? &entry->asset.midi : NULL;
+}
+
+/**
+ * @brief Release a shared MIDI file handle
+ *
+ * @param file A handle returned by loadMidiFileCached(), or NULL
+ */
+void releaseMidiFileCached(midiFile_t* file)
+{
+    releaseCachedAsset(file, CACHE_MIDI);
+}
+
+/**
+ * @brief Set the number of bytes the cache may hold before evicting unreferenced assets. Unreferenced assets are
+ * evicted immediately if the cache is over the new budget
+ *
+ * @param budget The new budget, in bytes
+ */
+void setAssetCacheBudget(uint32_t budget)
+{
+    cacheBudget = budget;
+    trimAssetCache();
+}
+
+/**
+ * @brief Get the total size of all cached assets, referenced or not
+ *
+ * @return The approximate number of bytes used by the cache
+ */
+uint32_t getAssetCacheSize(void)
+{
+    return cacheSize;
+}
+
+/**
+ * @brief Free all unreferenced cached assets. Referenced assets stay cached
+ */
+void flushAssetCache(void)
+{
+    cacheEntry_t* entry;
+    while ((entry = shift(&cacheLru)))
+    {
+        entry->lruNode = NULL;
+        evictCachedAsset(entry);
+    }
+}
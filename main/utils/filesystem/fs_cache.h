@@ -0,0 +1,73 @@
+/*! \file fs_cache.h
+ *
+ * \section fs_cache_design Design Philosophy
+ *
+ * Many modes and utilities load the same assets, like trophy icons, menu graphics, and fonts. Each loadWsg(),
+ * loadFont(), or loadMidiFile() decompresses the file again into its own copy, which costs both time and RAM.
+ *
+ * The asset cache loads each file once and hands out shared, reference-counted handles to it. Every load of the same
+ * ::cnfsFileIdx_t returns the same handle and increments its reference count. Releasing a handle decrements the count.
+ *
+ * Assets with no references are not freed right away. They are kept in least-recently-used order so that loading
+ * them again is free. When the total size of all cached assets exceeds the budget, the least-recently-used
+ * unreferenced assets are freed until it fits again. Referenced assets are never evicted, so the budget may be
+ * exceeded while they are all in use.
+ *
+ * Cached assets are always loaded to SPI RAM. The budget defaults to ::ASSET_CACHE_DEFAULT_BUDGET bytes and may be
+ * changed with setAssetCacheBudget().
+ *
+ * The cache is not thread safe and must only be used from the main loop.
+ *
+ * \section fs_cache_usage Usage
+ *
+ * Load shared assets with loadWsgCached(), loadFontCached(), and loadMidiFileCached(). Each returns a handle which
+ * must not be modified, or NULL if the asset couldn't be loaded.
+ *
+ * Release each handle exactly once when done with releaseWsgCached(), releaseFontCached(), or
+ * releaseMidiFileCached(). Never free a handle with freeWsg(), freeFont(), or unloadMidiFile().
+ *
+ * trimAssetCache() evicts unreferenced assets until the cache fits in its budget. The system calls it after a mode
+ * exits, so assets shared between modes, like menu graphics and fonts, stay warm across mode switches.
+ * flushAssetCache() frees all unreferenced assets regardless of the budget. The system calls it when it deinitializes.
+ *
+ * \section fs_cache_example Example
+ *
+ * \code{.c}
+ * // Get a shared handle to an image
+ * wsg_t* trophy = loadWsgCached(GOLD_TROPHY_WSG);
+ * // Draw it
+ * drawWsgSimple(trophy, 0, 0);
+ * // Release the handle
+ * releaseWsgCached(trophy);
+ * \endcode
+ */
+
+#ifndef _FS_CACHE_H_
+#define _FS_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cnfs_image.h"
+#include "wsg.h"
+#include "font.h"
+#include "midiFileParser.h"
+
+/// The default number of bytes the asset cache may hold before evicting unreferenced assets
+#define ASSET_CACHE_DEFAULT_BUDGET (256 * 1024)
+
+wsg_t* loadWsgCached(cnfsFileIdx_t fIdx);
+void releaseWsgCached(wsg_t* wsg);
+
+font_t* loadFontCached(cnfsFileIdx_t fIdx);
+void releaseFontCached(font_t* font);
+
+midiFile_t* loadMidiFileCached(cnfsFileIdx_t fIdx);
+void releaseMidiFileCached(midiFile_t* file);
+
+void setAssetCacheBudget(uint32_t budget);
+uint32_t getAssetCacheSize(void);
+void trimAssetCache(void);
+void flushAssetCache(void);
+
+#endif
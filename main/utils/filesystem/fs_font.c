@@ -43,7 +43,8 @@ bool loadFont(cnfsFileIdx_t fIdx, font_t* font, bool spiRam)
     }
 
     // Read the data into a font struct
-    font->height = buf[bufIdx++];
+    font->height    = buf[bufIdx++];
+    font->spanCache = NULL;
 
     // Read each char
     while (bufIdx < sz && chIdx < ARRAY_SIZE(font->chars))
@@ -52,7 +53,9 @@ bool loadFont(cnfsFileIdx_t fIdx, font_t* font, bool spiRam)
         font_ch_t* this = &font->chars[chIdx++];
 
         // Read the width
-        this->width = buf[bufIdx++];
+        this->width    = buf[bufIdx++];
+        this->spans    = NULL;
+        this->numSpans = 0;
 
         // Figure out what size the char is
         int pixels = font->height * this->width;
@@ -72,8 +75,10 @@ bool loadFont(cnfsFileIdx_t fIdx, font_t* font, bool spiRam)
     // Zero out any unused chars
     while (chIdx <= '~' - ' ' + 1)
     {
-        font->chars[chIdx].bitmap  = NULL;
-        font->chars[chIdx++].width = 0;
+        font->chars[chIdx].bitmap   = NULL;
+        font->chars[chIdx].spans    = NULL;
+        font->chars[chIdx].numSpans = 0;
+        font->chars[chIdx++].width  = 0;
     }
 
     return true;
@@ -88,6 +93,10 @@ void freeFont(font_t* font)
 {
     if (font->height)
     {
+        // Free anything cached for this font
+        freeFontGlyphCache(font);
+        clearTextLayoutCache(font);
+
         // using uint8_t instead of char because a char will overflow to -128 after the last char is freed (\x7f)
         for (uint8_t idx = 0; idx <= '~' - ' ' + 1; idx++)
         {
@@ -14,102 +14,237 @@
 #include "fs_wsg.h"
 #include "macros.h"
 
+//==============================================================================
+// Function Prototypes
+//==============================================================================
+
+static bool readWsgHeader(heatshrinkStream_t* hs, uint16_t* w, uint16_t* h, bool* spans);
+static bool readWsgPixels(heatshrinkStream_t* hs, paletteColor_t* px, uint16_t w, uint16_t h, bool spans);
+static uint32_t encodeWsgSpanRow(const paletteColor_t* in, uint16_t w, uint8_t* out);
+static bool indexWsgSpans(wsgSpans_t* spr, uint32_t spanSize);
+
 //==============================================================================
 // Functions
 //==============================================================================
 
 /**
- * @brief Load a WSG from ROM to RAM. WSGs placed in the assets_image folder
- * before compilation will be automatically flashed to ROM
+ * @brief Read the four byte WSG header from a heatshrink stream
  *
- * @param fIdx The cnfsFileIdx_t the WSG to load
- * @param wsg  A handle to load the WSG to
- * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
- * than normal RAM
- * @return true if the WSG was loaded successfully,
- *         false if the WSG load failed and should not be used
+ * @param hs The stream to read from, at the start of the file
+ * @param[out] w The width of the image
+ * @param[out] h The height of the image
+ * @param[out] spans true if the pixels are span-encoded, see \ref wsg_spans
+ * @return true if the header was read, false if the file was too short
  */
-bool loadWsg(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam)
+static bool readWsgHeader(heatshrinkStream_t* hs, uint16_t* w, uint16_t* h, bool* spans)
 {
-    // Read and decompress file
-    uint32_t decompressedSize = 0;
-    uint8_t* decompressedBuf  = readHeatshrinkFile(fIdx, &decompressedSize, spiRam);
-
-    if (NULL == decompressedBuf)
+    uint8_t hdr[4];
+    if (sizeof(hdr) != heatshrinkStreamRead(hs, hdr, sizeof(hdr)))
     {
         return false;
     }
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    uint16_t newW = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    uint16_t newH = (decompressedBuf[2] << 8) | decompressedBuf[3];
+    *w     = ((hdr[0] << 8) | hdr[1]) & ~WSG_SPAN_FLAG;
+    *h     = (hdr[2] << 8) | hdr[3];
+    *spans = (hdr[0] & (WSG_SPAN_FLAG >> 8)) != 0;
+    return true;
+}
 
-    // If there is an existing buffer and it doesn't match, free it
-    if (wsg->px && (wsg->w * wsg->h != newW * newH))
+/**
+ * @brief Decode the pixels of a WSG file straight from a heatshrink stream into a pixel buffer. Span-encoded files are
+ * expanded, with transparent pixels filled in between the spans.
+ *
+ * @param hs The stream to read from, just after the header
+ * @param px The pixel buffer to write to, must be at least w * h pixels
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param spans true if the pixels are span-encoded
+ * @return true if all the pixels were read, false if the file was truncated or corrupt
+ */
+static bool readWsgPixels(heatshrinkStream_t* hs, paletteColor_t* px, uint16_t w, uint16_t h, bool spans)
+{
+    if (!spans)
     {
-        heap_caps_free(wsg->px);
-        wsg->px = NULL;
+        // Raw pixels, decode them directly
+        return (w * h) == heatshrinkStreamRead(hs, px, w * h);
     }
 
-// The rest of the bytes are pixels
-#ifndef __XTENSA__
-    char tag[32];
-    sprintf(tag, "cnfsIdx %d", fIdx);
-#endif
+    memset(px, cTransparent, w * h);
+    for (uint16_t y = 0; y < h; y++)
+    {
+        uint8_t runHdr[4];
+        if (2 != heatshrinkStreamRead(hs, runHdr, 2))
+        {
+            return false;
+        }
+
+        uint16_t numRuns = (runHdr[0] << 8) | runHdr[1];
+        while (numRuns--)
+        {
+            if (4 != heatshrinkStreamRead(hs, runHdr, 4))
+            {
+                return false;
+            }
+
+            uint16_t x   = (runHdr[0] << 8) | runHdr[1];
+            uint16_t len = (runHdr[2] << 8) | runHdr[3];
+            if (x + len > w)
+            {
+                ESP_LOGE("WSG", "Corrupt span in row %" PRIu16, y);
+                return false;
+            }
+
+            if (len != heatshrinkStreamRead(hs, &px[y * w + x], len))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-    // If there is no pixel buffer
-    if (!wsg->px)
+/**
+ * @brief Encode one row of pixels as opaque spans, see \ref wsg_spans
+ *
+ * @param in The row of pixels to encode
+ * @param w The number of pixels in the row
+ * @param out The buffer to write the encoded row to, or NULL to only measure it
+ * @return The number of bytes the encoded row takes
+ */
+static uint32_t encodeWsgSpanRow(const paletteColor_t* in, uint16_t w, uint8_t* out)
+{
+    uint32_t outSize = 2;
+    uint16_t numRuns = 0;
+    uint16_t x       = 0;
+
+    while (x < w)
     {
-        // Allocate it
-        wsg->px = (paletteColor_t*)heap_caps_malloc_tag(sizeof(paletteColor_t) * newW * newH,
-                                                        spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
+        // Skip over transparent pixels
+        while (x < w && cTransparent == in[x])
+        {
+            x++;
+        }
+        if (x == w)
+        {
+            break;
+        }
+
+        // Measure the opaque run
+        uint16_t start = x;
+        while (x < w && cTransparent != in[x])
+        {
+            x++;
+        }
+        uint16_t len = x - start;
+
+        if (out)
+        {
+            out[outSize + 0] = (start >> 8) & 0xFF;
+            out[outSize + 1] = (start) & 0xFF;
+            out[outSize + 2] = (len >> 8) & 0xFF;
+            out[outSize + 3] = (len) & 0xFF;
+            memcpy(&out[outSize + 4], &in[start], len);
+        }
+        outSize += 4 + len;
+        numRuns++;
     }
 
-    if (NULL != wsg->px)
+    if (out)
     {
-        // Set the size
-        wsg->w = newW;
-        wsg->h = newH;
+        out[0] = (numRuns >> 8) & 0xFF;
+        out[1] = (numRuns) & 0xFF;
+    }
+    return outSize;
+}
 
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        heap_caps_free(decompressedBuf);
-        return true;
+/**
+ * @brief Fill in the row offsets of a span-encoded WSG by walking the spans, validating them along the way
+ *
+ * @param spr The span-encoded WSG, with spans, w, and h set
+ * @param spanSize The number of bytes of span data
+ * @return true if all rows were found within the span data, false if the data is corrupt
+ */
+static bool indexWsgSpans(wsgSpans_t* spr, uint32_t spanSize)
+{
+    uint32_t offset = 0;
+    for (uint16_t y = 0; y < spr->h; y++)
+    {
+        if (offset + 2 > spanSize)
+        {
+            return false;
+        }
+        spr->rowOffsets[y] = offset;
+
+        uint16_t numRuns = (spr->spans[offset] << 8) | spr->spans[offset + 1];
+        offset += 2;
+        while (numRuns--)
+        {
+            if (offset + 4 > spanSize)
+            {
+                return false;
+            }
+            uint16_t x   = (spr->spans[offset + 0] << 8) | spr->spans[offset + 1];
+            uint16_t len = (spr->spans[offset + 2] << 8) | spr->spans[offset + 3];
+            offset += 4 + len;
+            if (x + len > spr->w || offset > spanSize)
+            {
+                return false;
+            }
+        }
     }
+    return true;
+}
 
-    // all done
-    heap_caps_free(decompressedBuf);
-    return false;
+/**
+ * @brief Load a WSG from ROM to RAM. WSGs placed in the assets_image folder
+ * before compilation will be automatically flashed to ROM
+ *
+ * The file is decompressed straight into the WSG's pixel buffer, so there is never a second full copy of the image in
+ * RAM.
+ *
+ * @param fIdx The cnfsFileIdx_t the WSG to load
+ * @param wsg  A handle to load the WSG to
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
+ * than normal RAM
+ * @return true if the WSG was loaded successfully,
+ *         false if the WSG load failed and should not be used
+ */
+bool loadWsg(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam)
+{
+    return loadWsgInplace(fIdx, wsg, spiRam, NULL);
 }
 
 /**
  * @brief Load a WSG from ROM to RAM. WSGs placed in the assets_image folder
  * before compilation will be automatically flashed to ROM.
- * You must provide a decoder and decode space to this function. It's useful
- * when creating one decoder & space to decode many consecutive WSGs
+ * You may provide a decoder to this function. It's useful when creating one
+ * decoder to decode many consecutive WSGs
  *
  * @param fIdx The cnfsFileIdx_t the WSG to load
  * @param wsg  A handle to load the WSG to
  * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
  * than normal RAM
- * @param decompressedBuf Memory to store decoded data. This must be as large as the decoded data
- * @param hsd A heatshrink decoder
+ * @param hsd A heatshrink decoder, or NULL to allocate one for this load
  * @return true if the WSG was loaded successfully,
  *         false if the WSG load failed and should not be used
  */
-bool loadWsgInplace(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam, uint8_t* decompressedBuf, heatshrink_decoder* hsd)
+bool loadWsgInplace(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam, heatshrink_decoder* hsd)
 {
-    // Read and decompress file
-    uint32_t decompressedSize = 0;
-    decompressedBuf           = readHeatshrinkFileInplace(fIdx, &decompressedSize, decompressedBuf, hsd);
-
-    if (NULL == decompressedBuf)
+    // Start decompressing the file
+    heatshrinkStream_t hs;
+    if (!heatshrinkStreamOpenFile(&hs, fIdx, hsd))
     {
         return false;
     }
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    uint16_t newW = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    uint16_t newH = (decompressedBuf[2] << 8) | decompressedBuf[3];
+    // The first four bytes are dimension
+    uint16_t newW, newH;
+    bool spans;
+    if (!readWsgHeader(&hs, &newW, &newH, &spans))
+    {
+        heatshrinkStreamClose(&hs);
+        return false;
+    }
 
     // If there is an existing buffer and it doesn't match, free it
     if (wsg->px && (wsg->w * wsg->h != newW * newH))
@@ -132,36 +267,41 @@ bool loadWsgInplace(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam, uint8_t* decomp
                                                         spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
     }
 
+    bool result = false;
     if (NULL != wsg->px)
     {
         // Set the size
         wsg->w = newW;
         wsg->h = newH;
 
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        return true;
+        // Decompress the pixels directly into the WSG
+        result = readWsgPixels(&hs, wsg->px, newW, newH, spans);
     }
 
     // all done
-    return false;
+    heatshrinkStreamClose(&hs);
+    return result;
 }
 
 bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam)
 {
-    // Read and decompress file
-    uint32_t decompressedSize = 0;
-    uint8_t* decompressedBuf  = readHeatshrinkNvs(namespace, key, &decompressedSize, spiRam);
-
-    if (NULL == decompressedBuf)
+    // Read the compressed blob and start decompressing it
+    heatshrinkStream_t hs;
+    if (!heatshrinkStreamOpenNvs(&hs, namespace, key, spiRam))
     {
         return false;
     }
 
-    ESP_LOGD("WSG", "decompressedBuf size is %" PRIu32, decompressedSize);
+    ESP_LOGD("WSG", "decompressed size is %" PRIu32, hs.decompressedSize);
 
-    // Save the decompressed info to the wsg. The first four bytes are dimension
-    uint16_t newW = (decompressedBuf[0] << 8) | decompressedBuf[1];
-    uint16_t newH = (decompressedBuf[2] << 8) | decompressedBuf[3];
+    // The first four bytes are dimension
+    uint16_t newW, newH;
+    bool spans;
+    if (!readWsgHeader(&hs, &newW, &newH, &spans))
+    {
+        heatshrinkStreamClose(&hs);
+        return false;
+    }
 
     ESP_LOGD("WSG", "full WSG is %" PRIu16 " x %" PRIu16 ", or %d pixels", newW, newH, newW * newH);
 
@@ -172,12 +312,6 @@ bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam)
         wsg->px = NULL;
     }
 
-    // The rest of the bytes are pixels
-#ifndef __XTENSA__
-    char tag[32];
-    sprintf(tag, "NVS key: %s", key);
-#endif
-
     // If there is no pixel buffer
     if (!wsg->px)
     {
@@ -186,23 +320,24 @@ bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam)
                                                         spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, key);
     }
 
+    bool result = false;
     if (NULL != wsg->px)
     {
         // Set the size
         wsg->w = newW;
         wsg->h = newH;
 
-        ESP_LOGD("WSG", "Copying %" PRIu32 " pixels into WSG now", decompressedSize - 4);
-        memcpy(wsg->px, &decompressedBuf[4], decompressedSize - 4);
-        heap_caps_free(decompressedBuf);
-        return true;
+        ESP_LOGD("WSG", "Decompressing pixels into WSG now");
+        result = readWsgPixels(&hs, wsg->px, newW, newH, spans);
+    }
+    else
+    {
+        ESP_LOGE("WSG", "Allocating pixels failed");
     }
-
-    ESP_LOGE("WSG", "Allocating pixels failed");
 
     // all done
-    heap_caps_free(decompressedBuf);
-    return false;
+    heatshrinkStreamClose(&hs);
+    return result;
 }
 
 bool saveWsgNvs(const char* namespace, const char* key, const wsg_t* wsg)
@@ -268,3 +403,132 @@ void freeWsg(wsg_t* wsg)
         wsg->w  = 0;
     }
 }
+
+/**
+ * @brief Encode a WSG in RAM as opaque spans. The source WSG is not modified and must still be freed separately.
+ *
+ * @param wsg The WSG to encode
+ * @param spr A handle to write the span-encoded WSG to
+ * @param spiRam true to allocate the spans in SPI RAM, false to allocate them in normal RAM
+ * @return true if the WSG was encoded successfully,
+ *         false if the allocation failed and the span-encoded WSG should not be used
+ */
+bool wsgToSpans(const wsg_t* wsg, wsgSpans_t* spr, bool spiRam)
+{
+    // Measure the encoded size first
+    uint32_t spanSize = 0;
+    for (uint16_t y = 0; y < wsg->h; y++)
+    {
+        spanSize += encodeWsgSpanRow(&wsg->px[y * wsg->w], wsg->w, NULL);
+    }
+
+    spr->rowOffsets = (uint32_t*)heap_caps_malloc_tag(sizeof(uint32_t) * wsg->h + spanSize,
+                                                      spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, "wsgSpans");
+    if (NULL == spr->rowOffsets)
+    {
+        spr->spans = NULL;
+        return false;
+    }
+
+    spr->spans = (uint8_t*)&spr->rowOffsets[wsg->h];
+    spr->w     = wsg->w;
+    spr->h     = wsg->h;
+
+    // Then encode each row
+    uint32_t offset = 0;
+    for (uint16_t y = 0; y < wsg->h; y++)
+    {
+        spr->rowOffsets[y] = offset;
+        offset += encodeWsgSpanRow(&wsg->px[y * wsg->w], wsg->w, &spr->spans[offset]);
+    }
+    return true;
+}
+
+/**
+ * @brief Load a WSG from ROM to RAM as opaque spans, which may be drawn with drawWsgSpans(). WSGs which were
+ * span-encoded by the assets_preprocessor are decompressed directly, and raw WSGs are encoded at load time.
+ *
+ * @param fIdx The cnfsFileIdx_t the WSG to load
+ * @param spr A handle to load the span-encoded WSG to
+ * @param spiRam true to load to SPI RAM, false to load to normal RAM. SPI RAM is more plentiful but slower to access
+ * than normal RAM
+ * @return true if the WSG was loaded successfully,
+ *         false if the WSG load failed and should not be used
+ */
+bool loadWsgSpans(cnfsFileIdx_t fIdx, wsgSpans_t* spr, bool spiRam)
+{
+    // Start decompressing the file
+    heatshrinkStream_t hs;
+    if (!heatshrinkStreamOpenFile(&hs, fIdx, NULL))
+    {
+        return false;
+    }
+
+    uint16_t newW, newH;
+    bool spans;
+    if (!readWsgHeader(&hs, &newW, &newH, &spans))
+    {
+        heatshrinkStreamClose(&hs);
+        return false;
+    }
+
+    bool result = false;
+    if (spans)
+    {
+        // Already span-encoded, decompress the spans directly after the row offsets
+#ifndef __XTENSA__
+        char tag[32];
+        sprintf(tag, "cnfsIdx %d", fIdx);
+#endif
+        uint32_t spanSize = hs.decompressedSize - 4;
+        spr->rowOffsets   = (uint32_t*)heap_caps_malloc_tag(sizeof(uint32_t) * newH + spanSize,
+                                                            spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
+        if (NULL != spr->rowOffsets)
+        {
+            spr->spans = (uint8_t*)&spr->rowOffsets[newH];
+            spr->w     = newW;
+            spr->h     = newH;
+
+            result = (spanSize == heatshrinkStreamRead(&hs, spr->spans, spanSize)) && indexWsgSpans(spr, spanSize);
+            if (!result)
+            {
+                ESP_LOGE("WSG", "Corrupt spans in cnfsIdx %d", fIdx);
+                freeWsgSpans(spr);
+            }
+        }
+    }
+    else
+    {
+        // Raw pixels, decompress them to a temporary WSG and encode them now
+        wsg_t raw = {0};
+        raw.px    = (paletteColor_t*)heap_caps_malloc(sizeof(paletteColor_t) * newW * newH,
+                                                      spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+        raw.w     = newW;
+        raw.h     = newH;
+        if (NULL != raw.px)
+        {
+            result = readWsgPixels(&hs, raw.px, newW, newH, false) && wsgToSpans(&raw, spr, spiRam);
+            heap_caps_free(raw.px);
+        }
+    }
+
+    heatshrinkStreamClose(&hs);
+    return result;
+}
+
+/**
+ * @brief Free the memory for a span-encoded WSG
+ *
+ * @param spr The span-encoded WSG handle to free memory from
+ */
+void freeWsgSpans(wsgSpans_t* spr)
+{
+    if (spr->rowOffsets)
+    {
+        heap_caps_free(spr->rowOffsets);
+        spr->rowOffsets = NULL;
+        spr->spans      = NULL;
+        spr->h          = 0;
+        spr->w          = 0;
+    }
+}
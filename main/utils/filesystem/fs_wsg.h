@@ -17,6 +17,10 @@
  *
  * Free when done using freeWsg(). If a wsg is not freed, the memory will leak.
  *
+ * Sprites with a lot of transparency may instead be loaded as opaque spans with loadWsgSpans() and drawn with
+ * drawWsgSpans(). A WSG already in RAM may be converted with wsgToSpans(). Free span-encoded WSGs with freeWsgSpans().
+ * See \ref wsg_spans for the encoding.
+ *
  * \section fs_wsg_example Example
  *
  * \code{.c}
@@ -44,9 +48,13 @@
 #include "heatshrink_encoder.h"
 
 bool loadWsg(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam);
-bool loadWsgInplace(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam, uint8_t* decompressedBuf, heatshrink_decoder* hsd);
+bool loadWsgInplace(cnfsFileIdx_t fIdx, wsg_t* wsg, bool spiRam, heatshrink_decoder* hsd);
 bool loadWsgNvs(const char* namespace, const char* key, wsg_t* wsg, bool spiRam);
 bool saveWsgNvs(const char* namespace, const char* key, const wsg_t* wsg);
 void freeWsg(wsg_t* wsg);
 
+bool loadWsgSpans(cnfsFileIdx_t fIdx, wsgSpans_t* spr, bool spiRam);
+bool wsgToSpans(const wsg_t* wsg, wsgSpans_t* spr, bool spiRam);
+void freeWsgSpans(wsgSpans_t* spr);
+
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <stddef.h>
+#include <string.h>
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
@@ -11,6 +12,69 @@
 
 #include "heatshrink_helper.h"
 
+/**
+ * @brief Read the four byte header at the start of heatshrink compressed data
+ *
+ * @param src The compressed data
+ * @param srcSize The size of the compressed data
+ * @param decompressedSize Written with the size of the data after decompression, may be NULL
+ * @param stored Written with true if the data is stored uncompressed, may be NULL
+ * @param windowBits Written with the window size the data was compressed with, as a power of two, may be NULL
+ * @param lookaheadBits Written with the lookahead size the data was compressed with, as a power of two, may be NULL
+ * @return true if the header was read, false if the data is too short or the header is invalid
+ */
+bool heatshrinkParseHeader(const uint8_t* src, uint32_t srcSize, uint32_t* decompressedSize, bool* stored,
+                           uint8_t* windowBits, uint8_t* lookaheadBits)
+{
+    // Can't decompress if the heatshrink header doesn't even fit
+    if (NULL == src || srcSize < 4)
+    {
+        return false;
+    }
+
+    uint8_t format = src[0];
+    uint8_t window = HEATSHRINK_DEFAULT_WINDOW_BITS;
+    uint8_t look   = HEATSHRINK_DEFAULT_LOOKAHEAD_BITS;
+    uint32_t size  = (src[1] << 16) | (src[2] << 8) | (src[3]);
+
+    if (HEATSHRINK_HEADER_STORED == format)
+    {
+        // The whole decompressed size must be there to use it in place
+        if (srcSize - 4 < size)
+        {
+            return false;
+        }
+    }
+    else if (HEATSHRINK_HEADER_DEFAULT != format)
+    {
+        window = format >> 4;
+        look   = format & 0x0F;
+        if (window < HEATSHRINK_MIN_WINDOW_BITS || window > HEATSHRINK_MAX_WINDOW_BITS
+            || look < HEATSHRINK_MIN_LOOKAHEAD_BITS || look >= window)
+        {
+            return false;
+        }
+    }
+
+    if (decompressedSize)
+    {
+        (*decompressedSize) = size;
+    }
+    if (stored)
+    {
+        (*stored) = (HEATSHRINK_HEADER_STORED == format);
+    }
+    if (windowBits)
+    {
+        (*windowBits) = window;
+    }
+    if (lookaheadBits)
+    {
+        (*lookaheadBits) = look;
+    }
+    return true;
+}
+
 /**
  * @brief Read a heatshrink compressed file from the filesystem into an output array.
  * Files that are in the assets_image folder before compilation and flashing
@@ -21,65 +85,32 @@
  * @param fIdx    The CNFS index of the file to load
  * @param outsize A pointer to a size_t to return how much data was read
  * @param decompressedBuf Memory to store decoded data. This must be as large as the decoded data
- * @param hsd A heatshrink decoder
+ * @param hsd A heatshrink decoder, or NULL to allocate one. A new one is also allocated if the file was compressed with
+ * a different window or lookahead than this decoder's
  * @return A pointer to the read data if successful, or NULL if there is a failure
  *         This data must be freed when done
  */
 uint8_t* readHeatshrinkFileInplace(cnfsFileIdx_t fIdx, uint32_t* outsize, uint8_t* decompressedBuf,
                                    heatshrink_decoder* hsd)
 {
-    // Read WSG from file
-    size_t sz;
-    const uint8_t* buf = cnfsGetFile(fIdx, &sz);
-    if (NULL == buf)
+    heatshrinkStream_t hs;
+    if (!heatshrinkStreamOpenFile(&hs, fIdx, hsd))
     {
-        ESP_LOGE("WSG", "Failed to read %d", fIdx);
         (*outsize) = 0;
         return NULL;
     }
 
-    // Pick out the decompressed size and create a space for it
-    (*outsize) = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
-
-    // Create the decoder
-    size_t copied = 0;
-    heatshrink_decoder_reset(hsd);
+    // Decode the whole file
+    (*outsize)    = hs.decompressedSize;
+    uint32_t read = heatshrinkStreamRead(&hs, decompressedBuf, hs.decompressedSize);
+    heatshrinkStreamClose(&hs);
 
-    // The decompressed filesize is four bytes, so start after that
-    uint32_t inputIdx  = 4;
-    uint32_t outputIdx = 0;
-    // Decode the file in chunks
-    while (inputIdx < sz)
+    if (read != (*outsize))
     {
-        // Decode some data
-        copied = 0;
-        heatshrink_decoder_sink(hsd, &buf[inputIdx], sz - inputIdx, &copied);
-        inputIdx += copied;
-
-        if (copied == 0)
-        {
-            ESP_LOGE("WSG", "Failed to read %d fault on decode", fIdx);
-            heatshrink_decoder_finish(hsd);
-            return 0;
-        }
-
-        // Save it to the output array
-        copied = 0;
-        heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-        outputIdx += copied;
+        ESP_LOGE("WSG", "Failed to read %d fault on decode", fIdx);
+        return NULL;
     }
 
-    // Note that it's all done
-    heatshrink_decoder_finish(hsd);
-
-    // Flush any final output
-    copied = 0;
-    heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-    outputIdx += copied;
-
-    // All done decoding
-    heatshrink_decoder_finish(hsd);
-
     // Return the decompressed bytes
     return decompressedBuf;
 }
@@ -108,7 +139,14 @@ uint8_t* readHeatshrinkFile(cnfsFileIdx_t fIdx, uint32_t* outsize, bool readToSp
     }
 
     // Pick out the decompressed size and create a space for it
-    int32_t decompressedSize = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
+    uint32_t decompressedSize;
+    if (!heatshrinkParseHeader(buf, (uint32_t)sz, &decompressedSize, NULL, NULL, NULL))
+    {
+        ESP_LOGE("WSG", "Failed to read %d, invalid header", fIdx);
+        (*outsize) = 0;
+        return NULL;
+    }
+
     uint8_t* decompressedBuf;
     if (readToSpiRam)
     {
@@ -119,14 +157,14 @@ uint8_t* readHeatshrinkFile(cnfsFileIdx_t fIdx, uint32_t* outsize, bool readToSp
         decompressedBuf = (uint8_t*)heap_caps_malloc(decompressedSize, MALLOC_CAP_8BIT);
     }
 
-    // Allocate the decoder
-    heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-
-    // Decode the file
-    uint8_t* data = readHeatshrinkFileInplace(fIdx, outsize, decompressedBuf, hsd);
+    if (NULL == decompressedBuf)
+    {
+        (*outsize) = 0;
+        return NULL;
+    }
 
-    // Free the decoder
-    heatshrink_decoder_free(hsd);
+    // Decode the file. The stream allocates a decoder which matches the file's window and lookahead
+    uint8_t* data = readHeatshrinkFileInplace(fIdx, outsize, decompressedBuf, NULL);
 
     // If there was an error, free decompressedBuf
     if (NULL == data)
@@ -140,66 +178,22 @@ uint8_t* readHeatshrinkFile(cnfsFileIdx_t fIdx, uint32_t* outsize, bool readToSp
 
 uint8_t* readHeatshrinkNvs(const char* namespace, const char* key, uint32_t* outsize, bool spiRam)
 {
-    // Read WSG from NVS
-    size_t sz;
-
-    // Get full size
-    readNamespaceNvsBlob(namespace, key, NULL, &sz);
-
-    ESP_LOGD("Heatshrink", "Compressed size is %" PRIu64, (uint64_t)sz);
-
-    uint8_t* buf = (uint8_t*)heap_caps_malloc(sz, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
-    if (!buf)
-    {
-        return NULL;
-    }
-
-    if (!readNamespaceNvsBlob(namespace, key, buf, &sz))
+    heatshrinkStream_t hs;
+    if (!heatshrinkStreamOpenNvs(&hs, namespace, key, spiRam))
     {
-        heap_caps_free(buf);
         return NULL;
     }
 
-    // Pick out the decompresed size and create a space for it
-    (*outsize) = (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]);
-
+    // Create a space for the decompressed data and decode straight into it
+    (*outsize)               = hs.decompressedSize;
     uint8_t* decompressedBuf = (uint8_t*)heap_caps_malloc((*outsize), spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
-
-    // Create the decoder
-    size_t copied           = 0;
-    heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-    heatshrink_decoder_reset(hsd);
-
-    // The decompressed filesize is four bytes, so start after that
-    uint32_t inputIdx  = 4;
-    uint32_t outputIdx = 0;
-    // Decode the file in chunks
-    while (inputIdx < sz)
+    if (decompressedBuf)
     {
-        // Decode some data
-        copied = 0;
-        heatshrink_decoder_sink(hsd, &buf[inputIdx], sz - inputIdx, &copied);
-        inputIdx += copied;
-
-        // Save it to the output array
-        copied = 0;
-        heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-        outputIdx += copied;
+        heatshrinkStreamRead(&hs, decompressedBuf, (*outsize));
     }
 
-    // Note that it's all done
-    heatshrink_decoder_finish(hsd);
-
-    // Flush any final output
-    copied = 0;
-    heatshrink_decoder_poll(hsd, &decompressedBuf[outputIdx], (*outsize) - outputIdx, &copied);
-    outputIdx += copied;
-
-    // All done decoding
-    heatshrink_decoder_finish(hsd);
-    heatshrink_decoder_free(hsd);
-    // Free the bytes read from the file
-    heap_caps_free(buf);
+    // Free the bytes read from NVS
+    heatshrinkStreamClose(&hs);
 
     // Return the decompressed bytes
     return decompressedBuf;
@@ -360,57 +354,232 @@ bool heatshrinkDecompress(uint8_t* dest, uint32_t* destSize, const uint8_t* sour
     // Write the destSize
     if (destSize)
     {
-        (*destSize) = (source[0] << 24) | (source[1] << 16) | (source[2] << 8) | (source[3]);
-        sizeRead    = true;
+        sizeRead = heatshrinkParseHeader(source, sourceSize, destSize, NULL, NULL, NULL);
+        if (!sizeRead)
+        {
+            return false;
+        }
     }
 
     // Write the actual data
     if (dest)
     {
-        // Create the decoder
-        size_t copied           = 0;
-        heatshrink_decoder* hsd = heatshrink_decoder_alloc(256, 8, 4);
-        heatshrink_decoder_reset(hsd);
+        heatshrinkStream_t hs;
+        if (!heatshrinkStreamOpen(&hs, source, sourceSize, NULL))
+        {
+            return false;
+        }
 
-        // The decompressed filesize is four bytes, so start after that
-        uint32_t inputIdx  = 4;
-        uint32_t outputIdx = 0;
-        // Decode the file in chunks
-        while (inputIdx < sourceSize)
+        uint32_t size = hs.decompressedSize;
+        uint32_t read = heatshrinkStreamRead(&hs, dest, size);
+        heatshrinkStreamClose(&hs);
+
+        if (read != size)
         {
-            // Decode some data
-            copied = 0;
-            heatshrink_decoder_sink(hsd, &source[inputIdx], sourceSize - inputIdx, &copied);
-            inputIdx += copied;
+            ESP_LOGE("WSG", "Failed to decompress heatshrink buffer -- fault on decode");
+            return false;
+        }
 
-            if (copied == 0)
+        return true;
+    }
+
+    return sizeRead;
+}
+
+/**
+ * @brief Start decoding heatshrink compressed data incrementally. Decoded data is read with heatshrinkStreamRead()
+ * directly into the caller's buffers, so no intermediate decompressed buffer is needed.
+ *
+ * @param hs The stream to initialize
+ * @param src The compressed data, including the four byte size header. This must stay valid until the stream is
+ * closed
+ * @param srcSize The size of the compressed data
+ * @param hsd A heatshrink decoder to use, or NULL to allocate one for this stream. A new one is also allocated if the
+ * data was compressed with a different window or lookahead than this decoder's
+ * @return true if the stream was opened, false if the header was invalid or a decoder couldn't be allocated
+ */
+bool heatshrinkStreamOpen(heatshrinkStream_t* hs, const uint8_t* src, uint32_t srcSize, heatshrink_decoder* hsd)
+{
+    memset(hs, 0, sizeof(heatshrinkStream_t));
+
+    uint8_t windowBits, lookaheadBits;
+    if (!heatshrinkParseHeader(src, srcSize, &hs->decompressedSize, &hs->stored, &windowBits, &lookaheadBits))
+    {
+        return false;
+    }
+
+    if (!hs->stored)
+    {
+        // A decoder can only decode data compressed with its own window and lookahead
+        if (NULL == hsd || HEATSHRINK_DECODER_WINDOW_BITS(hsd) != windowBits
+            || HEATSHRINK_DECODER_LOOKAHEAD_BITS(hsd) != lookaheadBits)
+        {
+            hsd = heatshrink_decoder_alloc(256, windowBits, lookaheadBits);
+            if (NULL == hsd)
             {
-                ESP_LOGE("WSG", "Failed to decompress heatshrink buffer -- fault on decode");
-                heatshrink_decoder_finish(hsd);
-                heatshrink_decoder_free(hsd);
                 return false;
             }
-
-            // Save it to the output array
-            copied = 0;
-            heatshrink_decoder_poll(hsd, &dest[outputIdx], (*destSize) - outputIdx, &copied);
-            outputIdx += copied;
+            hs->ownsDecoder = true;
         }
+        heatshrink_decoder_reset(hsd);
+        hs->hsd = hsd;
+    }
 
-        // Note that it's all done
-        heatshrink_decoder_finish(hsd);
+    hs->src     = src;
+    hs->srcSize = srcSize;
+    // The header is four bytes, so start after that
+    hs->srcIdx = 4;
+    return true;
+}
 
-        // Flush any final output
-        copied = 0;
-        heatshrink_decoder_poll(hsd, &dest[outputIdx], (*destSize) - outputIdx, &copied);
-        outputIdx += copied;
+/**
+ * @brief Start decoding a heatshrink compressed file from the filesystem incrementally. The file is read in place
+ * from the filesystem image and never copied to RAM.
+ *
+ * @param hs The stream to initialize
+ * @param fIdx The CNFS index of the file to decode
+ * @param hsd A heatshrink decoder to use, or NULL to allocate one for this stream
+ * @return true if the stream was opened, false if the file couldn't be read or a decoder couldn't be allocated
+ */
+bool heatshrinkStreamOpenFile(heatshrinkStream_t* hs, cnfsFileIdx_t fIdx, heatshrink_decoder* hsd)
+{
+    size_t sz;
+    const uint8_t* buf = cnfsGetFile(fIdx, &sz);
+    if (NULL == buf)
+    {
+        ESP_LOGE("WSG", "Failed to read %d", fIdx);
+        memset(hs, 0, sizeof(heatshrinkStream_t));
+        return false;
+    }
+    return heatshrinkStreamOpen(hs, buf, (uint32_t)sz, hsd);
+}
 
-        // All done decoding
-        heatshrink_decoder_finish(hsd);
-        heatshrink_decoder_free(hsd);
+/**
+ * @brief Start decoding a heatshrink compressed blob from NVS incrementally. Only the compressed blob is read to RAM,
+ * and it is freed when the stream is closed.
+ *
+ * @param hs The stream to initialize
+ * @param namespace The NVS namespace to read from
+ * @param key The NVS key to read
+ * @param spiRam true to read the compressed blob to SPI RAM, false to use normal RAM
+ * @return true if the stream was opened, false if the blob couldn't be read or memory couldn't be allocated
+ */
+bool heatshrinkStreamOpenNvs(heatshrinkStream_t* hs, const char* namespace, const char* key, bool spiRam)
+{
+    memset(hs, 0, sizeof(heatshrinkStream_t));
 
-        return true;
+    // Get full size
+    size_t sz;
+    if (!readNamespaceNvsBlob(namespace, key, NULL, &sz))
+    {
+        return false;
     }
 
-    return sizeRead;
+    ESP_LOGD("Heatshrink", "Compressed size is %" PRIu64, (uint64_t)sz);
+
+    uint8_t* buf = (uint8_t*)heap_caps_malloc(sz, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (!buf)
+    {
+        return false;
+    }
+
+    if (!readNamespaceNvsBlob(namespace, key, buf, &sz) || !heatshrinkStreamOpen(hs, buf, sz, NULL))
+    {
+        heap_caps_free(buf);
+        return false;
+    }
+
+    hs->ownedSrc = buf;
+    return true;
+}
+
+/**
+ * @brief Decode the next bytes from a heatshrink stream into a buffer
+ *
+ * @param hs The stream to read from
+ * @param dest The buffer to decode into
+ * @param len The number of bytes to decode
+ * @return The number of bytes decoded. This is less than len only at the end of the data or on a decode fault
+ */
+uint32_t heatshrinkStreamRead(heatshrinkStream_t* hs, uint8_t* dest, uint32_t len)
+{
+    if (hs->stored)
+    {
+        // Stored data is just copied, stopping at the end of the data
+        uint32_t avail = hs->srcSize - hs->srcIdx;
+        if (len > avail)
+        {
+            len = avail;
+        }
+        memcpy(dest, &hs->src[hs->srcIdx], len);
+        hs->srcIdx += len;
+        hs->outIdx += len;
+        return len;
+    }
+
+    uint32_t outputIdx = 0;
+    while (outputIdx < len)
+    {
+        // Drain whatever the decoder already has
+        size_t copied = 0;
+        if (heatshrink_decoder_poll(hs->hsd, &dest[outputIdx], len - outputIdx, &copied) < 0)
+        {
+            ESP_LOGE("WSG", "Failed to decompress heatshrink stream -- fault on poll");
+            break;
+        }
+        outputIdx += copied;
+
+        if (outputIdx == len)
+        {
+            break;
+        }
+        else if (hs->srcIdx < hs->srcSize)
+        {
+            // The decoder is empty, sink more input
+            copied = 0;
+            heatshrink_decoder_sink(hs->hsd, &hs->src[hs->srcIdx], hs->srcSize - hs->srcIdx, &copied);
+            if (copied == 0)
+            {
+                ESP_LOGE("WSG", "Failed to decompress heatshrink stream -- fault on decode");
+                break;
+            }
+            hs->srcIdx += copied;
+        }
+        else if (!hs->finished)
+        {
+            // All input is sunk, flush any final output
+            heatshrink_decoder_finish(hs->hsd);
+            hs->finished = true;
+        }
+        else
+        {
+            // All done
+            break;
+        }
+    }
+
+    hs->outIdx += outputIdx;
+    return outputIdx;
+}
+
+/**
+ * @brief Finish a heatshrink stream and free the decoder and compressed data if the stream allocated them
+ *
+ * @param hs The stream to close
+ */
+void heatshrinkStreamClose(heatshrinkStream_t* hs)
+{
+    if (hs->hsd)
+    {
+        heatshrink_decoder_finish(hs->hsd);
+        if (hs->ownsDecoder)
+        {
+            heatshrink_decoder_free(hs->hsd);
+        }
+    }
+    if (hs->ownedSrc)
+    {
+        heap_caps_free(hs->ownedSrc);
+    }
+    memset(hs, 0, sizeof(heatshrinkStream_t));
 }
@@ -8,6 +8,40 @@
 #include "heatshrink_decoder.h"
 #include "heatshrink_encoder.h"
 
+// Compressed data starts with a four byte header. The first byte says how the data is stored, and the next three
+// bytes are the big-endian decompressed size. Any other format byte holds the window size as a power of two in the
+// high nibble and the lookahead size as a power of two in the low nibble. These must match the assets_preprocessor
+
+/// Header format byte for data compressed with the default window and lookahead
+#define HEATSHRINK_HEADER_DEFAULT 0x00
+/// Header format byte for data which is stored uncompressed
+#define HEATSHRINK_HEADER_STORED 0xFF
+
+/// The window size, as a power of two, of data with the ::HEATSHRINK_HEADER_DEFAULT header
+#define HEATSHRINK_DEFAULT_WINDOW_BITS 8
+/// The lookahead size, as a power of two, of data with the ::HEATSHRINK_HEADER_DEFAULT header
+#define HEATSHRINK_DEFAULT_LOOKAHEAD_BITS 4
+
+/**
+ * @brief State for decoding a heatshrink compressed file incrementally, straight into caller-owned buffers
+ */
+typedef struct
+{
+    const uint8_t* src;        ///< The compressed data, including the four byte size header
+    uint32_t srcSize;          ///< The size of the compressed data
+    uint32_t srcIdx;           ///< How much of the compressed data has been sunk into the decoder
+    uint32_t decompressedSize; ///< The total decompressed size, from the header
+    uint32_t outIdx;           ///< How many decompressed bytes have been read so far
+    heatshrink_decoder* hsd;   ///< The decoder, or NULL if the data is stored uncompressed
+    bool ownsDecoder;          ///< true if the decoder was allocated by the stream and must be freed
+    uint8_t* ownedSrc;         ///< The compressed data if it was allocated by the stream and must be freed, or NULL
+    bool finished;             ///< true if heatshrink_decoder_finish() has been called
+    bool stored;               ///< true if the data is stored uncompressed and is copied rather than decoded
+} heatshrinkStream_t;
+
+bool heatshrinkParseHeader(const uint8_t* src, uint32_t srcSize, uint32_t* decompressedSize, bool* stored,
+                           uint8_t* windowBits, uint8_t* lookaheadBits);
+
 uint8_t* readHeatshrinkFileInplace(cnfsFileIdx_t fIdx, uint32_t* outsize, uint8_t* decompressedBuf,
                                    heatshrink_decoder* hsd);
 uint8_t* readHeatshrinkFile(cnfsFileIdx_t fIdx, uint32_t* outsize, bool readToSpiRam);
@@ -16,4 +50,10 @@ uint32_t heatshrinkCompress(uint8_t* dest, const uint8_t* src, uint32_t size);
 bool writeHeatshrinkNvs(const char* namespace, const char* key, const uint8_t* data, uint32_t size);
 bool heatshrinkDecompress(uint8_t* dest, uint32_t* destSize, const uint8_t* source, uint32_t sourceSize);
 
+bool heatshrinkStreamOpen(heatshrinkStream_t* hs, const uint8_t* src, uint32_t srcSize, heatshrink_decoder* hsd);
+bool heatshrinkStreamOpenFile(heatshrinkStream_t* hs, cnfsFileIdx_t fIdx, heatshrink_decoder* hsd);
+bool heatshrinkStreamOpenNvs(heatshrinkStream_t* hs, const char* namespace, const char* key, bool spiRam);
+uint32_t heatshrinkStreamRead(heatshrinkStream_t* hs, uint8_t* dest, uint32_t len);
+void heatshrinkStreamClose(heatshrinkStream_t* hs);
+
 #endif
\ No newline at end of file
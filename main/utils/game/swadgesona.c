@@ -16,15 +16,18 @@
 
 // C
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
 
 // ESP
 #include <esp_log.h>
 #include <esp_random.h>
+#include <esp_heap_caps.h>
 
 // Swadge
 #include "fs_wsg.h"
 #include "hdw-nvs.h"
+#include "hashMap.h"
 #include "wsgCanvas.h"
 
 //==============================================================================
@@ -34,6 +37,9 @@
 #define SWSN_HEIGHT 64
 #define SWSN_WIDTH  64
 
+// The number of finished images to keep
+#define SWSN_IMAGE_CACHE_SIZE 16
+
 //==============================================================================
 // Consts
 //==============================================================================
@@ -226,6 +232,51 @@ typedef enum
     COLOR_GLASSES,
 } paletteSwap_t;
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// @brief Everything which affects a finished image. Only uint8_t so there is no padding to hash
+typedef struct
+{
+    uint8_t skin;
+    uint8_t hairColor;
+    uint8_t eyeColor;
+    uint8_t hatColor;
+    uint8_t clothes;
+    uint8_t glassesColor;
+    uint8_t bodyMarks;
+    uint8_t earShape;
+    uint8_t eyebrows;
+    uint8_t eyeShape;
+    uint8_t hairStyle;
+    uint8_t hat;
+    uint8_t mouthShape;
+    uint8_t glasses;
+    uint8_t drawBody;
+} sonaImageKey_t;
+
+/// @brief A finished image in the cache
+typedef struct
+{
+    sonaImageKey_t key; ///< What the image was generated from
+    uint32_t hash;      ///< The hash of the key
+    uint32_t lastUsed;  ///< When this image was last used, for finding the least recently used entry
+    wsgPalette_t pal;   ///< The palette left on the swadgesona after generating the image
+    paletteColor_t* px; ///< The pixels, or NULL if this entry is empty
+} sonaImageCacheEntry_t;
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// Layers as opaque spans, indexed by ::cnfsFileIdx_t, allocated the first time a layer is drawn
+static wsgSpans_t** sonaLayers = NULL;
+/// Recently generated images
+static sonaImageCacheEntry_t sonaImages[SWSN_IMAGE_CACHE_SIZE];
+/// Incremented each time the image cache is used
+static uint32_t sonaImageTick = 0;
+
 //==============================================================================
 // Function declarations
 //==============================================================================
@@ -247,6 +298,25 @@ static void _getPaletteFromIdx(wsgPalette_t* palette, paletteSwap_t ps, int idx)
  */
 static void _splatHat(swadgesona_t* sw, wsg_t* dest);
 
+/**
+ * @brief Draw a layer onto an image at 0, 0. The layer is loaded as opaque spans the first time it is drawn and kept
+ * until clearSwadgesonaCache(), so only opaque pixels are ever touched.
+ *
+ * @param dest The image to draw onto
+ * @param layer The layer to draw
+ * @param pal The palette to recolor the layer with, or NULL to draw it as is
+ */
+static void _drawLayer(wsg_t* dest, cnfsFileIdx_t layer, const wsgPalette_t* pal);
+
+/**
+ * @brief Build the image cache key for a swadgesona
+ *
+ * @param core The swadgesona's data
+ * @param drawBody Whether or not the image has the shirt/neck
+ * @param key The key to write
+ */
+static void _getImageKey(const swadgesonaCore_t* core, bool drawBody, sonaImageKey_t* key);
+
 //==============================================================================
 // Functions
 //==============================================================================
@@ -345,54 +415,78 @@ void generateSwadgesonaImage(swadgesona_t* sw, bool drawBody)
     // Make a new canvas
     canvasBlankInit(&sw->image, SWSN_WIDTH, SWSN_HEIGHT, cTransparent, true);
 
+    // Check if this image was generated recently
+    sonaImageKey_t key;
+    _getImageKey(&sw->core, drawBody, &key);
+    uint32_t hash = hashBytes((const uint8_t*)&key, sizeof(key));
+
+    sonaImageCacheEntry_t* oldest = &sonaImages[0];
+    for (int idx = 0; idx < SWSN_IMAGE_CACHE_SIZE; idx++)
+    {
+        sonaImageCacheEntry_t* entry = &sonaImages[idx];
+        if (NULL != entry->px && entry->hash == hash && 0 == memcmp(&entry->key, &key, sizeof(key)))
+        {
+            memcpy(sw->image.px, entry->px, SWSN_WIDTH * SWSN_HEIGHT * sizeof(paletteColor_t));
+            sw->pal         = entry->pal;
+            entry->lastUsed = ++sonaImageTick;
+            return;
+        }
+
+        // Track the entry to replace, empty or least recently used
+        if (NULL != oldest->px && (NULL == entry->px || entry->lastUsed < oldest->lastUsed))
+        {
+            oldest = entry;
+        }
+    }
+
     // Body
     wsgPaletteReset(&sw->pal);
     _getPaletteFromIdx(&sw->pal, COLOR_SKIN, sw->core.skin);
-    canvasDrawSimplePal(&sw->image, SWSN_HEAD_WSG, 0, 0, &sw->pal);
+    _drawLayer(&sw->image, SWSN_HEAD_WSG, &sw->pal);
 
     if (sw->core.bodyMarks == BME_VITILIGO)
     {
-        canvasDrawSimple(&sw->image, BM_VITILIGO_WSG, 0, 0);
+        _drawLayer(&sw->image, BM_VITILIGO_WSG, NULL);
     }
 
     // Ears
     // Human ears require no extra draw calls.
     if (sw->core.earShape != EAE_HUMAN)
     {
-        canvasDrawSimplePal(&sw->image, earWsgs[sw->core.earShape - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, earWsgs[sw->core.earShape - 1], &sw->pal);
     }
 
     // Mouth
-    canvasDrawSimple(&sw->image, mouthWsgs[sw->core.mouthShape], 0, 0);
+    _drawLayer(&sw->image, mouthWsgs[sw->core.mouthShape], NULL);
 
     // Eyes
     wsgPaletteReset(&sw->pal);
     _getPaletteFromIdx(&sw->pal, COLOR_EYES, sw->core.eyeColor);
-    canvasDrawSimplePal(&sw->image, eyeWsgs[sw->core.eyeShape], 0, 0, &sw->pal);
+    _drawLayer(&sw->image, eyeWsgs[sw->core.eyeShape], &sw->pal);
 
     // Eyebrows
     wsgPaletteReset(&sw->pal);
     _getPaletteFromIdx(&sw->pal, COLOR_HAIR, sw->core.hairColor);
-    canvasDrawSimplePal(&sw->image, eyebrowsWsgs[sw->core.eyebrows], 0, 0, &sw->pal);
+    _drawLayer(&sw->image, eyebrowsWsgs[sw->core.eyebrows], &sw->pal);
 
     // Body marks
     if (sw->core.bodyMarks != BME_NONE && sw->core.bodyMarks != BME_VITILIGO)
     {
-        canvasDrawSimplePal(&sw->image, bodymarksWsgs[sw->core.bodyMarks - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, bodymarksWsgs[sw->core.bodyMarks - 1], &sw->pal);
     }
 
     // Hair
     // Use the same palette as the eyebrows
     if (sw->core.hairStyle != HE_NONE)
     {
-        canvasDrawSimplePal(&sw->image, hairWsgs[sw->core.hairStyle - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, hairWsgs[sw->core.hairStyle - 1], &sw->pal);
     }
 
     // Bunny, Cat, and Dog ears go over the hair
     if (sw->core.earShape == EAE_BUNNY || sw->core.earShape == EAE_DOG || sw->core.earShape == EAE_CAT
         || sw->core.earShape == EAE_DOWN_COW || sw->core.earShape == EAE_OPEN_COW)
     {
-        canvasDrawSimplePal(&sw->image, earWsgs[sw->core.earShape - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, earWsgs[sw->core.earShape - 1], &sw->pal);
     }
 
     // Draw shirt if required
@@ -401,12 +495,12 @@ void generateSwadgesonaImage(swadgesona_t* sw, bool drawBody)
         wsgPaletteReset(&sw->pal);
         _getPaletteFromIdx(&sw->pal, COLOR_SKIN, sw->core.skin);
         _getPaletteFromIdx(&sw->pal, COLOR_CLOTHES, sw->core.clothes);
-        canvasDrawSimplePal(&sw->image, SWSN_BODY_WSG, 0, 0, &sw->pal);
+        _drawLayer(&sw->image, SWSN_BODY_WSG, &sw->pal);
         if (sw->core.bodyMarks == BME_CHOKER || sw->core.bodyMarks == BME_SPIKED_NECKLACE
             || sw->core.bodyMarks == BME_NECK_BLOOD)
         {
             wsgPaletteReset(&sw->pal);
-            canvasDrawSimple(&sw->image, bodymarksWsgs[sw->core.bodyMarks - 1], 0, 0);
+            _drawLayer(&sw->image, bodymarksWsgs[sw->core.bodyMarks - 1], NULL);
         }
     }
 
@@ -415,24 +509,38 @@ void generateSwadgesonaImage(swadgesona_t* sw, bool drawBody)
     {
         wsgPaletteReset(&sw->pal);
         _getPaletteFromIdx(&sw->pal, COLOR_HAIR, sw->core.hairColor);
-        canvasDrawSimplePal(&sw->image, hairWsgs[sw->core.hairStyle - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, hairWsgs[sw->core.hairStyle - 1], &sw->pal);
     }
     else if (sw->core.hairStyle == HE_JINX)
     {
         wsgPaletteReset(&sw->pal);
         _getPaletteFromIdx(&sw->pal, COLOR_HAIR, sw->core.hairColor);
-        canvasDrawSimplePal(&sw->image, H_JINX_HALF_WSG, 0, 0, &sw->pal);
+        _drawLayer(&sw->image, H_JINX_HALF_WSG, &sw->pal);
     }
 
     // Glasses
     if (sw->core.glasses != G_NONE)
     {
         _getPaletteFromIdx(&sw->pal, COLOR_GLASSES, sw->core.glassesColor);
-        canvasDrawSimplePal(&sw->image, glassesWsgs[sw->core.glasses - 1], 0, 0, &sw->pal);
+        _drawLayer(&sw->image, glassesWsgs[sw->core.glasses - 1], &sw->pal);
     }
 
     // Hats
     _splatHat(sw, &sw->image);
+
+    // Save a copy of the finished image, reusing the least recently used entry's pixels
+    if (NULL == oldest->px)
+    {
+        oldest->px = heap_caps_malloc(SWSN_WIDTH * SWSN_HEIGHT * sizeof(paletteColor_t), MALLOC_CAP_SPIRAM);
+    }
+    if (NULL != oldest->px)
+    {
+        memcpy(oldest->px, sw->image.px, SWSN_WIDTH * SWSN_HEIGHT * sizeof(paletteColor_t));
+        oldest->key      = key;
+        oldest->hash     = hash;
+        oldest->pal      = sw->pal;
+        oldest->lastUsed = ++sonaImageTick;
+    }
 }
 
 void loadSPSona(swadgesonaCore_t* sw)
@@ -459,7 +567,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
         {
             wsgPaletteReset(&sw->pal);
             _getPaletteFromIdx(&sw->pal, COLOR_SKIN, sw->core.skin);
-            canvasDrawSimplePal(dest, SWSN_HEAD_WSG, 0, 0, &sw->pal);
+            _drawLayer(dest, SWSN_HEAD_WSG, &sw->pal);
             found = true;
             break;
         }
@@ -467,7 +575,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
         {
             if (sw->core.bodyMarks != BME_NONE)
             {
-                canvasDrawSimplePal(dest, bodymarksWsgs[sw->core.bodyMarks - 1], 0, 0, &sw->pal);
+                _drawLayer(dest, bodymarksWsgs[sw->core.bodyMarks - 1], &sw->pal);
                 found = true;
             }
             break;
@@ -478,7 +586,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
             {
                 wsgPaletteReset(&sw->pal);
                 _getPaletteFromIdx(&sw->pal, COLOR_SKIN, sw->core.skin);
-                canvasDrawSimplePal(dest, earWsgs[sw->core.earShape - 1], 0, 0, &sw->pal);
+                _drawLayer(dest, earWsgs[sw->core.earShape - 1], &sw->pal);
                 found = true;
             }
             break;
@@ -487,7 +595,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
         {
             wsgPaletteReset(&sw->pal);
             _getPaletteFromIdx(&sw->pal, COLOR_EYES, sw->core.eyeColor);
-            canvasDrawSimplePal(dest, eyeWsgs[sw->core.eyeShape], 0, 0, &sw->pal);
+            _drawLayer(dest, eyeWsgs[sw->core.eyeShape], &sw->pal);
             found = true;
             break;
         }
@@ -495,7 +603,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
         {
             wsgPaletteReset(&sw->pal);
             _getPaletteFromIdx(&sw->pal, COLOR_HAIR, sw->core.hairColor);
-            canvasDrawSimplePal(dest, eyebrowsWsgs[sw->core.eyebrows], 0, 0, &sw->pal);
+            _drawLayer(dest, eyebrowsWsgs[sw->core.eyebrows], &sw->pal);
             found = true;
             break;
         }
@@ -505,7 +613,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
             {
                 wsgPaletteReset(&sw->pal);
                 _getPaletteFromIdx(&sw->pal, COLOR_HAIR, sw->core.hairColor);
-                canvasDrawSimplePal(dest, hairWsgs[sw->core.hairStyle - 1], 0, 0, &sw->pal);
+                _drawLayer(dest, hairWsgs[sw->core.hairStyle - 1], &sw->pal);
                 found = true;
             }
             break;
@@ -521,7 +629,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
         }
         case SWSN_MOUTH:
         {
-            canvasDrawSimple(dest, mouthWsgs[sw->core.mouthShape], 0, 0);
+            _drawLayer(dest, mouthWsgs[sw->core.mouthShape], NULL);
             found = true;
             break;
         }
@@ -531,7 +639,7 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
             {
                 wsgPaletteReset(&sw->pal);
                 _getPaletteFromIdx(&sw->pal, COLOR_GLASSES, sw->core.glassesColor);
-                canvasDrawSimplePal(dest, glassesWsgs[sw->core.glasses - 1], 0, 0, &sw->pal);
+                _drawLayer(dest, glassesWsgs[sw->core.glasses - 1], &sw->pal);
                 found = true;
             }
             break;
@@ -544,6 +652,29 @@ bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest)
     return found;
 }
 
+void clearSwadgesonaCache(void)
+{
+    if (NULL != sonaLayers)
+    {
+        for (int idx = 0; idx < CNFS_NUM_FILES; idx++)
+        {
+            if (NULL != sonaLayers[idx])
+            {
+                freeWsgSpans(sonaLayers[idx]);
+                heap_caps_free(sonaLayers[idx]);
+            }
+        }
+        heap_caps_free(sonaLayers);
+        sonaLayers = NULL;
+    }
+
+    for (int idx = 0; idx < SWSN_IMAGE_CACHE_SIZE; idx++)
+    {
+        heap_caps_free(sonaImages[idx].px);
+    }
+    memset(sonaImages, 0, sizeof(sonaImages));
+}
+
 //==============================================================================
 // Static Functions
 //==============================================================================
@@ -1187,6 +1318,98 @@ static void _splatHat(swadgesona_t* sw, wsg_t* dest)
             _getPaletteFromIdx(&sw->pal, COLOR_HAT, sw->core.hatColor);
         }
         // Draw hat
-        canvasDrawSimplePal(dest, hatWsgs[sw->core.hat - 1], 0, 0, &sw->pal);
+        _drawLayer(dest, hatWsgs[sw->core.hat - 1], &sw->pal);
     }
-}
\ No newline at end of file
+}
+
+static void _drawLayer(wsg_t* dest, cnfsFileIdx_t layer, const wsgPalette_t* pal)
+{
+    if (NULL == sonaLayers)
+    {
+        sonaLayers = heap_caps_calloc(CNFS_NUM_FILES, sizeof(wsgSpans_t*), MALLOC_CAP_SPIRAM);
+        if (NULL == sonaLayers)
+        {
+            return;
+        }
+    }
+
+    // Load the layer the first time it's drawn
+    wsgSpans_t* spr = sonaLayers[layer];
+    if (NULL == spr)
+    {
+        spr = heap_caps_calloc(1, sizeof(wsgSpans_t), MALLOC_CAP_SPIRAM);
+        if (NULL == spr)
+        {
+            return;
+        }
+        if (!loadWsgSpans(layer, spr, true))
+        {
+            heap_caps_free(spr);
+            return;
+        }
+        sonaLayers[layer] = spr;
+    }
+
+    int32_t h = (spr->h < dest->h) ? spr->h : dest->h;
+    for (int32_t y = 0; y < h; y++)
+    {
+        const uint8_t* row = &spr->spans[spr->rowOffsets[y]];
+        uint16_t numRuns   = (row[0] << 8) | row[1];
+        row += 2;
+
+        paletteColor_t* out = &dest->px[y * dest->w];
+        while (numRuns--)
+        {
+            int32_t x                = (row[0] << 8) | row[1];
+            int32_t len              = (row[2] << 8) | row[3];
+            const paletteColor_t* in = (const paletteColor_t*)&row[4];
+            row                      = &row[4 + len];
+
+            // Runs are sorted left to right, so nothing after this one fits
+            if (x >= dest->w)
+            {
+                break;
+            }
+            if (x + len > dest->w)
+            {
+                len = dest->w - x;
+            }
+
+            if (NULL == pal)
+            {
+                memcpy(&out[x], in, len * sizeof(paletteColor_t));
+            }
+            else
+            {
+                // The palette may recolor pixels to transparent, which must not be drawn
+                for (int32_t i = 0; i < len; i++)
+                {
+                    paletteColor_t col = pal->newColors[in[i]];
+                    if (cTransparent != col)
+                    {
+                        out[x + i] = col;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void _getImageKey(const swadgesonaCore_t* core, bool drawBody, sonaImageKey_t* key)
+{
+    key->skin         = core->skin;
+    key->hairColor    = core->hairColor;
+    key->eyeColor     = core->eyeColor;
+    key->hatColor     = core->hatColor;
+    key->clothes      = core->clothes;
+    key->glassesColor = core->glassesColor;
+    key->bodyMarks    = core->bodyMarks;
+    key->earShape     = core->earShape;
+    key->eyebrows     = core->eyebrows;
+    key->eyeShape     = core->eyeShape;
+    key->hairStyle    = core->hairStyle;
+    key->hat          = core->hat;
+    key->mouthShape   = core->mouthShape;
+    key->glasses      = core->glasses;
+    key->drawBody     = drawBody;
+}
@@ -34,6 +34,11 @@
  * random swadgesona can easily be generated to avoid always seeing the default when loading one up before data is
  * initialized.
  *
+ * Each layer is decoded once, as opaque spans, the first time it is drawn. Finished images are also cached, keyed by
+ * everything that affects how they look, so generating the same sona again is just a copy. This makes screens full of
+ * SwadgePass sonas load quickly. The caches are freed with clearSwadgesonaCache(), which the system calls after each
+ * mode exits.
+ *
  * \code {.c}
 // Data
 swadgesona_t sw; // The swadgesona object
@@ -629,4 +634,10 @@ void loadSPSona(swadgesonaCore_t* sw);
  * @param dest The place to save the file into
  * @return bool True if it found a sprite, false otherwise
  */
-bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest);
\ No newline at end of file
+bool getFeatureWSG(swadgesona_t* sw, features_t feature, wsg_t* dest);
+
+/**
+ * @brief Free the decoded layers and finished images cached by generateSwadgesonaImage() and getFeatureWSG(). The
+ * system calls this after each mode exits.
+ */
+void clearSwadgesonaCache(void);
\ No newline at end of file
@@ -26,6 +26,7 @@
 // Drawing
 #include "fs_font.h"
 #include "fs_wsg.h"
+#include "fs_cache.h"
 #include "fill.h"
 #include "shapes.h"
 
@@ -63,7 +64,7 @@ typedef struct
 {
     trophyData_t trophyData; ///< Individual trophy data
     int32_t currentVal;      ///< Saved value of the trophy
-    wsg_t image;             ///< Where the image is loaded
+    wsg_t* image;            ///< Shared image from the asset cache, NULL if none
     bool active;             ///< If this slot is loaded and ready to animate
 } trophyDataWrapper_t;
 
@@ -72,7 +73,7 @@ typedef struct
 {
     int* heights;                 ///< Total height of the stack
     int platHeight;               ///< Height of ther plat frame
-    wsg_t* images;                ///< Array of images to display
+    wsg_t** images;               ///< Array of shared images to display, NULL if none
     trophyListDisplayMode_t mode; ///< Current display mode
 
     // Colors
@@ -90,7 +91,7 @@ typedef struct
     // Platinum
     trophyData_t plat; ///< Platinum trophy data
     int32_t platVal;   ///< Value of the platinum trophy
-    wsg_t platImg;     ///< Platinum's image
+    wsg_t* platImg;    ///< Platinum's shared image, loaded while the list is displayed
 
     // Drawing
     bool active;                ///< If the mode should be drawing a banner
@@ -248,12 +249,12 @@ static int _getListItemHeight(const trophyData_t* t, font_t* fnt);
 static void _drawTrophyListItem(const trophyData_t* t, int yOffset, int height, font_t* fnt, wsg_t* image);
 
 /**
- * @brief Loads the default image to the wsg_t slot provided based on difficulty
+ * @brief Gets a shared handle to the default image based on difficulty
  *
  * @param td Difficulty to get trophy for
- * @param image Place to store image
+ * @return The shared image, or NULL if it couldn't be loaded
  */
-static void _loadDefaultTrophyImage(trophyDifficulty_t td, wsg_t* image);
+static wsg_t* _loadDefaultTrophyImage(trophyDifficulty_t td);
 
 // Points
 
@@ -342,7 +343,7 @@ void trophySystemInit(const trophyDataList_t* data, const char* modeName)
     trophyDataWrapper_t* toFree;
     while ((toFree = pop(&trophySystem.trophyQueue)))
     {
-        freeWsg(&toFree->image);
+        releaseWsgCached(toFree->image);
         heap_caps_free(toFree);
     }
 }
@@ -429,12 +430,12 @@ bool trophyUpdate(const trophyData_t* t, int newVal, bool drawUpdate)
             if (tw->trophyData.image == NO_IMAGE_SET)
             {
                 // Use default image
-                _loadDefaultTrophyImage(tw->trophyData.difficulty, &tw->image);
+                tw->image = _loadDefaultTrophyImage(tw->trophyData.difficulty);
             }
             else
             {
                 // Use dev defined image
-                loadWsg(tw->trophyData.image, &tw->image, true);
+                tw->image = loadWsgCached(tw->trophyData.image);
             }
         }
 
@@ -455,7 +456,7 @@ bool trophyUpdate(const trophyData_t* t, int newVal, bool drawUpdate)
             twf->currentVal = trophySystem.platVal;
             _setPoints(_genPoints(twf->trophyData.difficulty));
             _saveLatestWin(twf);
-            loadWsg(twf->trophyData.image, &twf->image, true);
+            twf->image = loadWsgCached(twf->trophyData.image);
         }
         // drawing an update
         return true;
@@ -620,7 +621,7 @@ void trophyDraw(font_t* fnt, int64_t elapsedUs)
 
         // Remove the trophy wrapper from the queue and free memory
         trophyDataWrapper_t* tw = shift(&trophySystem.trophyQueue);
-        freeWsg(&tw->image);
+        releaseWsgCached(tw->image);
         heap_caps_free(tw);
 
         // Reset animation
@@ -671,22 +672,23 @@ void trophyDrawListInit(trophyListDisplayMode_t mode)
     // Colors
     trophyDrawListColors(c000, c012, c023, c045, c054, c050);
 
-    // Load all the WSGs
-    trophySystem.tdl.images = heap_caps_calloc(trophySystem.data->length, sizeof(wsg_t), MALLOC_CAP_8BIT);
+    // Load all the WSGs. Trophies with the same image share it
+    trophySystem.tdl.images = heap_caps_calloc(trophySystem.data->length, sizeof(wsg_t*), MALLOC_CAP_8BIT);
     for (int idx = 0; idx < trophySystem.data->length; idx++)
     {
         if (trophySystem.data->list[idx].image == NO_IMAGE_SET)
         {
             if (!trophySystem.data->list[idx].noImage)
             {
-                _loadDefaultTrophyImage(trophySystem.data->list[idx].difficulty, &trophySystem.tdl.images[idx]);
+                trophySystem.tdl.images[idx] = _loadDefaultTrophyImage(trophySystem.data->list[idx].difficulty);
             }
         }
         else
         {
-            loadWsg(trophySystem.data->list[idx].image, &trophySystem.tdl.images[idx], true);
+            trophySystem.tdl.images[idx] = loadWsgCached(trophySystem.data->list[idx].image);
         }
     }
+    trophySystem.platImg = loadWsgCached(trophySystem.plat.image);
 }
 
 void trophyDrawListColors(paletteColor_t background, paletteColor_t panel, paletteColor_t shadowBoxes,
@@ -704,9 +706,11 @@ void trophyDrawListDeinit()
 {
     for (int idx = 0; idx < trophySystem.data->length; idx++)
     {
-        freeWsg(&trophySystem.tdl.images[idx]);
+        releaseWsgCached(trophySystem.tdl.images[idx]);
     }
     heap_caps_free(trophySystem.tdl.images);
+    releaseWsgCached(trophySystem.platImg);
+    trophySystem.platImg = NULL;
     heap_caps_free(trophySystem.tdl.heights);
 
     trophySystem.tdl.heights = NULL;
@@ -737,10 +741,8 @@ void trophyDrawList(font_t* fnt, int yOffset)
         {
             if (trophySystem.platVal == 0)
             {
-                loadWsg(trophySystem.plat.image, &trophySystem.platImg, true);
-                _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, &trophySystem.platImg);
+                _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, trophySystem.platImg);
                 cumulativeHeight += tdl->platHeight;
-                freeWsg(&trophySystem.platImg);
             }
             break;
         }
@@ -748,19 +750,15 @@ void trophyDrawList(font_t* fnt, int yOffset)
         {
             if (trophySystem.platVal == 1)
             {
-                loadWsg(trophySystem.plat.image, &trophySystem.platImg, true);
-                _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, &trophySystem.platImg);
+                _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, trophySystem.platImg);
                 cumulativeHeight += tdl->platHeight;
-                freeWsg(&trophySystem.platImg);
             }
             break;
         }
         default:
         {
-            loadWsg(trophySystem.plat.image, &trophySystem.platImg, true);
-            _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, &trophySystem.platImg);
+            _drawTrophyListItem(&trophySystem.plat, -yOffset, tdl->platHeight, fnt, trophySystem.platImg);
             cumulativeHeight += tdl->platHeight;
-            freeWsg(&trophySystem.platImg);
             break;
         }
     }
@@ -778,7 +776,7 @@ void trophyDrawList(font_t* fnt, int yOffset)
                 if (!trophySystem.data->list[idx].hidden || (trophySystem.data->list[idx].maxVal <= tw.currentVal))
                 {
                     _drawTrophyListItem(&trophySystem.data->list[idx], -yOffset + cumulativeHeight, tdl->heights[idx],
-                                        fnt, &tdl->images[idx]);
+                                        fnt, tdl->images[idx]);
                     cumulativeHeight += tdl->heights[idx];
                 }
                 break;
@@ -791,7 +789,7 @@ void trophyDrawList(font_t* fnt, int yOffset)
                 if (trophySystem.data->list[idx].maxVal <= tw.currentVal)
                 {
                     _drawTrophyListItem(&trophySystem.data->list[idx], -yOffset + cumulativeHeight, tdl->heights[idx],
-                                        fnt, &tdl->images[idx]);
+                                        fnt, tdl->images[idx]);
                     cumulativeHeight += tdl->heights[idx];
                 }
                 break;
@@ -804,7 +802,7 @@ void trophyDrawList(font_t* fnt, int yOffset)
                 if (!trophySystem.data->list[idx].hidden && trophySystem.data->list[idx].maxVal > tw.currentVal)
                 {
                     _drawTrophyListItem(&trophySystem.data->list[idx], -yOffset + cumulativeHeight, tdl->heights[idx],
-                                        fnt, &tdl->images[idx]);
+                                        fnt, tdl->images[idx]);
                     cumulativeHeight += tdl->heights[idx];
                 }
                 break;
@@ -812,7 +810,7 @@ void trophyDrawList(font_t* fnt, int yOffset)
             default:
             {
                 _drawTrophyListItem(&trophySystem.data->list[idx], -yOffset + cumulativeHeight, tdl->heights[idx], fnt,
-                                    &tdl->images[idx]);
+                                    tdl->images[idx]);
                 cumulativeHeight += tdl->heights[idx];
             }
             break;
@@ -1067,8 +1065,11 @@ static void _drawAtYCoord(trophyDataWrapper_t* t, int yOffset, font_t* fnt)
         {
             wp = &trophySystem.normalPalette;
         }
-        drawWsgPaletteSimple(&t->image, startX + ((BANNER_MAX_ICON_DIM - t->image.w) >> 1),
-                             startY + ((BANNER_MAX_ICON_DIM - t->image.h) >> 1), wp);
+        if (NULL != t->image)
+        {
+            drawWsgPaletteSimple(t->image, startX + ((BANNER_MAX_ICON_DIM - t->image->w) >> 1),
+                                 startY + ((BANNER_MAX_ICON_DIM - t->image->h) >> 1), wp);
+        }
     }
 
     // Draw text, starting after image if present
@@ -1294,8 +1295,11 @@ static void _drawTrophyListItem(const trophyData_t* t, int yOffset, int height,
         {
             wp = &trophySystem.normalPalette;
         }
-        drawWsgPaletteSimple(image, startX + ((BANNER_MAX_ICON_DIM - image->w) >> 1),
-                             startY + ((BANNER_MAX_ICON_DIM - image->h) >> 1), wp);
+        if (NULL != image)
+        {
+            drawWsgPaletteSimple(image, startX + ((BANNER_MAX_ICON_DIM - image->w) >> 1),
+                                 startY + ((BANNER_MAX_ICON_DIM - image->h) >> 1), wp);
+        }
     }
 
     // Draw text, starting after image if present
@@ -1322,30 +1326,26 @@ static void _drawTrophyListItem(const trophyData_t* t, int yOffset, int height,
     }
 }
 
-static void _loadDefaultTrophyImage(trophyDifficulty_t td, wsg_t* image)
+static wsg_t* _loadDefaultTrophyImage(trophyDifficulty_t td)
 {
     switch (td)
     {
         case TROPHY_DIFF_EXTREME:
         {
-            loadWsg(WINGED_TROPHY_WSG, image, true);
-            break;
+            return loadWsgCached(WINGED_TROPHY_WSG);
         }
         case TROPHY_DIFF_HARD:
         {
-            loadWsg(GOLD_TROPHY_WSG, image, true);
-            break;
+            return loadWsgCached(GOLD_TROPHY_WSG);
         }
         case TROPHY_DIFF_MEDIUM:
         {
-            loadWsg(SILVER_TROPHY_WSG, image, true);
-            break;
+            return loadWsgCached(SILVER_TROPHY_WSG);
         }
         case TROPHY_DIFF_EASY:
         default:
         {
-            loadWsg(BRONZE_TROPHY_WSG, image, true);
-            break;
+            return loadWsgCached(BRONZE_TROPHY_WSG);
         }
     }
 }
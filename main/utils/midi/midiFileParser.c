@@ -54,6 +54,94 @@ typedef struct
     midiTrackState_t* trackStates;
 } midiSaveState_t;
 
+/// @brief A single compactly encoded event in a MIDI event index
+typedef struct
+{
+    /// @brief The absolute timestamp of this event in ticks
+    uint32_t absTime;
+
+    /// @brief The MIDI status byte, or 0 for a meta or SysEx event stored in ::midiEventIndex::extEvents
+    uint8_t status;
+
+    /// @brief The index of the track which contains this event
+    uint8_t track;
+
+    /// @brief The MIDI data bytes, or the little-endian index into ::midiEventIndex::extEvents
+    uint8_t data[2];
+} midiIndexEvent_t;
+
+/// @brief A point in a MIDI event index where playback state can be restored without reading earlier events
+typedef struct
+{
+    /// @brief The index of the first event after this checkpoint
+    uint32_t eventIdx;
+
+    /// @brief The offset of this checkpoint's state events in ::midiEventIndex::stateEvents
+    uint32_t stateStart;
+
+    /// @brief The number of state events for this checkpoint
+    uint32_t stateCount;
+} midiCheckpoint_t;
+
+/// @brief A time-sorted index of every event in a MIDI file
+struct midiEventIndex
+{
+    /// @brief The number of events in the file
+    uint32_t eventCount;
+
+    /// @brief Every event in the file, in playback order
+    midiIndexEvent_t* events;
+
+    /// @brief The number of meta and SysEx events
+    uint32_t extCount;
+
+    /// @brief Fully parsed meta and SysEx events, whose data points into the file
+    midiEvent_t* extEvents;
+
+    /// @brief The number of checkpoints
+    uint32_t checkpointCount;
+
+    /// @brief Checkpoints every ::MIDI_INDEX_CHECKPOINT_INTERVAL events
+    midiCheckpoint_t* checkpoints;
+
+    /// @brief The indices of the events which restore state at each checkpoint, in file order
+    uint32_t* stateEvents;
+};
+
+/// @brief The events which affect playback state, tracked while building an index. Unused slots are UINT32_MAX
+typedef struct
+{
+    /// @brief The latest tempo event
+    uint32_t tempo;
+
+    /// @brief The latest program change on each channel
+    uint32_t program[16];
+
+    /// @brief The bank select MSB and LSB which were in effect at each channel's latest program change
+    uint32_t programBank[16][2];
+
+    /// @brief The latest value of each controller on each channel
+    uint32_t controller[16][128];
+
+    /// @brief The latest pitch bend on each channel
+    uint32_t pitchBend[16];
+
+    /// @brief The note on event for each note which is still sounding
+    uint32_t note[16][128];
+
+    /// @brief Notes which were released while the hold pedal was down
+    bool noteHeld[16][128];
+
+    /// @brief Whether the hold pedal is down on each channel
+    bool hold[16];
+
+    /// @brief Events which must all be replayed in order, like parameter data entry and SysEx
+    uint32_t* sequence;
+
+    /// @brief The number of events in sequence
+    uint32_t sequenceCount;
+} midiIndexState_t;
+
 //==============================================================================
 // Static Function Declarations
 //==============================================================================
@@ -63,6 +151,15 @@ static int writeVariableLength(uint8_t* out, int max, uint32_t length);
 static bool trackParseNext(midiFileReader_t* reader, midiTrackState_t* track);
 static bool parseMidiHeader(midiFile_t* file);
 static void readFirstEvents(midiFileReader_t* reader);
+static void decodeIndexEvent(const midiEventIndex_t* index, uint32_t idx, midiEvent_t* event);
+static void releaseIndexNote(midiIndexState_t* state, uint8_t channel, uint8_t note);
+static void releaseHeldIndexNotes(midiIndexState_t* state, uint8_t channel);
+static bool trackIndexState(midiIndexState_t* state, const midiEvent_t* event, uint32_t idx);
+static uint32_t gatherIndexSlots(uint32_t* out, const uint32_t* slots, uint32_t numSlots);
+static uint32_t* writeCheckpoint(midiIndexState_t* state, uint32_t* stateEvents, uint32_t* stateEventCount,
+                                 midiCheckpoint_t* checkpoint, bool spiRam);
+static int cmpEventIdx(const void* a, const void* b);
+static const midiCheckpoint_t* findCheckpoint(const midiEventIndex_t* index, uint32_t tick);
 
 //==============================================================================
 // Variables
@@ -801,6 +898,7 @@ bool loadMidiData(uint8_t* data, size_t size, midiFile_t* file)
     {
         file->data   = data;
         file->length = (uint32_t)size;
+        file->index  = NULL;
         if (parseMidiHeader(file))
         {
             return true;
@@ -825,30 +923,24 @@ bool loadMidiFile(cnfsFileIdx_t fIdx, midiFile_t* file, bool spiRam)
 {
     uint32_t size;
     size_t raw_size;
-    uint8_t* data = cnfsReadFile(fIdx, &raw_size, spiRam);
+    uint8_t* data      = NULL;
+    const uint8_t* raw = cnfsGetFile(fIdx, &raw_size);
 
-    if (NULL != data)
+    if (NULL != raw)
     {
-        if (raw_size < sizeof(midiHeader) || memcmp(data, midiHeader, sizeof(midiHeader)))
+        if (raw_size < sizeof(midiHeader) || memcmp(raw, midiHeader, sizeof(midiHeader)))
         {
-            // This is not a MIDI file! Try to decompress
-            if (heatshrinkDecompress(NULL, &size, data, (uint32_t)raw_size))
+            // This is not a MIDI file! Try to decompress it straight from the filesystem image
+            if (heatshrinkDecompress(NULL, &size, raw, (uint32_t)raw_size))
             {
                 // Size was read successfully, allocate the non-compressed buffer
 #ifndef __XTENSA__
                 char tag[32];
                 sprintf(tag, "cnfsIdx %d", fIdx);
 #endif
-                uint8_t* decompressed = heap_caps_malloc_tag(size, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
-                if (decompressed && heatshrinkDecompress(decompressed, &size, data, (uint32_t)raw_size))
+                data = heap_caps_malloc_tag(size, spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT, tag);
+                if (!data || !heatshrinkDecompress(data, &size, raw, (uint32_t)raw_size))
                 {
-                    // Success, free the raw data
-                    heap_caps_free(data);
-                    data = decompressed;
-                }
-                else
-                {
-                    heap_caps_free(decompressed);
                     heap_caps_free(data);
                     return false;
                 }
@@ -856,13 +948,13 @@ bool loadMidiFile(cnfsFileIdx_t fIdx, midiFile_t* file, bool spiRam)
             else
             {
                 ESP_LOGE("MIDIFileParser", "Song %d could not be decompressed!", fIdx);
-                heap_caps_free(data);
                 return false;
             }
         }
         else
         {
             ESP_LOGI("MIDIFileParser", "Song %d is loaded uncompressed", fIdx);
+            data = cnfsReadFile(fIdx, &raw_size, spiRam);
             size = (uint32_t)raw_size;
         }
     }
@@ -888,6 +980,7 @@ bool loadMidiFile(cnfsFileIdx_t fIdx, midiFile_t* file, bool spiRam)
 
 void unloadMidiFile(midiFile_t* file)
 {
+    freeMidiIndex(file);
     if (file->tracks)
     {
         heap_caps_free(file->tracks);
@@ -935,6 +1028,7 @@ void midiParserSetFile(midiFileReader_t* reader, const midiFile_t* file)
 
     reader->file     = file;
     reader->division = file->timeDivision;
+    reader->indexPos = 0;
 
     readFirstEvents(reader);
 }
@@ -959,6 +1053,7 @@ void resetMidiParser(midiFileReader_t* reader)
         reader->states[i].time = 0;
     }
 
+    reader->indexPos = 0;
     if (reader->file != NULL)
     {
         reader->division = reader->file->timeDivision;
@@ -991,6 +1086,18 @@ bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event)
         return false;
     }
 
+    // Indexed files are already merged into a single sorted list
+    const midiEventIndex_t* index = reader->file->index;
+    if (NULL != index)
+    {
+        if (reader->indexPos >= index->eventCount)
+        {
+            return false;
+        }
+        decodeIndexEvent(index, reader->indexPos++, event);
+        return true;
+    }
+
     // TODO: This treats all formats like a format 1 (simultaneous)
     for (int i = 0; i < reader->stateCount; i++)
     {
@@ -1046,6 +1153,535 @@ bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event)
     return true;
 }
 
+/**
+ * @brief Decode an event from a MIDI event index
+ *
+ * @param index The index to read from
+ * @param idx The position of the event in the index
+ * @param event The event to write to
+ */
+static void decodeIndexEvent(const midiEventIndex_t* index, uint32_t idx, midiEvent_t* event)
+{
+    const midiIndexEvent_t* indexed = &index->events[idx];
+    if (0 == indexed->status)
+    {
+        *event = index->extEvents[indexed->data[0] | (indexed->data[1] << 8)];
+    }
+    else
+    {
+        event->type         = MIDI_EVENT;
+        event->track        = indexed->track;
+        event->midi.status  = indexed->status;
+        event->midi.data[0] = indexed->data[0];
+        event->midi.data[1] = indexed->data[1];
+    }
+    event->absTime   = indexed->absTime;
+    event->deltaTime = indexed->absTime - ((idx > 0) ? index->events[idx - 1].absTime : 0);
+}
+
+/**
+ * @brief Stop tracking a note, unless the hold pedal is keeping it on
+ *
+ * @param state The state being tracked
+ * @param channel The channel of the note
+ * @param note The note which was released
+ */
+static void releaseIndexNote(midiIndexState_t* state, uint8_t channel, uint8_t note)
+{
+    if (state->hold[channel])
+    {
+        state->noteHeld[channel][note] = (UINT32_MAX != state->note[channel][note]);
+    }
+    else
+    {
+        state->note[channel][note] = UINT32_MAX;
+    }
+}
+
+/**
+ * @brief Stop tracking all the notes which were only kept on by the hold pedal
+ *
+ * @param state The state being tracked
+ * @param channel The channel whose pedal was released
+ */
+static void releaseHeldIndexNotes(midiIndexState_t* state, uint8_t channel)
+{
+    for (int note = 0; note < 128; note++)
+    {
+        if (state->noteHeld[channel][note])
+        {
+            state->noteHeld[channel][note] = false;
+            state->note[channel][note]     = UINT32_MAX;
+        }
+    }
+}
+
+/**
+ * @brief Update the tracked playback state with an event
+ *
+ * @param state The state being tracked
+ * @param event The event to track
+ * @param idx The position of the event in the index
+ * @return true if the event was tracked
+ * @return false if memory could not be allocated
+ */
+static bool trackIndexState(midiIndexState_t* state, const midiEvent_t* event, uint32_t idx)
+{
+    bool sequenced = false;
+
+    switch (event->type)
+    {
+        case META_EVENT:
+        {
+            if (TEMPO == event->meta.type)
+            {
+                state->tempo = idx;
+            }
+            break;
+        }
+
+        case SYSEX_EVENT:
+        {
+            // SysEx may do anything, like turning General MIDI on or off, so keep them all
+            sequenced = true;
+            break;
+        }
+
+        case MIDI_EVENT:
+        {
+            uint8_t channel = event->midi.status & 0x0F;
+            uint8_t data0   = event->midi.data[0] & 0x7F;
+            uint8_t data1   = event->midi.data[1] & 0x7F;
+
+            switch (event->midi.status & 0xF0)
+            {
+                // Note off
+                case 0x80:
+                {
+                    releaseIndexNote(state, channel, data0);
+                    break;
+                }
+
+                // Note on
+                case 0x90:
+                {
+                    if (0 == data1)
+                    {
+                        releaseIndexNote(state, channel, data0);
+                    }
+                    else
+                    {
+                        state->note[channel][data0]     = idx;
+                        state->noteHeld[channel][data0] = false;
+                    }
+                    break;
+                }
+
+                // Control change
+                case 0xB0:
+                {
+                    switch (data0)
+                    {
+                        case MCC_DATA_ENTRY_MSB:
+                        case MCC_DATA_ENTRY_LSB:
+                        case MCC_DATA_BUTTON_INC:
+                        case MCC_DATA_BUTTON_DEC:
+                        case MCC_NON_REGISTERED_PARAM_LSB:
+                        case MCC_NON_REGISTERED_PARAM_MSB:
+                        case MCC_REGISTERED_PARAM_LSB:
+                        case MCC_REGISTERED_PARAM_MSB:
+                        {
+                            // Parameter selection and data entry depend on each other, so keep them all in order
+                            sequenced = true;
+                            break;
+                        }
+
+                        case MCC_ALL_SOUND_OFF:
+                        {
+                            memset(state->note[channel], 0xFF, sizeof(state->note[channel]));
+                            memset(state->noteHeld[channel], 0, sizeof(state->noteHeld[channel]));
+                            break;
+                        }
+
+                        case MCC_ALL_CONTROLS_OFF:
+                        {
+                            memset(state->controller[channel], 0xFF, sizeof(state->controller[channel]));
+                            state->pitchBend[channel] = UINT32_MAX;
+                            state->hold[channel]      = false;
+                            releaseHeldIndexNotes(state, channel);
+                            break;
+                        }
+
+                        case MCC_ALL_NOTE_OFF:
+                        {
+                            for (int note = 0; note < 128; note++)
+                            {
+                                releaseIndexNote(state, channel, note);
+                            }
+                            break;
+                        }
+
+                        default:
+                        {
+                            state->controller[channel][data0] = idx;
+                            if (MCC_HOLD_PEDAL == data0)
+                            {
+                                state->hold[channel] = (data1 >= 64);
+                                if (!state->hold[channel])
+                                {
+                                    releaseHeldIndexNotes(state, channel);
+                                }
+                            }
+                            break;
+                        }
+                    }
+                    break;
+                }
+
+                // Program change
+                case 0xC0:
+                {
+                    // The bank is read when the program changes, so keep the bank select events in effect then
+                    state->program[channel]        = idx;
+                    state->programBank[channel][0] = state->controller[channel][MCC_BANK_MSB];
+                    state->programBank[channel][1] = state->controller[channel][MCC_BANK_LSB];
+                    break;
+                }
+
+                // Pitch bend
+                case 0xE0:
+                {
+                    state->pitchBend[channel] = idx;
+                    break;
+                }
+
+                // Aftertouch and system messages don't need to be restored
+                default:
+                {
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    if (sequenced)
+    {
+        // Grow the sequence in chunks
+        if (0 == (state->sequenceCount % 64))
+        {
+            uint32_t* grown
+                = heap_caps_realloc(state->sequence, (state->sequenceCount + 64) * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+            if (NULL == grown)
+            {
+                return false;
+            }
+            state->sequence = grown;
+        }
+        state->sequence[state->sequenceCount++] = idx;
+    }
+    return true;
+}
+
+/**
+ * @brief Compare two event indices, for sorting
+ *
+ * @param a A pointer to the first uint32_t index
+ * @param b A pointer to the second uint32_t index
+ * @return A negative value, zero, or a positive value if a is before, at, or after b
+ */
+static int cmpEventIdx(const void* a, const void* b)
+{
+    uint32_t idxA = *(const uint32_t*)a;
+    uint32_t idxB = *(const uint32_t*)b;
+    return (idxA > idxB) - (idxA < idxB);
+}
+
+/**
+ * @brief Copy the used slots of an array of tracked event indices
+ *
+ * @param out Where to copy the used slots to
+ * @param slots The tracked event indices, where unused slots are UINT32_MAX
+ * @param numSlots The number of slots
+ * @return The number of slots copied
+ */
+static uint32_t gatherIndexSlots(uint32_t* out, const uint32_t* slots, uint32_t numSlots)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < numSlots; i++)
+    {
+        if (UINT32_MAX != slots[i])
+        {
+            out[count++] = slots[i];
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Append the events which restore the tracked state to the index, and fill in a checkpoint
+ *
+ * @param state The tracked state at the checkpoint
+ * @param stateEvents The state events for all previous checkpoints
+ * @param stateEventCount The number of state events, which is updated
+ * @param checkpoint The checkpoint to fill in, with eventIdx already set
+ * @param spiRam Whether to allocate in SPIRAM
+ * @return The reallocated state events, or NULL if memory could not be allocated
+ */
+static uint32_t* writeCheckpoint(midiIndexState_t* state, uint32_t* stateEvents, uint32_t* stateEventCount,
+                                 midiCheckpoint_t* checkpoint, bool spiRam)
+{
+    // Make room for the largest possible checkpoint
+    uint32_t maxCount = 1 + (16 * (1 + 2 + 128 + 1 + 128)) + state->sequenceCount;
+    uint32_t* grown   = heap_caps_realloc(stateEvents, (*stateEventCount + maxCount) * sizeof(uint32_t),
+                                          spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    if (NULL == grown)
+    {
+        heap_caps_free(stateEvents);
+        return NULL;
+    }
+
+    // Gather every event which is still in effect
+    uint32_t* out  = &grown[*stateEventCount];
+    uint32_t count = 0;
+
+    if (UINT32_MAX != state->tempo)
+    {
+        out[count++] = state->tempo;
+    }
+    count += gatherIndexSlots(&out[count], state->program, ARRAY_SIZE(state->program));
+    count += gatherIndexSlots(&out[count], &state->programBank[0][0], 16 * 2);
+    count += gatherIndexSlots(&out[count], &state->controller[0][0], 16 * 128);
+    count += gatherIndexSlots(&out[count], state->pitchBend, ARRAY_SIZE(state->pitchBend));
+    count += gatherIndexSlots(&out[count], &state->note[0][0], 16 * 128);
+    if (state->sequenceCount > 0)
+    {
+        memcpy(&out[count], state->sequence, state->sequenceCount * sizeof(uint32_t));
+        count += state->sequenceCount;
+    }
+
+    // Replay in file order, removing duplicates like bank selects which are also the latest value
+    qsort(out, count, sizeof(uint32_t), cmpEventIdx);
+    uint32_t unique = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (0 == unique || out[unique - 1] != out[i])
+        {
+            out[unique++] = out[i];
+        }
+    }
+
+    checkpoint->stateStart = *stateEventCount;
+    checkpoint->stateCount = unique;
+    *stateEventCount += unique;
+
+    // Shrink back down to what was used
+    uint32_t* shrunk = heap_caps_realloc(grown, *stateEventCount * sizeof(uint32_t) + 1,
+                                         spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT);
+    return shrunk ? shrunk : grown;
+}
+
+bool indexMidiFile(midiFile_t* file, bool spiRam)
+{
+    if (NULL != file->index)
+    {
+        return true;
+    }
+
+    if (MIDI_FORMAT_2 == file->format)
+    {
+        // Format 2 tracks play one after another, and aren't merged
+        return false;
+    }
+
+    uint32_t caps = spiRam ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
+
+    // Read the whole file once to count the events
+    midiFileReader_t reader = {0};
+    if (!initMidiParser(&reader, file))
+    {
+        return false;
+    }
+    reader.handleMetaEvents = true;
+
+    midiEvent_t event;
+    uint32_t eventCount = 0;
+    uint32_t extCount   = 0;
+    while (midiNextEvent(&reader, &event))
+    {
+        eventCount++;
+        if (MIDI_EVENT != event.type)
+        {
+            extCount++;
+        }
+    }
+
+    if (extCount > UINT16_MAX)
+    {
+        ESP_LOGW("MIDIParser", "Too many meta events to index: %" PRIu32, extCount);
+        deinitMidiParser(&reader);
+        return false;
+    }
+
+    // Allocate everything
+    midiEventIndex_t* index  = heap_caps_calloc_tag(1, sizeof(midiEventIndex_t), caps, "midiIndex");
+    midiIndexState_t* state  = heap_caps_calloc(1, sizeof(midiIndexState_t), MALLOC_CAP_SPIRAM);
+    uint32_t checkpointCount = (eventCount > 0) ? (eventCount - 1) / MIDI_INDEX_CHECKPOINT_INTERVAL : 0;
+    if (NULL != index)
+    {
+        index->events      = heap_caps_malloc_tag(eventCount * sizeof(midiIndexEvent_t) + 1, caps, "midiIndex");
+        index->extEvents   = heap_caps_malloc_tag(extCount * sizeof(midiEvent_t) + 1, caps, "midiIndex");
+        index->checkpoints = heap_caps_malloc_tag(checkpointCount * sizeof(midiCheckpoint_t) + 1, caps, "midiIndex");
+    }
+
+    bool ok = (NULL != index && NULL != state && NULL != index->events && NULL != index->extEvents
+               && NULL != index->checkpoints);
+
+    if (ok)
+    {
+        // Every slot is empty to start
+        state->tempo = UINT32_MAX;
+        memset(state->program, 0xFF, sizeof(state->program));
+        memset(state->programBank, 0xFF, sizeof(state->programBank));
+        memset(state->controller, 0xFF, sizeof(state->controller));
+        memset(state->pitchBend, 0xFF, sizeof(state->pitchBend));
+        memset(state->note, 0xFF, sizeof(state->note));
+
+        // Read the file again to fill in the index
+        resetMidiParser(&reader);
+        uint32_t stateEventCount = 0;
+        for (uint32_t idx = 0; ok && idx < eventCount && midiNextEvent(&reader, &event); idx++)
+        {
+            // Checkpoints are taken before the event they point to
+            if (idx > 0 && 0 == (idx % MIDI_INDEX_CHECKPOINT_INTERVAL))
+            {
+                midiCheckpoint_t* checkpoint = &index->checkpoints[index->checkpointCount++];
+                checkpoint->eventIdx         = idx;
+                index->stateEvents = writeCheckpoint(state, index->stateEvents, &stateEventCount, checkpoint, spiRam);
+                ok                 = (NULL != index->stateEvents);
+            }
+
+            midiIndexEvent_t* indexed = &index->events[index->eventCount++];
+            indexed->absTime          = event.absTime;
+            indexed->track            = event.track;
+            if (MIDI_EVENT == event.type)
+            {
+                indexed->status  = event.midi.status;
+                indexed->data[0] = event.midi.data[0];
+                indexed->data[1] = event.midi.data[1];
+            }
+            else
+            {
+                indexed->status  = 0;
+                indexed->data[0] = index->extCount & 0xFF;
+                indexed->data[1] = (index->extCount >> 8) & 0xFF;
+
+                index->extEvents[index->extCount++] = event;
+            }
+
+            ok = ok && trackIndexState(state, &event, idx);
+        }
+    }
+
+    deinitMidiParser(&reader);
+    if (NULL != state)
+    {
+        heap_caps_free(state->sequence);
+        heap_caps_free(state);
+    }
+
+    if (!ok)
+    {
+        ESP_LOGE("MIDIParser", "Could not index MIDI file with %" PRIu32 " events", eventCount);
+        file->index = index;
+        freeMidiIndex(file);
+        return false;
+    }
+
+    ESP_LOGI("MIDIParser", "Indexed %" PRIu32 " events with %" PRIu32 " checkpoints", index->eventCount,
+             index->checkpointCount);
+    file->index = index;
+    return true;
+}
+
+void freeMidiIndex(midiFile_t* file)
+{
+    midiEventIndex_t* index = file->index;
+    if (NULL != index)
+    {
+        heap_caps_free(index->events);
+        heap_caps_free(index->extEvents);
+        heap_caps_free(index->checkpoints);
+        heap_caps_free(index->stateEvents);
+        heap_caps_free(index);
+        file->index = NULL;
+    }
+}
+
+/**
+ * @brief Binary search for the last checkpoint whose first event is at or before a tick
+ *
+ * @param index The index to search
+ * @param tick The tick to search for
+ * @return The checkpoint, or NULL if every checkpoint is after the tick
+ */
+static const midiCheckpoint_t* findCheckpoint(const midiEventIndex_t* index, uint32_t tick)
+{
+    const midiCheckpoint_t* found = NULL;
+    uint32_t lo                   = 0;
+    uint32_t hi                   = index->checkpointCount;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index->events[index->checkpoints[mid].eventIdx].absTime <= tick)
+        {
+            found = &index->checkpoints[mid];
+            lo    = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return found;
+}
+
+uint32_t midiFindCheckpoint(const midiFile_t* file, uint32_t tick)
+{
+    if (NULL == file || NULL == file->index)
+    {
+        return 0;
+    }
+
+    const midiCheckpoint_t* checkpoint = findCheckpoint(file->index, tick);
+    return checkpoint ? checkpoint->eventIdx : 0;
+}
+
+bool midiSeekCheckpoint(midiFileReader_t* reader, uint32_t tick, midiCheckpointCb_t stateCb, void* arg)
+{
+    if (NULL == reader->file || NULL == reader->file->index)
+    {
+        return false;
+    }
+
+    const midiEventIndex_t* index      = reader->file->index;
+    const midiCheckpoint_t* checkpoint = findCheckpoint(index, tick);
+    if (NULL == checkpoint)
+    {
+        return false;
+    }
+
+    // Restore the state, then continue reading from the checkpoint
+    midiEvent_t event;
+    for (uint32_t i = 0; i < checkpoint->stateCount; i++)
+    {
+        decodeIndexEvent(index, index->stateEvents[checkpoint->stateStart + i], &event);
+        stateCb(&event, arg);
+    }
+    reader->indexPos = checkpoint->eventIdx;
+    return true;
+}
+
 void* globalMidiSave(void)
 {
     // TODO: There are multiple allocs here, so the return value _can't_ safely be heap_caps_free()'d by others
@@ -10,6 +10,13 @@
 
 #include "cnfs_image.h"
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// @brief The number of events between checkpoints in a MIDI event index
+#define MIDI_INDEX_CHECKPOINT_INTERVAL 256
+
 //==============================================================================
 // Enums
 //==============================================================================
@@ -80,6 +87,8 @@ typedef struct
     uint8_t* data;
 } midiTrack_t;
 
+typedef struct midiEventIndex midiEventIndex_t;
+
 /**
  * @brief Contains information which applies to the entire MIDI file
  */
@@ -102,6 +111,9 @@ typedef struct
 
     /// @brief An array of MIDI tracks
     midiTrack_t* tracks;
+
+    /// @brief A time-sorted index of every event in the file, or NULL if indexMidiFile() has not been called
+    midiEventIndex_t* index;
 } midiFile_t;
 
 typedef struct midiTrackState midiTrackState_t;
@@ -122,6 +134,9 @@ typedef struct
 
     /// @brief An array containing the internal parser state for each track
     midiTrackState_t* states;
+
+    /// @brief The position of the next event to read from the file's index, if the file is indexed
+    uint32_t indexPos;
 } midiFileReader_t;
 
 /**
@@ -257,6 +272,14 @@ typedef struct
     };
 } midiEvent_t;
 
+/**
+ * @brief A function called for each event which restores the state at a checkpoint
+ *
+ * @param event The event to handle
+ * @param arg The argument passed to midiSeekCheckpoint()
+ */
+typedef void (*midiCheckpointCb_t)(const midiEvent_t* event, void* arg);
+
 //==============================================================================
 // Function Declarations
 //==============================================================================
@@ -342,6 +365,55 @@ uint32_t midiNextEventTime(midiFileReader_t* reader);
  */
 bool midiNextEvent(midiFileReader_t* reader, midiEvent_t* event);
 
+/**
+ * @brief Build an index of every event in a MIDI file, which makes reading events cheaper and seeking faster
+ *
+ * All tracks are merged into a single time-sorted array of compactly encoded events. Every
+ * ::MIDI_INDEX_CHECKPOINT_INTERVAL events, a checkpoint records the events needed to restore the tempo, program,
+ * controller, pitch bend, and held note state at that point. Readers of an indexed file read from the index
+ * automatically. The index is freed by unloadMidiFile().
+ *
+ * Format 2 files are not indexed.
+ *
+ * @param file The MIDI file to index
+ * @param spiRam Whether to allocate the index in SPIRAM
+ * @return true if the file is indexed
+ * @return false if the file could not be indexed, in which case it is still readable
+ */
+bool indexMidiFile(midiFile_t* file, bool spiRam);
+
+/**
+ * @brief Free the event index of a MIDI file, if it has one
+ *
+ * @param file The MIDI file to free the index of
+ */
+void freeMidiIndex(midiFile_t* file);
+
+/**
+ * @brief Find the position of the last checkpoint in an indexed MIDI file at or before a tick
+ *
+ * @param file The indexed MIDI file
+ * @param tick The tick to find a checkpoint for
+ * @return The index of the first event after the checkpoint, or 0 if there is no checkpoint or the file isn't indexed
+ */
+uint32_t midiFindCheckpoint(const midiFile_t* file, uint32_t tick);
+
+/**
+ * @brief Move a reader to the last checkpoint at or before a tick, and call a function with each event which restores
+ * the state at that checkpoint, in file order
+ *
+ * The reader's state should be reset before calling this. Events after the checkpoint are then read normally with
+ * midiNextEvent().
+ *
+ * @param reader The reader to move, which must have an indexed file
+ * @param tick The tick to seek to
+ * @param stateCb A function to call for each state event
+ * @param arg An argument to pass to stateCb
+ * @return true if the reader was moved to a checkpoint
+ * @return false if the file isn't indexed or there is no checkpoint before the tick
+ */
+bool midiSeekCheckpoint(midiFileReader_t* reader, uint32_t tick, midiCheckpointCb_t stateCb, void* arg);
+
 /**
  * @brief Writes a MIDI event to a byte buffer
  *
@@ -65,6 +65,12 @@ static const uint8_t oscDither[] = {
 
 // #define VS_ANY(statePtr) ((statePtr)->on)
 
+// The most samples rendered at once into the accumulation buffer on the stack
+#define MIDI_RENDER_BLOCK 64
+
+// The most samples rendered between checks of the streaming callback
+#define MIDI_STREAMING_BLOCK 16
+
 /// @brief Set only the MSB of a 14-bit value
 #define SET_MSB(target, val)                   \
     do                                         \
@@ -120,8 +126,25 @@ static int32_t stepSampleVoice(midiVoice_t* voice, voiceStates_t* states, uint8_
                                uint32_t* specialStates);
 static int32_t stepPlayFuncVoice(midiVoice_t* voice, voiceStates_t* states, uint8_t voiceIdx, midiChannel_t* channel,
                                  uint32_t* specialStates);
+static void stepVoiceVolume(midiVoice_t* voice);
 static int32_t midiStepVoice(midiChannel_t* channel, voiceStates_t* states, uint8_t voiceIdx, midiVoice_t* voice,
                              uint32_t* specialStates);
+/**
+ * @brief Render a block of samples for a single voice, adding them into the block
+ *
+ * This is the same as calling midiStepVoice() for each sample, but ADSR transitions are only checked when they are
+ * due and the channel lookup is done once per block. Rendering stops early if the voice turns off.
+ *
+ * @param channels The player's MIDI channels
+ * @param states The voice state bitmaps for the voice's pool
+ * @param voiceIdx The index of the voice in its pool
+ * @param voice The voice to render
+ * @param specialStates The percussion special state bitmap
+ * @param block The accumulation buffer to add samples into
+ * @param count The number of samples to render
+ */
+static void midiRenderVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t voiceIdx, midiVoice_t* voice,
+                            uint32_t* specialStates, int32_t* block, uint16_t count);
 static bool setVoiceTimbre(midiVoice_t* voice, const midiTimbre_t* timbre);
 static void updateSampleVoicePitch(midiVoice_t* voice);
 static void initTimbre(midiTimbre_t* dest, const midiTimbre_t* config);
@@ -130,6 +153,14 @@ static void handleSysexEvent(midiPlayer_t* player, const midiSysexEvent_t* sysex
 static void handleMetaEvent(midiPlayer_t* player, const midiMetaEvent_t* event);
 static void handleEvent(midiPlayer_t* player, const midiEvent_t* event);
 static void midiSongEnd(midiPlayer_t* player);
+static uint32_t activeVoiceMask(const voiceStates_t* states);
+static void midiPlayerHandleEvents(midiPlayer_t* player);
+static void midiPlayerAdvanceSamples(midiPlayer_t* player, uint32_t count);
+static uint16_t midiSamplesToNextTick(const midiPlayer_t* player, uint16_t maxSamples);
+static void midiRenderVoices(midiPlayer_t* player, voiceStates_t* states, midiVoice_t* voices, int32_t* block,
+                             uint16_t count);
+static void midiPlayerRender(midiPlayer_t* player, int32_t* block, uint16_t len);
+static void midiSeekStateCb(const midiEvent_t* event, void* arg);
 
 // Check for the first unused note, then try to steal one in order of less to more bad, and return INT32_MAX if none are
 // available
@@ -673,22 +704,13 @@ static int32_t stepPlayFuncVoice(midiVoice_t* voice, voiceStates_t* states, uint
     return sample;
 }
 
-int32_t midiStepVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t voiceIdx, midiVoice_t* voice,
-                      uint32_t* specialStates)
+/**
+ * @brief Step a voice's envelope volume forward by one sample
+ *
+ * @param voice The voice to step
+ */
+static void stepVoiceVolume(midiVoice_t* voice)
 {
-    while (voice->stateChangeTick == voice->voiceTick)
-    {
-        MIDI_DBG("Voice %" PRIu8 " has reached state change tick %" PRIu32, voiceIdx, voice->stateChangeTick);
-        if (ADSR_OFF
-            == voiceAdvanceAdsr(voice, states, voiceIdx,
-                                (voice->channel < MIDI_CHANNEL_COUNT) ? &channels[voice->channel] : NULL, specialStates,
-                                ADSR_ON))
-        {
-            // Don't continue stepping a turned-off voice!
-            return 0;
-        }
-    }
-
     // Make sure we don't over/underflow the volume!!
     if (voice->volRate < 0 && (uq8_24)(-voice->volRate) > voice->curVol)
     {
@@ -712,6 +734,26 @@ int32_t midiStepVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t vo
     }
 
     voice->volRate += voice->volAccel;
+}
+
+int32_t midiStepVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t voiceIdx, midiVoice_t* voice,
+                      uint32_t* specialStates)
+{
+    while (voice->stateChangeTick == voice->voiceTick)
+    {
+        MIDI_DBG("Voice %" PRIu8 " has reached state change tick %" PRIu32, voiceIdx, voice->stateChangeTick);
+        if (ADSR_OFF
+            == voiceAdvanceAdsr(voice, states, voiceIdx,
+                                (voice->channel < MIDI_CHANNEL_COUNT) ? &channels[voice->channel] : NULL, specialStates,
+                                ADSR_ON))
+        {
+            // Don't continue stepping a turned-off voice!
+            return 0;
+        }
+    }
+
+    stepVoiceVolume(voice);
+
     int32_t nextSample     = 0;
     midiChannel_t* channel = (voice->channel < MIDI_CHANNEL_COUNT) ? &channels[voice->channel] : NULL;
     uint16_t chanVol       = channel ? channel->volume : UINT14_MAX;
@@ -744,6 +786,66 @@ int32_t midiStepVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t vo
     return nextSample;
 }
 
+static void midiRenderVoice(midiChannel_t* channels, voiceStates_t* states, uint8_t voiceIdx, midiVoice_t* voice,
+                            uint32_t* specialStates, int32_t* block, uint16_t count)
+{
+    // Events aren't handled within a block, so the channel can't change
+    midiChannel_t* channel = (voice->channel < MIDI_CHANNEL_COUNT) ? &channels[voice->channel] : NULL;
+    uint16_t chanVol       = channel ? channel->volume : UINT14_MAX;
+    uint32_t voiceBit      = (1 << voiceIdx);
+
+    uint16_t n = 0;
+    while (n < count)
+    {
+        while (voice->stateChangeTick == voice->voiceTick)
+        {
+            MIDI_DBG("Voice %" PRIu8 " has reached state change tick %" PRIu32, voiceIdx, voice->stateChangeTick);
+            if (ADSR_OFF == voiceAdvanceAdsr(voice, states, voiceIdx, channel, specialStates, ADSR_ON))
+            {
+                // Don't continue rendering a turned-off voice!
+                return;
+            }
+        }
+
+        // Render samples until the next ADSR transition or the end of the block
+        switch (voice->type)
+        {
+            case VOICE_WAVE_FUNC:
+            {
+                // Wave voices only change state at the state change tick
+                do
+                {
+                    stepVoiceVolume(voice);
+                    block[n++] += stepWaveVoice(voice, states, voiceIdx, channel, specialStates) * chanVol / UINT14_MAX;
+                    voice->voiceTick++;
+                } while (n < count && voice->stateChangeTick != voice->voiceTick);
+                break;
+            }
+
+            case VOICE_PLAY_FUNC:
+            case VOICE_SAMPLE:
+            {
+                // These voices may turn themselves off, or be released, at any sample
+                do
+                {
+                    stepVoiceVolume(voice);
+                    int32_t sample = (VOICE_SAMPLE == voice->type)
+                                         ? stepSampleVoice(voice, states, voiceIdx, channel, specialStates)
+                                         : stepPlayFuncVoice(voice, states, voiceIdx, channel, specialStates);
+                    block[n++] += sample * chanVol / UINT14_MAX;
+                    voice->voiceTick++;
+
+                    if (0 == (activeVoiceMask(states) & voiceBit))
+                    {
+                        return;
+                    }
+                } while (n < count && voice->stateChangeTick != voice->voiceTick);
+                break;
+            }
+        }
+    }
+}
+
 /**
  * @brief Set the timbre (instrument definition) of a MIDI voice
  *
@@ -1479,13 +1581,25 @@ void midiPlayerResetNewSong(midiPlayer_t* player)
     player->songEnding       = false;
 }
 
-int32_t midiPlayerStep(midiPlayer_t* player)
+/**
+ * @brief Get a bitmap of every voice which is making sound or waiting to
+ *
+ * @param states The voice state bitmaps
+ * @return A bitmap with a bit set for every voice in any ADSR state
+ */
+static uint32_t activeVoiceMask(const voiceStates_t* states)
 {
-    if (player->paused)
-    {
-        return 0;
-    }
+    return states->on | states->held | states->sustenuto | states->release | states->attack | states->decay
+           | states->sustain;
+}
 
+/**
+ * @brief Handle every event which is due at the current tick, or every event from the streaming callback
+ *
+ * @param player The MIDI player to handle events for
+ */
+static void midiPlayerHandleEvents(midiPlayer_t* player)
+{
     bool checkEvents = !player->songEnding && player->forceCheckEvents;
     if (checkEvents && player->mode == MIDI_FILE)
     {
@@ -1522,13 +1636,162 @@ int32_t midiPlayerStep(midiPlayer_t* player)
             }
         }
     }
+}
+
+/**
+ * @brief Advance the song position by some samples, and schedule an event check if the tick changed
+ *
+ * @param player The MIDI player to advance
+ * @param count The number of samples which were rendered
+ */
+static void midiPlayerAdvanceSamples(midiPlayer_t* player, uint32_t count)
+{
+    player->sampleCount += count;
+    uint32_t newTick = SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division);
+    if (newTick != player->tick)
+    {
+        player->tick             = newTick;
+        player->forceCheckEvents = true;
+    }
+}
+
+/**
+ * @brief Get the number of samples which may be rendered before events must be checked again
+ *
+ * This is the number of samples until the MIDI tick changes, so events are still handled on the exact sample they
+ * would be if the player were stepped one sample at a time.
+ *
+ * @param player The MIDI player to check
+ * @param maxSamples The most samples to return
+ * @return The number of samples to render, between 1 and maxSamples
+ */
+static uint16_t midiSamplesToNextTick(const midiPlayer_t* player, uint16_t maxSamples)
+{
+    if (player->mode == MIDI_STREAMING)
+    {
+        // Events may arrive at any time, so poll for them regularly
+        maxSamples = MIN(maxSamples, MIDI_STREAMING_BLOCK);
+    }
+
+    if (0 == player->reader.division)
+    {
+        // Ticks never advance
+        return maxSamples;
+    }
+
+    // After a tempo change, the tick for the current sample may not match anymore. Step one sample to resync
+    if (SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division) != player->tick)
+    {
+        return 1;
+    }
+
+    // Find the first sample with a later tick, the inverse of SAMPLES_TO_MIDI_TICKS() rounded up
+    uint64_t ticksDen       = (uint64_t)1000000 * player->reader.division;
+    uint64_t nextTickSample = ((uint64_t)(player->tick + 1) * DAC_SAMPLE_RATE_HZ * player->tempo + ticksDen - 1)
+                              / ticksDen;
+
+    if (nextTickSample <= player->sampleCount)
+    {
+        return 1;
+    }
+    else if (nextTickSample - player->sampleCount < maxSamples)
+    {
+        return nextTickSample - player->sampleCount;
+    }
+    return maxSamples;
+}
+
+/**
+ * @brief Render a block of samples for every active voice in a voice pool, adding them into the block
+ *
+ * Each voice is stepped through the whole block before the next, so its state stays in registers and cache. No
+ * events are handled within a block, so the voices can't affect each other and the sum is the same as stepping every
+ * voice one sample at a time.
+ *
+ * @param player The MIDI player which owns the voices
+ * @param states The voice state bitmaps for the pool
+ * @param voices The voices in the pool
+ * @param block The accumulation buffer to add samples into
+ * @param count The number of samples to render
+ */
+static void midiRenderVoices(midiPlayer_t* player, voiceStates_t* states, midiVoice_t* voices, int32_t* block,
+                             uint16_t count)
+{
+    uint32_t activeVoices = activeVoiceMask(states);
+    while (0 != activeVoices)
+    {
+        uint8_t voiceIdx = __builtin_ctz(activeVoices);
+        midiRenderVoice(player->channels, states, voiceIdx, &voices[voiceIdx], &player->percSpecialStates, block,
+                        count);
+        activeVoices &= ~(1 << voiceIdx);
+    }
+}
+
+/**
+ * @brief Render a buffer of samples from a MIDI player, before headroom is applied
+ *
+ * This produces the same samples as calling midiPlayerStep() for each one, but events are only checked at tick
+ * boundaries and each voice is rendered a block at a time.
+ *
+ * @param player The MIDI player to render
+ * @param block The buffer to write samples to
+ * @param len The number of samples to render
+ */
+static void midiPlayerRender(midiPlayer_t* player, int32_t* block, uint16_t len)
+{
+    uint16_t n = 0;
+    while (n < len)
+    {
+        if (player->paused)
+        {
+            memset(&block[n], 0, (len - n) * sizeof(int32_t));
+            return;
+        }
+
+        midiPlayerHandleEvents(player);
+
+        uint32_t anyVoices = activeVoiceMask(&player->poolVoiceStates) | activeVoiceMask(&player->percVoiceStates);
+        uint16_t count     = midiSamplesToNextTick(player, len - n);
+        if (player->songEnding)
+        {
+            // The song ends on the sample after the last voice turns off, so step one sample at a time until then
+            count = 1;
+        }
+
+        // Render all voices into the block
+        int32_t* out = &block[n];
+        memset(out, 0, count * sizeof(int32_t));
+        midiRenderVoices(player, &player->poolVoiceStates, player->poolVoices, out, count);
+        midiRenderVoices(player, &player->percVoiceStates, player->percVoices, out, count);
+        midiPlayerAdvanceSamples(player, count);
+
+        // Apply the global volume value
+        for (uint16_t i = 0; i < count; i++)
+        {
+            out[i] *= player->volume;
+            out[i] /= UINT14_MAX;
+        }
+        n += count;
+
+        if (player->songEnding && !anyVoices)
+        {
+            midiSongEnd(player);
+        }
+    }
+}
+
+int32_t midiPlayerStep(midiPlayer_t* player)
+{
+    if (player->paused)
+    {
+        return 0;
+    }
+
+    midiPlayerHandleEvents(player);
 
     int32_t sample = 0;
     // Handle ADSR transitions, etc. for all voices and get a sample
-    uint32_t activeVoices = player->poolVoiceStates.on | player->poolVoiceStates.held
-                            | player->poolVoiceStates.sustenuto | player->poolVoiceStates.release
-                            | player->poolVoiceStates.attack | player->poolVoiceStates.decay
-                            | player->poolVoiceStates.sustain;
+    uint32_t activeVoices = activeVoiceMask(&player->poolVoiceStates);
     uint32_t anyVoices    = activeVoices;
     while (0 != activeVoices)
     {
@@ -1539,9 +1802,7 @@ int32_t midiPlayerStep(midiPlayer_t* player)
     }
 
     // Now, repeat for the percussion voices!
-    activeVoices = player->percVoiceStates.on | player->percVoiceStates.held | player->percVoiceStates.sustenuto
-                   | player->percVoiceStates.release | player->percVoiceStates.attack | player->percVoiceStates.decay
-                   | player->percVoiceStates.sustain;
+    activeVoices = activeVoiceMask(&player->percVoiceStates);
     anyVoices |= activeVoices;
     while (0 != activeVoices)
     {
@@ -1551,13 +1812,7 @@ int32_t midiPlayerStep(midiPlayer_t* player)
         activeVoices &= ~(1 << voiceIdx);
     }
 
-    player->sampleCount++;
-    uint32_t newTick = SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division);
-    if (newTick != player->tick)
-    {
-        player->tick             = newTick;
-        player->forceCheckEvents = true;
-    }
+    midiPlayerAdvanceSamples(player, 1);
 
     // Apply the global volume value
     sample *= player->volume;
@@ -1579,37 +1834,45 @@ void midiPlayerFillBuffer(midiPlayer_t* player, uint8_t* samples, int16_t len)
         return;
     }
 
-    for (int16_t n = 0; n < len; n++)
+    int32_t block[MIDI_RENDER_BLOCK];
+    for (int16_t start = 0; start < len; start += MIDI_RENDER_BLOCK)
     {
-        // Step the state forward by one sample and return the next sample sum
-        int32_t sample = midiPlayerStep(player);
-
-        // Multiply the sample by 0.3 to provide some headroom for stacking samples
-        sample *= player->headroom;
-        sample >>= 16;
+        uint16_t count = MIN(len - start, MIDI_RENDER_BLOCK);
+        midiPlayerRender(player, block, count);
 
-        if (sample < -128)
-        {
-            samples[n] = 0;
-            player->clipped++;
-        }
-        else if (sample > 127)
-        {
-            samples[n] = 255;
-            player->clipped++;
-        }
-        else
+        for (uint16_t n = 0; n < count; n++)
         {
-            samples[n] = sample + 128;
+            // Multiply the sample by 0.3 to provide some headroom for stacking samples
+            int32_t sample = block[n] * player->headroom;
+            sample >>= 16;
+
+            if (sample < -128)
+            {
+                samples[start + n] = 0;
+                player->clipped++;
+            }
+            else if (sample > 127)
+            {
+                samples[start + n] = 255;
+                player->clipped++;
+            }
+            else
+            {
+                samples[start + n] = sample + 128;
+            }
         }
     }
 }
 
 void midiPlayerFillBufferMulti(midiPlayer_t* players, uint8_t playerCount, uint8_t* samples, int16_t len)
 {
-    for (int16_t n = 0; n < len; n++)
+    int32_t block[MIDI_RENDER_BLOCK];
+    int32_t mix[MIDI_RENDER_BLOCK];
+    for (int16_t start = 0; start < len; start += MIDI_RENDER_BLOCK)
     {
-        int32_t sample = 0;
+        uint16_t count = MIN(len - start, MIDI_RENDER_BLOCK);
+        memset(mix, 0, count * sizeof(int32_t));
+
         for (int i = 0; i < playerCount; i++)
         {
             if (players[i].seeking)
@@ -1617,25 +1880,32 @@ void midiPlayerFillBufferMulti(midiPlayer_t* players, uint8_t playerCount, uint8
                 continue;
             }
 
-            // Apply the player's headroom to its sample sum
-            sample += (midiPlayerStep(&players[i]) * players[i].headroom);
+            // Apply the player's headroom to its sample sums
+            midiPlayerRender(&players[i], block, count);
+            for (uint16_t n = 0; n < count; n++)
+            {
+                mix[n] += (block[n] * players[i].headroom);
+            }
         }
 
-        // Shift right by 16 to account for the headroom application
-        sample >>= 16;
-
-        // TODO: Can't keep track of clipping here... does it matter?
-        if (sample < -128)
+        for (uint16_t n = 0; n < count; n++)
         {
-            samples[n] = 0;
-        }
-        else if (sample > 127)
-        {
-            samples[n] = 255;
-        }
-        else
-        {
-            samples[n] = sample + 128;
+            // Shift right by 16 to account for the headroom application
+            int32_t sample = mix[n] >> 16;
+
+            // TODO: Can't keep track of clipping here... does it matter?
+            if (sample < -128)
+            {
+                samples[start + n] = 0;
+            }
+            else if (sample > 127)
+            {
+                samples[start + n] = 255;
+            }
+            else
+            {
+                samples[start + n] = sample + 128;
+            }
         }
     }
 }
@@ -2781,6 +3051,17 @@ void midiPause(midiPlayer_t* player, bool pause)
     player->paused = pause;
 }
 
+/**
+ * @brief Apply an event which restores playback state while seeking to a checkpoint
+ *
+ * @param event The state event
+ * @param arg The ::midiPlayer_t to apply it to
+ */
+static void midiSeekStateCb(const midiEvent_t* event, void* arg)
+{
+    handleEvent((midiPlayer_t*)arg, event);
+}
+
 void midiSeek(midiPlayer_t* player, uint32_t ticks)
 {
     bool paused  = player->paused;
@@ -2795,9 +3076,13 @@ void midiSeek(midiPlayer_t* player, uint32_t ticks)
         player->songFinishedCallback = NULL;
         bool loop                    = player->loop;
 
-        if (SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division) > ticks)
+        // Indexed files can skip straight to the last checkpoint before the target, in either direction
+        bool goBack = SAMPLES_TO_MIDI_TICKS(player->sampleCount, player->tempo, player->reader.division) > ticks;
+        bool jump   = midiFindCheckpoint(loadedFile, ticks) > player->reader.indexPos;
+
+        if (goBack || jump)
         {
-            // We have to go back
+            // We have to start over
             midiPlayerReset(player);
             midiSetFile(player, loadedFile);
         }
@@ -2809,6 +3094,12 @@ void midiSeek(midiPlayer_t* player, uint32_t ticks)
         midiPause(player, false);
         player->loop = false;
 
+        if ((goBack || jump) && midiSeekCheckpoint(&player->reader, ticks, midiSeekStateCb, player))
+        {
+            // The reader moved, so any pending event is stale
+            player->eventAvailable = false;
+        }
+
         // Okay, new strategy:
         // We work in ticks here to preserve precision
         // Calculate the current tick, use that to skip through events
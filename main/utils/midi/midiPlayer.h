@@ -835,6 +835,10 @@ int32_t midiPlayerStep(midiPlayer_t* player);
  * @brief Fill a buffer with the next set of samples from the MIDI player. This should be called by the
  * callback passed into initDac(). Samples are generated at sampling rate of ::DAC_SAMPLE_RATE_HZ
  *
+ * Samples are rendered a block at a time, with events handled only at tick boundaries. The output is the same as
+ * calling midiPlayerStep() for every sample, except that a streaming callback is polled every few samples rather than
+ * every sample.
+ *
  * @param player The MIDI player to sample from
  * @param samples An array of unsigned 8-bit samples to fill
  * @param len The length of the array to fill
@@ -10,10 +10,12 @@
 #include <esp_log.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include <esp_heap_caps.h>
 
 #include "hdw-esp-now.h"
 #include "p2pConnection.h"
 #include "hdw-nvs.h"
+#include "linked_list.h"
 
 //==============================================================================
 // Defines
@@ -27,6 +29,12 @@
 // (240 steps of rotation + (252/4) steps of decay) * 12ms
 #define FAILURE_RESTART_US 8000000
 
+// The time to wait for a windowed packet to be ACKed before sending it again
+#define WIN_RETRY_US 5000
+
+// Each windowed packet starts with a byte for the number of fragments left in the message
+#define WIN_FRAG_DATA_LEN (P2P_MAX_DATA_LEN - 1)
+
 // #define P2P_DEBUG
 #ifdef P2P_DEBUG
 static const char* P2P_TAG = "P2P";
@@ -35,6 +43,50 @@ static const char* P2P_TAG = "P2P";
     #define P2P_LOG(...)
 #endif
 
+//==============================================================================
+// Structs
+//==============================================================================
+
+/// A windowed message which is queued, in flight, or waiting to be ACKed
+typedef struct
+{
+    p2pWinMsgTxCbFn txCbFn; ///< Called when the whole message is ACKed or fails
+    uint16_t len;           ///< The length of the message
+    uint16_t fragCount;     ///< The number of packets the message is split into
+    uint16_t fragsSent;     ///< The number of packets which have been put in the window so far
+    uint8_t data[];         ///< A copy of the message
+} p2pWinTxMsg_t;
+
+/// A packet in the transmit or receive window
+typedef struct
+{
+    p2pDataMsg_t msg;    ///< The packet
+    uint8_t len;         ///< The length of the packet, or 0 if this slot is empty
+    bool acked;          ///< true if the packet was ACKed. Only used for transmission
+    bool lastFrag;       ///< true if this is the last packet of a message. Only used for transmission
+    int64_t firstSentUs; ///< The time the packet was first transmitted. Only used for transmission
+    int64_t sentUs;      ///< The time the packet was last transmitted. Only used for transmission
+} p2pWinSlot_t;
+
+/// State for windowed messages
+struct p2pWindow
+{
+    p2pWinMsgRxCbFn rxCbFn;           ///< Called when a whole windowed message is received
+    list_t txQueue;                   ///< Messages which are queued or in flight, oldest first. Holds p2pWinTxMsg_t*
+    p2pWinSlot_t tx[P2P_WINDOW_SIZE]; ///< Packets in flight, indexed by sequence number
+    uint8_t txBase;                   ///< The oldest sequence number which hasn't been ACKed
+    uint8_t txNext;                   ///< The next sequence number to transmit
+    int64_t retryAtUs;                ///< When p2pPollWindows() next checks for packets to retry, or 0 if none are
+    p2pWinSlot_t rx[P2P_WINDOW_SIZE]; ///< Packets received out of order, indexed by sequence number
+    uint8_t rxNext;                   ///< The next sequence number to deliver
+    uint8_t* rxMsg;                   ///< The message being reassembled, ::P2P_MAX_MSG_LEN bytes
+    uint16_t rxMsgLen;                ///< The number of bytes reassembled so far
+    bool rxMsgOverflow;               ///< true if the message being reassembled is too long to deliver
+    volatile bool resetPending;       ///< true if p2pRestart() was called and p2pPollWindows() must reset the window
+    p2pInfo* p2p;                     ///< The p2pInfo this window belongs to
+    p2pWindow_t* next;                ///< The next window polled by p2pPollWindows()
+};
+
 //==============================================================================
 // Function Prototypes
 //==============================================================================
@@ -51,6 +103,22 @@ static void p2pSendMsgEx(p2pInfo* p2p, uint8_t* msg, uint16_t len, bool shouldAc
                          p2pAckFailureFn failure);
 static void p2pModeMsgSuccess(p2pInfo* p2p, const uint8_t* data, uint8_t dataLen);
 static void p2pModeMsgFailure(p2pInfo* p2p);
+static void p2pFreeWindow(p2pInfo* p2p);
+static void p2pWinReset(p2pInfo* p2p);
+static void p2pWinRecv(p2pInfo* p2p, const p2pDataMsg_t* msg, uint8_t len);
+static void p2pWinRecvData(p2pInfo* p2p, const p2pDataMsg_t* msg, uint8_t len);
+static void p2pWinRecvAck(p2pInfo* p2p, const p2pDataMsg_t* msg);
+static void p2pWinSendAck(p2pInfo* p2p);
+static void p2pWinFill(p2pInfo* p2p);
+static void p2pWinArmRetry(p2pInfo* p2p);
+static void p2pWinRetry(p2pInfo* p2p);
+
+//==============================================================================
+// Variables
+//==============================================================================
+
+/// Every enabled window, polled from the main loop by p2pPollWindows()
+static p2pWindow_t* p2pWindows = NULL;
 
 //==============================================================================
 // Functions
@@ -222,6 +290,9 @@ void p2pDeinit(p2pInfo* p2p, bool deleteTimers)
         }
     }
 
+    // Free queued windowed messages without calling back
+    p2pFreeWindow(p2p);
+
     // Clear out for good measure
     memset(p2p, 0, sizeof(p2pInfo));
 }
@@ -507,6 +578,17 @@ void p2pRecvCb(p2pInfo* p2p, const uint8_t* mac_addr, const uint8_t* data, uint8
         return;
     }
 
+    // Windowed packets have their own sequence numbers and ACKs
+    if (len >= sizeof(p2pCommonHeader_t)
+        && (P2P_MSG_WIN_DATA == p2pHdr->messageType || P2P_MSG_WIN_ACK == p2pHdr->messageType))
+    {
+        if (p2p->cnc.isConnected && NULL != p2p->win)
+        {
+            p2pWinRecv(p2p, (const p2pDataMsg_t*)data, len);
+        }
+        return;
+    }
+
     // By here, we know the received message matches our message ID, either a
     // broadcast or for us. If this isn't an ack message, ack it
     if (len >= sizeof(p2pCommonHeader_t) && p2pHdr->messageType != P2P_MSG_ACK
@@ -758,6 +840,12 @@ static void p2pProcConnectionEvt(p2pInfo* p2p, connectionEvt_t event)
         // Connection was successful, so disarm the failure timer
         esp_timer_stop(p2p->tmr.Reinit);
 
+        // The other Swadge's window starts from scratch for this connection, so this one must too
+        if (NULL != p2p->win)
+        {
+            p2pWinReset(p2p);
+        }
+
         p2p->cnc.isConnected = true;
 
         // tell the mode it's connected
@@ -823,6 +911,10 @@ void p2pRestart(p2pInfo* p2p)
     p2pMsgRxCbFn oldMsgRxCbFn = p2p->msgRxCbFn;
     int8_t oldConnectionRssi  = p2p->connectionRssi;
 
+    // Keep the window so p2pDeinit() doesn't free it
+    p2pWindow_t* oldWin = p2p->win;
+    p2p->win            = NULL;
+
     // Don't call p2pDeinit() here because it deletes timers while being called from a timer callback
     p2pDeinit(p2p, false);
     p2pInitialize(p2p, modeId, oldConCbFn, oldMsgRxCbFn, oldConnectionRssi);
@@ -831,6 +923,14 @@ void p2pRestart(p2pInfo* p2p)
     {
         p2pSetAsymmetric(p2p, incomingModeId);
     }
+
+    // Fail every queued windowed message and start the sequence numbers over from the main loop, since this may be
+    // called from a timer
+    if (NULL != oldWin)
+    {
+        oldWin->resetPending = true;
+        p2p->win             = oldWin;
+    }
 }
 
 /**
@@ -933,7 +1033,490 @@ void p2pSetPlayOrder(p2pInfo* p2p, playOrder_t order)
  */
 bool p2pIsTxIdle(p2pInfo* p2p)
 {
-    return p2p->cnc.isConnected && !p2p->ack.isWaitingForAck;
+    return p2p->cnc.isConnected && !p2p->ack.isWaitingForAck && (NULL == p2p->win || 0 == p2p->win->txQueue.length);
+}
+
+/**
+ * @brief Allow windowed messages to be sent with p2pSendWinMsg() and received. Both Swadges must call this after
+ * p2pInitialize(). It persists through p2pRestart(), which fails every queued message, and is undone by p2pDeinit()
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ * @param winMsgRxCbFn A function pointer which will be called when a whole windowed message is received
+ * @return true if windowed messages are enabled, false if memory could not be allocated
+ */
+bool p2pEnableWindow(p2pInfo* p2p, p2pWinMsgRxCbFn winMsgRxCbFn)
+{
+    if (NULL == p2p->win)
+    {
+        p2p->win = heap_caps_calloc(1, sizeof(p2pWindow_t), MALLOC_CAP_8BIT);
+        if (NULL == p2p->win)
+        {
+            return false;
+        }
+
+        p2p->win->rxMsg = heap_caps_malloc(P2P_MAX_MSG_LEN, MALLOC_CAP_8BIT);
+        if (NULL == p2p->win->rxMsg)
+        {
+            heap_caps_free(p2p->win);
+            p2p->win = NULL;
+            return false;
+        }
+
+        // Poll the window from the main loop
+        p2p->win->p2p  = p2p;
+        p2p->win->next = p2pWindows;
+        p2pWindows     = p2p->win;
+    }
+    p2p->win->rxCbFn = winMsgRxCbFn;
+    return true;
+}
+
+/**
+ * @brief Queue a windowed message to be sent to the other Swadge. This must not be called before the CON_ESTABLISHED
+ * event occurs, and p2pEnableWindow() must have been called on both Swadges.
+ *
+ * Unlike p2pSendMsg(), this may be called again before the previous message is ACKed. Messages are sent in order, with
+ * several packets in flight at once, and messages longer than one packet are split up and reassembled automatically.
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ * @param payload A byte array to be copied and sent
+ * @param len The length of the byte array, at most ::P2P_MAX_MSG_LEN
+ * @param winMsgTxCbFn A callback function when this whole message is ACKed or dropped. May be NULL
+ * @return true if the message was queued, false if it couldn't be
+ */
+bool p2pSendWinMsg(p2pInfo* p2p, const uint8_t* payload, uint16_t len, p2pWinMsgTxCbFn winMsgTxCbFn)
+{
+    P2P_LOG("%s", __func__);
+
+    if (NULL == p2p->win || !p2p->cnc.isConnected || len > P2P_MAX_MSG_LEN || (NULL == payload && 0 != len))
+    {
+        return false;
+    }
+
+    // Copy the message so the caller doesn't have to keep it around
+    p2pWinTxMsg_t* txMsg = heap_caps_malloc(sizeof(p2pWinTxMsg_t) + len, MALLOC_CAP_8BIT);
+    if (NULL == txMsg)
+    {
+        return false;
+    }
+    txMsg->txCbFn    = winMsgTxCbFn;
+    txMsg->len       = len;
+    txMsg->fragCount = (len == 0) ? 1 : (len + WIN_FRAG_DATA_LEN - 1) / WIN_FRAG_DATA_LEN;
+    txMsg->fragsSent = 0;
+    memcpy(txMsg->data, payload, len);
+
+    push(&p2p->win->txQueue, txMsg);
+
+    // Send as much as the window allows
+    p2pWinFill(p2p);
+    return true;
+}
+
+/**
+ * @brief Free all windowed message state, without calling any callbacks
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pFreeWindow(p2pInfo* p2p)
+{
+    if (NULL != p2p->win)
+    {
+        // Stop polling the window
+        for (p2pWindow_t** link = &p2pWindows; NULL != *link; link = &(*link)->next)
+        {
+            if (*link == p2p->win)
+            {
+                *link = p2p->win->next;
+                break;
+            }
+        }
+
+        p2pWinTxMsg_t* txMsg;
+        while (NULL != (txMsg = shift(&p2p->win->txQueue)))
+        {
+            heap_caps_free(txMsg);
+        }
+        heap_caps_free(p2p->win->rxMsg);
+        heap_caps_free(p2p->win);
+        p2p->win = NULL;
+    }
+}
+
+/**
+ * @brief Drop every windowed packet in flight or being reassembled, and start the sequence numbers over from zero.
+ * Every queued message is reported as ::MSG_FAILED through its callback
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pWinReset(p2pInfo* p2p)
+{
+    p2pWindow_t* win = p2p->win;
+
+    // Take the queue so callbacks can't modify it while it's failed
+    list_t failed = win->txQueue;
+    memset(&win->txQueue, 0, sizeof(win->txQueue));
+
+    // Forget the sequence and ACK state
+    memset(win->tx, 0, sizeof(win->tx));
+    memset(win->rx, 0, sizeof(win->rx));
+    win->txBase        = 0;
+    win->txNext        = 0;
+    win->rxNext        = 0;
+    win->retryAtUs     = 0;
+    win->rxMsgLen      = 0;
+    win->rxMsgOverflow = false;
+    win->resetPending  = false;
+
+    // Report every dropped message
+    p2pWinTxMsg_t* txMsg;
+    while (NULL != (txMsg = shift(&failed)))
+    {
+        if (NULL != txMsg->txCbFn)
+        {
+            txMsg->txCbFn(p2p, MSG_FAILED, txMsg->data, txMsg->len);
+        }
+        heap_caps_free(txMsg);
+    }
+}
+
+/**
+ * @brief Process a received windowed packet
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ * @param msg The received packet
+ * @param len The length of the received packet
+ */
+static void p2pWinRecv(p2pInfo* p2p, const p2pDataMsg_t* msg, uint8_t len)
+{
+    // Every windowed packet has at least one byte after the header
+    if (len <= sizeof(p2pCommonHeader_t))
+    {
+        return;
+    }
+
+    if (P2P_MSG_WIN_DATA == msg->hdr.messageType)
+    {
+        p2pWinRecvData(p2p, msg, len);
+    }
+    else
+    {
+        p2pWinRecvAck(p2p, msg);
+    }
+}
+
+/**
+ * @brief Store a received windowed data packet, deliver any messages which are complete and in order, and ACK it
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ * @param msg The received packet
+ * @param len The length of the received packet
+ */
+static void p2pWinRecvData(p2pInfo* p2p, const p2pDataMsg_t* msg, uint8_t len)
+{
+    p2pWindow_t* win = p2p->win;
+
+    // Packets behind the window were already delivered, and packets past it can't be stored
+    uint8_t offset = msg->hdr.seqNum - win->rxNext;
+    if (offset < P2P_WINDOW_SIZE)
+    {
+        p2pWinSlot_t* slot = &win->rx[msg->hdr.seqNum % P2P_WINDOW_SIZE];
+        if (0 == slot->len)
+        {
+            memcpy(&slot->msg, msg, len);
+            slot->len = len;
+        }
+
+        // Reassemble every packet which is now in order
+        while (0 != (slot = &win->rx[win->rxNext % P2P_WINDOW_SIZE])->len)
+        {
+            uint8_t fragsLeft = slot->msg.data[0];
+            uint8_t fragLen   = slot->len - sizeof(p2pCommonHeader_t) - 1;
+
+            if (win->rxMsgLen + fragLen <= P2P_MAX_MSG_LEN)
+            {
+                memcpy(&win->rxMsg[win->rxMsgLen], &slot->msg.data[1], fragLen);
+                win->rxMsgLen += fragLen;
+            }
+            else
+            {
+                win->rxMsgOverflow = true;
+            }
+
+            slot->len = 0;
+            win->rxNext++;
+
+            if (0 == fragsLeft)
+            {
+                uint16_t rxMsgLen = win->rxMsgLen;
+                bool overflow     = win->rxMsgOverflow;
+                win->rxMsgLen      = 0;
+                win->rxMsgOverflow = false;
+
+                if (overflow)
+                {
+                    ESP_LOGW("P2P", "Dropped a windowed message longer than %d bytes", P2P_MAX_MSG_LEN);
+                }
+                else if (NULL != win->rxCbFn)
+                {
+                    win->rxCbFn(p2p, win->rxMsg, rxMsgLen);
+
+                    // The callback may have deinitialized p2p
+                    if (p2p->win != win)
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    // ACK duplicates too, in case the ACK for the original was lost
+    p2pWinSendAck(p2p);
+}
+
+/**
+ * @brief Send a selective ACK for windowed data packets. The sequence number is the next one expected, and each bit of
+ * the payload byte is set if the packet that many after it was received out of order
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pWinSendAck(p2pInfo* p2p)
+{
+    p2pWindow_t* win = p2p->win;
+
+    p2pDataMsg_t ack;
+    ack.hdr.startByte   = P2P_START_BYTE;
+    ack.hdr.modeId      = p2p->modeId;
+    ack.hdr.messageType = P2P_MSG_WIN_ACK;
+    ack.hdr.seqNum      = win->rxNext;
+    memcpy(ack.hdr.macAddr, p2p->cnc.otherMac, sizeof(ack.hdr.macAddr));
+
+    // The slot for rxNext is always empty, so the other slots fit in one byte
+    ack.data[0] = 0;
+    for (uint8_t i = 1; i < P2P_WINDOW_SIZE; i++)
+    {
+        if (0 != win->rx[(uint8_t)(win->rxNext + i) % P2P_WINDOW_SIZE].len)
+        {
+            ack.data[0] |= (1 << (i - 1));
+        }
+    }
+
+    espNowSend((const char*)&ack, sizeof(p2pCommonHeader_t) + 1);
+}
+
+/**
+ * @brief Process a selective ACK for windowed data packets, complete any messages which were fully ACKed, and send
+ * more packets
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ * @param msg The received ACK
+ */
+static void p2pWinRecvAck(p2pInfo* p2p, const p2pDataMsg_t* msg)
+{
+    p2pWindow_t* win = p2p->win;
+
+    // Ignore ACKs for packets which aren't in flight
+    uint8_t inFlight = win->txNext - win->txBase;
+    uint8_t cumAck   = msg->hdr.seqNum;
+    if ((uint8_t)(cumAck - win->txBase) > inFlight)
+    {
+        return;
+    }
+
+    // Everything before cumAck was received
+    for (uint8_t seq = win->txBase; seq != cumAck; seq++)
+    {
+        win->tx[seq % P2P_WINDOW_SIZE].acked = true;
+    }
+
+    // Some packets after it may have been received too
+    for (uint8_t i = 0; i < P2P_WINDOW_SIZE - 1; i++)
+    {
+        uint8_t seq = cumAck + 1 + i;
+        if ((msg->data[0] & (1 << i)) && (uint8_t)(seq - win->txBase) < inFlight)
+        {
+            win->tx[seq % P2P_WINDOW_SIZE].acked = true;
+        }
+    }
+
+    // Slide the window past every ACKed packet
+    while (win->txBase != win->txNext && win->tx[win->txBase % P2P_WINDOW_SIZE].acked)
+    {
+        p2pWinSlot_t* slot = &win->tx[win->txBase % P2P_WINDOW_SIZE];
+        bool lastFrag      = slot->lastFrag;
+        slot->len          = 0;
+        slot->acked        = false;
+        win->txBase++;
+
+        // Messages are sent in order, so the last packet of a message always completes the oldest one
+        if (lastFrag)
+        {
+            p2pWinTxMsg_t* txMsg = shift(&win->txQueue);
+            if (NULL != txMsg)
+            {
+                if (NULL != txMsg->txCbFn)
+                {
+                    txMsg->txCbFn(p2p, MSG_ACKED, txMsg->data, txMsg->len);
+                }
+                heap_caps_free(txMsg);
+
+                // The callback may have deinitialized p2p
+                if (p2p->win != win)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    // Make room for more packets
+    p2pWinFill(p2p);
+}
+
+/**
+ * @brief Transmit queued packets until the window is full or the queue is empty
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pWinFill(p2pInfo* p2p)
+{
+    p2pWindow_t* win = p2p->win;
+
+    // Find the oldest message which hasn't been fully sent
+    node_t* node = win->txQueue.first;
+    while (NULL != node && ((p2pWinTxMsg_t*)node->val)->fragsSent == ((p2pWinTxMsg_t*)node->val)->fragCount)
+    {
+        node = node->next;
+    }
+
+    while (NULL != node && (uint8_t)(win->txNext - win->txBase) < P2P_WINDOW_SIZE)
+    {
+        p2pWinTxMsg_t* txMsg = node->val;
+        p2pWinSlot_t* slot   = &win->tx[win->txNext % P2P_WINDOW_SIZE];
+
+        // Build the header
+        slot->msg.hdr.startByte   = P2P_START_BYTE;
+        slot->msg.hdr.modeId      = p2p->modeId;
+        slot->msg.hdr.messageType = P2P_MSG_WIN_DATA;
+        slot->msg.hdr.seqNum      = win->txNext;
+        memcpy(slot->msg.hdr.macAddr, p2p->cnc.otherMac, sizeof(slot->msg.hdr.macAddr));
+
+        // Copy the next fragment
+        uint16_t offset = txMsg->fragsSent * WIN_FRAG_DATA_LEN;
+        uint16_t fragLen
+            = (txMsg->len - offset < WIN_FRAG_DATA_LEN) ? (txMsg->len - offset) : WIN_FRAG_DATA_LEN;
+        slot->msg.data[0] = txMsg->fragCount - txMsg->fragsSent - 1;
+        memcpy(&slot->msg.data[1], &txMsg->data[offset], fragLen);
+
+        slot->len         = sizeof(p2pCommonHeader_t) + 1 + fragLen;
+        slot->acked       = false;
+        slot->lastFrag    = (0 == slot->msg.data[0]);
+        slot->firstSentUs = esp_timer_get_time();
+        slot->sentUs      = slot->firstSentUs;
+
+        win->txNext++;
+        txMsg->fragsSent++;
+        if (txMsg->fragsSent == txMsg->fragCount)
+        {
+            node = node->next;
+        }
+
+        espNowSend((const char*)&slot->msg, slot->len);
+    }
+
+    p2pWinArmRetry(p2p);
+}
+
+/**
+ * @brief Schedule the next check for windowed packets to retry if any packets are in flight and none is scheduled
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pWinArmRetry(p2pInfo* p2p)
+{
+    p2pWindow_t* win = p2p->win;
+    if (0 == win->retryAtUs && win->txBase != win->txNext)
+    {
+        win->retryAtUs = esp_timer_get_time() + WIN_RETRY_US;
+    }
+}
+
+/**
+ * @brief Send windowed packets which weren't ACKed in time again. If the oldest one has been retried for too long,
+ * fail every queued message and restart p2p
+ *
+ * @param p2p The p2pInfo struct with all the state information
+ */
+static void p2pWinRetry(p2pInfo* p2p)
+{
+    p2pWindow_t* win = p2p->win;
+    win->retryAtUs   = 0;
+
+    int64_t now = esp_timer_get_time();
+
+    if (win->txBase != win->txNext && now - win->tx[win->txBase % P2P_WINDOW_SIZE].firstSentUs > RETRY_TIME_US)
+    {
+        P2P_LOG("Windowed message totally failed");
+
+        // The other Swadge can't know which packets were dropped, so start over. Either way, every queued message fails
+        if (p2p->cnc.isActive)
+        {
+            p2pRestart(p2p);
+
+            // The CON_LOST callback may have deinitialized p2p
+            if (p2p->win != win)
+            {
+                return;
+            }
+        }
+        p2pWinReset(p2p);
+        return;
+    }
+
+    // Retry every packet which hasn't been ACKed in time
+    for (uint8_t seq = win->txBase; seq != win->txNext; seq++)
+    {
+        p2pWinSlot_t* slot = &win->tx[seq % P2P_WINDOW_SIZE];
+        if (!slot->acked && now - slot->sentUs >= WIN_RETRY_US)
+        {
+            slot->sentUs = now;
+            espNowSend((const char*)&slot->msg, slot->len);
+        }
+    }
+
+    p2pWinArmRetry(p2p);
+}
+
+/**
+ * @brief Retry windowed packets which weren't ACKed in time, and finish restarts, for every p2p connection with windowed
+ * messages enabled. The system calls this from the main loop after receiving ESP-NOW packets, so windowed messages and
+ * their callbacks are only ever handled on the main loop, never from a timer
+ */
+void p2pPollWindows(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    p2pWindow_t* win = p2pWindows;
+    while (NULL != win)
+    {
+        // Callbacks may deinitialize p2p, which unlinks the window, so find the next one first
+        p2pWindow_t* next = win->next;
+        p2pInfo* p2p      = win->p2p;
+
+        // p2pRestart() may be detaching and reattaching the window from a timer
+        if (p2p->win == win)
+        {
+            if (win->resetPending)
+            {
+                p2pWinReset(p2p);
+            }
+            else if (0 != win->retryAtUs && now >= win->retryAtUs)
+            {
+                p2pWinRetry(p2p);
+            }
+        }
+        win = next;
+    }
 }
 
 /**
@@ -119,7 +119,29 @@
  * -# p2pSendMsg() does not queue messages, so if you try to send multiple messages without first receiving the transmit
  * callback (#p2pMsgTxCbFn), then only the last sent message will be sent successfully. Instead, you should either
  * combine data into a single packet (which is preferred, fewer larger packets tend to be faster) or wait for a
- * transmission to completely finish before starting the next.
+ * transmission to completely finish before starting the next. Windowed messages, described below, are queued.
+ *
+ * \section p2p_window Windowed Messages
+ *
+ * p2pSendMsg() is stop-and-wait: only one message is in flight, and the next may only be sent after the previous one is
+ * acknowledged. For higher throughput, both Swadges may call p2pEnableWindow() after initializing p2p, then send with
+ * p2pSendWinMsg() instead.
+ *
+ * Windowed messages are queued, and up to ::P2P_WINDOW_SIZE packets are in flight at once. Each packet has its own
+ * sequence number. The receiver acknowledges every packet with the next sequence number it expects and a bitmask of
+ * the later packets it has already received, so only packets which were actually lost are sent again. Messages up to
+ * ::P2P_MAX_MSG_LEN bytes long are split into as many packets as needed, and are delivered whole and in order to the
+ * #p2pWinMsgRxCbFn.
+ *
+ * If a windowed packet isn't acknowledged within a few seconds, every queued message fails and p2p restarts, because
+ * the two Swadges can no longer agree on which messages were delivered. Queued messages which are dropped by a restart
+ * are reported as ::MSG_FAILED through their #p2pWinMsgTxCbFn. Sequence numbers start over whenever a connection is
+ * established, so a Swadge which restarted can talk to one which didn't. p2pDeinit() frees queued messages without
+ * calling back. Windowed messages do not carry data in ACKs.
+ *
+ * Retries and restarts of windowed messages are handled by p2pPollWindows(), which the system calls from the main loop
+ * after receiving packets. Windowed callbacks are always called from the main loop, even when p2pRestart() is called
+ * from a timer, in which case queued messages fail on the next main loop iteration.
  *
  * \section p2p_example Example
  *
@@ -194,6 +216,12 @@
 /// The maximum payload of a p2p packet is 245 bytes
 #define P2P_MAX_DATA_LEN 245
 
+/// The number of windowed packets which may be in flight at once
+#define P2P_WINDOW_SIZE 8
+
+/// The maximum length of a windowed message, which is split into as many packets as needed
+#define P2P_MAX_MSG_LEN 4096
+
 /// After connecting, one Swadge will be ::GOING_FIRST and one will be ::GOING_SECOND
 typedef enum
 {
@@ -249,6 +277,25 @@ typedef void (*p2pMsgRxCbFn)(p2pInfo* p2p, const uint8_t* payload, uint8_t len);
  */
 typedef void (*p2pMsgTxCbFn)(p2pInfo* p2p, messageStatus_t status, const uint8_t* data, uint8_t len);
 
+/**
+ * @brief This typedef is for the function callback which delivers received windowed messages to the Swadge mode
+ *
+ * @param p2p The p2pInfo
+ * @param payload The whole message that was received
+ * @param len The length of the message that was received
+ */
+typedef void (*p2pWinMsgRxCbFn)(p2pInfo* p2p, const uint8_t* payload, uint16_t len);
+
+/**
+ * @brief This typedef is for the function callback which delivers the status of a windowed message to the Swadge mode
+ *
+ * @param p2p The p2pInfo
+ * @param status The status of the transmission
+ * @param data The message that was transmitted
+ * @param len The length of the message that was transmitted
+ */
+typedef void (*p2pWinMsgTxCbFn)(p2pInfo* p2p, messageStatus_t status, const uint8_t* data, uint16_t len);
+
 /**
  * @brief This typedef is for a function callback called when a message is acknowledged.
  * It make also contain a data packet which was appended to the ACK.
@@ -270,7 +317,7 @@ typedef void (*p2pAckFailureFn)(p2pInfo* p2p);
 #define P2P_START_BYTE 'p'
 
 /**
- * @brief The five different types of p2p messages
+ * @brief The seven different types of p2p messages
  */
 typedef enum __attribute__((packed))
 {
@@ -278,7 +325,9 @@ typedef enum __attribute__((packed))
     P2P_MSG_START,    ///< The start message, used during connection
     P2P_MSG_ACK,      ///< An acknowledge message
     P2P_MSG_DATA_ACK, ///< An acknowledge message with extra data
-    P2P_MSG_DATA      ///< A data message
+    P2P_MSG_DATA,     ///< A data message
+    P2P_MSG_WIN_DATA, ///< A windowed data packet, which may be one fragment of a larger message
+    P2P_MSG_WIN_ACK,  ///< A selective acknowledge for windowed data packets
 } p2pMsgType_t;
 
 /**
@@ -312,6 +361,9 @@ typedef struct
     uint8_t data[P2P_MAX_DATA_LEN]; ///< The data bytes sent or received
 } p2pDataMsg_t;
 
+/// State for windowed messages, see p2pEnableWindow()
+typedef struct p2pWindow p2pWindow_t;
+
 /**
  * @brief All the state variables required for a P2P session with another Swadge
  */
@@ -374,6 +426,8 @@ typedef struct _p2pInfo
         esp_timer_handle_t Connection;   ///< A timer used to cancel a connection if the handshake fails
         esp_timer_handle_t Reinit;       ///< A timer used to restart P2P after any complete failures
     } tmr;
+
+    p2pWindow_t* win; ///< State for windowed messages, or NULL if p2pEnableWindow() wasn't called
 } p2pInfo;
 
 /**
@@ -401,6 +455,10 @@ void p2pSetDataInAck(p2pInfo* p2p, const uint8_t* ackData, uint8_t ackDataLen);
 void p2pClearDataInAck(p2pInfo* p2p);
 bool p2pIsTxIdle(p2pInfo* p2p);
 
+bool p2pEnableWindow(p2pInfo* p2p, p2pWinMsgRxCbFn winMsgRxCbFn);
+bool p2pSendWinMsg(p2pInfo* p2p, const uint8_t* payload, uint16_t len, p2pWinMsgTxCbFn winMsgTxCbFn);
+void p2pPollWindows(void);
+
 playOrder_t p2pGetPlayOrder(p2pInfo* p2p);
 void p2pSetPlayOrder(p2pInfo* p2p, playOrder_t order);
 
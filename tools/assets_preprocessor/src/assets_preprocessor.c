@@ -7,6 +7,7 @@
 #include <ftw.h>
 #include <getopt.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -53,6 +54,44 @@ static const assetProcessor_t* allAssetProcessors[] = {
 // END Asset Processor List
 //==============================================================================
 
+//==============================================================================
+// Defines
+//==============================================================================
+
+/// Change this whenever the preprocessor's output changes, so every asset in the manifest is regenerated
+#define MANIFEST_VERSION "assets-manifest-2"
+
+/// The maximum number of threads to process assets with
+#define MAX_THREADS 64
+
+//==============================================================================
+// Structs
+//==============================================================================
+
+/**
+ * @brief A single input file to be processed into an output file
+ */
+typedef struct
+{
+    char inFile[256];                 ///< The path to the input file
+    char outFile[256];                ///< The path to the output file
+    char optionsFilename[256];        ///< The path to the options file, if hasOptions is true
+    bool hasOptions;                  ///< Whether an options file applies to this input
+    const fileProcessorMap_t* extMap; ///< The extension mapping which matched the input file
+    long size;                        ///< The size of the input file, used to schedule large files first
+    uint64_t hash;                    ///< The content hash of the input file, options, and processor
+    bool done;                        ///< Whether the output is up to date with hash after processing
+} assetJob_t;
+
+/**
+ * @brief The content hash an output file was last generated from
+ */
+typedef struct
+{
+    uint64_t hash;  ///< The content hash of the input file, options, and processor
+    char name[256]; ///< The filename of the output file, without the output directory
+} manifestEntry_t;
+
 //==============================================================================
 // Variables
 //==============================================================================
@@ -67,6 +106,15 @@ const processorOptions_t* globalConfig = NULL;
 static const fileProcessorMap_t* loadedExtMappings = NULL;
 static size_t loadedExtMappingCount                = 0;
 
+static assetJob_t* jobs         = NULL;
+static size_t jobCount          = 0;
+static size_t jobCapacity       = 0;
+static size_t nextJob           = 0;
+static pthread_mutex_t jobMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static manifestEntry_t* manifest = NULL;
+static size_t manifestCount      = 0;
+
 //==============================================================================
 // Function declarations
 //==============================================================================
@@ -95,7 +143,7 @@ static const char optionsFileExtension[] = "opts";
 void print_usage(void)
 {
     printf("Usage:\n  assets_preprocessor\n    -i INPUT_DIRECTORY\n    -o OUTPUT_DIRECTORY\n    [-t "
-           "TIMESTAMP_FILE_OUTPUT]\n    [-c CONFIG_FILE]\n    [-v]\n");
+           "TIMESTAMP_FILE_OUTPUT]\n    [-m MANIFEST_FILE]\n    [-c CONFIG_FILE]\n    [-j THREADS]\n    [-r]\n    [-v]\n");
     printf("\n All Asset processors:\n");
     for (int n = 0; n < sizeof(allAssetProcessors) / sizeof(*allAssetProcessors); n++)
     {
@@ -132,563 +180,949 @@ bool endsWith(const char* filename, const char* suffix)
 }
 
 /**
- * @brief TODO
+ * @brief Find the options file which applies to an input file
  *
- * @param fpath
- * @param st
- * @param tflag
- * @return int
+ * This is the input file with its extension replaced by `.opts` if it exists, or else the closest `.opts` file in the
+ * input file's directory or any parent directory within the input directory.
+ *
+ * @param optionsFilename A buffer to write the options file path to
+ * @param size The size of the optionsFilename buffer
+ * @param inFile The input file path
+ * @param inExt The input file extension, without a leading '.'
+ * @return true if an options file was found
+ * @return false if no options file applies to this input file
+ */
+static bool findOptionsFile(char* optionsFilename, size_t size, const char* inFile, const char* inExt)
+{
+    // Add the whole input file path to the buffer
+    strncpy(optionsFilename, inFile, size - 1);
+
+    // Clip off the input extension
+    optionsFilename[strlen(optionsFilename) - strlen(inExt)] = '\0';
+
+    // And append the options file extension
+    strcat(optionsFilename, optionsFileExtension);
+
+    // Now, check if the options filename exists
+    bool hasOptions = doesFileExist(optionsFilename);
+
+    if (!hasOptions)
+    {
+        // First, just remove the filename and replace it with the opts extension
+        // This should be guaranteed to be inside the assets dir still...
+        char* lastSlash  = strrchr(optionsFilename, '/');
+        *(lastSlash + 1) = '\0';
+        strcat(optionsFilename, ".");
+        strcat(optionsFilename, optionsFileExtension);
+
+        hasOptions = doesFileExist(optionsFilename);
+        if (!hasOptions)
+        {
+            do
+            {
+                // Trim the first slash, of "/.opts"
+                lastSlash  = strrchr(optionsFilename, '/');
+                *lastSlash = '\0';
+                // Find the next previous slash
+                lastSlash = strrchr(optionsFilename, '/');
+                if (!lastSlash)
+                {
+                    // Reached the top of a relative input directory
+                    break;
+                }
+                // Chop the string after it
+                *(lastSlash + 1) = '\0';
+                // And append the options extension
+                strcat(optionsFilename, ".");
+                strcat(optionsFilename, optionsFileExtension);
+                // Then, at the end of the loop, first we make sure the new filename is still inside
+                // the assets directory. We don't want to touch anything outside the input directory!
+                // Next, if that's true, we set hasOptions based on if the file exists and exit if so
+            } while (startsWith(optionsFilename, inDirName) && !(hasOptions = doesFileExist(optionsFilename)));
+        }
+    }
+
+    return hasOptions;
+}
+
+/**
+ * @brief ftw() callback which queues a job for each input file matching an extension mapping
+ *
+ * Nothing is processed here. Jobs are run by the worker threads after the whole tree has been walked.
+ *
+ * @param inFile The path of the file or directory being visited
+ * @param st The stat() result for inFile
+ * @param tflag The type of entry being visited
+ * @return int 0 to continue walking the tree, or -1 to stop
  */
-static int processFile(const char* inFile, const struct stat* st __attribute__((unused)), int tflag)
+static int queueFile(const char* inFile, const struct stat* st, int tflag)
 {
     if (FTW_F == tflag)
     {
-        char extBuf[16]           = {0};
-        char outFile[256]         = {0};
-        char optionsFilename[256] = {0};
+        char extBuf[16] = {0};
 
         for (size_t i = 0; i < loadedExtMappingCount; i++)
         {
-            const fileProcessorMap_t* extMap  = &loadedExtMappings[i];
-            const assetProcessor_t* processor = extMap->processor;
+            const fileProcessorMap_t* extMap = &loadedExtMappings[i];
 
             snprintf(extBuf, sizeof(extBuf), ".%s", extMap->inExt);
 
             if (endsWith(inFile, extBuf))
             {
                 // This is the matching processor!
-                // Calculate the outFile name (replace the extension) and
+                if (jobCount == jobCapacity)
+                {
+                    size_t newCapacity  = jobCapacity ? jobCapacity * 2 : 256;
+                    assetJob_t* newJobs = realloc(jobs, newCapacity * sizeof(assetJob_t));
+                    if (!newJobs)
+                    {
+                        fprintf(stderr, "[assets-preprocessor] Out of memory queueing %s\n", inFile);
+                        return -1;
+                    }
+                    jobs        = newJobs;
+                    jobCapacity = newCapacity;
+                }
+
+                assetJob_t* job = &jobs[jobCount];
+                memset(job, 0, sizeof(assetJob_t));
+                job->extMap = extMap;
+                job->size   = st->st_size;
+                strncpy(job->inFile, inFile, sizeof(job->inFile) - 1);
 
-                strcat(outFile, outDirName);
-                // strcat(outFile, "/");
-                strcat(outFile, get_filename(inFile));
+                // Calculate the outFile name (replace the extension)
+                strcat(job->outFile, outDirName);
+                strcat(job->outFile, get_filename(inFile));
 
                 // Clip off the input file extension
-                outFile[strlen(outFile) - strlen(extMap->inExt)] = '\0';
+                job->outFile[strlen(job->outFile) - strlen(extMap->inExt)] = '\0';
 
                 // Add the output file extension
-                strcat(outFile, extMap->outExt);
-
-                // Now, construct the options filename
-
-                // Add the whole input file path to the buffer
-                strncpy(optionsFilename, inFile, sizeof(optionsFilename));
-
-                // Clip off the input extension  again
-                optionsFilename[strlen(optionsFilename) - strlen(extMap->inExt)] = '\0';
-
-                // And append the options file extension
-                strcat(optionsFilename, optionsFileExtension);
+                strcat(job->outFile, extMap->outExt);
 
-                // Now, check if the options filename exists
-                bool hasOptions = doesFileExist(optionsFilename);
+                job->hasOptions = findOptionsFile(job->optionsFilename, sizeof(job->optionsFilename), inFile,
+                                                  extMap->inExt);
 
-                if (!hasOptions)
+                // Two inputs with the same name in different directories would be written to the same output file
+                // by different threads. Only the last one found was ever kept, so just replace the earlier job.
+                for (size_t n = 0; n < jobCount; n++)
                 {
-                    // First, just remove the filename and replace it with the opts extension
-                    // This should be guaranteed to be inside the assets dir still...
-                    char* lastSlash  = strrchr(optionsFilename, '/');
-                    *(lastSlash + 1) = '\0';
-                    strcat(optionsFilename, ".");
-                    strcat(optionsFilename, optionsFileExtension);
-
-                    hasOptions = doesFileExist(optionsFilename);
-                    if (!hasOptions)
+                    if (!strcmp(jobs[n].outFile, job->outFile))
                     {
-                        do
+                        if (verbose)
                         {
-                            // Trim the first slash, of "/.opts"
-                            lastSlash  = strrchr(optionsFilename, '/');
-                            *lastSlash = '\0';
-                            // Find the next previous slash
-                            lastSlash = strrchr(optionsFilename, '/');
-                            // Chop the string after it
-                            *(lastSlash + 1) = '\0';
-                            // And append the options extension
-                            strcat(optionsFilename, ".");
-                            strcat(optionsFilename, optionsFileExtension);
-                            // Then, at the end of the loop, first we make sure the new filename is still inside
-                            // the assets directory. We don't want to touch anything outside the input directory!
-                            // Next, if that's true, we set hasOptions based on if the file exists and exit if so
-                        } while (startsWith(optionsFilename, inDirName)
-                                 && !(hasOptions = doesFileExist(optionsFilename)));
+                            printf("[%s] DUP %s replaces %s -> %s\n", extMap->inExt, get_filename(inFile),
+                                   get_filename(jobs[n].inFile), get_filename(job->outFile));
+                        }
+                        memcpy(&jobs[n], job, sizeof(assetJob_t));
+                        return 0;
                     }
                 }
 
-                // And if the options file has been modified since the output was generated,
-                // regenerate it the same as though the source file was modified
-                bool optionsModified = hasOptions && isSourceFileNewer(optionsFilename, outFile);
-                bool inFileModified  = isSourceFileNewer(inFile, outFile);
+                jobCount++;
+                break;
+            }
+        }
+    }
+    else if (FTW_D != tflag)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sort jobs so the largest input files are processed first, which keeps all the threads busy until the end
+ *
+ * @param a A pointer to an ::assetJob_t
+ * @param b A pointer to an ::assetJob_t
+ * @return int The sort order of a and b
+ */
+static int jobSizeCmp(const void* a, const void* b)
+{
+    const assetJob_t* jobA = a;
+    const assetJob_t* jobB = b;
+
+    if (jobA->size != jobB->size)
+    {
+        return (jobA->size > jobB->size) ? -1 : 1;
+    }
+    return strcmp(jobA->inFile, jobB->inFile);
+}
+
+/**
+ * @brief Sort manifest entries by output file name
+ *
+ * @param a A pointer to a ::manifestEntry_t
+ * @param b A pointer to a ::manifestEntry_t
+ * @return int The sort order of a and b
+ */
+static int manifestEntryCmp(const void* a, const void* b)
+{
+    return strcmp(((const manifestEntry_t*)a)->name, ((const manifestEntry_t*)b)->name);
+}
+
+/**
+ * @brief Load the content hashes of the last run from the manifest file
+ *
+ * A missing manifest is not an error, every output is then checked by its modification time instead.
+ *
+ * @param fpath The path to the manifest file
+ */
+static void loadManifest(const char* fpath)
+{
+    FILE* in = fopen(fpath, "r");
+    if (!in)
+    {
+        return;
+    }
+
+    char line[512];
+    size_t capacity = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        // Each line is "<hash> <output filename>"
+        char* name    = NULL;
+        uint64_t hash = strtoull(line, &name, 16);
+        if (name == line || *name != ' ')
+        {
+            continue;
+        }
+        name++;
+        name[strcspn(name, "\r\n")] = '\0';
+
+        if (manifestCount == capacity)
+        {
+            capacity                    = capacity ? capacity * 2 : 256;
+            manifestEntry_t* newEntries = realloc(manifest, capacity * sizeof(manifestEntry_t));
+            if (!newEntries)
+            {
+                break;
+            }
+            manifest = newEntries;
+        }
+
+        manifest[manifestCount].hash = hash;
+        strncpy(manifest[manifestCount].name, name, sizeof(manifest[manifestCount].name) - 1);
+        manifest[manifestCount].name[sizeof(manifest[manifestCount].name) - 1] = '\0';
+        manifestCount++;
+    }
+
+    fclose(in);
+
+    qsort(manifest, manifestCount, sizeof(manifestEntry_t), manifestEntryCmp);
+}
+
+/**
+ * @brief Find the manifest entry for an output file
+ *
+ * @param outFile The path to the output file
+ * @return const manifestEntry_t* The entry from the last run, or NULL if there isn't one
+ */
+static const manifestEntry_t* findManifestEntry(const char* outFile)
+{
+    manifestEntry_t key = {0};
+    strncpy(key.name, get_filename(outFile), sizeof(key.name) - 1);
+    return bsearch(&key, manifest, manifestCount, sizeof(manifestEntry_t), manifestEntryCmp);
+}
+
+/**
+ * @brief Write the content hash of every up-to-date output to the manifest file, then free the loaded manifest
+ *
+ * Outputs which failed to process are left out so they are retried next time. The manifest is written to a temporary
+ * file first so an interrupted build never leaves a truncated manifest behind.
+ *
+ * @param fpath The path to the manifest file
+ * @return int 0 if the manifest was written, or -1 if there was an error
+ */
+static int writeManifest(const char* fpath)
+{
+    free(manifest);
+    manifest      = NULL;
+    manifestCount = 0;
+
+    manifestEntry_t* entries = calloc(jobCount ? jobCount : 1, sizeof(manifestEntry_t));
+    if (!entries)
+    {
+        return -1;
+    }
+
+    size_t entryCount = 0;
+    for (size_t i = 0; i < jobCount; i++)
+    {
+        if (jobs[i].done)
+        {
+            entries[entryCount].hash = jobs[i].hash;
+            strncpy(entries[entryCount].name, get_filename(jobs[i].outFile), sizeof(entries[entryCount].name) - 1);
+            entryCount++;
+        }
+    }
+
+    // Sort so the manifest doesn't change between runs with the same results
+    qsort(entries, entryCount, sizeof(manifestEntry_t), manifestEntryCmp);
+
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", fpath);
+
+    FILE* out = fopen(tmpPath, "w");
+    if (NULL == out)
+    {
+        free(entries);
+        return -1;
+    }
+
+    for (size_t i = 0; i < entryCount; i++)
+    {
+        fprintf(out, "%016" PRIx64 " %s\n", entries[i].hash, entries[i].name);
+    }
+
+    free(entries);
 
-                if (!inFileModified && !optionsModified)
+    if (0 != fclose(out))
+    {
+        deleteFile(tmpPath);
+        return -1;
+    }
+
+    // rename() can't replace an existing file on Windows
+    if (0 != rename(tmpPath, fpath) && (0 != remove(fpath) || 0 != rename(tmpPath, fpath)))
+    {
+        deleteFile(tmpPath);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Hash everything which affects a job's output: the input file, its options file, and the processor
+ *
+ * @param job The job to hash. The result is written to job->hash
+ * @return true if the hash was calculated
+ * @return false if the input or options file couldn't be read
+ */
+static bool hashJob(assetJob_t* job)
+{
+    const fileProcessorMap_t* extMap  = job->extMap;
+    const assetProcessor_t* processor = extMap->processor;
+    uint64_t hash                     = FNV_OFFSET_BASIS;
+
+    // Strings are hashed with their NUL terminators so adjacent fields can't run together
+    hash = hashBytes(hash, MANIFEST_VERSION, sizeof(MANIFEST_VERSION));
+    hash = hashBytes(hash, processor->name, strlen(processor->name) + 1);
+    hash = hashBytes(hash, &processor->type, sizeof(processor->type));
+    hash = hashBytes(hash, extMap->inExt, strlen(extMap->inExt) + 1);
+    hash = hashBytes(hash, extMap->outExt, strlen(extMap->outExt) + 1);
+
+    // The compression profile from the config, since the config file itself isn't hashed
+    uint8_t compression[]
+        = {extMap->compression.stored, extMap->compression.windowBits, extMap->compression.lookaheadBits};
+
+    hash = hashBytes(hash, compression, sizeof(compression));
+
+    if (!hashFile(&hash, job->inFile))
+    {
+        return false;
+    }
+
+    if (job->hasOptions)
+    {
+        // Mark whether there is an options file, so an empty one still changes the hash
+        hash = hashBytes(hash, "opts", sizeof("opts"));
+        if (!hashFile(&hash, job->optionsFilename))
+        {
+            return false;
+        }
+    }
+
+    job->hash = hash;
+    return true;
+}
+
+/**
+ * @brief Process a single input file into its output file, unless the output is already up to date
+ *
+ * With a manifest, the output is up to date when it exists and the content hash matches the last run's. Outputs
+ * without a manifest entry fall back to comparing modification times.
+ *
+ * @param job The job to process
+ */
+static void processJob(assetJob_t* job)
+{
+    const fileProcessorMap_t* extMap  = job->extMap;
+    const assetProcessor_t* processor = extMap->processor;
+    const char* inFile                = job->inFile;
+    const char* outFile               = job->outFile;
+    const char* optionsFilename       = job->optionsFilename;
+    bool hasOptions                   = job->hasOptions;
+
+    // If the options file has been modified since the output was generated,
+    // regenerate it the same as though the source file was modified
+    bool optionsModified = hasOptions && isSourceFileNewer(optionsFilename, outFile);
+    bool inFileModified  = isSourceFileNewer(inFile, outFile);
+    bool hashed          = hashJob(job);
+    bool upToDate        = !inFileModified && !optionsModified;
+
+    if (hashed && doesFileExist(outFile))
+    {
+        const manifestEntry_t* entry = findManifestEntry(outFile);
+        if (entry)
+        {
+            // A touched file with the same contents is still up to date, and an older file restored over a newer
+            // one is not, so the hash overrides the modification times
+            upToDate = (entry->hash == job->hash);
+        }
+    }
+
+    if (upToDate && hashed)
+    {
+        if (verbose)
+        {
+            printf("[%s] SKIP %s -> %s\n", extMap->inExt, get_filename(inFile), get_filename(outFile));
+        }
+        job->done = true;
+        return;
+    }
+    else if (doesFileExist(outFile))
+    {
+        printf("[assets-preprocessor] %s modified! Regenerating %s\n",
+               (optionsModified && !inFileModified) ? (optionsFilename + strlen(inDirName)) : get_filename(inFile),
+               get_filename(outFile));
+    }
+
+    pthread_mutex_lock(&jobMutex);
+    filesUpdated++;
+    pthread_mutex_unlock(&jobMutex);
+
+    bool result    = false;
+    bool readError = false;
+
+    if (FUNCTION == processor->type)
+    {
+        FILE* inHandle             = NULL;
+        FILE* outHandle            = NULL;
+        processorFileData_t inData = {0};
+        processorFileData_t outData = {0};
+
+        switch (processor->inFmt)
+        {
+            case FMT_FILE:
+            case FMT_TEXT:
+            case FMT_LINES:
+            {
+                inHandle = fopen(inFile, "r");
+                break;
+            }
+
+            case FMT_FILE_BIN:
+            case FMT_DATA:
+            case FMT_FILENAME:
+            {
+                inHandle = fopen(inFile, "rb");
+                break;
+            }
+        }
+
+        if (!inHandle)
+        {
+            fprintf(stderr, "[%s] FAILED! Cannot open input file '%s'\n", extMap->inExt, inFile);
+            return;
+        }
+
+        const char * outFileName = NULL;
+
+        switch (processor->outFmt)
+        {
+            case FMT_FILE:
+            case FMT_TEXT:
+            case FMT_LINES:
+            {
+                outHandle = fopen(outFile, "w");
+                outData = (processorFileData_t){ .file = outHandle };
+                break;
+            }
+
+            case FMT_FILENAME:
+            {
+                outFileName = outFile;
+                outData = (processorFileData_t){ .fileName = outFileName };
+                break;
+            }
+
+            case FMT_FILE_BIN:
+            case FMT_DATA:
+            {
+                outHandle = fopen(outFile, "wb");
+                outData = (processorFileData_t){ .file = outHandle };
+                break;
+            }
+        }
+
+        if (!outHandle && !outFileName)
+        {
+            fprintf(stderr, "[%s] FAILED! Cannot open output file '%s'\n", extMap->inExt, outFile);
+            fclose(inHandle);
+            return;
+        }
+
+        // Input and output files have been opened!
+        // Now, handle any extra processing for the input:
+        switch (processor->inFmt)
+        {
+            case FMT_FILE:
+            case FMT_FILE_BIN:
+            {
+                inData.file = inHandle;
+                break;
+            }
+
+            case FMT_FILENAME:
+            {
+                inData.fileName = inFile;
+                break;
+            }
+
+            case FMT_TEXT:
+            case FMT_DATA:
+            {
+                // Open file, read text
+                bool binFile = (processor->inFmt == FMT_DATA);
+                fseek(inHandle, 0L, SEEK_END);
+                long size = ftell(inHandle);
+                fseek(inHandle, 0L, SEEK_SET);
+
+                char* data = malloc(size + (binFile ? 0 : 1));
+
+                if (!data)
                 {
-                    if (verbose)
-                    {
-                        printf("[%s] SKIP %s -> %s\n", extMap->inExt, get_filename(inFile), get_filename(outFile));
-                    }
+                    readError = true;
                     break;
                 }
-                else if (doesFileExist(outFile))
-                {
-                    printf("[assets-preprocessor] %s modified! Regenerating %s\n",
-                           (!inFileModified) ? (optionsFilename + strlen(inDirName)) : get_filename(inFile),
-                           get_filename(outFile));
-                }
-                filesUpdated++;
 
-                bool result    = false;
-                bool readError = false;
+                fread(data, size, 1, inHandle);
 
-                if (FUNCTION == processor->type)
+                if (binFile)
                 {
-                    FILE* inHandle             = NULL;
-                    FILE* outHandle            = NULL;
-                    processorFileData_t inData = {0};
-                    processorFileData_t outData = {0};
+                    inData.data   = (uint8_t*)data;
+                    inData.length = size;
+                }
+                else
+                {
+                    data[size]      = '\0';
+                    inData.text     = data;
+                    inData.textSize = size + 1;
+                }
+                break;
+            }
 
-                    switch (processor->inFmt)
+            case FMT_LINES:
+            {
+                int lines = 0;
+                int last  = 0;
+                int ch    = 0;
+                long size = 0;
+                while (-1 != (ch = getc(inHandle)))
+                {
+                    switch (ch)
                     {
-                        case FMT_FILE:
-                        case FMT_TEXT:
-                        case FMT_LINES:
+                        case '\n':
                         {
-                            inHandle = fopen(inFile, "r");
+                            lines++;
                             break;
                         }
 
-                        case FMT_FILE_BIN:
-                        case FMT_DATA:
-                        case FMT_FILENAME:
-                        {
-                            inHandle = fopen(inFile, "rb");
+                        default:
                             break;
-                        }
                     }
 
-                    if (!inHandle)
-                    {
-                        fprintf(stderr, "[%s] FAILED! Cannot open input file '%s'\n", extMap->inExt, inFile);
-                        break;
-                    }
-
-                    const char * outFileName = NULL;
-
-                    switch (processor->outFmt)
-                    {
-                        case FMT_FILE:
-                        case FMT_TEXT:
-                        case FMT_LINES:
-                        {
-                            outHandle = fopen(outFile, "w");
-                            outData = (processorFileData_t){ .file = outHandle };
-                            break;
-                        }
+                    last = ch;
+                    size++;
+                }
 
-                        case FMT_FILENAME:
-                        {
-                            outFileName = outFile;
-                            outData = (processorFileData_t){ .fileName = outFileName };
-                            break;
-                        }
+                // Handle when a file doesn't end with a newline
+                if ('\n' != last)
+                {
+                    lines++;
+                }
 
-                        case FMT_FILE_BIN:
-                        case FMT_DATA:
-                        {
-                            outHandle = fopen(outFile, "wb");
-                            outData = (processorFileData_t){ .file = outHandle };
-                            break;
-                        }
-                    }
+                // Go back to the beginning for real reading
+                fseek(inHandle, 0L, SEEK_SET);
 
-                    if (!outHandle && !outFileName)
-                    {
-                        fprintf(stderr, "[%s] FAILED! Cannot open output file '%s'\n", extMap->inExt, outFile);
-                        break;
-                    }
+                char* data = (char*)malloc(size + 1);
+                if (!data)
+                {
+                    readError = true;
+                    break;
+                }
 
-                    // Input and output files have been opened!
-                    // Now, handle any extra processing for the input:
-                    switch (processor->inFmt)
+                char** lineList = malloc(lines * sizeof(char*));
+                if (!lineList)
+                {
+                    free(data);
+                    readError = true;
+                    break;
+                }
+                fread(data, size, 1, inHandle);
+                fclose(inHandle);
+                inHandle = NULL;
+
+                int outLine     = 0;
+                char* cur       = data;
+                const char* end = data + size;
+                char* lineStart = cur;
+                while (cur < end)
+                {
+                    switch (*cur)
                     {
-                        case FMT_FILE:
-                        case FMT_FILE_BIN:
+                        case '\r':
                         {
-                            inData.file = inHandle;
+                            if (cur + 1 < end && *(cur + 1) == '\n')
+                            {
+                                *cur = '\0';
+                            }
                             break;
                         }
 
-                        case FMT_FILENAME:
+                        case '\n':
                         {
-                            inData.fileName = inFile;
+                            *cur                = '\0';
+                            lineList[outLine++] = lineStart;
+                            lineStart           = NULL;
+
                             break;
                         }
 
-                        case FMT_TEXT:
-                        case FMT_DATA:
+                        default:
                         {
-                            // Open file, read text
-                            bool binFile = (processor->inFmt == FMT_DATA);
-                            fseek(inHandle, 0L, SEEK_END);
-                            long size = ftell(inHandle);
-                            fseek(inHandle, 0L, SEEK_SET);
-
-                            char* data = malloc(size + (binFile ? 0 : 1));
-
-                            if (!data)
+                            if (!lineStart)
                             {
-                                readError = true;
-                                break;
+                                lineStart = cur;
                             }
+                        }
+                    }
+                    cur++;
+                }
+                *cur = '\0';
 
-                            fread(data, size, 1, inHandle);
+                inData.lines     = lineList;
+                inData.lineCount = lines;
+                break;
+            }
+        }
 
-                            if (binFile)
-                            {
-                                inData.data   = (uint8_t*)data;
-                                inData.length = size;
-                            }
-                            else
-                            {
-                                data[size]      = '\0';
-                                inData.text     = data;
-                                inData.textSize = size + 1;
-                            }
-                            break;
-                        }
+        processorOptions_t options = {0};
+        if (hasOptions)
+        {
+            if (getOptionsFromIniFile(&options, optionsFilename))
+            {
+                if (verbose)
+                {
+                    printf("[%s] OPTS %s <- %s (%" PRIu32 ")\n", extMap->inExt, get_filename(inFile),
+                           optionsFilename + strlen(inDirName), (uint32_t)options.optionCount);
+                }
+            }
+            else
+            {
+                if (verbose)
+                {
+                    fprintf(
+                        stderr,
+                        "[WRN] Options file %s exists but contains no options! Is it a valid INI file?\n",
+                        optionsFilename);
+                }
+                hasOptions = false;
+            }
+        }
 
-                        case FMT_LINES:
-                        {
-                            int lines = 0;
-                            int last  = 0;
-                            int ch    = 0;
-                            long size = 0;
-                            while (-1 != (ch = getc(inHandle)))
-                            {
-                                switch (ch)
-                                {
-                                    case '\n':
-                                    {
-                                        lines++;
-                                        break;
-                                    }
-
-                                    default:
-                                        break;
-                                }
-
-                                last = ch;
-                                size++;
-                            }
+        // The options file may override the compression profile from the config file
+        heatshrinkProfile_t compression = extMap->compression;
+        if (hasOptions
+            && !parseHeatshrinkProfile(&compression, getStrOption(&options, "compression.method"),
+                                       getIntOption(&options, "compression.window", -1),
+                                       getIntOption(&options, "compression.lookahead", -1)))
+        {
+            fprintf(stderr, "[%s] Invalid compression options in %s\n", extMap->inExt,
+                    optionsFilename + strlen(inDirName));
+            readError = true;
+        }
 
-                            // Handle when a file doesn't end with a newline
-                            if ('\n' != last)
-                            {
-                                lines++;
-                            }
+        processorInput_t arg = {.in          = inData,
+                                .out         = outData,
+                                .inFilename  = get_filename(inFile),
+                                .options     = hasOptions ? &options : NULL,
+                                .compression = &compression};
 
-                            // Go back to the beginning for real reading
-                            fseek(inHandle, 0L, SEEK_SET);
+        if (!readError)
+        {
+            result = processor->function(&arg);
+            if (verbose)
+            {
+                printf("[%s] FUNC %s -> %s\n", extMap->inExt, arg.inFilename, get_filename(outFile));
+            }
+        }
 
-                            char* data = (char*)malloc(size + 1);
-                            if (!data)
-                            {
-                                readError = true;
-                                break;
-                            }
+        if (inHandle)
+        {
+            fclose(inHandle);
+        }
 
-                            char** lineList = malloc(lines * sizeof(char*));
-                            if (!lineList)
-                            {
-                                free(data);
-                                readError = true;
-                                break;
-                            }
-                            fread(data, size, 1, inHandle);
-                            fclose(inHandle);
-
-                            int outLine     = 0;
-                            char* cur       = data;
-                            const char* end = data + size;
-                            char* lineStart = cur;
-                            while (cur < end)
-                            {
-                                switch (*cur)
-                                {
-                                    case '\r':
-                                    {
-                                        if (cur + 1 < end && *(cur + 1) == '\n')
-                                        {
-                                            *cur = '\0';
-                                        }
-                                        break;
-                                    }
-
-                                    case '\n':
-                                    {
-                                        *cur                = '\0';
-                                        lineList[outLine++] = lineStart;
-                                        lineStart           = NULL;
-
-                                        break;
-                                    }
-
-                                    default:
-                                    {
-                                        if (!lineStart)
-                                        {
-                                            lineStart = cur;
-                                        }
-                                    }
-                                }
-                                cur++;
-                            }
-                            *cur = '\0';
+        if (hasOptions)
+        {
+            deleteOptions(&options);
+        }
 
-                            inData.lines     = lineList;
-                            inData.lineCount = lines;
-                            break;
-                        }
-                    }
+        switch (processor->outFmt)
+        {
+            case FMT_FILE:
+            case FMT_FILENAME:
+            case FMT_FILE_BIN:
+                // Nothing else necessary
+                break;
 
-                    processorOptions_t options = {0};
-                    if (hasOptions)
-                    {
-                        if (getOptionsFromIniFile(&options, optionsFilename))
-                        {
-                            if (verbose)
-                            {
-                                printf("[%s] OPTS %s <- %s (%" PRIu32 ")\n", extMap->inExt, get_filename(inFile),
-                                       optionsFilename + strlen(inDirName), (uint32_t)options.optionCount);
-                            }
-                        }
-                        else
-                        {
-                            if (verbose)
-                            {
-                                fprintf(
-                                    stderr,
-                                    "[WRN] Options file %s exists but contains no options! Is it a valid INI file?\n",
-                                    optionsFilename);
-                            }
-                            hasOptions = false;
-                        }
-                    }
+            case FMT_DATA:
+            {
+                fwrite(arg.out.data, arg.out.length, 1, outHandle);
 
-                    processorInput_t arg = {.in         = inData,
-                                            .out        = outData,
-                                            .inFilename = get_filename(inFile),
-                                            .options    = hasOptions ? &options : NULL};
+                if ((processor->inFmt != FMT_DATA || arg.out.data != arg.in.data)
+                    && (processor->inFmt != FMT_TEXT || (void*)arg.out.data != (void*)arg.in.text))
+                {
+                    free(arg.out.data);
+                }
+                break;
+            }
 
-                    if (!readError)
-                    {
-                        result = processor->function(&arg);
-                        if (verbose)
-                        {
-                            printf("[%s] FUNC %s -> %s\n", extMap->inExt, arg.inFilename, get_filename(outFile));
-                        }
-                    }
+            case FMT_TEXT:
+            {
+                fwrite(arg.out.text, strlen(arg.out.text), 1, outHandle);
 
-                    fclose(inHandle);
+                if ((processor->inFmt != FMT_TEXT || arg.out.text != arg.in.text)
+                    && (processor->inFmt != FMT_DATA || (void*)arg.out.text != (void*)arg.in.data))
+                {
+                    free(arg.out.text);
+                }
+                break;
+            }
 
-                    if (optionsModified)
-                    {
-                        deleteOptions(&options);
-                    }
+            case FMT_LINES:
+            {
+                for (size_t n = 0; n < arg.out.lineCount; n++)
+                {
+                    fwrite(arg.out.lines[n], strlen(arg.out.lines[n]), 1, outHandle);
+                    putc('\n', outHandle);
+                }
 
-                    switch (processor->outFmt)
-                    {
-                        case FMT_FILE:
-                        case FMT_FILENAME:
-                        case FMT_FILE_BIN:
-                            // Nothing else necessary
-                            break;
+                if (processor->inFmt != FMT_LINES || arg.out.lines != arg.in.lines)
+                {
+                    free(arg.out.lines[0]);
+                    free(arg.out.lines);
+                }
+                break;
+            }
+        }
 
-                        case FMT_DATA:
-                        {
-                            fwrite(arg.out.data, arg.out.length, 1, outHandle);
+        if (outHandle)
+        {
+            fclose(outHandle);
+        }
 
-                            if ((processor->inFmt != FMT_DATA || arg.out.data != arg.in.data)
-                                && (processor->inFmt != FMT_TEXT || (void*)arg.out.data != (void*)arg.in.text))
-                            {
-                                free(arg.out.data);
-                            }
-                            break;
-                        }
+        // And clean up the input file however necessary
+        switch (processor->inFmt)
+        {
+            case FMT_FILE:
+            case FMT_FILE_BIN:
+            case FMT_FILENAME:
+            {
+                break;
+            }
 
-                        case FMT_TEXT:
-                        {
-                            fwrite(arg.out.text, strlen(arg.out.text), 1, outHandle);
+            case FMT_DATA:
+            {
+                free(arg.in.data);
+                break;
+            }
 
-                            if ((processor->inFmt != FMT_TEXT || arg.out.text != arg.in.text)
-                                && (processor->inFmt != FMT_DATA || (void*)arg.out.text != (void*)arg.in.data))
-                            {
-                                free(arg.out.text);
-                            }
-                            break;
-                        }
+            case FMT_TEXT:
+            {
+                free(arg.in.text);
+                break;
+            }
 
-                        case FMT_LINES:
-                        {
-                            for (size_t n = 0; n < arg.out.lineCount; n++)
-                            {
-                                fwrite(arg.out.lines[n], strlen(arg.out.lines[n]), 1, outHandle);
-                                putc('\n', outHandle);
-                            }
+            case FMT_LINES:
+            {
+                free(arg.in.lines[0]);
+                free(arg.in.lines);
+                break;
+            }
 
-                            if (processor->inFmt != FMT_LINES || arg.out.lines != arg.in.lines)
-                            {
-                                free(arg.out.lines[0]);
-                                free(arg.out.lines);
-                            }
-                            break;
-                        }
-                    }
+            default:
+                break;
+        }
 
-                    if (outHandle)
-                    {
-                        fclose(outHandle);
-                    }
+        if (readError || !result)
+        {
+            if (!deleteFile(outFile))
+            {
+                fprintf(stderr,
+                        "[WRN] Could not clean up invalid output file %s after failed proecessing\n",
+                        outFile);
+            }
+        }
+    }
+    else if (EXEC == processor->type)
+    {
+        // 2048 chars ought to be enough for anybody!!
+        char buf[2048];
+        char* out = buf;
 
-                    // And clean up the input file however necessary
-                    switch (processor->inFmt)
+        const char* cur = processor->exec;
+        while (*cur)
+        {
+            switch (*cur)
+            {
+                case '%':
+                {
+                    const char* substStr = NULL;
+                    cur++;
+                    switch (*cur)
                     {
-                        case FMT_FILE:
-                        case FMT_FILE_BIN:
-                        case FMT_FILENAME:
-                        {
+                        // %i -> input file path
+                        case 'i':
+                            substStr = inFile;
                             break;
-                        }
-
-                        case FMT_DATA:
-                        {
-                            free(arg.in.data);
+                        // %f -> input file name
+                        case 'f':
+                            substStr = get_filename(inFile);
                             break;
-                        }
-
-                        case FMT_TEXT:
-                        {
-                            free(arg.in.text);
+                        // %o -> output file path
+                        case 'o':
+                            substStr = outFile;
                             break;
-                        }
-
-                        case FMT_LINES:
+                        // %a -> input file extension
+                        case 'a':
+                            substStr = extMap->inExt;
+                            break;
+                        // %b -> output file extension
+                        case 'b':
+                            substStr = extMap->outExt;
+                            break;
+                        // %% -> % (escape)
+                        case '%':
                         {
-                            free(arg.in.lines[0]);
-                            free(arg.in.lines);
+                            *out++ = *cur;
                             break;
                         }
-
                         default:
+                        {
+                            *out++ = '%';
+                            *out++ = *cur;
                             break;
+                        }
                     }
-
-                    if (readError || !result)
+                    if (substStr)
                     {
-                        if (!deleteFile(outFile))
-                        {
-                            fprintf(stderr,
-                                    "[WRN] Could not clean up invalid output file %s after failed proecessing\n",
-                                    outFile);
-                        }
+                        out = strcpy(out, substStr) + strlen(substStr);
                     }
+                    break;
                 }
-                else if (EXEC == processor->type)
+
+                default:
                 {
-                    // 2048 chars ought to be enough for anybody!!
-                    char buf[2048];
-                    char* out = buf;
+                    *out++ = *cur;
+                }
+                break;
+            }
+            cur++;
+        }
+        *out = '\0';
 
-                    const char* cur = processor->exec;
-                    while (*cur)
-                    {
-                        switch (*cur)
-                        {
-                            case '%':
-                            {
-                                const char* substStr = NULL;
-                                cur++;
-                                switch (*cur)
-                                {
-                                    // %i -> input file path
-                                    case 'i':
-                                        substStr = inFile;
-                                        break;
-                                    // %f -> input file name
-                                    case 'f':
-                                        substStr = get_filename(inFile);
-                                        break;
-                                    // %o -> output file path
-                                    case 'o':
-                                        substStr = outFile;
-                                        break;
-                                    // %a -> input file extension
-                                    case 'a':
-                                        substStr = extMap->inExt;
-                                        break;
-                                    // %b -> output file extension
-                                    case 'b':
-                                        substStr = extMap->outExt;
-                                        break;
-                                    // %% -> % (escape)
-                                    case '%':
-                                    {
-                                        *out++ = *cur;
-                                        break;
-                                    }
-                                    default:
-                                    {
-                                        *out++ = '%';
-                                        *out++ = *cur;
-                                        break;
-                                    }
-                                }
-                                if (substStr)
-                                {
-                                    out = strcpy(out, substStr) + strlen(substStr);
-                                }
-                                break;
-                            }
+        if (verbose)
+        {
+            printf("[%s] EXEC %s -> %s\n", extMap->inExt, get_filename(inFile), outFile);
+            printf(" >>> %s\n", buf);
+        }
 
-                            default:
-                            {
-                                *out++ = *cur;
-                            }
-                            break;
-                        }
-                        cur++;
-                    }
-                    *out = '\0';
+        result = (0 == system(buf));
 
-                    if (verbose)
-                    {
-                        printf("[%s] EXEC %s -> %s\n", extMap->inExt, get_filename(inFile), outFile);
-                        printf(" >>> %s\n", buf);
-                    }
+        if (!result)
+        {
+            fprintf(stderr, "Command failed!!!\n");
+        }
+    }
 
-                    result = (0 == system(buf));
+    if (!result)
+    {
+        fprintf(stderr, "[assets-preprocessor] Error! Failed to process %s!\n", get_filename(inFile));
 
-                    if (!result)
-                    {
-                        fprintf(stderr, "Command failed!!!\n");
-                    }
-                }
+        pthread_mutex_lock(&jobMutex);
+        processingErrors++;
+        pthread_mutex_unlock(&jobMutex);
+    }
 
-                if (!result)
-                {
-                    fprintf(stderr, "[assets-preprocessor] Error! Failed to process %s!\n", get_filename(inFile));
-                    processingErrors++;
-                }
+    job->done = result;
+}
 
-                break;
-            }
+/**
+ * @brief Worker thread which takes jobs from the queue until none are left
+ *
+ * @param arg Unused
+ * @return void* Always NULL
+ */
+static void* processWorker(void* arg)
+{
+    while (true)
+    {
+        pthread_mutex_lock(&jobMutex);
+        size_t idx = nextJob++;
+        pthread_mutex_unlock(&jobMutex);
+
+        if (idx >= jobCount)
+        {
+            break;
         }
+
+        processJob(&jobs[idx]);
     }
-    else if (FTW_D != tflag)
+
+    return NULL;
+}
+
+/**
+ * @brief Process all queued jobs in parallel
+ *
+ * @param threadCount The maximum number of threads to process jobs with
+ */
+static void processAllJobs(int threadCount)
+{
+    // Start with the largest files, which probably take longest
+    qsort(jobs, jobCount, sizeof(assetJob_t), jobSizeCmp);
+    nextJob = 0;
+
+    if (threadCount > jobCount)
     {
-        return -1;
+        threadCount = jobCount;
     }
 
-    return 0;
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+
+    // The calling thread always works too, so start one less
+    for (int i = 1; i < threadCount; i++)
+    {
+        if (0 != pthread_create(&threads[started], NULL, processWorker, NULL))
+        {
+            fprintf(stderr, "[WRN] Could not start worker thread, continuing with %d\n", started + 1);
+            break;
+        }
+        started++;
+    }
+
+    processWorker(NULL);
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
 }
 
 static const assetProcessor_t* findProcessor(const char* name)
@@ -718,6 +1152,11 @@ static void setupConfig(assetProcessor_t* execProcessors, size_t* procCount, fil
     assetProcessor_t pendingProc  = {0};
     fileProcessorMap_t pendingMap = {0};
 
+    // Compression options can't be checked until the whole section has been read
+    const char* pendingMethod = NULL;
+    int pendingWindow         = -1;
+    int pendingLookahead      = -1;
+
     const char* lastSectionName = NULL;
 
     // Okay, this loop is KINDA ugly...
@@ -735,8 +1174,9 @@ static void setupConfig(assetProcessor_t* execProcessors, size_t* procCount, fil
     // paragraph but I already wrote it so oh well!
     for (const optPair_t* opt = options->pairs; opt <= maxOpt; opt++)
     {
-        char* sectionName   = opt->section;
-        const char* optName = opt->name;
+        // Don't read the out-of-bounds option, just use it to flush the last section
+        char* sectionName   = (opt < maxOpt) ? opt->section : NULL;
+        const char* optName = (opt < maxOpt) ? opt->name : NULL;
 
         // Okay so it got a bit weirder since I wrote the last paragraph.
         // Turns out, the pending structs need to be flushed BEFORE we start
@@ -797,6 +1237,16 @@ static void setupConfig(assetProcessor_t* execProcessors, size_t* procCount, fil
                 validProc = false;
             }
 
+            if (validMap)
+            {
+                pendingMap.compression = defaultHeatshrinkProfile;
+                if (!parseHeatshrinkProfile(&pendingMap.compression, pendingMethod, pendingWindow, pendingLookahead))
+                {
+                    fprintf(stderr, "[WRN] Using default compression for [%s] in config\n", lastSectionName);
+                    pendingMap.compression = defaultHeatshrinkProfile;
+                }
+            }
+
             if (validMap && mapsOut < maxMaps)
             {
                 if (verbose)
@@ -810,7 +1260,10 @@ static void setupConfig(assetProcessor_t* execProcessors, size_t* procCount, fil
                 validMap = false;
             }
 
-            lastSectionName = sectionName;
+            lastSectionName  = sectionName;
+            pendingMethod    = NULL;
+            pendingWindow    = -1;
+            pendingLookahead = -1;
 
             if (verbose)
             {
@@ -870,6 +1323,18 @@ static void setupConfig(assetProcessor_t* execProcessors, size_t* procCount, fil
                 // But we know that it WILL be added to the list next, so...
                 pendingMap.processor = &execProcessors[procsOut];
             }
+            else if (!strcasecmp("compression", keyName))
+            {
+                pendingMethod = opt->value;
+            }
+            else if (!strcasecmp("window", keyName))
+            {
+                pendingWindow = atoi(opt->value);
+            }
+            else if (!strcasecmp("lookahead", keyName))
+            {
+                pendingLookahead = atoi(opt->value);
+            }
             else
             {
                 // Unrecognized config key, is this an error?
@@ -930,9 +1395,15 @@ int main(int argc, char** argv)
     int c;
     const char* configFile        = NULL;
     const char* timestampFileName = NULL;
+    const char* manifestFileName  = NULL;
+#ifdef _SC_NPROCESSORS_ONLN
+    int threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    int threadCount = 4;
+#endif
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "i:o:t:vc:h")) != -1)
+    while ((c = getopt(argc, argv, "i:o:t:m:j:rvc:h")) != -1)
     {
         switch (c)
         {
@@ -951,6 +1422,21 @@ int main(int argc, char** argv)
                 timestampFileName = optarg;
                 break;
             }
+            case 'm':
+            {
+                manifestFileName = optarg;
+                break;
+            }
+            case 'j':
+            {
+                threadCount = atoi(optarg);
+                break;
+            }
+            case 'r':
+            {
+                heatshrinkReport = true;
+                break;
+            }
             case 'v':
             {
                 verbose = true;
@@ -1018,7 +1504,7 @@ int main(int argc, char** argv)
     loadedExtMappings     = dynamicMappings;
     loadedExtMappingCount = mapCount;
 
-    if (ftw(inDirName, processFile, 99) == -1)
+    if (ftw(inDirName, queueFile, 99) == -1)
     {
         fprintf(stderr, "Failed to walk file tree\n");
         if (globalConfig)
@@ -1026,9 +1512,35 @@ int main(int argc, char** argv)
             deleteOptions(&configOptions);
             globalConfig = NULL;
         }
+        free(jobs);
         return -1;
     }
 
+    if (threadCount < 1)
+    {
+        threadCount = 1;
+    }
+    else if (threadCount > MAX_THREADS)
+    {
+        threadCount = MAX_THREADS;
+    }
+
+    if (manifestFileName)
+    {
+        loadManifest(manifestFileName);
+    }
+
+    processAllJobs(threadCount);
+
+    if (manifestFileName && 0 != writeManifest(manifestFileName))
+    {
+        fprintf(stderr, "[WRN] Failed to write manifest to '%s'\n", manifestFileName);
+    }
+
+    free(jobs);
+    jobs     = NULL;
+    jobCount = 0;
+
     if (globalConfig)
     {
         deleteOptions(&configOptions);
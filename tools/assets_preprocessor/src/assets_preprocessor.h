@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "heatshrink_util.h"
+
 /*! \file assets_preprocessor.h
  *
  * \section assetProc_design Design Philosophy
@@ -62,6 +64,11 @@
  * If you are trying to debug an issue with an asset processor, adding `-v` to the command
  * will enable verbose logging which could be helpful.
  *
+ * Assets are processed in parallel with one thread per CPU, which can be changed with `-j`.
+ * Adding `-m MANIFEST_FILE` keeps content hashes of each asset's input and options between
+ * runs, so only assets whose contents actually changed are processed again. Since many assets
+ * are processed at once, asset processor functions must not use any global state.
+ *
  * \subsection assetProc_config Config File
  *
  * The config file is what maps a file extension, such as `.png`, onto a specific asset
@@ -99,6 +106,33 @@
  * exec = python3 ./tools/my_game_asset_proc.py "%i" "%o"
  * ```
  *
+ * \subsubsection assetProc_compression Compression Profiles
+ *
+ * Function processors which compress their output with heatshrink, like `wsg`, `json`, and
+ * `heatshrink`, use a window of 2^8 bytes and a lookahead of 2^4 bytes by default. A section
+ * in the config file may change this for all of its files with these options:
+ *
+ * - `compression`: `heatshrink` to compress, or `none` to store files uncompressed. Stored
+ *   files are copied rather than decoded when loaded, which suits small assets which are
+ *   loaded often.
+ * - `window`: The window size as a power of two, from 4 to 15. Larger windows usually
+ *   compress large files better, but the decoder needs 2^`window` bytes of RAM.
+ * - `lookahead`: The lookahead size as a power of two, from 3 to one less than `window`.
+ *
+ * The profile is saved in each output file's header, so the firmware decodes every file
+ * with the right parameters. Files which heatshrink can't make any smaller are always stored
+ * uncompressed. Run the preprocessor with `-r` to print the compressed size, decoder RAM,
+ * and decode time of several profiles for every file it compresses.
+ *
+ * ```ini
+ * ; MIDI files compress better with a bigger window
+ * [.mid]
+ * outExt = mid
+ * func = heatshrink
+ * window = 10
+ * lookahead = 4
+ * ```
+ *
  * \subsection assetProc_options Asset Options Files
  *
  * In addition to the main config file, there is another type of file that can be used
@@ -135,6 +169,16 @@
  * dither = true
  * ```
  *
+ * The compression profile may also be changed for a single asset or directory with a
+ * `[compression]` section, which supports the options `method` (`heatshrink` or `none`),
+ * `window`, and `lookahead`. These override the profile from the config file.
+ *
+ * ```ini
+ * ; This sprite is drawn every frame, so keep it uncompressed
+ * [compression]
+ * method = none
+ * ```
+ *
  * \subsubsection assetProc_funcs Function Asset Preprocessors
  *
  * For all available asset processing functions, run the asset processor with the
@@ -178,6 +222,11 @@
  * will be reduced to fit the web-safe color palette, along with one fully
  * transparent color, \ref paletteColor_t::cTransparent.
  *
+ * Supports the option `spans`, which is false by default. If set to true, each
+ * row is stored as a list of opaque spans instead of raw pixels, which can be
+ * loaded with \ref loadWsgSpans() and drawn quickly with \ref drawWsgSpans().
+ * If the spans would be larger than the raw pixels, raw pixels are written instead.
+ *
  * \paragraph assetProc_gs gs
  * Process 12x6 pixel images as greyscale for the eyes.
  *
@@ -265,6 +314,9 @@
  * | `-o` | Output directory where processed assets are written. Always required.    |
  * | `-c` | Configuration file. Optional, but it won't do much without it.           |
  * | `-t` | Timestamp file. File will be updated any time an asset changes. Optional |
+ * | `-m` | Manifest file. Content hashes are kept here to skip unchanged assets.    |
+ * | `-j` | Number of threads to process assets with. Defaults to the CPU count.     |
+ * | `-r` | Report the size and decode time of several compression profiles.         |
  * | `-v` | Verbose mode. Outputs a lot more information during processing.          |
  * | `-h` | Display usage information, and list available processor function names.  |
  */
@@ -569,7 +621,8 @@
  *
  *     if (geBoolOption(arg->options, "file-with-options.compress", true))
  *     {
- *         return writeHeatshrinkFileHandle(arg->in.data, arg->in.length, arg->out.file);
+ *         return writeHeatshrinkFileHandle(arg->in.data, arg->in.length, arg->out.file, arg->compression,
+ *                                          arg->inFilename);
  *     }
  *     else
  *     {
@@ -748,6 +801,9 @@ typedef struct
 
     /// @brief Holds a pointer to any configuration options in use for this file
     const processorOptions_t* options;
+
+    /// @brief How to compress this file, to be passed to writeHeatshrinkFileHandle()
+    const heatshrinkProfile_t* compression;
 } processorInput_t;
 
 /**
@@ -800,6 +856,9 @@ typedef struct
 
     /// @brief Extra options passed to the processor for these files
     const processorOptions_t* options;
+
+    /// @brief How to compress these files, unless overridden by an options file
+    heatshrinkProfile_t compression;
 } fileProcessorMap_t;
 
 /// @brief The path that is provided for input assets on the command line.
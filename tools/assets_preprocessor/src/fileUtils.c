@@ -133,6 +133,54 @@ bool deleteFile(const char* path)
 #endif
 }
 
+/**
+ * @brief Add some bytes to a 64-bit FNV-1a hash
+ *
+ * @param hash The hash so far, or ::FNV_OFFSET_BASIS to start a new hash
+ * @param data The bytes to hash
+ * @param len The number of bytes to hash
+ * @return uint64_t The updated hash
+ */
+uint64_t hashBytes(uint64_t hash, const void* data, size_t len)
+{
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Add the entire contents of a file to a 64-bit FNV-1a hash
+ *
+ * @param hash A pointer to the hash so far, which is updated with the file's contents
+ * @param fname The path to the file to hash
+ * @return true if the whole file was hashed
+ * @return false if the file could not be read
+ */
+bool hashFile(uint64_t* hash, const char* fname)
+{
+    FILE* fp = fopen(fname, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "Cannot open file %s to hash: %s (%d)\n", fname, strerror(errno), errno);
+        return false;
+    }
+
+    uint8_t buf[4096];
+    size_t read;
+    while (0 < (read = fread(buf, 1, sizeof(buf), fp)))
+    {
+        *hash = hashBytes(*hash, buf, read);
+    }
+
+    bool ok = !ferror(fp);
+    fclose(fp);
+    return ok;
+}
+
 // Uncomment this to heavily debug the INI file parsing
 // #define INI_DEBUG
 
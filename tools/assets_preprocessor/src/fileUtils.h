@@ -2,6 +2,8 @@
 #define _FILE_UTILS_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "assets_preprocessor.h"
 
@@ -10,11 +12,16 @@
 #define HI_BYTE(x) ((x >> 8) & 0xFF)
 #define LO_BYTE(x) ((x) & 0xFF)
 
+/// The initial value for hashBytes() and hashFile()
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+
 long getFileSize(const char* fname);
 bool doesFileExist(const char* fname);
 const char* get_filename(const char* filename);
 bool isSourceFileNewer(const char* sourceFile, const char* destFile);
 bool deleteFile(const char* path);
+uint64_t hashBytes(uint64_t hash, const void* data, size_t len);
+bool hashFile(uint64_t* hash, const char* fname);
 
 bool getOptionsFromIniFile(processorOptions_t* options, const char* file);
 void deleteOptions(processorOptions_t* options);
@@ -1,18 +1,106 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
 
 #include "fileUtils.h"
 #include "heatshrink_encoder.h"
+#include "heatshrink_decoder.h"
 #include "heatshrink_util.h"
 
+/// The default profile, used when an asset has no compression configured
+const heatshrinkProfile_t defaultHeatshrinkProfile = {
+    .stored        = false,
+    .windowBits    = HS_DEFAULT_WINDOW_BITS,
+    .lookaheadBits = HS_DEFAULT_LOOKAHEAD_BITS,
+};
+
+/// Set to true to print the size and decode time of several profiles for every compressed asset
+bool heatshrinkReport = false;
+
+/// The profiles compared in the compression report, in addition to the asset's own profile
+static const heatshrinkProfile_t reportProfiles[] = {
+    {.stored = true},
+    {.windowBits = 8, .lookaheadBits = 4},
+    {.windowBits = 10, .lookaheadBits = 4},
+    {.windowBits = 12, .lookaheadBits = 5},
+};
+
+/// The size of the input buffer the firmware allocates its decoders with
+#define FIRMWARE_DECODER_INPUT_SIZE 256
+
+static uint32_t heatshrinkEncode(uint8_t* input, uint32_t len, uint8_t* output, uint32_t outputSize,
+                                 const heatshrinkProfile_t* profile);
+static double timeHeatshrinkDecode(uint8_t* compressed, uint32_t compressedLen, uint32_t len,
+                                   const heatshrinkProfile_t* profile);
+static void reportHeatshrink(uint8_t* input, uint32_t len, const heatshrinkProfile_t* profile,
+                             const char* name);
+
+/**
+ * @brief Update a compression profile from config values, and check that the result is valid
+ *
+ * @param profile The profile to update
+ * @param method "heatshrink" to compress, "none" to store uncompressed, or NULL to leave unchanged
+ * @param windowBits The heatshrink window size as a power of two, or a negative number to leave unchanged
+ * @param lookaheadBits The heatshrink lookahead size as a power of two, or a negative number to leave unchanged
+ * @return true if the profile is valid
+ * @return false if a value was not recognized, or the window and lookahead can't be used together
+ */
+bool parseHeatshrinkProfile(heatshrinkProfile_t* profile, const char* method, int windowBits, int lookaheadBits)
+{
+    if (NULL != method)
+    {
+        if (!strcasecmp(method, "none"))
+        {
+            profile->stored = true;
+        }
+        else if (!strcasecmp(method, "heatshrink"))
+        {
+            profile->stored = false;
+        }
+        else
+        {
+            fprintf(stderr, "[WRN] Unknown compression method '%s', expected 'heatshrink' or 'none'\n", method);
+            return false;
+        }
+    }
+
+    if (windowBits >= 0)
+    {
+        profile->windowBits = windowBits;
+    }
+
+    if (lookaheadBits >= 0)
+    {
+        profile->lookaheadBits = lookaheadBits;
+    }
+
+    // The window and lookahead are packed into one nibble each in the header
+    if (profile->windowBits < HEATSHRINK_MIN_WINDOW_BITS || profile->windowBits > HEATSHRINK_MAX_WINDOW_BITS
+        || profile->lookaheadBits < HEATSHRINK_MIN_LOOKAHEAD_BITS || profile->lookaheadBits >= profile->windowBits)
+    {
+        fprintf(stderr, "[WRN] Invalid heatshrink window %d and lookahead %d, window must be %d-%d and lookahead %d-%d\n",
+                profile->windowBits, profile->lookaheadBits, HEATSHRINK_MIN_WINDOW_BITS, HEATSHRINK_MAX_WINDOW_BITS,
+                HEATSHRINK_MIN_LOOKAHEAD_BITS, profile->windowBits - 1);
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief Utility to compress the given bytes and write them to a file
  *
  * @param input The bytes to compress and write to a file
  * @param len The length of the bytes to compress and write
  * @param outFilePath The filename to write to
+ * @param profile How to compress the bytes, or NULL to use ::defaultHeatshrinkProfile
+ * @param name The name of the asset, for the compression report
  */
-bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath)
+bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath, const heatshrinkProfile_t* profile,
+                         const char* name)
 {
     FILE* outFile = fopen(outFilePath, "wb");
 
@@ -24,7 +112,11 @@ bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath)
     }
     else if (NULL != outFile)
     {
-        ok = writeHeatshrinkFileHandle(input, len, outFile);
+        ok = writeHeatshrinkFileHandle(input, len, outFile, profile, name);
+    }
+
+    if (NULL != outFile)
+    {
         fclose(outFile);
     }
 
@@ -34,24 +126,41 @@ bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath)
 /**
  * @brief Utility to compress the given bytes and write them to a file handle
  *
+ * The file starts with a four byte header. The first byte is ::HS_HEADER_DEFAULT for the default window and lookahead,
+ * ::HS_HEADER_STORED for uncompressed data, or otherwise the window bits in the high nibble and the lookahead bits in
+ * the low nibble. The next three bytes are the big-endian decompressed size.
+ *
+ * Data which doesn't get any smaller with heatshrink is stored uncompressed instead.
+ *
  * @param input The bytes to compress and write to a file
  * @param len The length of the bytes to compress and write
  * @param outFile An open file handle to write to
+ * @param profile How to compress the bytes, or NULL to use ::defaultHeatshrinkProfile
+ * @param name The name of the asset, for the compression report
  */
-bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile)
+bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile, const heatshrinkProfile_t* profile,
+                               const char* name)
 {
-    int32_t errLine = -1;
-    /* Set up variables for compression */
-    /* The compressed data IS NOT guaranteed to be smaller than the original,
-       but it almost always is. When it's not, it's only a few bytes larger,
-       so allocate 16 bytes of extra space.
-    */
-    uint32_t outputSize   = len + 16;
-    uint8_t* output       = calloc(1, outputSize);
-    uint32_t outputIdx    = 0;
-    uint32_t inputIdx     = 0;
-    size_t copied         = 0;
-    uint32_t originalSize = outputSize;
+    if (outFile == NULL)
+    {
+        perror("Error occurred while writing file.\n");
+        return false;
+    }
+
+    if (len > HS_MAX_SIZE)
+    {
+        fprintf(stderr, "[%s] %" PRIu32 " bytes is too large to compress, the limit is %d\n", name, len, HS_MAX_SIZE);
+        return false;
+    }
+
+    if (NULL == profile)
+    {
+        profile = &defaultHeatshrinkProfile;
+    }
+
+    /* Each literal byte takes nine bits, so incompressible data grows by up to an eighth */
+    uint32_t outputSize = len + len / 8 + 16;
+    uint8_t* output     = calloc(1, outputSize);
 
     if (!output)
     {
@@ -59,21 +168,83 @@ bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile)
         return false;
     }
 
-    if (!outputSize)
+    uint32_t outputIdx = 0;
+    bool stored        = profile->stored;
+    if (!stored)
     {
-        fprintf(stderr, "Why is outputSize == 0?\n");
-        free(output);
-        return false;
+        outputIdx = heatshrinkEncode(input, len, output, outputSize, profile);
+        if (0 == outputIdx && 0 != len)
+        {
+            free(output);
+            return false;
+        }
+
+        // If compressing didn't help, storing is smaller and free to decode
+        stored = (outputIdx >= len);
     }
 
+    /* First byte is the format, then three bytes of decompresed size */
+    if (stored)
+    {
+        putc(HS_HEADER_STORED, outFile);
+    }
+    else if (profile->windowBits == HS_DEFAULT_WINDOW_BITS && profile->lookaheadBits == HS_DEFAULT_LOOKAHEAD_BITS)
+    {
+        putc(HS_HEADER_DEFAULT, outFile);
+    }
+    else
+    {
+        putc((profile->windowBits << 4) | profile->lookaheadBits, outFile);
+    }
+    putc(LO_BYTE(HI_WORD(len)), outFile);
+    putc(HI_BYTE(LO_WORD(len)), outFile);
+    putc(LO_BYTE(LO_WORD(len)), outFile);
+
+    /* Then dump the compressed bytes */
+    if (stored)
+    {
+        fwrite(input, len, 1, outFile);
+    }
+    else
+    {
+        fwrite(output, outputIdx, 1, outFile);
+    }
+
+    free(output);
+
+    if (heatshrinkReport)
+    {
+        reportHeatshrink(input, len, profile, name);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Compress bytes with heatshrink
+ *
+ * @param input The bytes to compress
+ * @param len The number of bytes to compress
+ * @param output The buffer to write compressed bytes to
+ * @param outputSize The size of the output buffer
+ * @param profile The window and lookahead to compress with
+ * @return uint32_t The number of compressed bytes, or 0 if there was an error
+ */
+static uint32_t heatshrinkEncode(uint8_t* input, uint32_t len, uint8_t* output, uint32_t outputSize,
+                                 const heatshrinkProfile_t* profile)
+{
+    int32_t errLine    = -1;
+    uint32_t outputIdx = 0;
+    uint32_t inputIdx  = 0;
+    size_t copied      = 0;
+
     /* Creete the encoder */
-    heatshrink_encoder* hse = heatshrink_encoder_alloc(8, 4);
+    heatshrink_encoder* hse = heatshrink_encoder_alloc(profile->windowBits, profile->lookaheadBits);
 
     if (!hse)
     {
         fprintf(stderr, "Couldn't allocate heatshrink encoder\n");
-        free(output);
-        return false;
+        return 0;
     }
 
     heatshrink_encoder_reset(hse);
@@ -176,43 +347,170 @@ bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile)
         }
     }
 
-    if (outFile == NULL)
+    /* Error handling and cleanup */
+heatshrink_error:
+    heatshrink_encoder_free(hse);
+    if (-1 != errLine)
     {
-        perror("Error occurred while writing file.\n");
-        return false;
+        fprintf(stderr, "[%d]: Heatshrink error\n", errLine);
+        return 0;
     }
-    /* First four bytes are decompresed size */
-    putc(HI_BYTE(HI_WORD(len)), outFile);
-    putc(LO_BYTE(HI_WORD(len)), outFile);
-    putc(HI_BYTE(LO_WORD(len)), outFile);
-    putc(LO_BYTE(LO_WORD(len)), outFile);
-    /* Then dump the compressed bytes */
-    fwrite(output, outputIdx, 1, outFile);
 
-    if (outputIdx > originalSize)
-    {
-        fprintf(stderr, "[WRN] Heatshrink-encoded data is %d bytes larger than original buffer!",
-                outputIdx - originalSize);
-    }
+    return outputIdx;
+}
 
-    /* Print results */
-    // printf("  Source length: %d\n  Shrunk length: %d\n", inputIdx, 4 + outputIdx);
+/**
+ * @brief Measure how long it takes to decode compressed data the same way the firmware does
+ *
+ * This runs on the host, so the time is only useful to compare profiles against each other
+ *
+ * @param compressed The compressed data, without a header
+ * @param compressedLen The number of compressed bytes
+ * @param len The number of decompressed bytes
+ * @param profile The window and lookahead the data was compressed with
+ * @return double The fastest time to decode the data, in microseconds, or a negative number if decoding failed
+ */
+static double timeHeatshrinkDecode(uint8_t* compressed, uint32_t compressedLen, uint32_t len,
+                                   const heatshrinkProfile_t* profile)
+{
+    uint8_t* decoded = malloc(len ? len : 1);
+    heatshrink_decoder* hsd
+        = heatshrink_decoder_alloc(FIRMWARE_DECODER_INPUT_SIZE, profile->windowBits, profile->lookaheadBits);
 
-    /* Error handling and cleanup */
-heatshrink_error:
-    if (NULL != output)
+    if (!decoded || !hsd)
     {
-        free(output);
+        free(decoded);
+        if (hsd)
+        {
+            heatshrink_decoder_free(hsd);
+        }
+        return -1;
     }
-    if (NULL != hse)
+
+    // Decode several times and keep the fastest, which is the least disturbed by everything else on the host
+    int runs        = 0;
+    double total    = 0;
+    double best     = 0;
+    bool decodeFail = false;
+    do
+    {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        heatshrink_decoder_reset(hsd);
+
+        uint32_t inIdx  = 0;
+        uint32_t outIdx = 0;
+        while (outIdx < len)
+        {
+            size_t copied = 0;
+            if (heatshrink_decoder_poll(hsd, &decoded[outIdx], len - outIdx, &copied) < 0)
+            {
+                decodeFail = true;
+                break;
+            }
+            outIdx += copied;
+
+            if (outIdx < len)
+            {
+                if (inIdx < compressedLen)
+                {
+                    copied = 0;
+                    heatshrink_decoder_sink(hsd, &compressed[inIdx], compressedLen - inIdx, &copied);
+                    inIdx += copied;
+                }
+                else if (HSDR_FINISH_DONE == heatshrink_decoder_finish(hsd))
+                {
+                    decodeFail = true;
+                    break;
+                }
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double elapsed = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_nsec - start.tv_nsec) / 1000.0;
+        if (0 == runs || elapsed < best)
+        {
+            best = elapsed;
+        }
+        total += elapsed;
+        runs++;
+    } while (!decodeFail && (runs < 5 || total < 5000) && runs < 1000);
+
+    heatshrink_decoder_free(hsd);
+    free(decoded);
+
+    return decodeFail ? -1 : best;
+}
+
+/**
+ * @brief Print the compressed size, decoder RAM, and decode time of an asset with several profiles
+ *
+ * @param input The uncompressed asset
+ * @param len The size of the uncompressed asset
+ * @param profile The asset's configured profile, which is marked in the report
+ * @param name The name of the asset
+ */
+static void reportHeatshrink(uint8_t* input, uint32_t len, const heatshrinkProfile_t* profile,
+                             const char* name)
+{
+    uint32_t outputSize = len + len / 8 + 16;
+    uint8_t* output     = malloc(outputSize);
+    if (!output)
     {
-        heatshrink_encoder_free(hse);
+        return;
     }
-    if (-1 != errLine)
+
+    // Build the whole report first so lines from different threads don't interleave
+    char report[1024];
+    int pos = snprintf(report, sizeof(report), "[heatshrink] %s: %" PRIu32 " bytes\n", name ? name : "?", len);
+
+    for (int i = -1; i < (int)(sizeof(reportProfiles) / sizeof(reportProfiles[0])); i++)
     {
-        fprintf(stderr, "[%d]: Heatshrink error\n", errLine);
-        return false;
+        const heatshrinkProfile_t* candidate = (i < 0) ? profile : &reportProfiles[i];
+
+        // Don't list the configured profile twice
+        if (i >= 0 && candidate->stored == profile->stored
+            && (candidate->stored
+                || (candidate->windowBits == profile->windowBits
+                    && candidate->lookaheadBits == profile->lookaheadBits)))
+        {
+            continue;
+        }
+
+        char label[16];
+        if (candidate->stored)
+        {
+            snprintf(label, sizeof(label), "none");
+        }
+        else
+        {
+            snprintf(label, sizeof(label), "w%d l%d", candidate->windowBits, candidate->lookaheadBits);
+        }
+
+        if (candidate->stored)
+        {
+            pos += snprintf(&report[pos], sizeof(report) - pos, "  %c %-6s %8" PRIu32 " bytes (%5.1f%%)\n",
+                            (i < 0) ? '*' : ' ', label, len + 4, len ? (100.0 * (len + 4) / len) : 0.0);
+        }
+        else
+        {
+            uint32_t compressedLen = heatshrinkEncode(input, len, output, outputSize, candidate);
+            double decodeUs        = timeHeatshrinkDecode(output, compressedLen, len, candidate);
+            pos += snprintf(&report[pos], sizeof(report) - pos,
+                            "  %c %-6s %8" PRIu32 " bytes (%5.1f%%), %5d byte decoder, %9.1f us to decode\n",
+                            (i < 0) ? '*' : ' ', label, compressedLen + 4,
+                            len ? (100.0 * (compressedLen + 4) / len) : 0.0,
+                            (int)(sizeof(heatshrink_decoder) + FIRMWARE_DECODER_INPUT_SIZE + (1 << candidate->windowBits)),
+                            decodeUs);
+        }
+
+        if (pos >= (int)sizeof(report))
+        {
+            break;
+        }
     }
 
-    return true;
+    free(output);
+    fputs(report, stdout);
 }
@@ -5,7 +5,38 @@
 #include <stdint.h>
 #include <stdio.h>
 
-bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath);
-bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile);
+// The first byte of the four byte header says how the data is stored. The other three bytes are the decompressed size.
+// These must match heatshrink_helper.h in the firmware
 
-#endif
\ No newline at end of file
+/// Header format byte for data compressed with the default window and lookahead
+#define HS_HEADER_DEFAULT 0x00
+/// Header format byte for data which is stored uncompressed
+#define HS_HEADER_STORED 0xFF
+/// The largest decompressed size which fits in the header
+#define HS_MAX_SIZE 0xFFFFFF
+
+/// The default heatshrink window size, as a power of two
+#define HS_DEFAULT_WINDOW_BITS 8
+/// The default heatshrink lookahead size, as a power of two
+#define HS_DEFAULT_LOOKAHEAD_BITS 4
+
+/**
+ * @brief How an asset is compressed, configured per extension in assets.conf or per asset in an options file
+ */
+typedef struct
+{
+    bool stored;           ///< true to store the data uncompressed, so it can be used straight from flash
+    uint8_t windowBits;    ///< The heatshrink window size, as a power of two
+    uint8_t lookaheadBits; ///< The heatshrink lookahead size, as a power of two
+} heatshrinkProfile_t;
+
+extern const heatshrinkProfile_t defaultHeatshrinkProfile;
+extern bool heatshrinkReport;
+
+bool parseHeatshrinkProfile(heatshrinkProfile_t* profile, const char* method, int windowBits, int lookaheadBits);
+bool writeHeatshrinkFile(uint8_t* input, uint32_t len, const char* outFilePath, const heatshrinkProfile_t* profile,
+                         const char* name);
+bool writeHeatshrinkFileHandle(uint8_t* input, uint32_t len, FILE* outFile, const heatshrinkProfile_t* profile,
+                               const char* name);
+
+#endif
@@ -49,6 +49,7 @@ typedef struct
 void shuffleArray(uint32_t* ar, uint32_t len);
 int isNeighborNotDrawn(pixel_t** img, int x, int y, int w, int h);
 void spreadError(pixel_t** img, int x, int y, int w, int h, int teR, int teG, int teB, float diagScalar);
+uint32_t encodeSpans(const unsigned char* paletteBuf, int w, int h, uint8_t* out);
 bool process_image(processorInput_t* arg);
 
 const assetProcessor_t imageProcessor
@@ -100,6 +101,68 @@ void spreadError(pixel_t** img, int x, int y, int w, int h, int teR, int teG, in
     }
 }
 
+/**
+ * @brief Encode a palette buffer as opaque spans per row. Each row is a two byte run count, then for each run a two
+ * byte x offset, a two byte length, and that many pixels. All values are big-endian.
+ *
+ * @param paletteBuf The palette buffer to encode, where 216 is transparent
+ * @param w The width of the image
+ * @param h The height of the image
+ * @param out The buffer to write the spans to, or NULL to only measure them
+ * @return The number of bytes of encoded spans
+ */
+uint32_t encodeSpans(const unsigned char* paletteBuf, int w, int h, uint8_t* out)
+{
+    uint32_t outIdx = 0;
+    for (int y = 0; y < h; y++)
+    {
+        const unsigned char* row = &paletteBuf[y * w];
+        uint32_t countIdx        = outIdx;
+        int numRuns              = 0;
+        outIdx += 2;
+
+        int x = 0;
+        while (x < w)
+        {
+            /* Skip transparent pixels */
+            while (x < w && row[x] == 6 * 6 * 6)
+            {
+                x++;
+            }
+            if (x == w)
+            {
+                break;
+            }
+
+            /* Measure the opaque run */
+            int start = x;
+            while (x < w && row[x] != 6 * 6 * 6)
+            {
+                x++;
+            }
+            int len = x - start;
+
+            if (out)
+            {
+                out[outIdx + 0] = HI_BYTE(start);
+                out[outIdx + 1] = LO_BYTE(start);
+                out[outIdx + 2] = HI_BYTE(len);
+                out[outIdx + 3] = LO_BYTE(len);
+                memcpy(&out[outIdx + 4], &row[start], len);
+            }
+            outIdx += 4 + len;
+            numRuns++;
+        }
+
+        if (out)
+        {
+            out[countIdx + 0] = HI_BYTE(numRuns);
+            out[countIdx + 1] = LO_BYTE(numRuns);
+        }
+    }
+    return outIdx;
+}
+
 bool process_image(processorInput_t* arg)
 {
     /* Load the source PNG */
@@ -107,6 +170,7 @@ bool process_image(processorInput_t* arg)
     unsigned char* data = stbi_load_from_file(arg->in.file, &w, &h, &n, 4);
 
     bool dither = getBoolOption(arg->options, "wsg.dither", false);
+    bool spans  = getBoolOption(arg->options, "wsg.spans", false);
 
     if (NULL != data)
     {
@@ -245,17 +309,28 @@ bool process_image(processorInput_t* arg)
         }
         free(image8b);
 
+        /* Span-encode the image if requested, but only if that doesn't make it bigger than the raw pixels */
+        uint32_t spanSize = spans ? encodeSpans(paletteBuf, w, h, NULL) : 0;
+        spans             = spans && (spanSize <= paletteBufSize);
+
         /* Combine the header and image*/
-        uint32_t hdrAndImgSz = sizeof(uint8_t) * (4 + paletteBufSize);
+        uint32_t hdrAndImgSz = sizeof(uint8_t) * (4 + (spans ? spanSize : paletteBufSize));
         uint8_t* hdrAndImg   = calloc(1, hdrAndImgSz);
-        hdrAndImg[0]         = HI_BYTE(w);
+        hdrAndImg[0]         = HI_BYTE(w) | (spans ? 0x80 : 0x00);
         hdrAndImg[1]         = LO_BYTE(w);
         hdrAndImg[2]         = HI_BYTE(h);
         hdrAndImg[3]         = LO_BYTE(h);
-        memcpy(&hdrAndImg[4], paletteBuf, paletteBufSize);
+        if (spans)
+        {
+            encodeSpans(paletteBuf, w, h, &hdrAndImg[4]);
+        }
+        else
+        {
+            memcpy(&hdrAndImg[4], paletteBuf, paletteBufSize);
+        }
         /* Write the compressed file */
 
-        bool result = writeHeatshrinkFileHandle(hdrAndImg, hdrAndImgSz, arg->out.file);
+        bool result = writeHeatshrinkFileHandle(hdrAndImg, hdrAndImgSz, arg->out.file, arg->compression, arg->inFilename);
         /* Cleanup */
         free(hdrAndImg);
         free(paletteBuf);
@@ -51,7 +51,8 @@ bool process_json(processorInput_t* arg)
 
     if (compress)
     {
-        return writeHeatshrinkFileHandle((uint8_t*)jsonText, strlen(jsonText), arg->out.file);
+        return writeHeatshrinkFileHandle((uint8_t*)jsonText, strlen(jsonText), arg->out.file, arg->compression,
+                                         arg->inFilename);
     }
     else
     {
@@ -21,5 +21,6 @@ const assetProcessor_t heatshrinkProcessor = {
 bool process_heatshrink(processorInput_t* arg)
 {
     // Write the compressed bytes to a file
-    return writeHeatshrinkFileHandle(arg->in.data, arg->in.length, arg->out.file);
+    return writeHeatshrinkFileHandle(arg->in.data, arg->in.length, arg->out.file, arg->compression,
+                                     arg->inFilename);
 }
\ No newline at end of file